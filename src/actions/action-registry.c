@@ -19,6 +19,34 @@ static Action*  actions[ACTION_REGISTRY_MAX_ACTIONS + 1];
 static uint32_t actions_allocated = 0;
 static bool     initialized       = false;
 
+/* Registered actions indexed by name atom, NULL where none */
+static Action** actions_by_atom      = NULL;
+static uint32_t actions_by_atom_size = 0;
+
+/*
+ * Grow actions_by_atom to cover atom, zero-filling the new slots.
+ */
+static bool
+reserve_atom(NameAtom atom)
+{
+  if (atom < actions_by_atom_size)
+    return true;
+
+  uint32_t new_size = actions_by_atom_size ? actions_by_atom_size : 64;
+  while (new_size <= atom)
+    new_size *= 2;
+
+  Action** grown = realloc(actions_by_atom, new_size * sizeof(Action*));
+  if (grown == NULL) {
+    LOG_ERROR("Cannot grow action index to %u atoms", new_size);
+    return false;
+  }
+  memset(grown + actions_by_atom_size, 0, (new_size - actions_by_atom_size) * sizeof(Action*));
+  actions_by_atom      = grown;
+  actions_by_atom_size = new_size;
+  return true;
+}
+
 /*
  * Built-in target resolver: current client
  * Uses weak linkage - provided by focus component if present
@@ -154,6 +182,9 @@ action_registry_shutdown(void)
   /* Unregister all actions */
   actions_allocated = 0;
   memset(actions, 0, sizeof(actions));
+  free(actions_by_atom);
+  actions_by_atom      = NULL;
+  actions_by_atom_size = 0;
 
   initialized = false;
 }
@@ -193,7 +224,15 @@ action_register(Action* action)
     return false;
   }
 
+  NameAtom atom = name_intern(action->name);
+  if (atom == NAME_ATOM_NONE || !reserve_atom(atom)) {
+    LOG_ERROR("Cannot index action '%s'", action->name);
+    return false;
+  }
+
   /* Register */
+  action->atom                 = atom;
+  actions_by_atom[atom]        = action;
   actions[actions_allocated++] = action;
 
   LOG_DEBUG("Registered action: %s", action->name);
@@ -209,14 +248,16 @@ action_unregister(const char* name)
     return false;
   }
 
-  if (name == NULL) {
+  Action* action = action_lookup(name);
+  if (action == NULL) {
     return false;
   }
 
   /* Find and remove */
   for (uint32_t i = 0; i < actions_allocated; i++) {
-    if (strcmp(actions[i]->name, name) == 0) {
+    if (actions[i] == action) {
       LOG_DEBUG("Unregistered action: %s", name);
+      actions_by_atom[action->atom] = NULL;
 
       /* Shift remaining actions */
       for (uint32_t j = i; j < actions_allocated - 1; j++) {
@@ -234,17 +275,17 @@ action_unregister(const char* name)
 Action*
 action_lookup(const char* name)
 {
-  if (!initialized || name == NULL) {
-    return NULL;
-  }
+  return action_lookup_atom(name_atom_find(name));
+}
 
-  for (uint32_t i = 0; i < actions_allocated; i++) {
-    if (strcmp(actions[i]->name, name) == 0) {
-      return actions[i];
-    }
+Action*
+action_lookup_atom(NameAtom atom)
+{
+  if (!initialized || atom >= actions_by_atom_size) {
+    return NULL;
   }
 
-  return NULL;
+  return actions_by_atom[atom];
 }
 
 Action**
@@ -266,26 +307,18 @@ action_count(void)
   return actions_allocated;
 }
 
-bool
-action_invoke(const char* name, ActionInvocation* inv)
+/*
+ * Resolve the target and call a registered action.
+ */
+static bool
+invoke_action(Action* action, ActionInvocation* inv)
 {
-  if (!initialized) {
-    LOG_ERROR("Action registry not initialized");
-    return false;
-  }
-
-  Action* action = action_lookup(name);
-  if (action == NULL) {
-    LOG_DEBUG("Action not found: %s", name);
-    return false;
-  }
-
   /* Resolve target */
   TargetID target = resolve_target(action, inv);
 
   /* Check if target is required */
   if (action->target_required && target == TARGET_ID_NONE) {
-    LOG_DEBUG("Action '%s' requires target but none available", name);
+    LOG_DEBUG("Action '%s' requires target but none available", action->name);
     return false;
   }
 
@@ -299,19 +332,53 @@ action_invoke(const char* name, ActionInvocation* inv)
   effective_inv.target = target;
 
   /* Call the callback */
-  LOG_DEBUG("Invoking action: %s (target=%" PRIu64 ")", name, target);
+  LOG_DEBUG("Invoking action: %s (target=%" PRIu64 ")", action->name, target);
 
   bool result = action->callback(&effective_inv);
 
   if (!result) {
-    LOG_DEBUG("Action '%s' returned failure", name);
+    LOG_DEBUG("Action '%s' returned failure", action->name);
   }
 
   return result;
 }
 
+bool
+action_invoke(const char* name, ActionInvocation* inv)
+{
+  if (!initialized) {
+    LOG_ERROR("Action registry not initialized");
+    return false;
+  }
+
+  Action* action = action_lookup(name);
+  if (action == NULL) {
+    LOG_DEBUG("Action not found: %s", name);
+    return false;
+  }
+
+  return invoke_action(action, inv);
+}
+
+bool
+action_invoke_atom(NameAtom atom, ActionInvocation* inv)
+{
+  if (!initialized) {
+    LOG_ERROR("Action registry not initialized");
+    return false;
+  }
+
+  Action* action = action_lookup_atom(atom);
+  if (action == NULL) {
+    LOG_DEBUG("Action not found: %s", name_atom_string(atom));
+    return false;
+  }
+
+  return invoke_action(action, inv);
+}
+
 bool
 action_exists(const char* name)
 {
   return action_lookup(name) != NULL;
-}
\ No newline at end of file
+}
@@ -10,6 +10,9 @@
  *   2. Components call action_register() in their on_init()
  *   3. Keybinding component calls action_lookup() when a key is pressed
  *   4. action_invoke() resolves the target and calls the callback
+ *
+ * Action names are interned (see wm-intern.h); callers that invoke the
+ * same action repeatedly can keep its atom and use the *_atom variants.
  */
 
 #ifndef _WM_ACTION_REGISTRY_H_
@@ -75,6 +78,7 @@ struct Action {
   ActionTargetType     target_type;     /* Hint for built-in target resolution */
   bool                 target_required; /* Fail if no target available */
   void*                userdata;        /* Component-specific data */
+  NameAtom             atom;            /* Interned name, assigned at registration */
 };
 
 /*
@@ -144,6 +148,7 @@ bool action_unregister(const char* name);
  * Returns NULL if not found.
  */
 Action* action_lookup(const char* name);
+Action* action_lookup_atom(NameAtom atom);
 
 /*
  * Get all registered actions.
@@ -164,6 +169,7 @@ uint32_t action_count(void);
  * Returns true if the action was found and invoked successfully.
  */
 bool action_invoke(const char* name, ActionInvocation* inv);
+bool action_invoke_atom(NameAtom atom, ActionInvocation* inv);
 
 /*
  * Check if an action with the given name exists.
@@ -110,6 +110,17 @@ keybinding_binding_shutdown(void)
   initialized   = false;
 }
 
+/*
+ * Internal: action of a binding, by its atom when it has one
+ */
+static Action*
+binding_action(const KeyBinding* binding)
+{
+  if (binding->action_atom != NAME_ATOM_NONE)
+    return action_lookup_atom(binding->action_atom);
+  return action_lookup(binding->action);
+}
+
 bool
 keybinding_binding_register(uint32_t modifiers, xcb_keycode_t keycode, const char* action)
 {
@@ -144,10 +155,11 @@ keybinding_binding_register(uint32_t modifiers, xcb_keycode_t keycode, const cha
 
   b->modifiers = modifiers;
   b->keycode   = keycode;
-  b->action    = action;
-  b->arg       = 0;
-  b->userdata  = NULL;
-  b->has_arg   = false;
+  b->action      = action;
+  b->arg         = 0;
+  b->userdata    = NULL;
+  b->has_arg     = false;
+  b->action_atom = name_intern(action);
 
   bindings[binding_count++] = b;
 
@@ -194,10 +206,11 @@ keybinding_binding_register_with_arg(uint32_t      modifiers,
 
   b->modifiers = modifiers;
   b->keycode   = keycode;
-  b->action    = action;
-  b->arg       = arg;
-  b->userdata  = NULL;
-  b->has_arg   = true;
+  b->action      = action;
+  b->arg         = arg;
+  b->userdata    = NULL;
+  b->has_arg     = true;
+  b->action_atom = name_intern(action);
 
   bindings[binding_count++] = b;
 
@@ -267,7 +280,7 @@ keybinding_binding_lookup_with_invocation(uint32_t modifiers, xcb_keycode_t keyc
   result.binding = binding;
 
   /* Look up action for target resolution */
-  Action* action = action_lookup(binding->action);
+  Action* action = binding_action(binding);
   if (action != NULL) {
     result.inv.target = resolve_binding_target(action);
   } else {
@@ -314,7 +327,7 @@ keybinding_binding_invoke(const KeyBinding* binding)
   }
 
   /* Look up action */
-  Action* action = action_lookup(binding->action);
+  Action* action = binding_action(binding);
   if (action == NULL) {
     LOG_DEBUG("Action not found for binding: %s", binding->action);
     return false;
@@ -342,7 +355,7 @@ keybinding_binding_invoke(const KeyBinding* binding)
   }
 
   /* Invoke action */
-  return action_invoke(binding->action, &inv);
+  return action_invoke_atom(action->atom, &inv);
 }
 
 bool
@@ -28,6 +28,7 @@
 
 #include "launcher.h"
 #include "wm-log.h"
+#include "wm-signals.h"
 #include "wm-xcb.h"
 
 /*
@@ -181,6 +182,7 @@ launcher_run_dmenu(void)
 
   if (pid == 0) {
     /* Child process - run dmenu */
+    restore_child_signals();
 
     /* Close read end of pipe */
     close(pipefd[0]);
@@ -262,6 +264,7 @@ launcher_run_dmenu(void)
 
   if (pid == 0) {
     /* Child - execute the command */
+    restore_child_signals();
 
     /*
      * Use execl with sh -c for proper shell interpretation.
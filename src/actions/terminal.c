@@ -25,6 +25,7 @@
 #include "action-registry.h"
 #include "terminal.h"
 #include "wm-log.h"
+#include "wm-signals.h"
 
 /*
  * Action definition for terminal.spawn
@@ -142,15 +143,12 @@ terminal_init(void)
    * Note: We intentionally do NOT install a SIGCHLD handler.
    *
    * Rationale: The launcher module (launcher.c) needs to wait for its forked
-   * dmenu child using waitpid(pid, ...). A process-wide SIGCHLD handler that
-   * reaps all children (waitpid(-1, ...)) would steal children from the
-   * launcher, causing waitpid to fail with ECHILD.
+   * dmenu child using waitpid(pid, ...). SIGCHLD is delivered through the
+   * main loop's signalfd (wm-signals.c), so the process-wide reaper only runs
+   * between event batches, after launcher's synchronous waitpid returned.
    *
-   * Terminal children are reaped using WNOHANG after spawn() returns.
-   * For long-running terminal processes, they will eventually become zombies,
-   * but since terminals are typically long-lived, this is acceptable.
-   * Alternatively, the window manager process could be configured to ignore
-   * SIGCHLD signals from child processes using prctl(PR_SET_PDEATHSIG).
+   * Terminal children are reaped using WNOHANG after spawn() returns, and
+   * by that reaper once they exit.
    */
 
   initialized = true;
@@ -199,9 +197,8 @@ terminal_action_spawn(ActionInvocation* inv)
  * Uses shell to parse command, supporting arguments and flags.
  *
  * Note: This is a fire-and-forget operation. The child process is not
- * explicitly reaped here - the kernel will deliver SIGCHLD when it exits.
- * For long-running terminal emulators, this is not a problem as they
- * typically outlive the window manager session.
+ * explicitly reaped here - the SIGCHLD reaper in wm-signals.c collects it
+ * when it exits.
  */
 bool
 terminal_spawn(void)
@@ -215,6 +212,7 @@ terminal_spawn(void)
 
   if (pid == 0) {
     /* Child process - execute terminal */
+    restore_child_signals();
 
     /*
      * Use setsid to create a new session and detach from controlling tty.
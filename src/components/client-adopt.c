@@ -0,0 +1,263 @@
+/*
+ * Client Adoption Implementation
+ *
+ * Pipelined startup adoption of pre-existing windows.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "client-adopt.h"
+#include "client-list.h"
+#include "client-props.h"
+#include "fullscreen.h"
+#include "src/xcb/xcb-atoms.h"
+#include "src/xcb/xcb-mirror.h"
+#include "wm-log.h"
+#include "wm-xcb-ewmh.h"
+
+/* ICCCM WM_HINTS flags and length (in CARD32s) */
+#define WM_HINTS_INPUT   (1U << 0)
+#define WM_HINTS_URGENCY (1U << 8)
+#define WM_HINTS_LENGTH  9
+
+/* Cookies of the requests sent for one window */
+typedef struct AdoptCookies {
+  xcb_get_window_attributes_cookie_t attributes;
+  xcb_get_geometry_cookie_t          geometry;
+  xcb_get_property_cookie_t          wm_class;
+  xcb_get_property_cookie_t          wm_name;
+  xcb_get_property_cookie_t          wm_hints;
+  xcb_get_property_cookie_t          wm_state;
+  xcb_get_property_cookie_t          window_type;
+} AdoptCookies;
+
+void
+client_adopt_parse(ClientAdoptInfo* info, xcb_window_t window, const ClientAdoptReplies* replies)
+{
+  memset(info, 0, sizeof(*info));
+  info->window    = window;
+  info->focusable = true;
+
+  if (replies->attributes != NULL) {
+    info->override_redirect = replies->attributes->override_redirect;
+    info->viewable          = replies->attributes->map_state == XCB_MAP_STATE_VIEWABLE;
+  }
+
+  if (replies->geometry != NULL) {
+    info->has_geometry = true;
+    info->x            = replies->geometry->x;
+    info->y            = replies->geometry->y;
+    info->width        = replies->geometry->width;
+    info->height       = replies->geometry->height;
+    info->border_width = replies->geometry->border_width;
+  }
+
+  info->title      = client_props_string(replies->wm_name);
+  info->class_name = client_props_class_name(replies->wm_class);
+
+  xcb_get_property_reply_t* hints = replies->wm_hints;
+  if (hints != NULL && hints->format == 32 && xcb_get_property_value_length(hints) >= 2 * 4) {
+    const uint32_t* v = (const uint32_t*) xcb_get_property_value(hints);
+    if (v[0] & WM_HINTS_INPUT)
+      info->focusable = v[1] != 0;
+    info->urgent = (v[0] & WM_HINTS_URGENCY) != 0;
+  }
+
+  info->fullscreen = ewmh_wm_state_has_fullscreen(replies->wm_state);
+
+  xcb_get_property_reply_t* type = replies->window_type;
+  if (type != NULL && type->format == 32 && xcb_get_property_value_length(type) >= 4)
+    info->window_type = *(const xcb_atom_t*) xcb_get_property_value(type);
+}
+
+bool
+client_adopt_wanted(const ClientAdoptInfo* info)
+{
+  /* Popups, menus and tooltips manage themselves */
+  if (info->override_redirect)
+    return false;
+
+  /* Withdrawn or iconic: it will send a MAP_REQUEST when it wants one */
+  if (!info->viewable || !info->has_geometry)
+    return false;
+
+  /* Panels and desktop windows are not tiled */
+  if (info->window_type != XCB_ATOM_NONE &&
+      (info->window_type == xcb_atom_get(ATOM_NET_WM_WINDOW_TYPE_DOCK) ||
+       info->window_type == xcb_atom_get(ATOM_NET_WM_WINDOW_TYPE_DESKTOP)))
+    return false;
+
+  return true;
+}
+
+uint32_t
+client_adopt_apply(ClientAdoptInfo* infos, uint32_t count)
+{
+  uint32_t adopted = 0;
+
+  /* Create every client first ... */
+  for (uint32_t i = 0; i < count; i++) {
+    ClientAdoptInfo* info = &infos[i];
+
+    if (!client_adopt_wanted(info) || client_get_by_window(info->window) != NULL)
+      continue;
+
+    Client* c = client_create(info->window);
+    if (c == NULL) {
+      LOG_WARN("Failed to adopt window %u", info->window);
+      continue;
+    }
+
+    client_set_geometry(c, info->x, info->y, info->width, info->height);
+    client_set_border_width(c, info->border_width);
+    client_set_title(c, info->title);
+    client_set_class(c, info->class_name);
+    client_set_urgent(c, info->urgent);
+    client_set_focusable(c, info->focusable);
+    client_set_mapped(c, true);
+    client_set_managed(c, true);
+    info->title      = NULL;
+    info->class_name = NULL;
+    info->client     = c;
+
+    /* Fresh from the pipeline; WM_NAME may lose to _NET_WM_NAME later */
+    c->props.window_type = info->window_type;
+    c->props.valid       = CLIENT_PROP_CLASS | CLIENT_PROP_HINTS | CLIENT_PROP_WINDOW_TYPE;
+
+    /* The server already has this state: the first layout sends only what differs */
+    XCBWindowState state = {
+      .x            = info->x,
+      .y            = info->y,
+      .width        = info->width,
+      .height       = info->height,
+      .border_width = info->border_width,
+    };
+    xcb_mirror_seed(info->window, XCB_MIRROR_CONFIG_MASK, &state, true);
+
+    adopted++;
+  }
+
+  /* ... then tell the rest of the WM, so listeners see the whole set */
+  for (uint32_t i = 0; i < count; i++) {
+    Client* c = infos[i].client;
+    if (c == NULL)
+      continue;
+
+    client_list_emit_event(EVT_CLIENT_CREATED, c);
+    client_list_emit_event(EVT_CLIENT_MANAGED, c);
+
+    /* Select property changes and fetch what the pipeline did not cover */
+    client_props_prefetch(c);
+
+    if (infos[i].fullscreen && fullscreen_component_is_initialized())
+      fullscreen_set_state(c, FULLSCREEN_STATE_FULLSCREEN);
+  }
+
+  return adopted;
+}
+
+void
+client_adopt_info_free(ClientAdoptInfo* info)
+{
+  free(info->title);
+  free(info->class_name);
+  info->title      = NULL;
+  info->class_name = NULL;
+}
+
+/* Request everything about a window; nothing is waited for */
+static void
+send_requests(xcb_connection_t* conn, xcb_window_t window, AdoptCookies* cookies)
+{
+  xcb_atom_t wm_state    = xcb_atom_get(ATOM_NET_WM_STATE);
+  xcb_atom_t window_type = xcb_atom_get(ATOM_NET_WM_WINDOW_TYPE);
+
+  cookies->attributes  = xcb_get_window_attributes(conn, window);
+  cookies->geometry    = xcb_get_geometry(conn, window);
+  cookies->wm_class    = xcb_get_property(conn, 0, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 256);
+  cookies->wm_name     = xcb_get_property(conn, 0, window, XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0, 256);
+  cookies->wm_hints    = xcb_get_property(conn, 0, window, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 0, WM_HINTS_LENGTH);
+  cookies->wm_state    = xcb_get_property(conn, 0, window, wm_state, XCB_ATOM_ATOM, 0, 64);
+  cookies->window_type = xcb_get_property(conn, 0, window, window_type, XCB_ATOM_ATOM, 0, 16);
+}
+
+/* Collect the replies for a window; only the first window waits */
+static void
+collect_replies(xcb_connection_t* conn, const AdoptCookies* cookies, ClientAdoptReplies* replies)
+{
+  replies->attributes  = xcb_get_window_attributes_reply(conn, cookies->attributes, NULL);
+  replies->geometry    = xcb_get_geometry_reply(conn, cookies->geometry, NULL);
+  replies->wm_class    = xcb_get_property_reply(conn, cookies->wm_class, NULL);
+  replies->wm_name     = xcb_get_property_reply(conn, cookies->wm_name, NULL);
+  replies->wm_hints    = xcb_get_property_reply(conn, cookies->wm_hints, NULL);
+  replies->wm_state    = xcb_get_property_reply(conn, cookies->wm_state, NULL);
+  replies->window_type = xcb_get_property_reply(conn, cookies->window_type, NULL);
+}
+
+static void
+free_replies(ClientAdoptReplies* replies)
+{
+  free(replies->attributes);
+  free(replies->geometry);
+  free(replies->wm_class);
+  free(replies->wm_name);
+  free(replies->wm_hints);
+  free(replies->wm_state);
+  free(replies->window_type);
+}
+
+uint32_t
+client_adopt_existing(xcb_connection_t* conn, xcb_window_t root)
+{
+  if (conn == NULL || root == XCB_NONE)
+    return 0;
+
+  /* Round trip 1: the top-level windows */
+  xcb_query_tree_cookie_t tree_cookie = xcb_query_tree(conn, root);
+  xcb_query_tree_reply_t* tree        = xcb_query_tree_reply(conn, tree_cookie, NULL);
+  if (tree == NULL)
+    return 0;
+
+  uint32_t count = (uint32_t) xcb_query_tree_children_length(tree);
+  if (count == 0) {
+    free(tree);
+    return 0;
+  }
+
+  /* The children array lives inside the reply: keep the reply until done */
+  xcb_window_t*    children = xcb_query_tree_children(tree);
+  AdoptCookies*    cookies  = malloc(count * sizeof(AdoptCookies));
+  ClientAdoptInfo* infos    = calloc(count, sizeof(ClientAdoptInfo));
+  if (cookies == NULL || infos == NULL) {
+    LOG_ERROR("Cannot allocate adoption state for %u windows", count);
+    free(cookies);
+    free(infos);
+    free(tree);
+    return 0;
+  }
+
+  /* Round trip 2: everything about every window, in one pipeline */
+  for (uint32_t i = 0; i < count; i++)
+    send_requests(conn, children[i], &cookies[i]);
+  xcb_flush(conn);
+
+  for (uint32_t i = 0; i < count; i++) {
+    ClientAdoptReplies replies;
+    collect_replies(conn, &cookies[i], &replies);
+    client_adopt_parse(&infos[i], children[i], &replies);
+    free_replies(&replies);
+  }
+
+  uint32_t adopted = client_adopt_apply(infos, count);
+
+  for (uint32_t i = 0; i < count; i++)
+    client_adopt_info_free(&infos[i]);
+
+  LOG_DEBUG("Adopted %u of %u existing windows", adopted, count);
+
+  free(infos);
+  free(cookies);
+  free(tree);
+  return adopted;
+}
@@ -0,0 +1,89 @@
+/*
+ * Client Adoption - Take over windows that exist before the WM starts
+ *
+ * Part of the client-list component. At startup every top-level window is
+ * inspected in one pipelined pass: after the query_tree reply, the window
+ * attributes, geometry, WM_CLASS, WM_NAME, WM_HINTS, _NET_WM_STATE and
+ * _NET_WM_WINDOW_TYPE of all windows are requested together and the
+ * replies collected afterwards, so adoption costs two round trips however
+ * many windows there are.
+ *
+ * Windows that are override-redirect, not viewable, docks or desktops are
+ * skipped. The rest become fully populated, managed Clients, created in one
+ * batch before any lifecycle event is emitted.
+ */
+
+#ifndef _COMPONENT_CLIENT_ADOPT_H_
+#define _COMPONENT_CLIENT_ADOPT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "src/target/client.h"
+
+/*
+ * Everything adoption learned about one window
+ */
+typedef struct ClientAdoptInfo {
+  xcb_window_t window;
+  bool         override_redirect;
+  bool         viewable;
+  bool         has_geometry;
+  int16_t      x;
+  int16_t      y;
+  uint16_t     width;
+  uint16_t     height;
+  uint16_t     border_width;
+  char*        title;      /* WM_NAME, owned until adopted */
+  char*        class_name; /* WM_CLASS class part, owned until adopted */
+  bool         urgent;     /* WM_HINTS urgency */
+  bool         focusable;  /* WM_HINTS input */
+  bool         fullscreen; /* _NET_WM_STATE_FULLSCREEN set */
+  xcb_atom_t   window_type;
+  Client*      client; /* set when adopted */
+} ClientAdoptInfo;
+
+/*
+ * Replies for one window; any of them may be NULL.
+ */
+typedef struct ClientAdoptReplies {
+  xcb_get_window_attributes_reply_t* attributes;
+  xcb_get_geometry_reply_t*          geometry;
+  xcb_get_property_reply_t*          wm_class;
+  xcb_get_property_reply_t*          wm_name;
+  xcb_get_property_reply_t*          wm_hints;
+  xcb_get_property_reply_t*          wm_state;
+  xcb_get_property_reply_t*          window_type;
+} ClientAdoptReplies;
+
+/*
+ * Fill info for a window from its replies (replies are not freed).
+ */
+void client_adopt_parse(ClientAdoptInfo* info, xcb_window_t window, const ClientAdoptReplies* replies);
+
+/*
+ * Check whether a window should become a managed client.
+ */
+bool client_adopt_wanted(const ClientAdoptInfo* info);
+
+/*
+ * Create clients for every wanted window, then emit their lifecycle
+ * events. Strings of adopted windows move into the Client.
+ * Returns the number of clients created.
+ */
+uint32_t client_adopt_apply(ClientAdoptInfo* infos, uint32_t count);
+
+/*
+ * Free whatever an info still owns.
+ */
+void client_adopt_info_free(ClientAdoptInfo* info);
+
+/*
+ * Run the whole pipeline against the server: query the tree, fetch
+ * everything about every child, adopt the wanted ones and select
+ * events on them. Returns the number of clients created.
+ */
+uint32_t client_adopt_existing(xcb_connection_t* conn, xcb_window_t root);
+
+#endif /* _COMPONENT_CLIENT_ADOPT_H_ */
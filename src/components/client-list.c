@@ -8,7 +8,9 @@
 #include <stdlib.h>
 
 #include "client-list.h"
+#include "client-props.h"
 #include "src/xcb/xcb-handler.h"
+#include "src/xcb/xcb-mirror.h"
 #include "wm-log.h"
 
 /*
@@ -149,6 +151,12 @@ client_list_component_init(void)
       base,
       client_list_on_unmap_notify);
 
+  /* Only the properties the cache holds; other atoms never reach us */
+  xcb_atom_t atoms[CLIENT_PROPS_MAX_ATOMS];
+  uint32_t   natoms = client_props_atoms(atoms);
+  for (uint32_t i = 0; i < natoms; i++)
+    result |= xcb_handler_register_property(atoms[i], XCB_NONE, base, client_list_on_property_notify);
+
   if (result != 0) {
     LOG_ERROR("Failed to register some XCB handlers for client list component");
     /* Continue anyway - partial registration is recoverable */
@@ -174,6 +182,7 @@ client_list_component_shutdown(void)
 
   /* Unregister XCB handlers for this component */
   xcb_handler_unregister_component(client_list_component_base());
+  client_props_shutdown();
 
   /* Shutdown the client list (destroys all clients) */
   client_list_shutdown();
@@ -193,7 +202,7 @@ client_list_component_shutdown(void)
  * Handle XCB_CREATE_NOTIFY event.
  * Creates a new Client for the window.
  */
-void
+XCBHandlerResult
 client_list_on_create_notify(void* event)
 {
   xcb_create_notify_event_t* e = (xcb_create_notify_event_t*) event;
@@ -204,14 +213,14 @@ client_list_on_create_notify(void* event)
   /* Skip override-redirect windows (e.g., popups, menus) */
   if (e->override_redirect) {
     LOG_DEBUG("Skipping override-redirect window %u", e->window);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Create a new client for this window */
   Client* c = client_create(e->window);
   if (c == NULL) {
     LOG_WARN("Failed to create client for window %u", e->window);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Set initial geometry from the event */
@@ -222,24 +231,27 @@ client_list_on_create_notify(void* event)
   client_list_emit_event(EVT_CLIENT_CREATED, c);
 
   LOG_DEBUG("Client created: window=%u", e->window);
+  return XCB_HANDLER_CONTINUE;
 }
 
 /*
  * Handle XCB_DESTROY_NOTIFY event.
  * Destroys the Client for the window.
  */
-void
+XCBHandlerResult
 client_list_on_destroy_notify(void* event)
 {
   xcb_destroy_notify_event_t* e = (xcb_destroy_notify_event_t*) event;
 
   LOG_DEBUG("DESTROY_NOTIFY: window=%u", e->window);
 
+  xcb_mirror_forget(e->window);
+
   /* Check if we have a client for this window */
   Client* c = client_get_by_window(e->window);
   if (c == NULL) {
     LOG_DEBUG("No client found for destroyed window %u", e->window);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Emit client destroyed event BEFORE destroying */
@@ -249,13 +261,14 @@ client_list_on_destroy_notify(void* event)
   client_destroy(c);
 
   LOG_DEBUG("Client destroyed: window=%u", e->window);
+  return XCB_HANDLER_CONTINUE;
 }
 
 /*
  * Handle XCB_MAP_REQUEST event.
  * Manages the window (adds to client list).
  */
-void
+XCBHandlerResult
 client_list_on_map_request(void* event)
 {
   xcb_map_request_event_t* e = (xcb_map_request_event_t*) event;
@@ -270,13 +283,14 @@ client_list_on_map_request(void* event)
     c = client_create(e->window);
     if (c == NULL) {
       LOG_WARN("Failed to create client for map request window %u", e->window);
-      return;
+      return XCB_HANDLER_CONTINUE;
     }
   }
 
   /* Mark as managed */
   if (!client_is_managed(c)) {
     client_set_managed(c, true);
+    client_props_prefetch(c);
     client_list_emit_event(EVT_CLIENT_MANAGED, c);
   }
 
@@ -284,13 +298,14 @@ client_list_on_map_request(void* event)
    * The WM typically checks if the window should be managed,
    * and if so, it maps it. This is a simplified implementation. */
   LOG_DEBUG("Client managed: window=%u", e->window);
+  return XCB_HANDLER_CONTINUE;
 }
 
 /*
  * Handle XCB_UNMAP_NOTIFY event.
  * Unmanages the window (removes from client list).
  */
-void
+XCBHandlerResult
 client_list_on_unmap_notify(void* event)
 {
   xcb_unmap_notify_event_t* e = (xcb_unmap_notify_event_t*) event;
@@ -298,11 +313,14 @@ client_list_on_unmap_notify(void* event)
   LOG_DEBUG("UNMAP_NOTIFY: window=%u, from_configure=%d",
             e->window, e->from_configure);
 
+  /* The window may have withdrawn itself: a later map must not be elided */
+  xcb_mirror_note_unmapped(e->window);
+
   /* Get the client for this window */
   Client* c = client_get_by_window(e->window);
   if (c == NULL) {
     LOG_DEBUG("No client for unmapped window %u", e->window);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Only emit unmanage event if client was managed */
@@ -312,6 +330,24 @@ client_list_on_unmap_notify(void* event)
   }
 
   LOG_DEBUG("Client unmanaged: window=%u", e->window);
+  return XCB_HANDLER_CONTINUE;
+}
+
+/*
+ * Handle XCB_PROPERTY_NOTIFY event.
+ * Marks the cached property stale; it is fetched again when next read.
+ */
+XCBHandlerResult
+client_list_on_property_notify(void* event)
+{
+  xcb_property_notify_event_t* e = (xcb_property_notify_event_t*) event;
+
+  Client* c = client_get_by_window(e->window);
+  if (c == NULL)
+    return XCB_HANDLER_CONTINUE;
+
+  client_props_invalidate_atom(c, e->atom);
+  return XCB_HANDLER_CONTINUE;
 }
 
 /*
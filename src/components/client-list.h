@@ -109,25 +109,31 @@ void client_list_component_shutdown(void);
  * Handle XCB_CREATE_NOTIFY event.
  * Creates a new Client for the window and registers with hub.
  */
-void client_list_on_create_notify(void* event);
+XCBHandlerResult client_list_on_create_notify(void* event);
 
 /*
  * Handle XCB_DESTROY_NOTIFY event.
  * Destroys the Client and unregisters from hub.
  */
-void client_list_on_destroy_notify(void* event);
+XCBHandlerResult client_list_on_destroy_notify(void* event);
 
 /*
  * Handle XCB_MAP_REQUEST event.
  * Manages the window (adds to client list) if not already managed.
  */
-void client_list_on_map_request(void* event);
+XCBHandlerResult client_list_on_map_request(void* event);
 
 /*
  * Handle XCB_UNMAP_NOTIFY event.
  * Unmanages the window (removes from client list) if managed.
  */
-void client_list_on_unmap_notify(void* event);
+XCBHandlerResult client_list_on_unmap_notify(void* event);
+
+/*
+ * Handle XCB_PROPERTY_NOTIFY event.
+ * Invalidates the client's cached property.
+ */
+XCBHandlerResult client_list_on_property_notify(void* event);
 
 /*
  * Client lifecycle helpers
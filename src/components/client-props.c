@@ -0,0 +1,505 @@
+/*
+ * Client Properties Implementation
+ *
+ * Lazy, asynchronous cache of the X properties of managed windows.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "client-props.h"
+#include "src/xcb/xcb-atoms.h"
+#include "src/xcb/xcb-reply.h"
+#include "wm-log.h"
+#include "wm-loop.h"
+#include "wm-xcb.h"
+
+/* ICCCM WM_HINTS flags */
+#define WM_HINTS_INPUT   (1U << 0)
+#define WM_HINTS_URGENCY (1U << 8)
+
+/* Reply userdata: the property bit, plus this flag for the WM_NAME retry */
+#define PROP_FALLBACK (1U << 16)
+
+/* Events selected on managed windows */
+#define CLIENT_EVENT_MASK \
+  (XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW | XCB_EVENT_MASK_PROPERTY_CHANGE)
+
+static ClientPropsStats stats;
+static LoopTimer        title_timer = -1;
+
+static uint64_t
+now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+static uint32_t
+count_bits(uint32_t bits)
+{
+  uint32_t n = 0;
+  for (; bits != 0; bits &= bits - 1)
+    n++;
+  return n;
+}
+
+char*
+client_props_string(const xcb_get_property_reply_t* reply)
+{
+  if (reply == NULL || reply->format != 8)
+    return NULL;
+
+  int len = xcb_get_property_value_length(reply);
+  if (len <= 0)
+    return NULL;
+
+  return strndup((const char*) xcb_get_property_value(reply), (size_t) len);
+}
+
+/* WM_CLASS is "instance\0class\0": keep the class, or the instance alone */
+char*
+client_props_class_name(const xcb_get_property_reply_t* reply)
+{
+  if (reply == NULL || reply->format != 8)
+    return NULL;
+
+  int len = xcb_get_property_value_length(reply);
+  if (len <= 0)
+    return NULL;
+
+  const char* value    = (const char*) xcb_get_property_value(reply);
+  size_t      instance = strnlen(value, (size_t) len);
+
+  if (instance + 1 < (size_t) len)
+    return strndup(value + instance + 1, (size_t) len - instance - 1);
+  return strndup(value, instance);
+}
+
+/* Number of CARD32s in a format-32 reply */
+static uint32_t
+card32_count(const xcb_get_property_reply_t* reply)
+{
+  if (reply == NULL || reply->format != 32)
+    return 0;
+  return (uint32_t) xcb_get_property_value_length(reply) / 4;
+}
+
+static void
+parse_size_hints(ClientSizeHints* hints, const xcb_get_property_reply_t* reply)
+{
+  uint32_t        n = card32_count(reply);
+  const uint32_t* v = n ? (const uint32_t*) xcb_get_property_value(reply) : NULL;
+
+  memset(hints, 0, sizeof(*hints));
+  if (n < 11)
+    return;
+
+  /* flags, x, y, width, height, min, max, inc, aspects, [base, gravity] */
+  hints->flags      = v[0];
+  hints->min_width  = (int32_t) v[5];
+  hints->min_height = (int32_t) v[6];
+  hints->max_width  = (int32_t) v[7];
+  hints->max_height = (int32_t) v[8];
+  hints->width_inc  = (int32_t) v[9];
+  hints->height_inc = (int32_t) v[10];
+  if (n >= 17) {
+    hints->base_width  = (int32_t) v[15];
+    hints->base_height = (int32_t) v[16];
+  } else {
+    hints->flags &= ~CLIENT_SIZE_HINT_P_BASE_SIZE;
+  }
+}
+
+void
+client_props_apply(Client* c, ClientProp prop, const xcb_get_property_reply_t* reply)
+{
+  if (c == NULL)
+    return;
+
+  switch (prop) {
+  case CLIENT_PROP_NAME:
+    client_set_title(c, client_props_string(reply));
+    break;
+
+  case CLIENT_PROP_CLASS:
+    client_set_class(c, client_props_class_name(reply));
+    break;
+
+  case CLIENT_PROP_HINTS: {
+    uint32_t        n     = card32_count(reply);
+    const uint32_t* v     = n ? (const uint32_t*) xcb_get_property_value(reply) : NULL;
+    uint32_t        flags = n >= 2 ? v[0] : 0;
+    client_set_focusable(c, (flags & WM_HINTS_INPUT) ? v[1] != 0 : true);
+    client_set_urgent(c, (flags & WM_HINTS_URGENCY) != 0);
+    break;
+  }
+
+  case CLIENT_PROP_NORMAL_HINTS:
+    parse_size_hints(&c->props.size_hints, reply);
+    break;
+
+  case CLIENT_PROP_TRANSIENT_FOR:
+    c->props.transient_for = card32_count(reply) >= 1
+                                 ? *(const xcb_window_t*) xcb_get_property_value(reply)
+                                 : XCB_NONE;
+    break;
+
+  case CLIENT_PROP_WINDOW_TYPE:
+    c->props.window_type = card32_count(reply) >= 1
+                               ? *(const xcb_atom_t*) xcb_get_property_value(reply)
+                               : XCB_ATOM_NONE;
+    break;
+
+  default:
+    return;
+  }
+
+  c->props.valid |= prop;
+}
+
+static void on_property_reply(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+
+/* Send the GetProperty for one property; false if it cannot be sent */
+static bool
+send_request(Client* c, ClientProp prop, bool fallback)
+{
+  xcb_atom_t atom   = XCB_ATOM_NONE;
+  xcb_atom_t type   = XCB_GET_PROPERTY_TYPE_ANY;
+  uint32_t   length = 1;
+
+  switch (prop) {
+  case CLIENT_PROP_NAME:
+    fallback = fallback || xcb_atom_get(ATOM_NET_WM_NAME) == XCB_ATOM_NONE;
+    atom     = fallback ? XCB_ATOM_WM_NAME : xcb_atom_get(ATOM_NET_WM_NAME);
+    length = 256;
+    break;
+  case CLIENT_PROP_CLASS:
+    atom   = XCB_ATOM_WM_CLASS;
+    type   = XCB_ATOM_STRING;
+    length = 256;
+    break;
+  case CLIENT_PROP_HINTS:
+    atom   = XCB_ATOM_WM_HINTS;
+    type   = XCB_ATOM_WM_HINTS;
+    length = 9;
+    break;
+  case CLIENT_PROP_NORMAL_HINTS:
+    atom   = XCB_ATOM_WM_NORMAL_HINTS;
+    type   = XCB_ATOM_WM_SIZE_HINTS;
+    length = 18;
+    break;
+  case CLIENT_PROP_TRANSIENT_FOR:
+    atom = XCB_ATOM_WM_TRANSIENT_FOR;
+    type = XCB_ATOM_WINDOW;
+    break;
+  case CLIENT_PROP_WINDOW_TYPE:
+    atom   = xcb_atom_get(ATOM_NET_WM_WINDOW_TYPE);
+    type   = XCB_ATOM_ATOM;
+    length = 16;
+    break;
+  default:
+    return false;
+  }
+
+  /* Atom table not interned yet */
+  if (atom == XCB_ATOM_NONE)
+    return false;
+
+  uintptr_t                 tag    = prop | (fallback ? PROP_FALLBACK : 0);
+  xcb_get_property_cookie_t cookie = xcb_get_property(dpy, 0, c->window, atom, type, 0, length);
+  return xcb_reply_register(cookie.sequence, c->target.id, on_property_reply, (void*) tag);
+}
+
+static void
+on_property_reply(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  Client*    c        = (Client*) hub_get_target_by_id(target);
+  uintptr_t  tag      = (uintptr_t) userdata;
+  ClientProp prop     = (ClientProp) (tag & CLIENT_PROP_ALL);
+  bool       fallback = (tag & PROP_FALLBACK) != 0;
+  (void) error;
+
+  if (c == NULL)
+    return;
+
+  /* No _NET_WM_NAME: retry with the legacy WM_NAME */
+  xcb_get_property_reply_t* r = (xcb_get_property_reply_t*) reply;
+  if (prop == CLIENT_PROP_NAME && !fallback &&
+      (r == NULL || xcb_get_property_value_length(r) == 0) &&
+      send_request(c, CLIENT_PROP_NAME, true))
+    return;
+
+  client_props_apply(c, prop, r);
+  c->props.pending &= ~prop;
+
+  /* Changed again while in flight: the value may already be old */
+  if (c->props.dirty & prop) {
+    c->props.dirty &= ~prop;
+    c->props.valid &= ~prop;
+  }
+}
+
+void
+client_props_fetch(Client* c, uint32_t props)
+{
+  if (c == NULL)
+    return;
+
+  props &= CLIENT_PROP_ALL & ~(c->props.valid | c->props.pending);
+  if (props == 0)
+    return;
+
+  stats.fetches += count_bits(props);
+  if (props & CLIENT_PROP_NAME)
+    c->props.title_fetched_ms = now_ms();
+
+  /* No connection (tests): nothing to ask */
+  if (dpy == NULL)
+    return;
+
+  for (uint32_t bit = 1; bit & CLIENT_PROP_ALL; bit <<= 1) {
+    if ((props & bit) && send_request(c, (ClientProp) bit, false))
+      c->props.pending |= bit;
+  }
+}
+
+void
+client_props_prefetch(Client* c)
+{
+  if (c == NULL)
+    return;
+
+  /* Select first, so no change slips in between the read and the notify */
+  if (dpy != NULL) {
+    const uint32_t values[] = { CLIENT_EVENT_MASK };
+    xcb_change_window_attributes(dpy, c->window, XCB_CW_EVENT_MASK, values);
+  }
+
+  client_props_fetch(c, CLIENT_PROP_ALL);
+}
+
+uint32_t
+client_props_atoms(xcb_atom_t* atoms)
+{
+  const xcb_atom_t all[CLIENT_PROPS_MAX_ATOMS] = {
+    XCB_ATOM_WM_NAME,
+    xcb_atom_get(ATOM_NET_WM_NAME),
+    XCB_ATOM_WM_CLASS,
+    XCB_ATOM_WM_HINTS,
+    XCB_ATOM_WM_NORMAL_HINTS,
+    XCB_ATOM_WM_TRANSIENT_FOR,
+    xcb_atom_get(ATOM_NET_WM_WINDOW_TYPE),
+  };
+  uint32_t n = 0;
+
+  for (uint32_t i = 0; i < CLIENT_PROPS_MAX_ATOMS; i++) {
+    if (all[i] != XCB_ATOM_NONE)
+      atoms[n++] = all[i];
+  }
+  return n;
+}
+
+uint32_t
+client_props_for_atom(xcb_atom_t atom)
+{
+  switch (atom) {
+  case XCB_ATOM_WM_NAME:
+    return CLIENT_PROP_NAME;
+  case XCB_ATOM_WM_CLASS:
+    return CLIENT_PROP_CLASS;
+  case XCB_ATOM_WM_HINTS:
+    return CLIENT_PROP_HINTS;
+  case XCB_ATOM_WM_NORMAL_HINTS:
+    return CLIENT_PROP_NORMAL_HINTS;
+  case XCB_ATOM_WM_TRANSIENT_FOR:
+    return CLIENT_PROP_TRANSIENT_FOR;
+  default:
+    break;
+  }
+
+  switch (xcb_atom_id(atom)) {
+  case ATOM_NET_WM_NAME:
+    return CLIENT_PROP_NAME;
+  case ATOM_NET_WM_WINDOW_TYPE:
+    return CLIENT_PROP_WINDOW_TYPE;
+  default:
+    return 0;
+  }
+}
+
+void
+client_props_invalidate(Client* c, uint32_t props)
+{
+  if (c == NULL)
+    return;
+
+  props &= CLIENT_PROP_ALL;
+  stats.invalidations += count_bits(props & c->props.valid);
+  c->props.dirty |= props & c->props.pending;
+  c->props.valid &= ~props;
+}
+
+bool
+client_props_invalidate_atom(Client* c, xcb_atom_t atom)
+{
+  uint32_t prop = client_props_for_atom(atom);
+  if (prop == 0) {
+    stats.ignored++;
+    return false;
+  }
+
+  client_props_invalidate(c, prop);
+  return true;
+}
+
+bool
+client_props_is_valid(const Client* c, ClientProp prop)
+{
+  return c != NULL && (c->props.valid & prop) == (uint32_t) prop;
+}
+
+/* Serve from the cache; start a fetch if the value is stale */
+static void
+ensure(Client* c, ClientProp prop)
+{
+  if (c->props.valid & prop)
+    stats.hits++;
+  else
+    client_props_fetch(c, prop);
+}
+
+static void on_title_timer(uint64_t expirations, void* userdata);
+
+/* One timer covers every window waiting for its title */
+static void
+schedule_title_refresh(uint64_t delay_ms)
+{
+  if (title_timer < 0)
+    title_timer = loop_add_timer((uint32_t) delay_ms, 0, on_title_timer, NULL);
+}
+
+/* Fetch the titles that were read during their debounce window */
+static void
+on_title_timer(uint64_t expirations, void* userdata)
+{
+  uint64_t now  = now_ms();
+  uint64_t next = 0;
+  (void) expirations;
+  (void) userdata;
+
+  loop_cancel_timer(title_timer);
+  title_timer = -1;
+
+  Client* sentinel = client_list_sentinel();
+  for (Client* c = sentinel->next; c != sentinel; c = c->next) {
+    if (!c->props.title_wanted)
+      continue;
+
+    uint64_t elapsed = now - c->props.title_fetched_ms;
+    if (elapsed < CLIENT_PROPS_TITLE_DEBOUNCE_MS) {
+      uint64_t left = CLIENT_PROPS_TITLE_DEBOUNCE_MS - elapsed;
+      if (next == 0 || left < next)
+        next = left;
+      continue;
+    }
+
+    c->props.title_wanted = false;
+    client_props_fetch(c, CLIENT_PROP_NAME);
+  }
+
+  if (next != 0)
+    schedule_title_refresh(next);
+}
+
+const char*
+client_props_title(Client* c)
+{
+  if (c == NULL)
+    return NULL;
+
+  if (c->props.valid & CLIENT_PROP_NAME) {
+    stats.hits++;
+    return c->title;
+  }
+  if (c->props.pending & CLIENT_PROP_NAME)
+    return c->title;
+
+  uint64_t elapsed = now_ms() - c->props.title_fetched_ms;
+  if (elapsed >= CLIENT_PROPS_TITLE_DEBOUNCE_MS) {
+    client_props_fetch(c, CLIENT_PROP_NAME);
+  } else {
+    /* Renamed again within the window: keep the old title for now */
+    stats.titles_deferred++;
+    c->props.title_wanted = true;
+    schedule_title_refresh(CLIENT_PROPS_TITLE_DEBOUNCE_MS - elapsed);
+  }
+  return c->title;
+}
+
+const char*
+client_props_class(Client* c)
+{
+  if (c == NULL)
+    return NULL;
+  ensure(c, CLIENT_PROP_CLASS);
+  return c->class_name;
+}
+
+xcb_window_t
+client_props_transient_for(Client* c)
+{
+  if (c == NULL)
+    return XCB_NONE;
+  ensure(c, CLIENT_PROP_TRANSIENT_FOR);
+  return c->props.transient_for;
+}
+
+xcb_atom_t
+client_props_window_type(Client* c)
+{
+  if (c == NULL)
+    return XCB_ATOM_NONE;
+  ensure(c, CLIENT_PROP_WINDOW_TYPE);
+  return c->props.window_type;
+}
+
+const ClientSizeHints*
+client_props_size_hints(Client* c)
+{
+  if (c == NULL)
+    return NULL;
+  ensure(c, CLIENT_PROP_NORMAL_HINTS);
+  return &c->props.size_hints;
+}
+
+bool
+client_props_urgent(Client* c)
+{
+  if (c == NULL)
+    return false;
+  ensure(c, CLIENT_PROP_HINTS);
+  return c->urgent;
+}
+
+void
+client_props_shutdown(void)
+{
+  if (title_timer >= 0)
+    loop_cancel_timer(title_timer);
+  title_timer = -1;
+}
+
+ClientPropsStats
+client_props_get_stats(void)
+{
+  return stats;
+}
+
+void
+client_props_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
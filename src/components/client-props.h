@@ -0,0 +1,142 @@
+/*
+ * Client Properties - Cached X properties of managed windows
+ *
+ * Part of the client-list component. Each Client caches the properties
+ * the WM cares about:
+ *
+ *   CLIENT_PROP_NAME           _NET_WM_NAME, else WM_NAME  -> c->title
+ *   CLIENT_PROP_CLASS          WM_CLASS                    -> c->class_name
+ *   CLIENT_PROP_HINTS          WM_HINTS                    -> c->urgent, c->focusable
+ *   CLIENT_PROP_NORMAL_HINTS   WM_NORMAL_HINTS             -> c->props.size_hints
+ *   CLIENT_PROP_TRANSIENT_FOR  WM_TRANSIENT_FOR            -> c->props.transient_for
+ *   CLIENT_PROP_WINDOW_TYPE    _NET_WM_WINDOW_TYPE         -> c->props.window_type
+ *
+ * Everything is fetched once, asynchronously, when the window is
+ * managed. A PROPERTY_NOTIFY only marks the property stale; it is fetched
+ * again when somebody reads it through one of the getters below, which
+ * return the cached value right away and never block.
+ *
+ * Title fetches are debounced: a window gets at most one title fetch per
+ * CLIENT_PROPS_TITLE_DEBOUNCE_MS, however often it rewrites its name. A
+ * title read during that window is served from the cache and the fetch
+ * happens when the window ends.
+ */
+
+#ifndef _COMPONENT_CLIENT_PROPS_H_
+#define _COMPONENT_CLIENT_PROPS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "src/target/client.h"
+
+/* Minimum interval between two title fetches for one window */
+#define CLIENT_PROPS_TITLE_DEBOUNCE_MS 100
+
+/* ICCCM WM_NORMAL_HINTS flags */
+#define CLIENT_SIZE_HINT_P_MIN_SIZE   (1U << 4)
+#define CLIENT_SIZE_HINT_P_MAX_SIZE   (1U << 5)
+#define CLIENT_SIZE_HINT_P_RESIZE_INC (1U << 6)
+#define CLIENT_SIZE_HINT_P_BASE_SIZE  (1U << 8)
+
+/*
+ * Cached properties
+ */
+typedef enum ClientProp {
+  CLIENT_PROP_NAME          = 1 << 0,
+  CLIENT_PROP_CLASS         = 1 << 1,
+  CLIENT_PROP_HINTS         = 1 << 2,
+  CLIENT_PROP_NORMAL_HINTS  = 1 << 3,
+  CLIENT_PROP_TRANSIENT_FOR = 1 << 4,
+  CLIENT_PROP_WINDOW_TYPE   = 1 << 5,
+  CLIENT_PROP_ALL           = (1 << 6) - 1,
+} ClientProp;
+
+/*
+ * Property cache statistics
+ */
+typedef struct ClientPropsStats {
+  uint64_t fetches;         /* properties fetched */
+  uint64_t invalidations;   /* cached values marked stale */
+  uint64_t ignored;         /* PROPERTY_NOTIFYs for uncached atoms */
+  uint64_t hits;            /* reads served from a current value */
+  uint64_t titles_deferred; /* title reads that hit the debounce window */
+} ClientPropsStats;
+
+/*
+ * Select property changes on the window and fetch every property that
+ * is not cached yet. Called when a window becomes managed.
+ */
+void client_props_prefetch(Client* c);
+
+/*
+ * Fetch the given properties unless current or already in flight.
+ */
+void client_props_fetch(Client* c, uint32_t props);
+
+/* Number of atoms feeding the cache */
+#define CLIENT_PROPS_MAX_ATOMS 7
+
+/*
+ * Fill atoms with every atom feeding the cache (those not interned yet
+ * are left out). Returns the number written, at most CLIENT_PROPS_MAX_ATOMS.
+ */
+uint32_t client_props_atoms(xcb_atom_t* atoms);
+
+/*
+ * Map an atom to the property it feeds, or 0 if it is not cached.
+ */
+uint32_t client_props_for_atom(xcb_atom_t atom);
+
+/*
+ * Mark the property fed by an atom stale (PROPERTY_NOTIFY).
+ * Returns false if the atom is not cached.
+ */
+bool client_props_invalidate_atom(Client* c, xcb_atom_t atom);
+
+/*
+ * Mark properties stale.
+ */
+void client_props_invalidate(Client* c, uint32_t props);
+
+/*
+ * Store a property reply in the cache. prop is a single CLIENT_PROP_*
+ * bit; a NULL reply clears the value.
+ */
+void client_props_apply(Client* c, ClientProp prop, const xcb_get_property_reply_t* reply);
+
+/*
+ * Check whether a property holds a current value.
+ */
+bool client_props_is_valid(const Client* c, ClientProp prop);
+
+/*
+ * Getters. Each returns the cached value immediately and starts a fetch
+ * if the value is stale, so the next read sees the fresh value.
+ */
+const char*            client_props_title(Client* c);
+const char*            client_props_class(Client* c);
+xcb_window_t           client_props_transient_for(Client* c);
+xcb_atom_t             client_props_window_type(Client* c);
+const ClientSizeHints* client_props_size_hints(Client* c);
+bool                   client_props_urgent(Client* c);
+
+/*
+ * Parse helpers shared with startup adoption. Strings are malloc'd.
+ */
+char* client_props_string(const xcb_get_property_reply_t* reply);
+char* client_props_class_name(const xcb_get_property_reply_t* reply);
+
+/*
+ * Cancel the deferred title refresh.
+ */
+void client_props_shutdown(void);
+
+/*
+ * Statistics
+ */
+ClientPropsStats client_props_get_stats(void);
+void             client_props_reset_stats(void);
+
+#endif /* _COMPONENT_CLIENT_PROPS_H_ */
@@ -28,8 +28,8 @@ typedef enum ConnectionState {
  * Connection State Machine events emitted on transitions
  */
 typedef enum ConnectionEvent {
-  EVT_MONITOR_DISCONNECTED = 100, /* Monitor output disconnected */
-  EVT_MONITOR_CONNECTED    = 101, /* Monitor output connected/reconnected */
+  EVT_MONITOR_DISCONNECTED = 35, /* Monitor output disconnected */
+  EVT_MONITOR_CONNECTED    = 36, /* Monitor output connected/reconnected */
 } ConnectionEvent;
 
 /*
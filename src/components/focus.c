@@ -213,7 +213,7 @@ focus_get_sm(Client* c)
   if (c == NULL)
     return NULL;
 
-  StateMachine* sm = client_get_sm(c, FOCUS_COMPONENT_NAME);
+  StateMachine* sm = client_get_sm_atom(c, FOCUS_COMPONENT_ATOM);
   if (sm != NULL)
     return sm;
 
@@ -234,7 +234,7 @@ focus_get_sm(Client* c)
   }
 
   /* Store in client */
-  if (!client_set_sm(c, FOCUS_COMPONENT_NAME, sm)) {
+  if (!client_set_sm_atom(c, FOCUS_COMPONENT_ATOM, sm)) {
     LOG_ERROR("Failed to store focus SM for client");
     sm_destroy(sm);
     return NULL;
@@ -253,7 +253,7 @@ focus_is_focused(Client* c)
   if (c == NULL)
     return false;
 
-  StateMachine* sm = client_get_sm(c, FOCUS_COMPONENT_NAME);
+  StateMachine* sm = client_get_sm_atom(c, FOCUS_COMPONENT_ATOM);
   if (sm == NULL)
     return false;
 
@@ -269,7 +269,7 @@ focus_get_state(Client* c)
   if (c == NULL)
     return FOCUS_STATE_UNFOCUSED;
 
-  StateMachine* sm = client_get_sm(c, FOCUS_COMPONENT_NAME);
+  StateMachine* sm = client_get_sm_atom(c, FOCUS_COMPONENT_ATOM);
   if (sm == NULL)
     return FOCUS_STATE_UNFOCUSED;
 
@@ -301,7 +301,7 @@ focus_set_state(Client* c, FocusState state)
         focus_component.focused_window != c->window) {
       Client* prev = client_get_by_window(focus_component.focused_window);
       if (prev != NULL && prev != c) {
-        StateMachine* prev_sm = client_get_sm(prev, FOCUS_COMPONENT_NAME);
+        StateMachine* prev_sm = client_get_sm_atom(prev, FOCUS_COMPONENT_ATOM);
         if (prev_sm != NULL) {
           sm_raw_write(prev_sm, FOCUS_STATE_UNFOCUSED);
         }
@@ -342,7 +342,7 @@ focus_get_focused_window(void)
  * Handle XCB_ENTER_NOTIFY event.
  * Sets focus to the entered client window.
  */
-void
+XCBHandlerResult
 focus_on_enter_notify(void* event)
 {
   xcb_enter_notify_event_t* e = (xcb_enter_notify_event_t*) event;
@@ -352,30 +352,30 @@ focus_on_enter_notify(void* event)
 
   /* Skip if this is not a normal enter (e.g., pointer grab) */
   if (e->mode != XCB_NOTIFY_MODE_NORMAL)
-    return;
+    return XCB_HANDLER_CONTINUE;
 
   /* Skip if detail indicates different focus reason */
   if (e->detail == XCB_NOTIFY_DETAIL_INFERIOR)
-    return;
+    return XCB_HANDLER_CONTINUE;
 
   /* Get client for this window */
   Client* c = client_get_by_window(e->event);
   if (c == NULL) {
     LOG_DEBUG("No client for enter notify window=%u", e->event);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Check if client is focusable */
   if (!c->focusable || !c->managed) {
     LOG_DEBUG("Client window=%u is not focusable or not managed", e->event);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Get or create the SM (on-demand) */
   StateMachine* sm = focus_get_sm(c);
   if (sm == NULL) {
     LOG_WARN("Focus listener: failed to get SM for client window=%u", c->window);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Get current SM state */
@@ -388,7 +388,7 @@ focus_on_enter_notify(void* event)
         focus_component.focused_window != c->window) {
       Client* prev = client_get_by_window(focus_component.focused_window);
       if (prev != NULL && prev != c) {
-        StateMachine* prev_sm = client_get_sm(prev, FOCUS_COMPONENT_NAME);
+        StateMachine* prev_sm = client_get_sm_atom(prev, FOCUS_COMPONENT_ATOM);
         if (prev_sm != NULL) {
           FocusState prev_state = (FocusState) sm_get_state(prev_sm);
           if (prev_state == FOCUS_STATE_FOCUSED) {
@@ -408,13 +408,14 @@ focus_on_enter_notify(void* event)
     /* Already focused, just update the tracked window */
     focus_component.focused_window = c->window;
   }
+  return XCB_HANDLER_CONTINUE;
 }
 
 /*
  * Handle XCB_LEAVE_NOTIFY event.
  * Clears focus when mouse leaves a client window.
  */
-void
+XCBHandlerResult
 focus_on_leave_notify(void* event)
 {
   xcb_leave_notify_event_t* e = (xcb_leave_notify_event_t*) event;
@@ -424,24 +425,24 @@ focus_on_leave_notify(void* event)
 
   /* Skip if this is not a normal leave (e.g., pointer grab) */
   if (e->mode != XCB_NOTIFY_MODE_NORMAL)
-    return;
+    return XCB_HANDLER_CONTINUE;
 
   /* Skip if detail indicates different focus reason */
   if (e->detail == XCB_NOTIFY_DETAIL_INFERIOR)
-    return;
+    return XCB_HANDLER_CONTINUE;
 
   /* Get client for this window */
   Client* c = client_get_by_window(e->event);
   if (c == NULL) {
     LOG_DEBUG("No client for leave notify window=%u", e->event);
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Get the SM */
-  StateMachine* sm = client_get_sm(c, FOCUS_COMPONENT_NAME);
+  StateMachine* sm = client_get_sm_atom(c, FOCUS_COMPONENT_ATOM);
   if (sm == NULL) {
     /* SM not yet created, nothing to unfocus */
-    return;
+    return XCB_HANDLER_CONTINUE;
   }
 
   /* Get current SM state */
@@ -457,6 +458,7 @@ focus_on_leave_notify(void* event)
       focus_component.focused_window = 0;
     }
   }
+  return XCB_HANDLER_CONTINUE;
 }
 
 /*
@@ -39,9 +39,10 @@
 #include "wm-hub.h"
 
 /*
- * Component name
+ * Component name, and its atom (also names the per-target SM)
  */
 #define FOCUS_COMPONENT_NAME "focus"
+#define FOCUS_COMPONENT_ATOM NAME_ATOM_FOCUS
 
 /*
  * Focus State Machine states
@@ -167,13 +168,13 @@ xcb_window_t focus_get_focused_window(void);
  * Handle XCB_ENTER_NOTIFY event.
  * Sets focus to the entered client.
  */
-void focus_on_enter_notify(void* event);
+XCBHandlerResult focus_on_enter_notify(void* event);
 
 /*
  * Handle XCB_LEAVE_NOTIFY event.
  * Clears focus from the left client.
  */
-void focus_on_leave_notify(void* event);
+XCBHandlerResult focus_on_leave_notify(void* event);
 
 /*
  * Guard Functions (for SM transitions)
@@ -19,7 +19,9 @@
 #include "src/sm/sm-registry.h"
 #include "src/sm/sm-template.h"
 #include "src/target/client.h"
+#include "src/xcb/xcb-atoms.h"
 #include "src/xcb/xcb-handler.h"
+#include "src/xcb/xcb-reply.h"
 #include "wm-hub.h"
 #include "wm-log.h"
 #include "wm-xcb-ewmh.h"
@@ -236,7 +238,7 @@ fullscreen_get_sm(Client* c)
   if (c == NULL)
     return NULL;
 
-  StateMachine* sm = client_get_sm(c, FULLSCREEN_COMPONENT_NAME);
+  StateMachine* sm = client_get_sm_atom(c, FULLSCREEN_COMPONENT_ATOM);
   if (sm != NULL)
     return sm;
 
@@ -254,7 +256,7 @@ fullscreen_get_sm(Client* c)
   }
 
   /* Store in client */
-  if (!client_set_sm(c, FULLSCREEN_COMPONENT_NAME, sm)) {
+  if (!client_set_sm_atom(c, FULLSCREEN_COMPONENT_ATOM, sm)) {
     LOG_ERROR("Failed to store fullscreen SM for client");
     sm_destroy(sm);
     return NULL;
@@ -273,7 +275,7 @@ fullscreen_is_fullscreen(Client* c)
   if (c == NULL)
     return false;
 
-  StateMachine* sm = client_get_sm(c, FULLSCREEN_COMPONENT_NAME);
+  StateMachine* sm = client_get_sm_atom(c, FULLSCREEN_COMPONENT_ATOM);
   if (sm == NULL)
     return false;
 
@@ -289,7 +291,7 @@ fullscreen_get_state(Client* c)
   if (c == NULL)
     return FULLSCREEN_STATE_WINDOWED;
 
-  StateMachine* sm = client_get_sm(c, FULLSCREEN_COMPONENT_NAME);
+  StateMachine* sm = client_get_sm_atom(c, FULLSCREEN_COMPONENT_ATOM);
   if (sm == NULL)
     return FULLSCREEN_STATE_WINDOWED;
 
@@ -339,7 +341,7 @@ fullscreen_update_x_property(Client* c, bool fullscreen)
         0, /* screen number */
         c->window,
         XCB_EWMH_WM_STATE_ADD,
-        ewmh->_NET_WM_STATE_FULLSCREEN,
+        xcb_atom_get(ATOM_NET_WM_STATE_FULLSCREEN),
         XCB_ATOM_NONE,
         0);
   } else {
@@ -349,7 +351,7 @@ fullscreen_update_x_property(Client* c, bool fullscreen)
         0, /* screen number */
         c->window,
         XCB_EWMH_WM_STATE_REMOVE,
-        ewmh->_NET_WM_STATE_FULLSCREEN,
+        xcb_atom_get(ATOM_NET_WM_STATE_FULLSCREEN),
         XCB_ATOM_NONE,
         0);
   }
@@ -369,9 +371,10 @@ fullscreen_executor(struct HubRequest* req)
 
   /* Get client from target ID */
   Client* c = (Client*) hub_get_target_by_id(req->target);
-  if (c == NULL || c->target.type_id != hub_get_target_type_id_by_name("client")) {
+  if (c == NULL || c->target.type_id != hub_get_target_type_id_by_atom(NAME_ATOM_CLIENT)) {
     LOG_DEBUG("fullscreen_executor: no client found for target");
     hub_emit(EVT_FULLSCREEN_FAILED, req->target, NULL);
+    req->failed = true;
     return;
   }
 
@@ -380,6 +383,7 @@ fullscreen_executor(struct HubRequest* req)
   if (sm == NULL) {
     LOG_ERROR("fullscreen_executor: failed to get fullscreen SM");
     hub_emit(EVT_FULLSCREEN_FAILED, req->target, NULL);
+    req->failed = true;
     return;
   }
 
@@ -400,27 +404,18 @@ fullscreen_executor(struct HubRequest* req)
 }
 
 /*
- * PropertyNotify handler for _NET_WM_STATE monitoring
+ * Reply to the _NET_WM_STATE read issued by the PropertyNotify handler.
+ * Only runs while the client is still managed.
  */
-void
-fullscreen_on_property_notify(void* event)
+static void
+fullscreen_on_wm_state_reply(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
 {
-  xcb_property_notify_event_t* e = (xcb_property_notify_event_t*) event;
-
-  LOG_DEBUG("PROPERTY_NOTIFY: window=%u atom=%u state=%d",
-            e->window, e->atom, e->state);
-
-  /* Check if this is _NET_WM_STATE property */
-  if (ewmh == NULL || e->atom != ewmh->_NET_WM_STATE)
-    return;
-
-  /* Get client for this window */
-  Client* c = client_get_by_window(e->window);
-  if (c == NULL)
+  Client* c = (Client*) hub_get_target_by_id(target);
+  if (c == NULL || reply == NULL)
     return;
 
   /* Check if _NET_WM_STATE contains _NET_WM_STATE_FULLSCREEN */
-  bool is_fullscreen = ewmh_check_wm_state_fullscreen(ewmh, c->window);
+  bool is_fullscreen = ewmh_wm_state_has_fullscreen(reply);
 
   /* Get or create the SM (on-demand) */
   StateMachine* sm = fullscreen_get_sm(c);
@@ -442,6 +437,29 @@ fullscreen_on_property_notify(void* event)
   }
 }
 
+/*
+ * PropertyNotify handler for _NET_WM_STATE monitoring
+ */
+XCBHandlerResult
+fullscreen_on_property_notify(void* event)
+{
+  xcb_property_notify_event_t* e = (xcb_property_notify_event_t*) event;
+
+  LOG_DEBUG("PROPERTY_NOTIFY: window=%u atom=%u state=%d",
+            e->window, e->atom, e->state);
+
+  /* Get client for this window */
+  Client* c = client_get_by_window(e->window);
+  if (c == NULL)
+    return XCB_HANDLER_CONTINUE;
+
+  /* Read the new atom list without waiting for the reply */
+  xcb_get_property_cookie_t cookie = xcb_get_property(
+      dpy, 0, c->window, xcb_atom_get(ATOM_NET_WM_STATE), XCB_GET_PROPERTY_TYPE_ANY, 0, 1024);
+  xcb_reply_register(cookie.sequence, c->target.id, fullscreen_on_wm_state_reply, NULL);
+  return XCB_HANDLER_CONTINUE;
+}
+
 /*
  * Component initialization
  */
@@ -480,11 +498,16 @@ fullscreen_component_init(void)
   /* Register with hub */
   hub_register_component(&fullscreen_component.base);
 
-  /* Register XCB handler for PROPERTY_NOTIFY */
-  int result = xcb_handler_register(
-      XCB_PROPERTY_NOTIFY,
-      &fullscreen_component.base,
-      fullscreen_on_property_notify);
+  /* Only _NET_WM_STATE changes concern us; without the atom (no X
+   * connection) there is nothing external to track */
+  xcb_atom_t wm_state = xcb_atom_get(ATOM_NET_WM_STATE);
+  int        result   = 0;
+  if (wm_state != XCB_ATOM_NONE)
+    result = xcb_handler_register_property(
+        wm_state,
+        XCB_NONE,
+        &fullscreen_component.base,
+        fullscreen_on_property_notify);
 
   if (result != 0) {
     LOG_ERROR("Failed to register PROPERTY_NOTIFY handler for fullscreen component");
@@ -38,9 +38,10 @@
 #include "wm-hub.h"
 
 /*
- * Component name
+ * Component name, and its atom (also names the per-target SM)
  */
 #define FULLSCREEN_COMPONENT_NAME "fullscreen"
+#define FULLSCREEN_COMPONENT_ATOM NAME_ATOM_FULLSCREEN
 
 /*
  * Fullscreen State Machine states
@@ -54,9 +55,9 @@ typedef enum FullscreenState {
  * Fullscreen events emitted on state transitions
  */
 typedef enum FullscreenEvent {
-  EVT_FULLSCREEN_ENTERED = 20,
-  EVT_FULLSCREEN_EXITED  = 21,
-  EVT_FULLSCREEN_FAILED  = 22,
+  EVT_FULLSCREEN_ENTERED = 25,
+  EVT_FULLSCREEN_EXITED  = 26,
+  EVT_FULLSCREEN_FAILED  = 27,
 } FullscreenEvent;
 
 /*
@@ -162,9 +163,9 @@ void fullscreen_update_x_property(Client* c, bool fullscreen);
 
 /*
  * PropertyNotify handler for _NET_WM_STATE monitoring.
- * Called by xcb_handler_dispatch() when a property changes on a client window.
+ * Subscribed to _NET_WM_STATE only, so every event it sees is one.
  */
-void fullscreen_on_property_notify(void* event);
+XCBHandlerResult fullscreen_on_property_notify(void* event);
 
 /*
  * Guard Functions (for SM transitions)
@@ -155,7 +155,7 @@ keybinding_get_count(void)
  * Handle KEY_PRESS events
  * Called from XCB event loop via xcb_handler_dispatch()
  */
-void
+XCBHandlerResult
 keybinding_handle_key_press(void* event)
 {
   xcb_key_press_event_t* e = (xcb_key_press_event_t*) event;
@@ -164,18 +164,20 @@ keybinding_handle_key_press(void* event)
   LOG_DEBUG("KEY_PRESS: state=0x%" PRIx32 " detail=%" PRIu8,
             e->state, e->detail);
 
-  /* Look up and execute the keybinding */
+  /* Look up and execute the keybinding; a bound key is ours alone */
   if (!keybinding_binding_execute(e->state, e->detail)) {
     LOG_DEBUG("Keybinding: no binding for key state=0x%" PRIx32 " keycode=%" PRIu8,
               e->state, e->detail);
+    return XCB_HANDLER_CONTINUE;
   }
+  return XCB_HANDLER_CONSUMED;
 }
 
 /*
  * Handle KEY_RELEASE events
  * Currently unused but available for future extension
  */
-void
+XCBHandlerResult
 keybinding_handle_key_release(void* event)
 {
   xcb_key_release_event_t* e = (xcb_key_release_event_t*) event;
@@ -186,6 +188,7 @@ keybinding_handle_key_release(void* event)
   /* For now, key releases don't trigger any actions.
    * In the future, we might want to track key hold duration
    * or implement key repeat behavior here. */
+  return XCB_HANDLER_CONTINUE;
 }
 
 /*
@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include <xcb/xcb.h>
 
+#include "src/xcb/xcb-handler.h"
 #include "wm-hub.h"
 
 /*
@@ -51,12 +52,13 @@ typedef enum {
  * The action name is looked up in the action registry at runtime.
  */
 typedef struct KeyBinding {
-  uint32_t      modifiers; /* XCB modifier mask (Shift, Control, Mod1, etc.) */
-  xcb_keycode_t keycode;   /* X11 keycode */
-  const char*   action;    /* Action name to invoke (e.g., "fullscreen.toggle") */
-  uint32_t      arg;       /* Integer argument (e.g., tag number) */
-  void*         userdata;  /* Binding-specific userdata */
-  bool          has_arg;   /* Whether arg should be passed to action */
+  uint32_t      modifiers;   /* XCB modifier mask (Shift, Control, Mod1, etc.) */
+  xcb_keycode_t keycode;     /* X11 keycode */
+  const char*   action;      /* Action name to invoke (e.g., "fullscreen.toggle") */
+  uint32_t      arg;         /* Integer argument (e.g., tag number) */
+  void*         userdata;    /* Binding-specific userdata */
+  bool          has_arg;     /* Whether arg should be passed to action */
+  NameAtom      action_atom; /* Interned action name, set at registration */
 } KeyBinding;
 
 /*
@@ -122,13 +124,13 @@ extern HubComponent keybinding_component;
  * Handle KEY_PRESS events
  * Looks up the keybinding, then invokes the action from the action registry
  */
-void keybinding_handle_key_press(void* event);
+XCBHandlerResult keybinding_handle_key_press(void* event);
 
 /*
  * Handle KEY_RELEASE events
  * Currently unused but available for key release handling
  */
-void keybinding_handle_key_release(void* event);
+XCBHandlerResult keybinding_handle_key_release(void* event);
 
 /*
  * Convert X event to key binding lookup
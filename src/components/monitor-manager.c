@@ -5,6 +5,8 @@
  * - Registers XCB handler for RANDR_NOTIFY events
  * - Creates/destroys Monitor targets based on output connect/disconnect
  * - Performs initial RandR output discovery on startup
+ * - Keeps a CRTC index current from RANDR_NOTIFY, so geometry changes
+ *   need no round trip
  */
 
 #include <stdint.h>
@@ -15,6 +17,7 @@
 
 #include "../target/monitor.h"
 #include "../xcb/xcb-handler.h"
+#include "../xcb/xcb-reply.h"
 #include "monitor-manager.h"
 #include "wm-hub.h"
 #include "wm-log.h"
@@ -32,17 +35,66 @@ extern xcb_connection_t* dpy;
 
 /* Forward declarations */
 static void monitor_manager_executor(struct HubRequest* req);
-static void monitor_manager_xcb_handler(void* event);
+static XCBHandlerResult monitor_manager_xcb_handler(void* event);
 
 /* Internal helper functions */
-static void                monitor_manager_discover_outputs(void);
-static Monitor*            monitor_manager_create_for_output(xcb_randr_output_t output);
-static void                monitor_manager_destroy_for_output(xcb_randr_output_t output);
-static void                monitor_manager_update_output_geometry(xcb_randr_output_t output, xcb_randr_crtc_t crtc);
-static void                monitor_manager_update_crtc_geometry(xcb_randr_crtc_t crtc, xcb_timestamp_t timestamp);
-static bool                monitor_manager_get_output_info(xcb_randr_output_t output, xcb_randr_crtc_t* crtc_out, char** name_out);
-static bool                monitor_manager_get_crtc_info(xcb_randr_crtc_t crtc, int16_t* x, int16_t* y, uint16_t* width, uint16_t* height, xcb_randr_mode_t* mode);
-static xcb_randr_output_t* monitor_manager_get_screen_outputs(xcb_window_t root, int* count);
+static void     monitor_manager_discover_outputs(void);
+static void     monitor_manager_discovery_expect(unsigned int sequence, XCBReplyHandler handler, void* userdata);
+static Monitor* monitor_manager_create_for_output(xcb_randr_output_t output);
+static void     monitor_manager_destroy_for_output(xcb_randr_output_t output);
+static void     monitor_manager_update_output_geometry(xcb_randr_output_t output, xcb_randr_crtc_t crtc);
+static void     monitor_manager_update_crtc_geometry(xcb_randr_crtc_t crtc);
+
+/* Reply continuations */
+static void monitor_manager_on_version(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+static void monitor_manager_on_screen_resources(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+static void monitor_manager_on_monitors(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+static void monitor_manager_on_output_info(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+static void monitor_manager_on_discovered_crtc(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+static void monitor_manager_on_crtc_info(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+
+/*
+ * CRTC index - last known configuration of every CRTC.
+ *
+ * Filled by discovery and kept current from CRTC_CHANGE payloads. The
+ * output side of the mapping is Monitor.crtc, kept current from
+ * OUTPUT_CHANGE payloads.
+ */
+typedef struct CrtcEntry {
+  xcb_randr_crtc_t crtc;
+  xcb_randr_mode_t mode; /* XCB_NONE while the CRTC is disabled */
+  int16_t          x;
+  int16_t          y;
+  uint16_t         width;
+  uint16_t         height;
+} CrtcEntry;
+
+static CrtcEntry* crtc_index          = NULL;
+static uint32_t   crtc_index_count    = 0;
+static uint32_t   crtc_index_capacity = 0;
+
+/*
+ * Discovery state. All requests of a stage go out together and the result
+ * is applied once the last reply is in.
+ */
+typedef struct DiscoveredOutput {
+  xcb_randr_output_t output;
+  xcb_randr_crtc_t   crtc;
+  bool               connected;
+} DiscoveredOutput;
+
+static struct {
+  bool              in_flight;
+  bool              again;         /* resources changed while in flight */
+  bool              have_monitors; /* RandR 1.5 monitors were applied */
+  uint32_t          pending;       /* replies still expected */
+  DiscoveredOutput* outputs;
+  uint32_t          output_count;
+} discovery;
+
+/* RandR version negotiated with the server (0.0 until known) */
+static uint32_t randr_major = 0;
+static uint32_t randr_minor = 0;
 
 /*
  * Request types handled by monitor manager (if any)
@@ -96,10 +148,12 @@ monitor_manager_init(void)
 
   /* Register XCB handler for RandR notify events.
    *
-   * RandR events are extension events. The response_type sent by the X
-   * server for RandR events is XCB_RANDR_NOTIFY (value 1).
+   * RandR events are extension events: the server sends them as
+   * first_event + XCB_RANDR_NOTIFY, and the handler registry resolves
+   * first_event at startup.
    */
-  int result = xcb_handler_register(
+  int result = xcb_handler_register_ext(
+      XCB_EXT_RANDR,
       XCB_RANDR_NOTIFY,
       &monitor_manager_component,
       monitor_manager_xcb_handler);
@@ -153,6 +207,16 @@ monitor_manager_shutdown(void)
   /* Unregister from hub */
   hub_unregister_component("monitor-manager");
 
+  /* Replies still in flight find no discovery and are ignored */
+  free(discovery.outputs);
+  memset(&discovery, 0, sizeof(discovery));
+  free(crtc_index);
+  crtc_index          = NULL;
+  crtc_index_count    = 0;
+  crtc_index_capacity = 0;
+  randr_major         = 0;
+  randr_minor         = 0;
+
   LOG_INFO("Monitor manager component shut down");
 }
 
@@ -176,6 +240,65 @@ monitor_manager_executor(struct HubRequest* req)
   LOG_DEBUG("Monitor manager: no handler for request type=%u", req->type);
 }
 
+/*
+ * Set monitor geometry and lay it out again at the end of the batch
+ * if it changed.
+ */
+static void
+monitor_manager_set_geometry(Monitor* m, int16_t x, int16_t y, uint16_t width, uint16_t height)
+{
+  if (m->x == x && m->y == y && m->width == width && m->height == height)
+    return;
+
+  monitor_set_geometry(m, x, y, width, height);
+  hub_schedule_relayout(m->target.id);
+}
+
+/*
+ * Find a CRTC in the index.
+ */
+static CrtcEntry*
+crtc_index_find(xcb_randr_crtc_t crtc)
+{
+  for (uint32_t i = 0; i < crtc_index_count; i++) {
+    if (crtc_index[i].crtc == crtc)
+      return &crtc_index[i];
+  }
+  return NULL;
+}
+
+/*
+ * Record the configuration of a CRTC.
+ */
+static void
+crtc_index_update(xcb_randr_crtc_t crtc, xcb_randr_mode_t mode, int16_t x, int16_t y, uint16_t width, uint16_t height)
+{
+  if (crtc == XCB_NONE)
+    return;
+
+  CrtcEntry* e = crtc_index_find(crtc);
+  if (e == NULL) {
+    if (crtc_index_count == crtc_index_capacity) {
+      uint32_t   capacity = crtc_index_capacity ? crtc_index_capacity * 2 : 8;
+      CrtcEntry* entries  = realloc(crtc_index, capacity * sizeof(CrtcEntry));
+      if (entries == NULL) {
+        LOG_ERROR("Monitor manager: cannot grow CRTC index");
+        return;
+      }
+      crtc_index          = entries;
+      crtc_index_capacity = capacity;
+    }
+    e       = &crtc_index[crtc_index_count++];
+    e->crtc = crtc;
+  }
+
+  e->mode   = mode;
+  e->x      = x;
+  e->y      = y;
+  e->width  = width;
+  e->height = height;
+}
+
 /*
  * Handle a RandR notify event.
  * Called when RandR notifies us of output changes.
@@ -215,13 +338,15 @@ monitor_manager_handle_randr_notify(void* event)
   }
 
   case XCB_RANDR_NOTIFY_CRTC_CHANGE: {
-    /* CRTC configuration changed - update affected output's monitor */
+    /* CRTC configuration changed - the event carries the new geometry */
     xcb_randr_crtc_change_t* cc = &randr_event->u.cc;
     LOG_DEBUG("Monitor manager: CRTC change - crtc=%u, mode=%u, x=%d y=%d %ux%u",
               cc->crtc, cc->mode, cc->x, cc->y, cc->width, cc->height);
 
-    /* Find the output that uses this CRTC and update its geometry */
-    monitor_manager_update_crtc_geometry(cc->crtc, cc->timestamp);
+    crtc_index_update(cc->crtc, cc->mode, cc->x, cc->y, cc->width, cc->height);
+
+    /* Update the monitors of the outputs on this CRTC */
+    monitor_manager_update_crtc_geometry(cc->crtc);
     break;
   }
 
@@ -252,6 +377,15 @@ monitor_manager_handle_randr_notify(void* event)
  * Discover all currently connected outputs via RandR.
  * Creates Monitor targets for each connected output.
  *
+ * Nothing blocks, and requests are pipelined:
+ * 1. version (first time only), screen resources and, on RandR 1.5,
+ *    the monitor list go out together. The monitor list alone is
+ *    enough to create every monitor with its geometry.
+ * 2. The screen resources reply sends the info requests for every output
+ *    and every CRTC at once. Their replies fill the CRTC index and the
+ *    output to CRTC mapping, and create the monitors on servers without
+ *    monitor lists.
+ *
  * Note: This function requires a valid X connection (dpy != NULL)
  * and root window. In test environments without X, this is a no-op.
  */
@@ -272,88 +406,230 @@ monitor_manager_discover_outputs(void)
     return;
   }
 
-  int                 output_count = 0;
-  xcb_randr_output_t* outputs      = monitor_manager_get_screen_outputs(root, &output_count);
-
-  if (outputs == NULL || output_count == 0) {
-    LOG_DEBUG("Monitor manager: No RandR outputs found");
+  /* Start over once the replies of the current pass are in */
+  if (discovery.in_flight) {
+    discovery.again = true;
     return;
   }
 
-  LOG_DEBUG("Monitor manager: Discovering %d RandR outputs", output_count);
+  discovery.in_flight     = true;
+  discovery.again         = false;
+  discovery.have_monitors = false;
+  discovery.pending       = 0;
 
-  for (int i = 0; i < output_count; i++) {
-    xcb_randr_output_t output = outputs[i];
+  /* Negotiate the version first: the server answers requests in order */
+  if (randr_major == 0) {
+    xcb_randr_query_version_cookie_t version = xcb_randr_query_version(dpy, 1, 5);
+    monitor_manager_discovery_expect(version.sequence, monitor_manager_on_version, NULL);
+  }
+
+  /* _current: no hardware probe, just what the server already knows */
+  xcb_randr_get_screen_resources_current_cookie_t resources = xcb_randr_get_screen_resources_current(dpy, root);
+  monitor_manager_discovery_expect(resources.sequence, monitor_manager_on_screen_resources, NULL);
 
-    /* Query output info once - get connection state and CRTC */
-    xcb_randr_get_output_info_cookie_t cookie = xcb_randr_get_output_info(dpy, output, XCB_CURRENT_TIME);
-    xcb_randr_get_output_info_reply_t* reply  = xcb_randr_get_output_info_reply(dpy, cookie, NULL);
+  /* Sent optimistically while the version is unknown; older servers
+   * answer with an error and the CRTC path takes over */
+  if (randr_major == 0 || randr_major > 1 || randr_minor >= 5) {
+    xcb_randr_get_monitors_cookie_t monitors = xcb_randr_get_monitors(dpy, root, 1);
+    monitor_manager_discovery_expect(monitors.sequence, monitor_manager_on_monitors, NULL);
+  }
+
+  /* No reply will ever arrive to finish this pass */
+  if (discovery.pending == 0)
+    discovery.in_flight = false;
+}
 
-    if (reply == NULL) {
+/*
+ * Wait for one more discovery reply. Only a registered continuation
+ * counts: an untracked reply never arrives, and discovery would never
+ * finish waiting for it.
+ */
+static void
+monitor_manager_discovery_expect(unsigned int sequence, XCBReplyHandler handler, void* userdata)
+{
+  if (xcb_reply_register(sequence, TARGET_ID_NONE, handler, userdata))
+    discovery.pending++;
+  else
+    LOG_ERROR("Monitor manager: cannot wait for discovery reply %u", sequence);
+}
+
+/*
+ * Apply what discovery learned: every connected output on a CRTC gets a
+ * monitor, and its CRTC recorded.
+ */
+static void
+monitor_manager_finish_discovery(void)
+{
+  for (uint32_t i = 0; i < discovery.output_count; i++) {
+    DiscoveredOutput* o = &discovery.outputs[i];
+
+    /* Only create monitor for connected outputs with a valid CRTC */
+    if (!o->connected || o->crtc == XCB_NONE)
+      continue;
+
+    Monitor* m = monitor_get_by_output(o->output);
+    if (m == NULL) {
+      m = monitor_manager_create_for_output(o->output);
+      if (m == NULL)
+        continue;
+    } else if (discovery.have_monitors) {
+      /* the monitor list already set the geometry */
+      m->crtc = o->crtc;
       continue;
     }
 
-    /* Only create monitor for connected outputs with a valid CRTC */
-    if (reply->crtc != XCB_NONE && reply->connection == XCB_RANDR_CONNECTION_CONNECTED) {
-      /* Only create if monitor doesn't already exist */
-      if (monitor_get_by_output(output) == NULL) {
-        Monitor* m = monitor_manager_create_for_output(output);
-        if (m != NULL) {
-          monitor_manager_update_output_geometry(output, reply->crtc);
-        }
-      }
+    monitor_manager_update_output_geometry(o->output, o->crtc);
+  }
+
+  free(discovery.outputs);
+  discovery.outputs      = NULL;
+  discovery.output_count = 0;
+  discovery.in_flight    = false;
+
+  LOG_DEBUG("Monitor manager: discovery done, %u CRTCs indexed", crtc_index_count);
+
+  if (discovery.again)
+    monitor_manager_discover_outputs();
+}
+
+/* Account for one discovery reply; applies the result after the last one */
+static void
+monitor_manager_discovery_reply_done(void)
+{
+  if (--discovery.pending == 0)
+    monitor_manager_finish_discovery();
+}
+
+static void
+monitor_manager_on_version(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  if (!discovery.in_flight)
+    return;
+
+  if (reply != NULL) {
+    xcb_randr_query_version_reply_t* version = reply;
+    randr_major                              = version->major_version;
+    randr_minor                              = version->minor_version;
+    LOG_DEBUG("Monitor manager: RandR %u.%u", randr_major, randr_minor);
+  }
+
+  monitor_manager_discovery_reply_done();
+}
+
+/*
+ * Screen resources arrived: query every output and CRTC without waiting
+ * in between.
+ */
+static void
+monitor_manager_on_screen_resources(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  if (!discovery.in_flight)
+    return;
+
+  if (reply != NULL && monitor_manager_component.registered) {
+    xcb_randr_get_screen_resources_current_reply_t* resources = reply;
+
+    xcb_randr_output_t* outputs      = xcb_randr_get_screen_resources_current_outputs(resources);
+    int                 output_count = xcb_randr_get_screen_resources_current_outputs_length(resources);
+    xcb_randr_crtc_t*   crtcs        = xcb_randr_get_screen_resources_current_crtcs(resources);
+    int                 crtc_count   = xcb_randr_get_screen_resources_current_crtcs_length(resources);
+
+    LOG_DEBUG("Monitor manager: Discovering %d RandR outputs on %d CRTCs", output_count, crtc_count);
+
+    if (output_count > 0) {
+      discovery.outputs = calloc((size_t) output_count, sizeof(DiscoveredOutput));
+      if (discovery.outputs == NULL)
+        output_count = 0;
+    }
+    discovery.output_count = (uint32_t) output_count;
+
+    for (int i = 0; i < output_count; i++) {
+      discovery.outputs[i].output = outputs[i];
+
+      xcb_randr_get_output_info_cookie_t cookie = xcb_randr_get_output_info(dpy, outputs[i], resources->config_timestamp);
+      monitor_manager_discovery_expect(cookie.sequence, monitor_manager_on_output_info, (void*) (uintptr_t) i);
     }
 
-    free(reply);
+    for (int i = 0; i < crtc_count; i++) {
+      xcb_randr_get_crtc_info_cookie_t cookie = xcb_randr_get_crtc_info(dpy, crtcs[i], resources->config_timestamp);
+      monitor_manager_discovery_expect(cookie.sequence, monitor_manager_on_discovered_crtc, (void*) (uintptr_t) crtcs[i]);
+    }
   }
 
-  free(outputs);
+  monitor_manager_discovery_reply_done();
 }
 
 /*
- * Get list of outputs for the root window.
- * Returns newly allocated array (caller must free) or NULL on error.
- * Output count is stored in *count.
- *
- * Note: Caller should check dpy != NULL before calling.
+ * RandR 1.5 monitor list: creates the monitors with their geometry right
+ * away. A monitor is keyed by its first output.
  */
-static xcb_randr_output_t*
-monitor_manager_get_screen_outputs(xcb_window_t root, int* count)
+static void
+monitor_manager_on_monitors(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
 {
-  /* Check for valid X connection */
-  if (dpy == NULL) {
-    *count = 0;
-    return NULL;
+  if (!discovery.in_flight)
+    return;
+
+  if (reply != NULL && monitor_manager_component.registered) {
+    xcb_randr_monitor_info_iterator_t it = xcb_randr_get_monitors_monitors_iterator(reply);
+
+    for (; it.rem > 0; xcb_randr_monitor_info_next(&it)) {
+      xcb_randr_monitor_info_t* info = it.data;
+      if (xcb_randr_monitor_info_outputs_length(info) == 0)
+        continue;
+
+      xcb_randr_output_t output = xcb_randr_monitor_info_outputs(info)[0];
+      Monitor*           m      = monitor_get_by_output(output);
+      if (m == NULL)
+        m = monitor_manager_create_for_output(output);
+      if (m == NULL)
+        continue;
+
+      monitor_manager_set_geometry(m, info->x, info->y, info->width, info->height);
+    }
+    discovery.have_monitors = true;
+  } else if (error != NULL) {
+    LOG_DEBUG("Monitor manager: no RandR monitor list, using CRTCs");
   }
 
-  xcb_randr_get_screen_resources_cookie_t cookie = xcb_randr_get_screen_resources(dpy, root);
-  xcb_randr_get_screen_resources_reply_t* reply  = xcb_randr_get_screen_resources_reply(dpy, cookie, NULL);
+  monitor_manager_discovery_reply_done();
+}
 
-  if (reply == NULL) {
-    *count = 0;
-    return NULL;
+/*
+ * Output info arrived during discovery (userdata carries its index).
+ */
+static void
+monitor_manager_on_output_info(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  if (!discovery.in_flight)
+    return;
+
+  uint32_t                           index = (uint32_t) (uintptr_t) userdata;
+  xcb_randr_get_output_info_reply_t* info  = reply;
+
+  if (info != NULL && index < discovery.output_count) {
+    discovery.outputs[index].crtc      = info->crtc;
+    discovery.outputs[index].connected = info->connection == XCB_RANDR_CONNECTION_CONNECTED;
   }
 
-  xcb_randr_output_t* outputs     = NULL;
-  int                 outputs_len = 0;
+  monitor_manager_discovery_reply_done();
+}
 
-  /* Get the outputs array from the reply */
-  xcb_randr_output_t* reply_outputs     = xcb_randr_get_screen_resources_outputs(reply);
-  int                 reply_outputs_len = xcb_randr_get_screen_resources_outputs_length(reply);
+/*
+ * CRTC info arrived during discovery (userdata carries the CRTC).
+ */
+static void
+monitor_manager_on_discovered_crtc(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  if (!discovery.in_flight)
+    return;
 
-  if (reply_outputs_len > 0) {
-    outputs_len = reply_outputs_len;
-    outputs     = malloc((size_t) outputs_len * sizeof(xcb_randr_output_t));
-    if (outputs != NULL) {
-      memcpy(outputs, reply_outputs, (size_t) outputs_len * sizeof(xcb_randr_output_t));
-    } else {
-      outputs_len = 0;
-    }
+  xcb_randr_get_crtc_info_reply_t* info = reply;
+  if (info != NULL) {
+    crtc_index_update((xcb_randr_crtc_t) (uintptr_t) userdata,
+                      info->mode, info->x, info->y, info->width, info->height);
   }
 
-  free(reply);
-  *count = outputs_len;
-  return outputs;
+  monitor_manager_discovery_reply_done();
 }
 
 /*
@@ -410,7 +686,9 @@ monitor_manager_destroy_for_output(xcb_randr_output_t output)
 
 /*
  * Update monitor geometry based on CRTC assignment.
- * Finds the monitor for the given output and updates its geometry.
+ * Finds the monitor for the given output and records the CRTC. The
+ * geometry comes from the CRTC index; only a CRTC never seen before
+ * costs a request.
  */
 static void
 monitor_manager_update_output_geometry(xcb_randr_output_t output, xcb_randr_crtc_t crtc)
@@ -423,149 +701,80 @@ monitor_manager_update_output_geometry(xcb_randr_output_t output, xcb_randr_crtc
   /* Update the stored CRTC */
   m->crtc = crtc;
 
-  /* Get CRTC geometry */
-  int16_t          x      = 0;
-  int16_t          y      = 0;
-  uint16_t         width  = 0;
-  uint16_t         height = 0;
-  xcb_randr_mode_t mode   = 0;
-
-  if (monitor_manager_get_crtc_info(crtc, &x, &y, &width, &height, &mode)) {
-    monitor_set_geometry(m, x, y, width, height);
-    LOG_DEBUG("Monitor manager: Updated output %u geometry to %ux%u+%d+%d",
-              output, (unsigned int) width, (unsigned int) height, x, y);
-  }
-}
-
-/*
- * Update monitor geometry for all outputs using a specific CRTC.
- * Called when CRTC configuration changes.
- *
- * Note: Requires valid X connection (dpy != NULL).
- */
-static void
-monitor_manager_update_crtc_geometry(xcb_randr_crtc_t crtc, xcb_timestamp_t timestamp)
-{
-  /* Check for valid X connection */
-  if (dpy == NULL) {
+  if (crtc == XCB_NONE) {
     return;
   }
 
-  extern xcb_window_t root;
-
-  /* Find the output that uses this CRTC */
-  int                 output_count = 0;
-  xcb_randr_output_t* outputs      = monitor_manager_get_screen_outputs(root, &output_count);
-
-  if (outputs == NULL) {
+  CrtcEntry* e = crtc_index_find(crtc);
+  if (e != NULL) {
+    if (e->mode != XCB_NONE) {
+      monitor_manager_set_geometry(m, e->x, e->y, e->width, e->height);
+      LOG_DEBUG("Monitor manager: Updated output %u geometry to %ux%u+%d+%d",
+                output, (unsigned int) e->width, (unsigned int) e->height, e->x, e->y);
+    }
     return;
   }
 
-  for (int i = 0; i < output_count; i++) {
-    xcb_randr_get_output_info_cookie_t cookie = xcb_randr_get_output_info(dpy, outputs[i], timestamp);
-    xcb_randr_get_output_info_reply_t* reply  = xcb_randr_get_output_info_reply(dpy, cookie, NULL);
-
-    if (reply != NULL && reply->crtc == crtc) {
-      Monitor* m = monitor_get_by_output(outputs[i]);
-      if (m != NULL) {
-        monitor_manager_update_output_geometry(outputs[i], crtc);
-      }
-    }
-
-    free(reply);
+  /* Check for valid X connection */
+  if (dpy == NULL) {
+    return;
   }
 
-  free(outputs);
+  /* Dropped automatically if the monitor goes away before the reply */
+  xcb_randr_get_crtc_info_cookie_t cookie = xcb_randr_get_crtc_info(dpy, crtc, XCB_CURRENT_TIME);
+  xcb_reply_register(cookie.sequence, m->target.id, monitor_manager_on_crtc_info, (void*) (uintptr_t) crtc);
 }
 
 /*
- * Get information about a RandR output.
- * Fills crtc_out with the current CRTC and optionally name_out with the output name.
- * Returns true on success, false on failure.
- *
- * Note: Caller should check dpy != NULL before calling.
+ * CRTC info arrived for a monitor (userdata carries the CRTC queried).
  */
-static bool
-monitor_manager_get_output_info(xcb_randr_output_t output, xcb_randr_crtc_t* crtc_out, char** name_out)
+static void
+monitor_manager_on_crtc_info(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
 {
-  /* Check for valid X connection */
-  if (dpy == NULL) {
-    return false;
-  }
-
-  xcb_randr_get_output_info_cookie_t cookie = xcb_randr_get_output_info(dpy, output, XCB_CURRENT_TIME);
-  xcb_randr_get_output_info_reply_t* reply  = xcb_randr_get_output_info_reply(dpy, cookie, NULL);
+  xcb_randr_crtc_t                 crtc = (xcb_randr_crtc_t) (uintptr_t) userdata;
+  xcb_randr_get_crtc_info_reply_t* info = reply;
 
-  if (reply == NULL) {
-    return false;
+  if (info == NULL) {
+    return;
   }
 
-  if (crtc_out != NULL) {
-    *crtc_out = reply->crtc;
-  }
+  crtc_index_update(crtc, info->mode, info->x, info->y, info->width, info->height);
 
-  if (name_out != NULL) {
-    int   name_len = xcb_randr_get_output_info_name_length(reply);
-    char* name     = malloc((size_t) name_len + 1);
-    if (name != NULL) {
-      memcpy(name, xcb_randr_get_output_info_name(reply), (size_t) name_len);
-      name[name_len] = '\0';
-      *name_out      = name;
-    }
+  /* The output moved to another CRTC while the request was in flight */
+  Monitor* m = (Monitor*) hub_get_target_by_id(target);
+  if (m == NULL || m->crtc != crtc) {
+    return;
   }
 
-  free(reply);
-  return true;
+  monitor_manager_update_output_geometry(m->output, crtc);
 }
 
 /*
- * Get information about a RandR CRTC.
- * Fills x, y, width, height, mode with CRTC configuration.
- * Returns true on success, false on failure.
- *
- * Note: Caller should check dpy != NULL and crtc != XCB_NONE before calling.
+ * Update monitor geometry for all outputs using a specific CRTC.
+ * Called when CRTC configuration changes, after the index was updated
+ * from the event.
  */
-static bool
-monitor_manager_get_crtc_info(xcb_randr_crtc_t crtc, int16_t* x, int16_t* y,
-                              uint16_t* width, uint16_t* height, xcb_randr_mode_t* mode)
+static void
+monitor_manager_update_crtc_geometry(xcb_randr_crtc_t crtc)
 {
-  /* Check for valid X connection */
-  if (dpy == NULL) {
-    return false;
-  }
-
   if (crtc == XCB_NONE) {
-    return false;
+    return;
   }
 
-  xcb_randr_get_crtc_info_cookie_t cookie = xcb_randr_get_crtc_info(dpy, crtc, XCB_CURRENT_TIME);
-  xcb_randr_get_crtc_info_reply_t* reply  = xcb_randr_get_crtc_info_reply(dpy, cookie, NULL);
-
-  if (reply == NULL) {
-    return false;
+  for (Monitor* m = monitor_list_get_first(); m != NULL; m = monitor_list_get_next(m)) {
+    if (m->crtc == crtc) {
+      monitor_manager_update_output_geometry(m->output, crtc);
+    }
   }
-
-  if (x != NULL)
-    *x = reply->x;
-  if (y != NULL)
-    *y = reply->y;
-  if (width != NULL)
-    *width = reply->width;
-  if (height != NULL)
-    *height = reply->height;
-  if (mode != NULL)
-    *mode = reply->mode;
-
-  free(reply);
-  return true;
 }
 
 /*
  * Internal XCB handler dispatcher wrapper.
  * Called by xcb_handler_dispatch() for RandR events.
  */
-static void
+static XCBHandlerResult
 monitor_manager_xcb_handler(void* event)
 {
   monitor_manager_handle_randr_notify(event);
+  return XCB_HANDLER_CONTINUE;
 }
\ No newline at end of file
@@ -18,9 +18,9 @@
 #include "wm-log.h"
 
 /*
- * Name used to store Pertag data in monitor's SM storage
+ * Name atom used to store Pertag data in monitor's SM storage
  */
-#define PERTAG_SM_NAME "pertag"
+#define PERTAG_SM_ATOM NAME_ATOM_PERTAG
 
 /*
  * Pertag component - registered with hub for adoption
@@ -117,7 +117,7 @@ pertag_init_internal(Pertag* pt, struct Monitor* m)
 void
 pertag_on_adopt(HubTarget* target)
 {
-  if (target == NULL || target->type_id != hub_get_target_type_id_by_name("monitor")) {
+  if (target == NULL || target->type_id != hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR)) {
     LOG_ERROR("pertag_on_adopt: invalid target");
     return;
   }
@@ -141,7 +141,7 @@ pertag_on_adopt(HubTarget* target)
   pertag_init_internal(pt, m);
 
   /* Store in monitor's SM storage */
-  if (!monitor_set_sm(m, PERTAG_SM_NAME, (StateMachine*) pt)) {
+  if (!monitor_set_sm_atom(m, PERTAG_SM_ATOM, (StateMachine*) pt)) {
     LOG_ERROR("Failed to store Pertag in monitor SM storage");
     free(pt);
     return;
@@ -157,7 +157,7 @@ pertag_on_adopt(HubTarget* target)
 void
 pertag_on_unadopt(HubTarget* target)
 {
-  if (target == NULL || target->type_id != hub_get_target_type_id_by_name("monitor"))
+  if (target == NULL || target->type_id != hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR))
     return;
 
   Monitor* m  = (Monitor*) target;
@@ -167,7 +167,7 @@ pertag_on_unadopt(HubTarget* target)
     return;
 
   /* Clear from monitor's SM storage (this destroys the "SM") */
-  monitor_set_sm(m, PERTAG_SM_NAME, NULL);
+  monitor_set_sm_atom(m, PERTAG_SM_ATOM, NULL);
 
   /* Free Pertag data */
   free(pt);
@@ -185,7 +185,7 @@ pertag_get_data(const struct Monitor* monitor)
     return NULL;
 
   /* Look up in monitor's SM storage by name */
-  StateMachine* sm = monitor_get_sm((Monitor*) monitor, PERTAG_SM_NAME);
+  StateMachine* sm = monitor_get_sm_atom((Monitor*) monitor, PERTAG_SM_ATOM);
   if (sm == NULL)
     return NULL;
 
@@ -0,0 +1,307 @@
+/*
+ * State Snapshot Implementation
+ *
+ * Publishing builds a whole snapshot in one allocation, then swaps the
+ * current pointer. The replaced snapshot is retired with the epoch it was
+ * replaced in and freed by a later publish, once every reader slot is idle
+ * or announces a newer epoch.
+ */
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/components/focus.h"
+#include "src/components/fullscreen.h"
+#include "src/components/tiling.h"
+#include "src/target/client.h"
+#include "src/target/monitor.h"
+#include "src/target/tag.h"
+#include "state-snapshot.h"
+#include "wm-log.h"
+
+/*
+ * Reader slot: epoch is the global epoch the reader entered in, 0 while
+ * the reader holds no snapshot. Padded so readers never share a line.
+ */
+typedef struct reader_slot_t {
+  alignas(64) atomic_bool claimed;
+  atomic_uint_fast64_t epoch;
+} reader_slot_t;
+
+static reader_slot_t          readers[SNAPSHOT_MAX_READERS];
+static _Atomic(WmSnapshot*)   current_snapshot = NULL;
+static atomic_uint_fast64_t   global_epoch     = 1;
+static _Thread_local int      reader_index     = -1;
+static _Thread_local uint32_t reader_depth     = 0;
+
+/* Replaced snapshots, event loop thread only */
+typedef struct retired_snapshot_t {
+  WmSnapshot* snapshot;
+  uint64_t    epoch; /* global epoch when it was replaced */
+} retired_snapshot_t;
+
+static retired_snapshot_t* retired          = NULL;
+static uint32_t            retired_count    = 0;
+static uint32_t            retired_capacity = 0;
+static uint64_t            sequence         = 0;
+static SnapshotStats       stats;
+
+/* Copy a string into the snapshot's string area */
+static const char*
+copy_string(char** strings, const char* s)
+{
+  if (s == NULL)
+    return NULL;
+
+  size_t len = strlen(s) + 1;
+  char*  out = *strings;
+  memcpy(out, s, len);
+  *strings += len;
+  return out;
+}
+
+static size_t
+string_size(const char* s)
+{
+  return s != NULL ? strlen(s) + 1 : 0;
+}
+
+/*
+ * Copy the current state into one block: the header, then the client,
+ * monitor and tag arrays, then the strings they point at.
+ */
+static WmSnapshot*
+snapshot_build(void)
+{
+  uint32_t client_count  = 0;
+  uint32_t monitor_count = 0;
+  uint32_t tag_count     = 0;
+  size_t   strings_size  = 0;
+
+  for (Client* c = client_list_get_head(); c != NULL; c = client_get_next(c)) {
+    client_count++;
+    strings_size += string_size(c->title) + string_size(c->class_name);
+  }
+  for (Monitor* m = monitor_list_get_first(); m != NULL; m = monitor_list_get_next(m))
+    monitor_count++;
+  for (Tag* t = tag_list_get_first(); t != NULL; t = tag_list_get_next(t)) {
+    tag_count++;
+    strings_size += string_size(t->name);
+  }
+
+  size_t size = sizeof(WmSnapshot)
+                + client_count * sizeof(WmSnapshotClient)
+                + monitor_count * sizeof(WmSnapshotMonitor)
+                + tag_count * sizeof(WmSnapshotTag)
+                + strings_size;
+
+  WmSnapshot* s = malloc(size);
+  if (s == NULL) {
+    LOG_ERROR("snapshot: cannot allocate %zu bytes", size);
+    return NULL;
+  }
+
+  WmSnapshotClient*  clients  = (WmSnapshotClient*) (s + 1);
+  WmSnapshotMonitor* monitors = (WmSnapshotMonitor*) (clients + client_count);
+  WmSnapshotTag*     tags     = (WmSnapshotTag*) (monitors + monitor_count);
+  char*              strings  = (char*) (tags + tag_count);
+
+  Client*  focused  = focus_get_focused_client();
+  Monitor* selected = monitor_get_selected();
+
+  *s = (WmSnapshot) {
+    .focused_client   = focused != NULL ? focused->target.id : TARGET_ID_NONE,
+    .selected_monitor = selected != NULL ? selected->target.id : TARGET_ID_NONE,
+    .client_count     = client_count,
+    .monitor_count    = monitor_count,
+    .tag_count        = tag_count,
+    .clients          = clients,
+    .monitors         = monitors,
+    .tags             = tags,
+  };
+
+  WmSnapshotClient* sc = clients;
+  for (Client* c = client_list_get_head(); c != NULL; c = client_get_next(c)) {
+    *sc++ = (WmSnapshotClient) {
+      .id         = c->target.id,
+      .window     = c->window,
+      .monitor    = c->monitor != NULL ? c->monitor->target.id : TARGET_ID_NONE,
+      .tags       = c->tags,
+      .x          = c->x,
+      .y          = c->y,
+      .width      = c->width,
+      .height     = c->height,
+      .managed    = c->managed,
+      .mapped     = c->mapped,
+      .urgent     = c->urgent,
+      .focused    = c == focused,
+      .fullscreen = fullscreen_is_fullscreen(c),
+      .title      = copy_string(&strings, c->title),
+      .class_name = copy_string(&strings, c->class_name),
+    };
+  }
+
+  WmSnapshotMonitor* sm = monitors;
+  for (Monitor* m = monitor_list_get_first(); m != NULL; m = monitor_list_get_next(m)) {
+    *sm++ = (WmSnapshotMonitor) {
+      .id       = m->target.id,
+      .x        = m->x,
+      .y        = m->y,
+      .width    = m->width,
+      .height   = m->height,
+      .tagset   = m->tagset,
+      .layout   = tiling_get_state(m),
+      .selected = m == selected,
+    };
+  }
+
+  WmSnapshotTag* st = tags;
+  for (Tag* t = tag_list_get_first(); t != NULL; t = tag_list_get_next(t)) {
+    *st++ = (WmSnapshotTag) {
+      .id    = t->target.id,
+      .index = t->index,
+      .mask  = t->mask,
+      .name  = copy_string(&strings, t->name),
+    };
+  }
+
+  return s;
+}
+
+/*
+ * Free the retired snapshots that no reader can hold: a reader that loaded
+ * one entered in an epoch no newer than the one it was replaced in.
+ */
+static void
+snapshot_reclaim(void)
+{
+  uint64_t oldest = UINT64_MAX;
+  for (uint32_t i = 0; i < SNAPSHOT_MAX_READERS; i++) {
+    uint64_t epoch = atomic_load(&readers[i].epoch);
+    if (epoch != 0 && epoch < oldest)
+      oldest = epoch;
+  }
+
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < retired_count; i++) {
+    if (retired[i].epoch < oldest) {
+      free(retired[i].snapshot);
+      stats.reclaimed++;
+    } else {
+      retired[kept++] = retired[i];
+    }
+  }
+  retired_count = kept;
+}
+
+void
+snapshot_publish(void)
+{
+  /* Room to retire the current snapshot, so the swap cannot fail */
+  if (retired_count == retired_capacity) {
+    uint32_t            new_capacity = retired_capacity ? retired_capacity * 2 : 8;
+    retired_snapshot_t* grown        = realloc(retired, new_capacity * sizeof(*retired));
+    if (grown == NULL) {
+      LOG_ERROR("snapshot: cannot grow the retired list to %u", new_capacity);
+      return;
+    }
+    retired          = grown;
+    retired_capacity = new_capacity;
+  }
+
+  WmSnapshot* next = snapshot_build();
+  if (next == NULL)
+    return;
+  next->sequence = ++sequence;
+
+  WmSnapshot* old = atomic_exchange(&current_snapshot, next);
+  stats.published++;
+
+  if (old != NULL)
+    retired[retired_count++] = (retired_snapshot_t) { .snapshot = old, .epoch = atomic_load(&global_epoch) };
+  atomic_fetch_add(&global_epoch, 1);
+
+  snapshot_reclaim();
+}
+
+void
+snapshot_shutdown(void)
+{
+  free(atomic_exchange(&current_snapshot, NULL));
+  for (uint32_t i = 0; i < retired_count; i++)
+    free(retired[i].snapshot);
+  free(retired);
+  retired          = NULL;
+  retired_count    = 0;
+  retired_capacity = 0;
+  sequence         = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+/* Claim a reader slot for the calling thread */
+static bool
+reader_claim(void)
+{
+  for (int i = 0; i < SNAPSHOT_MAX_READERS; i++) {
+    bool expected = false;
+    if (atomic_compare_exchange_strong(&readers[i].claimed, &expected, true)) {
+      reader_index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const WmSnapshot*
+snapshot_acquire(void)
+{
+  /* Nested: the epoch announced by the outer call protects this one too */
+  if (reader_depth > 0) {
+    reader_depth++;
+    return atomic_load(&current_snapshot);
+  }
+
+  if (reader_index < 0 && !reader_claim()) {
+    LOG_ERROR("snapshot: all %d reader slots are taken", SNAPSHOT_MAX_READERS);
+    return NULL;
+  }
+
+  reader_depth = 1;
+
+  /* Announce before loading, so a publish that misses us swapped first */
+  atomic_store(&readers[reader_index].epoch, atomic_load(&global_epoch));
+  return atomic_load(&current_snapshot);
+}
+
+void
+snapshot_release(const WmSnapshot* snapshot)
+{
+  (void) snapshot;
+
+  /* acquire found no free slot */
+  if (reader_depth == 0)
+    return;
+
+  if (--reader_depth == 0)
+    atomic_store(&readers[reader_index].epoch, 0);
+}
+
+void
+snapshot_reader_exit(void)
+{
+  if (reader_index < 0 || reader_depth > 0)
+    return;
+
+  atomic_store(&readers[reader_index].claimed, false);
+  reader_index = -1;
+}
+
+SnapshotStats
+snapshot_get_stats(void)
+{
+  SnapshotStats s = stats;
+  s.retired       = retired_count;
+  return s;
+}
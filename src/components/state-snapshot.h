@@ -0,0 +1,122 @@
+/*
+ * State Snapshot
+ *
+ * Read-only copy of window manager state for threads other than the event
+ * loop. The hub, the client and monitor lists and the components' state
+ * machines are plain data owned by the event loop thread; nothing else may
+ * touch them. Instead, the loop calls snapshot_publish() once per
+ * iteration, which copies clients, monitors, tags, focus and layout into
+ * one immutable block and swaps it in with an atomic pointer store.
+ *
+ * Any thread can then read state without locks:
+ *
+ *   const WmSnapshot* s = snapshot_acquire();
+ *   if (s != NULL) {
+ *     ... read s, including its strings ...
+ *   }
+ *   snapshot_release(s);
+ *
+ * Reclamation is epoch based. A reader announces the epoch it entered in a
+ * slot of its own; a replaced snapshot is freed by a later publish once no
+ * reader is still in an epoch older than its replacement. Publishing never
+ * waits: a reader holding a snapshot only delays freeing old ones.
+ */
+
+#ifndef _COMPONENT_STATE_SNAPSHOT_H_
+#define _COMPONENT_STATE_SNAPSHOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "wm-hub.h"
+
+/*
+ * Reader slots, one per thread that calls snapshot_acquire()
+ */
+#define SNAPSHOT_MAX_READERS 64
+
+typedef struct WmSnapshotClient {
+  TargetID     id;
+  xcb_window_t window;
+  TargetID     monitor; /* TARGET_ID_NONE if not on a monitor */
+  uint32_t     tags;
+  int16_t      x;
+  int16_t      y;
+  uint16_t     width;
+  uint16_t     height;
+  bool         managed;
+  bool         mapped;
+  bool         urgent;
+  bool         focused;
+  bool         fullscreen;
+  const char*  title;      /* NULL if unknown */
+  const char*  class_name; /* NULL if unknown */
+} WmSnapshotClient;
+
+typedef struct WmSnapshotMonitor {
+  TargetID id;
+  int16_t  x;
+  int16_t  y;
+  uint16_t width;
+  uint16_t height;
+  uint32_t tagset; /* visible tags */
+  uint32_t layout; /* LayoutState */
+  bool     selected;
+} WmSnapshotMonitor;
+
+typedef struct WmSnapshotTag {
+  TargetID    id;
+  int         index;
+  uint32_t    mask;
+  const char* name; /* NULL for the default name */
+} WmSnapshotTag;
+
+/*
+ * One published state. Everything it points at, strings included, lives
+ * in the same block and stays valid until snapshot_release().
+ */
+typedef struct WmSnapshot {
+  uint64_t                 sequence; /* 1 for the first publish, then +1 */
+  TargetID                 focused_client;
+  TargetID                 selected_monitor;
+  uint32_t                 client_count;
+  uint32_t                 monitor_count;
+  uint32_t                 tag_count;
+  const WmSnapshotClient*  clients; /* in client list order */
+  const WmSnapshotMonitor* monitors;
+  const WmSnapshotTag*     tags;
+} WmSnapshot;
+
+typedef struct SnapshotStats {
+  uint64_t published; /* snapshots made current */
+  uint64_t reclaimed; /* replaced snapshots freed */
+  uint32_t retired;   /* replaced snapshots a reader may still hold */
+} SnapshotStats;
+
+/*
+ * Publish the current state (event loop thread only). Also frees the
+ * replaced snapshots no reader can hold any more.
+ */
+void snapshot_publish(void);
+
+/*
+ * Free every snapshot (event loop thread only). No reader may hold one.
+ */
+void snapshot_shutdown(void);
+
+/*
+ * Current snapshot, or NULL if none is published or all reader slots are
+ * taken. Any thread; calls nest. Pair every call with snapshot_release().
+ */
+const WmSnapshot* snapshot_acquire(void);
+void              snapshot_release(const WmSnapshot* snapshot);
+
+/*
+ * Give up the calling thread's reader slot, e.g. before the thread exits.
+ */
+void snapshot_reader_exit(void);
+
+SnapshotStats snapshot_get_stats(void);
+
+#endif /* _COMPONENT_STATE_SNAPSHOT_H_ */
@@ -6,6 +6,7 @@
  * - Uses TagViewSM to track visible tag bitmask
  * - On tag change: shows/hides clients based on tag membership
  * - Emits EVT_TAG_CHANGED event
+ * - Batch executor toggles a tag on many clients with one re-tile per monitor
  */
 
 #include <stdlib.h>
@@ -22,9 +23,10 @@
 #include "wm-log.h"
 
 /*
- * Tag Manager SM template name
+ * Tag Manager SM template name, and its atom in monitor SM storage
  */
 #define TAG_VIEW_SM_NAME "tag-view"
+#define TAG_VIEW_SM_ATOM NAME_ATOM_TAG_VIEW
 
 /*
  * Tag Manager SM states
@@ -134,8 +136,8 @@ tag_view_sm_emit(StateMachine* sm, uint32_t from_state, uint32_t to_state, void*
   tag_manager_test_events.old_mask             = from_state == TAG_VIEW_EMPTY ? 0 : TAG_ALL_TAGS;
   tag_manager_test_events.new_mask             = new_mask;
 
-  /* Emit the event */
-  hub_emit(EVT_TAG_CHANGED, m->target.id, &new_mask);
+  /* Queue the event; the mask lives in the SM, so it outlives the queue */
+  hub_post(EVT_TAG_CHANGED, m->target.id, tag_mask_ptr);
 
   /* Update visibility for all clients on this monitor */
   tag_manager_update_visibility(m);
@@ -228,7 +230,7 @@ tag_manager_get_view_sm(Monitor* m)
   if (m == NULL)
     return NULL;
 
-  StateMachine* sm = monitor_get_sm(m, TAG_VIEW_SM_NAME);
+  StateMachine* sm = monitor_get_sm_atom(m, TAG_VIEW_SM_ATOM);
   if (sm != NULL)
     return sm;
 
@@ -261,7 +263,7 @@ tag_manager_get_view_sm(Monitor* m)
   sm->data = tag_mask;
 
   /* Store in monitor */
-  if (!monitor_set_sm(m, TAG_VIEW_SM_NAME, sm)) {
+  if (!monitor_set_sm_atom(m, TAG_VIEW_SM_ATOM, sm)) {
     LOG_ERROR("Failed to store tag-view SM in monitor");
     sm_destroy(sm);
     return NULL;
@@ -283,7 +285,7 @@ tag_manager_get_visible_tags(Monitor* m)
   if (m == NULL)
     return 0;
 
-  StateMachine* sm = monitor_get_sm(m, TAG_VIEW_SM_NAME);
+  StateMachine* sm = monitor_get_sm_atom(m, TAG_VIEW_SM_ATOM);
   if (sm == NULL || sm->data == NULL)
     return 0;
 
@@ -313,11 +315,12 @@ tag_manager_set_visible_tags(Monitor* m, uint32_t tag_mask)
     return;
   }
 
-  /* Update the mask */
+  /* Update the mask, and the monitor's copy read by snapshots and IPC */
   *current_mask = tag_mask;
+  monitor_set_tagset(m, tag_mask);
 
-  /* Emit event */
-  hub_emit(EVT_TAG_CHANGED, m->target.id, &tag_mask);
+  /* Queue event */
+  hub_post(EVT_TAG_CHANGED, m->target.id, current_mask);
 
   /* Update visibility */
   tag_manager_update_visibility(m);
@@ -380,6 +383,9 @@ tag_manager_update_visibility(Monitor* m)
     }
     c = client_get_next(c);
   }
+
+  /* The set of visible clients changed: re-tile once at the end of the batch */
+  hub_schedule_relayout(m->target.id);
 }
 
 /*
@@ -401,7 +407,7 @@ tag_manager_handle_view_request(RequestType type, TargetID target, void* data)
   }
 
   HubTarget* t = hub_get_target_by_id(target);
-  if (t == NULL || t->type_id != hub_get_target_type_id_by_name("monitor")) {
+  if (t == NULL || t->type_id != hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR)) {
     LOG_DEBUG("Tag view: invalid target");
     return;
   }
@@ -445,7 +451,7 @@ tag_manager_handle_toggle_request(RequestType type, TargetID target, void* data)
   }
 
   HubTarget* t = hub_get_target_by_id(target);
-  if (t == NULL || t->type_id != hub_get_target_type_id_by_name("monitor")) {
+  if (t == NULL || t->type_id != hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR)) {
     LOG_DEBUG("Tag toggle: invalid target");
     return;
   }
@@ -547,8 +553,8 @@ tag_manager_handle_client_tag_toggle(RequestType type, TargetID target, void* da
     }
   }
 
-  /* Emit client tag changed event */
-  hub_emit(EVT_TAG_CHANGED, c->target.id, NULL);
+  /* Queue client tag changed event */
+  hub_post(EVT_TAG_CHANGED, c->target.id, NULL);
 }
 
 /*
@@ -569,7 +575,7 @@ tag_manager_listener(Event e)
 void
 tag_manager_on_adopt(HubTarget* target)
 {
-  if (target == NULL || target->type_id != hub_get_target_type_id_by_name("monitor")) {
+  if (target == NULL || target->type_id != hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR)) {
     return;
   }
 
@@ -597,21 +603,21 @@ tag_manager_on_adopt(HubTarget* target)
 void
 tag_manager_on_unadopt(HubTarget* target)
 {
-  if (target == NULL || target->type_id != hub_get_target_type_id_by_name("monitor")) {
+  if (target == NULL || target->type_id != hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR)) {
     return;
   }
 
   Monitor* m = (Monitor*) target;
 
   /* Get the SM and free its data */
-  StateMachine* sm = monitor_get_sm(m, TAG_VIEW_SM_NAME);
+  StateMachine* sm = monitor_get_sm_atom(m, TAG_VIEW_SM_ATOM);
   if (sm != NULL && sm->data != NULL) {
     free(sm->data);
     sm->data = NULL;
   }
 
   /* Clear from monitor */
-  monitor_set_sm(m, TAG_VIEW_SM_NAME, NULL);
+  monitor_set_sm_atom(m, TAG_VIEW_SM_ATOM, NULL);
 
   LOG_DEBUG("Tag manager unadopted by monitor: %lu", (unsigned long) target->id);
 }
@@ -637,10 +643,68 @@ tag_manager_executor(struct HubRequest* req)
     break;
   default:
     LOG_DEBUG("Tag manager: unhandled request type %u", req->type);
+    req->failed = true;
     break;
   }
 }
 
+/*
+ * Batch executor
+ *
+ * REQ_TAG_CLIENT_TOGGLE on a selection of clients toggles the tag on each
+ * of them, then shows, hides and re-tiles each affected monitor once.
+ * Other request types run target by target.
+ */
+static void
+tag_manager_batch_executor(struct HubRequestBatch* batch)
+{
+  if (batch == NULL)
+    return;
+
+  if (batch->type != REQ_TAG_CLIENT_TOGGLE) {
+    for (uint32_t i = 0; i < batch->count; i++) {
+      struct HubRequest req = {
+        .type   = batch->type,
+        .target = batch->targets[i],
+        .data   = batch->data,
+      };
+      tag_manager_executor(&req);
+    }
+    return;
+  }
+
+  uint32_t tag_index = batch->data != NULL ? *(uint32_t*) batch->data : 0;
+  if (tag_index < 1 || tag_index > TAG_NUM_TAGS) {
+    LOG_DEBUG("Tag client toggle batch: invalid tag index %u", tag_index);
+    return;
+  }
+  uint32_t tag_mask = TAG_MASK(tag_index - 1);
+
+  uint32_t client_type = hub_get_target_type_id_by_atom(NAME_ATOM_CLIENT);
+  for (uint32_t i = 0; i < batch->count; i++) {
+    HubTarget* t = hub_get_target_by_id(batch->targets[i]);
+    if (t == NULL || t->type_id != client_type)
+      continue;
+
+    Client* c = (Client*) t;
+    c->tags ^= tag_mask;
+    hub_post(EVT_TAG_CHANGED, c->target.id, NULL);
+  }
+
+  /* Visibility and layout once per monitor holding a toggled client */
+  HubTarget** monitors = hub_get_targets_by_type(hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR));
+  for (; monitors != NULL && *monitors != NULL; monitors++) {
+    Monitor* m = (Monitor*) *monitors;
+    for (uint32_t i = 0; i < batch->count; i++) {
+      HubTarget* t = hub_get_target_by_id(batch->targets[i]);
+      if (t != NULL && t->type_id == client_type && ((Client*) t)->monitor == m) {
+        tag_manager_update_visibility(m);
+        break;
+      }
+    }
+  }
+}
+
 /*
  * Component initialization
  */
@@ -667,8 +731,9 @@ tag_manager_component_init(void)
 
   LOG_DEBUG("Initializing tag manager component");
 
-  /* Set the executor */
-  tag_manager_component()->executor = tag_manager_executor;
+  /* Set the executors */
+  tag_manager_component()->executor       = tag_manager_executor;
+  tag_manager_component()->batch_executor = tag_manager_batch_executor;
 
   /* Register with hub */
   hub_register_component(tag_manager_component());
@@ -676,6 +741,9 @@ tag_manager_component_init(void)
   /* Subscribe to events we care about */
   hub_subscribe(EVT_TAG_CHANGED, tag_manager_listener, NULL);
 
+  /* Several view changes of one target in a delivery reach listeners once */
+  hub_set_event_coalescing(EVT_TAG_CHANGED, true);
+
   /* Cache the template */
   cached_tag_view_template = tag_view_sm_template_create();
 
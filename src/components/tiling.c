@@ -6,7 +6,8 @@
  *
  * The component provides:
  * - Tiled layout for window arrangement
- * - Executor that handles REQ_MONITOR_TILE requests
+ * - Executor that handles REQ_MONITOR_TILE requests by scheduling a
+ *   deferred relayout, executed once per monitor at the end of the batch
  * - Tiling algorithm that divides monitor into master and stack
  * - XCB ConfigureRequest to position windows
  */
@@ -110,7 +111,7 @@ tiling_sm_emit(StateMachine* sm, uint32_t from_state, uint32_t to_state, void* u
   if (m == NULL)
     return;
 
-  hub_emit(EVT_LAYOUT_CHANGED, m->target.id, NULL);
+  hub_post(EVT_LAYOUT_CHANGED, m->target.id, NULL);
   (void) to_state;
 }
 
@@ -136,7 +137,7 @@ tiling_guard_can_change_layout(StateMachine* sm, void* data)
 
 /*
  * Action called when layout changes.
- * Tiles all clients on the monitor.
+ * Schedules a relayout of the monitor for the end of the event batch.
  */
 bool
 tiling_action_on_layout_change(StateMachine* sm, void* data)
@@ -148,9 +149,9 @@ tiling_action_on_layout_change(StateMachine* sm, void* data)
 
   Monitor* m = (Monitor*) sm->owner;
 
-  /* Only tile in TILE state */
+  /* Only tile in TILE state; the layout itself runs at the end of the batch */
   if (sm_get_state(sm) == LAYOUT_STATE_TILE) {
-    tiling_tile_monitor(m);
+    hub_schedule_relayout(m->target.id);
   }
 
   return true;
@@ -202,7 +203,7 @@ tiling_get_sm(Monitor* m)
   if (m == NULL)
     return NULL;
 
-  StateMachine* sm = monitor_get_sm(m, TILING_COMPONENT_NAME);
+  StateMachine* sm = monitor_get_sm_atom(m, TILING_COMPONENT_ATOM);
   if (sm != NULL)
     return sm;
 
@@ -223,7 +224,7 @@ tiling_get_sm(Monitor* m)
   }
 
   /* Store in monitor */
-  if (!monitor_set_sm(m, TILING_COMPONENT_NAME, sm)) {
+  if (!monitor_set_sm_atom(m, TILING_COMPONENT_ATOM, sm)) {
     LOG_ERROR("Failed to store layout SM for monitor");
     sm_destroy(sm);
     return NULL;
@@ -242,7 +243,7 @@ tiling_get_state(Monitor* m)
   if (m == NULL)
     return LAYOUT_STATE_TILE;
 
-  StateMachine* sm = monitor_get_sm(m, TILING_COMPONENT_NAME);
+  StateMachine* sm = monitor_get_sm_atom(m, TILING_COMPONENT_ATOM);
   if (sm == NULL)
     return LAYOUT_STATE_TILE;
 
@@ -450,7 +451,7 @@ tiling_arrange(
       c->border_width = 1;
 
       /* Configure window via X */
-      client_configure_from_struct(c);
+      client_move_resize(c);
     }
   }
 
@@ -471,7 +472,7 @@ tiling_arrange(
         c->border_width = 1;
 
         /* Configure window via X */
-        client_configure_from_struct(c);
+        client_move_resize(c);
       }
     } else {
       /* No stack area - tile in master */
@@ -489,7 +490,7 @@ tiling_arrange(
         c->border_width = 1;
 
         /* Configure window via X */
-        client_configure_from_struct(c);
+        client_move_resize(c);
       }
     }
   }
@@ -528,6 +529,23 @@ tiling_tile_monitor(Monitor* m)
   /* Arrange clients */
   tiling_arrange(m, master_clients, actual_nmaster, stack_clients, nstack);
 
+  /*
+   * Top down, each client below the one after it: the same order as
+   * raising them one by one, but a stable layout sends no restack at all
+   */
+  xcb_window_t above = XCB_NONE;
+  for (uint32_t i = client_count; i-- > 0;) {
+    Client* c = clients[i];
+    if (c == NULL)
+      continue;
+
+    if (above == XCB_NONE)
+      client_restack(c->window, XCB_NONE, XCB_STACK_MODE_ABOVE);
+    else
+      client_restack(c->window, above, XCB_STACK_MODE_BELOW);
+    above = c->window;
+  }
+
   /* Show all clients */
   for (uint32_t i = 0; i < client_count; i++) {
     Client* c = clients[i];
@@ -614,13 +632,27 @@ tiling_executor(struct HubRequest* req)
 
   /* Get monitor from target ID */
   Monitor* m = (Monitor*) hub_get_target_by_id(req->target);
-  if (m == NULL || m->target.type_id != hub_get_target_type_id_by_name("monitor")) {
+  if (m == NULL || m->target.type_id != hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR)) {
     LOG_DEBUG("tiling_executor: no monitor found for target");
+    req->failed = true;
     return;
   }
 
-  /* Just tile the monitor - this component handles tiling */
-  tiling_tile_monitor(m);
+  /* Defer the layout: a burst of requests tiles the monitor only once */
+  hub_schedule_relayout(m->target.id);
+}
+
+/*
+ * Relayout handler: run once per dirty monitor at the end of an event batch
+ */
+static void
+tiling_relayout(HubTarget* target)
+{
+  Monitor* m = (Monitor*) target;
+
+  if (tiling_get_state(m) == LAYOUT_STATE_TILE) {
+    tiling_tile_monitor(m);
+  }
 }
 
 /*
@@ -658,6 +690,9 @@ tiling_component_init(void)
 
   /* Register with hub */
   hub_register_component(&tiling_component.base);
+  hub_register_relayout_handler(hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR), tiling_relayout);
+  hub_set_event_coalescing(EVT_LAYOUT_CHANGED, true);
+  hub_set_request_merging(REQ_MONITOR_TILE, true);
 
   /* Cache the template for future monitors */
   cached_layout_template = layout_sm_template_create();
@@ -687,6 +722,7 @@ tiling_component_shutdown(void)
   LOG_DEBUG("Shutting down tiling component");
 
   /* Unregister from hub */
+  hub_unregister_relayout_handler(hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR));
   hub_unregister_component(TILING_COMPONENT_NAME);
 
   /* Unregister guards and actions */
@@ -6,7 +6,8 @@
  *
  * Component lifecycle:
  * - on_init(): register REQ_MONITOR_TILE executor
- * - executor: handle REQ_MONITOR_TILE request, tile windows on monitor
+ * - executor: handle REQ_MONITOR_TILE request, mark the monitor dirty
+ * - relayout handler: tile windows once per dirty monitor per event batch
  *
  * Layout Algorithm:
  * - Divides monitor into master area and stack
@@ -34,9 +35,10 @@
 #include "wm-hub.h"
 
 /*
- * Component name
+ * Component name, and its atom (also names the per-target SM)
  */
 #define TILING_COMPONENT_NAME "tiling"
+#define TILING_COMPONENT_ATOM NAME_ATOM_TILING
 
 /*
  * Layout State Machine states
@@ -263,7 +265,7 @@ bool tiling_guard_can_change_layout(StateMachine* sm, void* data);
 
 /*
  * Action called when layout changes.
- * Tiles all clients on the monitor.
+ * Schedules a relayout of the monitor for the end of the event batch.
  */
 bool tiling_action_on_layout_change(StateMachine* sm, void* data);
 
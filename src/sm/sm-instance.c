@@ -261,7 +261,9 @@ sm_transition(StateMachine* sm, uint32_t target_state)
   /* Run guards - use registry to find and call guard function */
   if (t->guard_fn != NULL) {
     LOG_DEBUG("sm_transition: checking guard '%s' for %s", t->guard_fn, sm->name);
-    if (!sm_run_guard(sm, t->guard_fn, sm->data)) {
+    bool allowed = t->guard_atom != NAME_ATOM_NONE ? sm_run_guard_atom(sm, t->guard_atom, sm->data)
+                                                   : sm_run_guard(sm, t->guard_fn, sm->data);
+    if (!allowed) {
       LOG_DEBUG("sm_transition: guard '%s' rejected transition %s: %u -> %u",
                 t->guard_fn, sm->name, sm->current_state, target_state);
       return false;
@@ -279,7 +281,9 @@ sm_transition(StateMachine* sm, uint32_t target_state)
 
   /* Execute action - use registry to find and call action function */
   if (t->action_fn != NULL) {
-    if (!sm_run_action(sm, t->action_fn, sm->data)) {
+    bool done = t->action_atom != NAME_ATOM_NONE ? sm_run_action_atom(sm, t->action_atom, sm->data)
+                                                 : sm_run_action(sm, t->action_fn, sm->data);
+    if (!done) {
       LOG_ERROR("sm_transition: action '%s' failed for %s", t->action_fn, sm->name);
       return false;
     }
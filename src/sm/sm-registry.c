@@ -4,113 +4,44 @@
 #include <string.h>
 
 #include "sm-instance.h"
+#include "wm-intern.h"
 #include "wm-log.h"
 
-/* Registry entry - uses separate typed function pointer fields to avoid
- * casting between function pointers and data pointers (UB in standard C) */
-typedef struct RegistryEntry {
-  const char* name;
-  union {
-    SMGuardFn  guard_fn;
-    SMActionFn action_fn;
-  } fn;
-  struct RegistryEntry* next;
-  bool                  is_guard; /* true for guard entries, false for action entries */
-} RegistryEntry;
-
-/* Registry buckets */
-#define GUARD_REGISTRY_BUCKETS  16
-#define ACTION_REGISTRY_BUCKETS 16
-
-static RegistryEntry* guard_registry[GUARD_REGISTRY_BUCKETS];
-static RegistryEntry* action_registry[ACTION_REGISTRY_BUCKETS];
+/*
+ * Guards and actions by name atom (see wm-intern.h). Separate typed arrays
+ * avoid casting between function pointers and data pointers (UB in
+ * standard C). A NULL entry means nothing is registered under that name.
+ */
+static SMGuardFn*  guards          = NULL;
+static uint32_t    guard_capacity  = 0;
+static SMActionFn* actions         = NULL;
+static uint32_t    action_capacity = 0;
 
 static bool initialized = false;
 
-static uint32_t
-hash_string(const char* s)
-{
-  uint32_t hash = 5381;
-  while (*s) {
-    hash = ((hash << 5) + hash) + (uint32_t) *s;
-    s++;
-  }
-  return hash;
-}
-
-static void*
-lookup_in_bucket(RegistryEntry** buckets, int num_buckets, const char* name, bool is_guard)
+/*
+ * Grow an atom-indexed array to cover atom, zero-filling the new part.
+ */
+static bool
+reserve_atom(void** items, uint32_t* capacity, NameAtom atom, size_t size)
 {
-  if (name == NULL)
-    return NULL;
+  if (atom < *capacity)
+    return true;
 
-  uint32_t       hash  = hash_string(name) % (uint32_t) num_buckets;
-  RegistryEntry* entry = buckets[hash];
+  uint32_t new_capacity = *capacity > 0 ? *capacity : 16;
+  while (new_capacity <= atom)
+    new_capacity *= 2;
 
-  while (entry != NULL) {
-    if (entry->is_guard == is_guard && strcmp(entry->name, name) == 0) {
-      /* Return the appropriate function pointer from the union */
-      return is_guard ? (void*) entry->fn.guard_fn : (void*) entry->fn.action_fn;
-    }
-    entry = entry->next;
+  void* grown = realloc(*items, (size_t) new_capacity * size);
+  if (grown == NULL) {
+    LOG_ERROR("Failed to grow SM registry to %u names", new_capacity);
+    return false;
   }
 
-  return NULL;
-}
-
-static void
-register_in_bucket(RegistryEntry** buckets, int num_buckets,
-                   const char* name, void* fn, bool is_guard)
-{
-  if (name == NULL || fn == NULL)
-    return;
-
-  uint32_t hash = hash_string(name) % (uint32_t) num_buckets;
-
-  /* Check if already registered */
-  if (lookup_in_bucket(buckets, num_buckets, name, is_guard) != NULL) {
-    LOG_WARN("Function '%s' already registered", name);
-    return;
-  }
-
-  RegistryEntry* entry = malloc(sizeof(RegistryEntry));
-  if (entry == NULL) {
-    LOG_ERROR("Failed to allocate registry entry");
-    return;
-  }
-
-  entry->name     = name;
-  entry->is_guard = is_guard;
-  /* Store in union field based on type */
-  if (is_guard) {
-    entry->fn.guard_fn = (SMGuardFn) fn;
-  } else {
-    entry->fn.action_fn = (SMActionFn) fn;
-  }
-  entry->next   = buckets[hash];
-  buckets[hash] = entry;
-}
-
-static void
-unregister_from_bucket(RegistryEntry** buckets, int num_buckets,
-                       const char* name)
-{
-  if (name == NULL)
-    return;
-
-  uint32_t        hash = hash_string(name) % (uint32_t) num_buckets;
-  RegistryEntry** prev = &buckets[hash];
-  RegistryEntry*  curr = *prev;
-
-  while (curr != NULL) {
-    if (strcmp(curr->name, name) == 0) {
-      *prev = curr->next;
-      free(curr);
-      return;
-    }
-    prev = &curr->next;
-    curr = curr->next;
-  }
+  memset((char*) grown + (size_t) *capacity * size, 0, (size_t) (new_capacity - *capacity) * size);
+  *items    = grown;
+  *capacity = new_capacity;
+  return true;
 }
 
 void
@@ -119,9 +50,6 @@ sm_registry_init(void)
   if (initialized)
     return;
 
-  memset(guard_registry, 0, sizeof(guard_registry));
-  memset(action_registry, 0, sizeof(action_registry));
-
   initialized = true;
   LOG_DEBUG("SM registry initialized");
 }
@@ -143,35 +71,15 @@ ensure_initialized(void)
 void
 sm_registry_shutdown(void)
 {
-  /* Always free buckets, regardless of initialized state */
-  if (!initialized) {
-    /* Buckets might have been allocated without init call */
-    memset(guard_registry, 0, sizeof(guard_registry));
-    memset(action_registry, 0, sizeof(action_registry));
-    return;
-  }
+  free(guards);
+  free(actions);
+  guards          = NULL;
+  actions         = NULL;
+  guard_capacity  = 0;
+  action_capacity = 0;
 
-  /* Free all guard entries */
-  for (int i = 0; i < GUARD_REGISTRY_BUCKETS; i++) {
-    RegistryEntry* curr = guard_registry[i];
-    while (curr != NULL) {
-      RegistryEntry* next = curr->next;
-      free(curr);
-      curr = next;
-    }
-    guard_registry[i] = NULL;
-  }
-
-  /* Free all action entries */
-  for (int i = 0; i < ACTION_REGISTRY_BUCKETS; i++) {
-    RegistryEntry* curr = action_registry[i];
-    while (curr != NULL) {
-      RegistryEntry* next = curr->next;
-      free(curr);
-      curr = next;
-    }
-    action_registry[i] = NULL;
-  }
+  if (!initialized)
+    return;
 
   initialized = false;
   LOG_DEBUG("SM registry shut down");
@@ -180,45 +88,75 @@ sm_registry_shutdown(void)
 void
 sm_register_guard(const char* name, SMGuardFn fn)
 {
-  if (!ensure_initialized())
+  if (name == NULL || fn == NULL || !ensure_initialized())
+    return;
+
+  NameAtom atom = name_intern(name);
+  if (atom == NAME_ATOM_NONE || !reserve_atom((void**) &guards, &guard_capacity, atom, sizeof(*guards)))
+    return;
+
+  if (guards[atom] != NULL) {
+    LOG_WARN("Function '%s' already registered", name);
     return;
-  register_in_bucket(guard_registry, GUARD_REGISTRY_BUCKETS, name, fn, true);
+  }
+  guards[atom] = fn;
 }
 
 void
 sm_unregister_guard(const char* name)
 {
-  if (!initialized)
-    return;
-  unregister_from_bucket(guard_registry, GUARD_REGISTRY_BUCKETS, name);
+  NameAtom atom = name_atom_find(name);
+  if (initialized && atom < guard_capacity)
+    guards[atom] = NULL;
 }
 
 void
 sm_register_action(const char* name, SMActionFn fn)
 {
-  if (!ensure_initialized())
+  if (name == NULL || fn == NULL || !ensure_initialized())
     return;
-  register_in_bucket(action_registry, ACTION_REGISTRY_BUCKETS, name, fn, false);
+
+  NameAtom atom = name_intern(name);
+  if (atom == NAME_ATOM_NONE || !reserve_atom((void**) &actions, &action_capacity, atom, sizeof(*actions)))
+    return;
+
+  if (actions[atom] != NULL) {
+    LOG_WARN("Function '%s' already registered", name);
+    return;
+  }
+  actions[atom] = fn;
 }
 
 void
 sm_unregister_action(const char* name)
 {
-  if (!initialized)
-    return;
-  unregister_from_bucket(action_registry, ACTION_REGISTRY_BUCKETS, name);
+  NameAtom atom = name_atom_find(name);
+  if (initialized && atom < action_capacity)
+    actions[atom] = NULL;
 }
 
 SMGuardFn
 sm_lookup_guard(const char* name)
 {
-  return (SMGuardFn) lookup_in_bucket(guard_registry, GUARD_REGISTRY_BUCKETS, name, true);
+  return sm_lookup_guard_atom(name_atom_find(name));
 }
 
 SMActionFn
 sm_lookup_action(const char* name)
 {
-  return (SMActionFn) lookup_in_bucket(action_registry, ACTION_REGISTRY_BUCKETS, name, false);
+  return sm_lookup_action_atom(name_atom_find(name));
+}
+
+SMGuardFn
+sm_lookup_guard_atom(NameAtom atom)
+{
+  return atom < guard_capacity ? guards[atom] : NULL;
+}
+
+SMActionFn
+sm_lookup_action_atom(NameAtom atom)
+{
+  return atom < action_capacity ? actions[atom] : NULL;
 }
 
 bool
@@ -249,4 +187,34 @@ sm_run_action(StateMachine* sm, const char* action_name, void* data)
   }
 
   return action(sm, data);
-}
\ No newline at end of file
+}
+
+bool
+sm_run_guard_atom(StateMachine* sm, NameAtom guard_atom, void* data)
+{
+  if (guard_atom == NAME_ATOM_NONE)
+    return true; /* No guard = always allowed */
+
+  SMGuardFn guard = sm_lookup_guard_atom(guard_atom);
+  if (guard == NULL) {
+    LOG_WARN("Guard '%s' not found, allowing transition", name_atom_string(guard_atom));
+    return true; /* Failsafe: allow if guard not found */
+  }
+
+  return guard(sm, data);
+}
+
+bool
+sm_run_action_atom(StateMachine* sm, NameAtom action_atom, void* data)
+{
+  if (action_atom == NAME_ATOM_NONE)
+    return true; /* No action = success */
+
+  SMActionFn action = sm_lookup_action_atom(action_atom);
+  if (action == NULL) {
+    LOG_WARN("Action '%s' not found", name_atom_string(action_atom));
+    return false; /* Fail if action not found */
+  }
+
+  return action(sm, data);
+}
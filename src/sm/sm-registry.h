@@ -6,12 +6,15 @@
  *
  * Provides registration and lookup of guard and action functions
  * for state machine transitions. Components register their guards
- * and actions, and the SM framework looks them up by name.
+ * and actions by name; the registry keys them on the interned name atom
+ * (see wm-intern.h), and SM transitions look them up by atom.
  */
 
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "wm-intern.h"
+
 /* Forward declarations */
 typedef struct StateMachine StateMachine;
 
@@ -67,6 +70,13 @@ SMGuardFn sm_lookup_guard(const char* name);
  */
 SMActionFn sm_lookup_action(const char* name);
 
+/*
+ * Look up a guard or action function by name atom.
+ * Returns NULL if not found.
+ */
+SMGuardFn  sm_lookup_guard_atom(NameAtom atom);
+SMActionFn sm_lookup_action_atom(NameAtom atom);
+
 /*
  * Run a guard by name.
  * Returns true if guard passes.
@@ -84,4 +94,11 @@ bool sm_run_guard(StateMachine* sm, const char* guard_name, void* data);
  */
 bool sm_run_action(StateMachine* sm, const char* action_name, void* data);
 
+/*
+ * Run a guard or action by name atom, as sm_run_guard() and
+ * sm_run_action() do by name. NAME_ATOM_NONE means no guard or action.
+ */
+bool sm_run_guard_atom(StateMachine* sm, NameAtom guard_atom, void* data);
+bool sm_run_action_atom(StateMachine* sm, NameAtom action_atom, void* data);
+
 #endif /* _SM_REGISTRY_H_ */
\ No newline at end of file
@@ -27,6 +27,11 @@ sm_template_create(
   tmpl->num_transitions = num_transitions;
   tmpl->initial_state   = initial_state;
 
+  for (uint32_t i = 0; transitions != NULL && i < num_transitions; i++) {
+    transitions[i].guard_atom  = name_intern(transitions[i].guard_fn);
+    transitions[i].action_atom = name_intern(transitions[i].action_fn);
+  }
+
   LOG_DEBUG("Created SMTemplate: %s", name);
   return tmpl;
 }
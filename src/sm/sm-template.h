@@ -11,6 +11,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "wm-intern.h"
+
 /* Forward declarations */
 typedef struct StateMachine StateMachine;
 typedef struct SMTemplate   SMTemplate;
@@ -22,9 +24,11 @@ typedef struct SMTemplate   SMTemplate;
 typedef struct SMTransition {
   uint32_t    from_state;
   uint32_t    to_state;
-  const char* guard_fn;   /* name of guard function */
-  const char* action_fn;  /* name of action function */
-  uint32_t    emit_event; /* event to emit on transition */
+  const char* guard_fn;    /* name of guard function */
+  const char* action_fn;   /* name of action function */
+  uint32_t    emit_event;  /* event to emit on transition */
+  NameAtom    guard_atom;  /* guard_fn interned by sm_template_create() */
+  NameAtom    action_atom; /* action_fn interned by sm_template_create() */
 } SMTransition;
 
 /*
@@ -42,6 +46,8 @@ struct SMTemplate {
 
 /*
  * Create a new SMTemplate with the given parameters.
+ * Interns the guard and action names of every transition, so transitions
+ * look them up by atom.
  * Returns NULL on allocation failure.
  */
 SMTemplate* sm_template_create(
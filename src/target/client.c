@@ -11,6 +11,7 @@
 
 #include "../sm/sm-registry.h"
 #include "../sm/sm.h"
+#include "../xcb/xcb-mirror.h"
 #include "client.h"
 #include "monitor.h"
 #include "wm-hub.h"
@@ -47,6 +48,9 @@ client_properties_init(Client* c)
   c->mapped       = false;
   c->stack_mode   = XCB_STACK_MODE_ABOVE;
 
+  /* Nothing cached yet */
+  memset(&c->props, 0, sizeof(c->props));
+
   /* Initialize SM storage */
   c->sms.machines = NULL;
   c->sms.names    = NULL;
@@ -55,17 +59,17 @@ client_properties_init(Client* c)
 }
 
 /*
- * Helper: find SM index by name.
+ * Helper: find SM index by name atom.
  * Returns -1 if not found.
  */
 static int32_t
-client_sm_find(const Client* c, const char* sm_name)
+client_sm_find(const Client* c, NameAtom sm_name)
 {
-  if (c == NULL || sm_name == NULL)
+  if (c == NULL || sm_name == NAME_ATOM_NONE)
     return -1;
 
   for (uint32_t i = 0; i < c->sms.count; i++) {
-    if (c->sms.names[i] != NULL && strcmp(c->sms.names[i], sm_name) == 0) {
+    if (c->sms.names[i] == sm_name) {
       return (int32_t) i;
     }
   }
@@ -73,16 +77,15 @@ client_sm_find(const Client* c, const char* sm_name)
 }
 
 /*
- * Helper: add or update SM for a name.
+ * Helper: add or update SM for a name atom.
  * Takes ownership of `sm` - any previously registered SM for this name
  * will be destroyed (unless it's the same pointer to avoid self-destruction).
- * The sm_name string is copied internally.
  *
  * Returns true on success, false on failure (OOM).
  * On failure, the caller should handle cleanup of the passed SM.
  */
 static bool
-client_sm_set_internal(Client* c, const char* sm_name, StateMachine* sm)
+client_sm_set_internal(Client* c, NameAtom sm_name, StateMachine* sm)
 {
   int32_t idx = client_sm_find(c, sm_name);
 
@@ -99,7 +102,7 @@ client_sm_set_internal(Client* c, const char* sm_name, StateMachine* sm)
   if (c->sms.count >= c->sms.capacity) {
     uint32_t       new_capacity = c->sms.capacity == 0 ? 4 : c->sms.capacity * 2;
     StateMachine** new_machines = NULL;
-    char**         new_names    = NULL;
+    NameAtom*      new_names    = NULL;
 
     /* Reallocate machines first */
     new_machines = realloc(c->sms.machines, new_capacity * sizeof(StateMachine*));
@@ -109,7 +112,7 @@ client_sm_set_internal(Client* c, const char* sm_name, StateMachine* sm)
     }
 
     /* Reallocate names */
-    new_names = realloc(c->sms.names, new_capacity * sizeof(char*));
+    new_names = realloc(c->sms.names, new_capacity * sizeof(NameAtom));
     if (new_names == NULL) {
       free(new_machines);
       LOG_ERROR("Failed to expand SM names storage for client");
@@ -122,16 +125,8 @@ client_sm_set_internal(Client* c, const char* sm_name, StateMachine* sm)
     c->sms.capacity = new_capacity;
   }
 
-  /* strdup the name - check for failure */
-  char* copied_name = sm_name ? strdup(sm_name) : NULL;
-  if (sm_name != NULL && copied_name == NULL) {
-    LOG_ERROR("Failed to copy SM name for client");
-    /* Don't add the SM if we can't store the name */
-    return false;
-  }
-
   c->sms.machines[c->sms.count] = sm;
-  c->sms.names[c->sms.count]    = copied_name;
+  c->sms.names[c->sms.count]    = sm_name;
   c->sms.count++;
 
   return true;
@@ -299,7 +294,7 @@ client_create(xcb_window_t window)
 
   /* Initialize base target */
   c->target.id         = (TargetID) window;
-  c->target.type_id    = hub_get_target_type_id_by_name("client");
+  c->target.type_id    = hub_get_target_type_id_by_atom(NAME_ATOM_CLIENT);
   c->target.registered = false;
 
   /* Initialize X properties */
@@ -343,9 +338,6 @@ client_destroy(Client* c)
     if (c->sms.machines[i] != NULL) {
       sm_destroy(c->sms.machines[i]);
     }
-    if (c->sms.names[i] != NULL) {
-      free(c->sms.names[i]);
-    }
   }
   free(c->sms.machines);
   free(c->sms.names);
@@ -369,6 +361,9 @@ client_destroy(Client* c)
     hub_unregister_target(c->target.id);
   }
 
+  /* Nothing we sent for this window applies to a future window with its ID */
+  xcb_mirror_forget(c->window);
+
   /* Free client */
   free(c);
 
@@ -394,7 +389,7 @@ Client*
 client_get_by_window(xcb_window_t window)
 {
   HubTarget* t = hub_get_target_by_id((TargetID) window);
-  if (t == NULL || t->type_id != hub_get_target_type_id_by_name("client"))
+  if (t == NULL || t->type_id != hub_get_target_type_id_by_atom(NAME_ATOM_CLIENT))
     return NULL;
   return (Client*) t;
 }
@@ -474,9 +469,16 @@ client_get_prev(const Client* c)
 StateMachine*
 client_get_sm(Client* c, const char* sm_name)
 {
-  if (c == NULL || sm_name == NULL)
-    return NULL;
+  return client_get_sm_atom(c, name_atom_find(sm_name));
+}
 
+/*
+ * Get state machine by name atom.
+ * Returns NULL if no SM is registered for this name.
+ */
+StateMachine*
+client_get_sm_atom(Client* c, NameAtom sm_name)
+{
   int32_t idx = client_sm_find(c, sm_name);
   if (idx < 0)
     return NULL;
@@ -494,7 +496,13 @@ client_get_sm(Client* c, const char* sm_name)
 bool
 client_set_sm(Client* c, const char* sm_name, StateMachine* sm)
 {
-  if (c == NULL || sm_name == NULL)
+  return client_set_sm_atom(c, name_intern(sm_name), sm);
+}
+
+bool
+client_set_sm_atom(Client* c, NameAtom sm_name, StateMachine* sm)
+{
+  if (c == NULL || sm_name == NAME_ATOM_NONE)
     return false;
 
   return client_sm_set_internal(c, sm_name, sm);
@@ -732,6 +740,21 @@ client_get_stack_mode(const Client* c)
  * Moved from wm-clients.c to consolidate client functionality
  */
 
+/*
+ * Send the fields of mask that differ from what the server already has.
+ */
+static xcb_void_cookie_t
+configure_window(xcb_window_t wnd, uint16_t mask, const XCBWindowState* wanted)
+{
+  uint32_t value_list[7];
+
+  uint16_t value_mask = xcb_mirror_filter_configure(wnd, mask, wanted, value_list);
+  if (value_mask == 0)
+    return (xcb_void_cookie_t) { 0 };
+
+  return xcb_configure_window(dpy, wnd, value_mask, value_list);
+}
+
 /*
  * Configure a client window (position, size, border, stack order).
  */
@@ -745,14 +768,56 @@ client_configure(
     uint16_t              border_width,
     enum xcb_stack_mode_t stack_mode)
 {
-  uint32_t value_list[] = { (uint32_t) x, (uint32_t) y, width, height, border_width, (uint32_t) stack_mode };
+  XCBWindowState wanted = {
+    .x            = x,
+    .y            = y,
+    .width        = width,
+    .height       = height,
+    .border_width = border_width,
+    .sibling      = XCB_NONE,
+    .stack_mode   = (uint8_t) stack_mode,
+  };
 
-  const uint16_t value_mask =
-      XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
-      XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT |
-      XCB_CONFIG_WINDOW_BORDER_WIDTH | XCB_CONFIG_WINDOW_STACK_MODE;
+  return configure_window(wnd, XCB_MIRROR_CONFIG_MASK | XCB_CONFIG_WINDOW_STACK_MODE, &wanted);
+}
 
-  return xcb_configure_window(dpy, wnd, value_mask, value_list);
+/*
+ * Move and resize a client window to its struct geometry, leaving its
+ * place in the stacking order alone.
+ */
+xcb_void_cookie_t
+client_move_resize(const Client* c)
+{
+  if (c == NULL)
+    return (xcb_void_cookie_t) { 0 };
+
+  XCBWindowState wanted = {
+    .x            = c->x,
+    .y            = c->y,
+    .width        = c->width,
+    .height       = c->height,
+    .border_width = c->border_width,
+  };
+
+  return configure_window(c->window, XCB_MIRROR_CONFIG_MASK, &wanted);
+}
+
+/*
+ * Restack a client window relative to a sibling.
+ */
+xcb_void_cookie_t
+client_restack(xcb_window_t wnd, xcb_window_t sibling, enum xcb_stack_mode_t stack_mode)
+{
+  XCBWindowState wanted = {
+    .sibling    = sibling,
+    .stack_mode = (uint8_t) stack_mode,
+  };
+  uint16_t mask = XCB_CONFIG_WINDOW_STACK_MODE;
+
+  if (sibling != XCB_NONE)
+    mask |= XCB_CONFIG_WINDOW_SIBLING;
+
+  return configure_window(wnd, mask, &wanted);
 }
 
 /*
@@ -780,6 +845,9 @@ client_configure_from_struct(const Client* c)
 xcb_void_cookie_t
 client_show(xcb_window_t wnd)
 {
+  if (!xcb_mirror_filter_map(wnd, true))
+    return (xcb_void_cookie_t) { 0 };
+
   return xcb_map_window(dpy, wnd);
 }
 
@@ -789,5 +857,8 @@ client_show(xcb_window_t wnd)
 xcb_void_cookie_t
 client_hide(xcb_window_t wnd)
 {
+  if (!xcb_mirror_filter_map(wnd, false))
+    return (xcb_void_cookie_t) { 0 };
+
   return xcb_unmap_window(dpy, wnd);
 }
@@ -27,6 +27,22 @@
 /* Forward declaration */
 typedef struct Monitor Monitor;
 
+/*
+ * WM_NORMAL_HINTS sizes (ICCCM); a field is meaningful when its
+ * flag (P_MIN_SIZE, P_MAX_SIZE, P_RESIZE_INC, P_BASE_SIZE) is set.
+ */
+typedef struct ClientSizeHints {
+  uint32_t flags;
+  int32_t  min_width;
+  int32_t  min_height;
+  int32_t  max_width;
+  int32_t  max_height;
+  int32_t  width_inc;
+  int32_t  height_inc;
+  int32_t  base_width;
+  int32_t  base_height;
+} ClientSizeHints;
+
 /*
  * Client structure
  * Represents a managed X11 window in the window manager.
@@ -60,10 +76,22 @@ typedef struct Client {
   bool                  mapped;     /* is currently mapped */
   enum xcb_stack_mode_t stack_mode; /* X11 stack mode */
 
+  /* Cached X properties - see src/components/client-props.h */
+  struct {
+    uint32_t        valid;            /* CLIENT_PROP_* bits holding a current value */
+    uint32_t        pending;          /* CLIENT_PROP_* bits with a fetch in flight */
+    uint32_t        dirty;            /* changed again while their fetch was in flight */
+    bool            title_wanted;     /* title read while its refresh was debounced */
+    uint64_t        title_fetched_ms; /* monotonic time of the last title fetch */
+    xcb_window_t    transient_for;
+    xcb_atom_t      window_type;
+    ClientSizeHints size_hints;
+  } props;
+
   /* Adopted state machines - dynamically allocated on demand */
   struct {
     StateMachine** machines; /* array of SM pointers */
-    char**         names;    /* corresponding SM names */
+    NameAtom*      names;    /* corresponding SM name atoms */
     uint32_t       count;    /* number of SMs */
     uint32_t       capacity; /* allocated capacity */
   } sms;
@@ -185,6 +213,7 @@ uint32_t client_count_managed(void);
  * NULL if no state machine has been attached for the given name.
  */
 StateMachine* client_get_sm(Client* c, const char* sm_name);
+StateMachine* client_get_sm_atom(Client* c, NameAtom sm_name);
 
 /*
  * Set a state machine for this client.
@@ -194,6 +223,7 @@ StateMachine* client_get_sm(Client* c, const char* sm_name);
  * On failure, the caller should destroy the SM to avoid leaks.
  */
 bool client_set_sm(Client* c, const char* sm_name, StateMachine* sm);
+bool client_set_sm_atom(Client* c, NameAtom sm_name, StateMachine* sm);
 
 /*
  * Client Property Accessors
@@ -287,6 +317,19 @@ xcb_void_cookie_t client_configure(
  */
 xcb_void_cookie_t client_configure_from_struct(const Client* c);
 
+/*
+ * Move and resize a client window to its struct geometry without
+ * restacking it.
+ */
+xcb_void_cookie_t client_move_resize(const Client* c);
+
+/*
+ * Restack a client window directly above or below sibling, or at the top
+ * or bottom of all windows when sibling is XCB_NONE. Restacks that leave
+ * the window where it is are not sent.
+ */
+xcb_void_cookie_t client_restack(xcb_window_t wnd, xcb_window_t sibling, enum xcb_stack_mode_t stack_mode);
+
 /*
  * Show a client window (map it).
  */
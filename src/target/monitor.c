@@ -55,17 +55,17 @@ monitor_properties_init(Monitor* m, xcb_randr_output_t output)
 }
 
 /*
- * Helper: find SM index by name.
+ * Helper: find SM index by name atom.
  * Returns -1 if not found.
  */
 static int32_t
-monitor_sm_find(const Monitor* m, const char* sm_name)
+monitor_sm_find(const Monitor* m, NameAtom sm_name)
 {
-  if (m == NULL || sm_name == NULL)
+  if (m == NULL || sm_name == NAME_ATOM_NONE)
     return -1;
 
   for (uint32_t i = 0; i < m->sms.count; i++) {
-    if (m->sms.names[i] != NULL && strcmp(m->sms.names[i], sm_name) == 0) {
+    if (m->sms.names[i] == sm_name) {
       return (int32_t) i;
     }
   }
@@ -73,16 +73,15 @@ monitor_sm_find(const Monitor* m, const char* sm_name)
 }
 
 /*
- * Helper: add or update SM for a name.
+ * Helper: add or update SM for a name atom.
  * Takes ownership of `sm` - any previously registered SM for this name
  * will be destroyed (unless it's the same pointer to avoid self-destruction).
- * The sm_name string is copied internally.
  *
  * Returns true on success, false on failure (OOM).
  * On failure, the caller should handle cleanup of the passed SM.
  */
 static bool
-monitor_sm_set_internal(Monitor* m, const char* sm_name, StateMachine* sm)
+monitor_sm_set_internal(Monitor* m, NameAtom sm_name, StateMachine* sm)
 {
   int32_t idx = monitor_sm_find(m, sm_name);
 
@@ -94,9 +93,8 @@ monitor_sm_set_internal(Monitor* m, const char* sm_name, StateMachine* sm)
     }
     m->sms.machines[idx] = sm;
     /* Clear name if setting to NULL (data cleanup case) */
-    if (sm == NULL && m->sms.names[idx] != NULL) {
-      free(m->sms.names[idx]);
-      m->sms.names[idx] = NULL;
+    if (sm == NULL) {
+      m->sms.names[idx] = NAME_ATOM_NONE;
     }
     return true;
   }
@@ -113,7 +111,7 @@ monitor_sm_set_internal(Monitor* m, const char* sm_name, StateMachine* sm)
     }
     m->sms.machines = tmp_machines;
 
-    char** tmp_names = realloc(m->sms.names, new_capacity * sizeof(char*));
+    NameAtom* tmp_names = realloc(m->sms.names, new_capacity * sizeof(NameAtom));
     if (tmp_names == NULL) {
       LOG_ERROR("Failed to expand SM names storage for monitor");
       return false;
@@ -122,16 +120,8 @@ monitor_sm_set_internal(Monitor* m, const char* sm_name, StateMachine* sm)
     m->sms.capacity = new_capacity;
   }
 
-  /* strdup the name - check for failure */
-  char* copied_name = sm_name ? strdup(sm_name) : NULL;
-  if (sm_name != NULL && copied_name == NULL) {
-    LOG_ERROR("Failed to copy SM name for monitor");
-    /* Don't add the SM if we can't store the name */
-    return false;
-  }
-
   m->sms.machines[m->sms.count] = sm;
-  m->sms.names[m->sms.count]    = copied_name;
+  m->sms.names[m->sms.count]    = sm_name;
   m->sms.count++;
 
   return true;
@@ -145,13 +135,10 @@ static void
 monitor_sm_storage_free(Monitor* m)
 {
   for (uint32_t i = 0; i < m->sms.count; i++) {
-    if (m->sms.names[i] != NULL) {
-      /* Check for component data that needs freeing */
-      /* Pertag stores Pertag* as void* in machines[i] - free it */
-      if (strcmp(m->sms.names[i], "pertag") == 0 && m->sms.machines[i] != NULL) {
-        free(m->sms.machines[i]);
-      }
-      free(m->sms.names[i]);
+    /* Check for component data that needs freeing */
+    /* Pertag stores Pertag* as void* in machines[i] - free it */
+    if (m->sms.names[i] == NAME_ATOM_PERTAG && m->sms.machines[i] != NULL) {
+      free(m->sms.machines[i]);
     }
   }
   free(m->sms.machines);
@@ -229,7 +216,7 @@ monitor_create(xcb_randr_output_t output)
 
   /* Initialize base target */
   m->target.id         = (TargetID) output;
-  m->target.type_id    = hub_get_target_type_id_by_name("monitor");
+  m->target.type_id    = hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR);
   m->target.registered = false;
 
   /* Initialize properties */
@@ -528,9 +515,16 @@ monitor_get_geometry(const Monitor* m, int16_t* x, int16_t* y, uint16_t* width,
 StateMachine*
 monitor_get_sm(Monitor* m, const char* sm_name)
 {
-  if (m == NULL || sm_name == NULL)
-    return NULL;
+  return monitor_get_sm_atom(m, name_atom_find(sm_name));
+}
 
+/*
+ * Get state machine by name atom.
+ * Returns NULL if no SM is registered for this name.
+ */
+StateMachine*
+monitor_get_sm_atom(Monitor* m, NameAtom sm_name)
+{
   int32_t idx = monitor_sm_find(m, sm_name);
   if (idx < 0)
     return NULL;
@@ -550,7 +544,13 @@ monitor_get_sm(Monitor* m, const char* sm_name)
 bool
 monitor_set_sm(Monitor* m, const char* sm_name, StateMachine* sm)
 {
-  if (m == NULL || sm_name == NULL)
+  return monitor_set_sm_atom(m, name_intern(sm_name), sm);
+}
+
+bool
+monitor_set_sm_atom(Monitor* m, NameAtom sm_name, StateMachine* sm)
+{
+  if (m == NULL || sm_name == NAME_ATOM_NONE)
     return false;
 
   return monitor_sm_set_internal(m, sm_name, sm);
@@ -71,7 +71,7 @@ typedef struct Monitor {
    * Components store their data here, keyed by name (e.g., "pertag"). */
   struct {
     StateMachine** machines; /* array of SM pointers */
-    char**         names;    /* corresponding names */
+    NameAtom*      names;    /* corresponding name atoms */
     uint32_t       count;    /* number of entries */
     uint32_t       capacity; /* allocated capacity */
   } sms;
@@ -224,6 +224,7 @@ void monitor_get_geometry(const Monitor* m, int16_t* x, int16_t* y, uint16_t* wi
  * NULL if no data has been attached for the given name.
  */
 StateMachine* monitor_get_sm(Monitor* m, const char* sm_name);
+StateMachine* monitor_get_sm_atom(Monitor* m, NameAtom sm_name);
 
 /*
  * Set component data for this monitor.
@@ -235,5 +236,6 @@ StateMachine* monitor_get_sm(Monitor* m, const char* sm_name);
  * On failure, the caller should free the data to avoid leaks.
  */
 bool monitor_set_sm(Monitor* m, const char* sm_name, StateMachine* sm);
+bool monitor_set_sm_atom(Monitor* m, NameAtom sm_name, StateMachine* sm);
 
 #endif /* _MONITOR_H_ */
@@ -0,0 +1,336 @@
+#include "xcb-atoms.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/xcb/xcb-reply.h"
+#include "wm-log.h"
+
+#define XCB_ATOMS_INITIAL_CAPACITY 64
+
+/* Names of the atoms in WM_ATOM_LIST, by table index */
+static const char* const table_names[ATOM_COUNT] = {
+#define WM_ATOM_NAME(id, name) [ATOM_##id] = name,
+  WM_ATOM_LIST(WM_ATOM_NAME)
+#undef WM_ATOM_NAME
+};
+
+/* Predefined atoms have fixed values and need no cache */
+static const char* const predefined_names[XCB_ATOM_WM_TRANSIENT_FOR + 1] = {
+  [XCB_ATOM_PRIMARY]             = "PRIMARY",
+  [XCB_ATOM_SECONDARY]           = "SECONDARY",
+  [XCB_ATOM_ARC]                 = "ARC",
+  [XCB_ATOM_ATOM]                = "ATOM",
+  [XCB_ATOM_BITMAP]              = "BITMAP",
+  [XCB_ATOM_CARDINAL]            = "CARDINAL",
+  [XCB_ATOM_COLORMAP]            = "COLORMAP",
+  [XCB_ATOM_CURSOR]              = "CURSOR",
+  [XCB_ATOM_CUT_BUFFER0]         = "CUT_BUFFER0",
+  [XCB_ATOM_CUT_BUFFER1]         = "CUT_BUFFER1",
+  [XCB_ATOM_CUT_BUFFER2]         = "CUT_BUFFER2",
+  [XCB_ATOM_CUT_BUFFER3]         = "CUT_BUFFER3",
+  [XCB_ATOM_CUT_BUFFER4]         = "CUT_BUFFER4",
+  [XCB_ATOM_CUT_BUFFER5]         = "CUT_BUFFER5",
+  [XCB_ATOM_CUT_BUFFER6]         = "CUT_BUFFER6",
+  [XCB_ATOM_CUT_BUFFER7]         = "CUT_BUFFER7",
+  [XCB_ATOM_DRAWABLE]            = "DRAWABLE",
+  [XCB_ATOM_FONT]                = "FONT",
+  [XCB_ATOM_INTEGER]             = "INTEGER",
+  [XCB_ATOM_PIXMAP]              = "PIXMAP",
+  [XCB_ATOM_POINT]               = "POINT",
+  [XCB_ATOM_RECTANGLE]           = "RECTANGLE",
+  [XCB_ATOM_RESOURCE_MANAGER]    = "RESOURCE_MANAGER",
+  [XCB_ATOM_RGB_COLOR_MAP]       = "RGB_COLOR_MAP",
+  [XCB_ATOM_RGB_BEST_MAP]        = "RGB_BEST_MAP",
+  [XCB_ATOM_RGB_BLUE_MAP]        = "RGB_BLUE_MAP",
+  [XCB_ATOM_RGB_DEFAULT_MAP]     = "RGB_DEFAULT_MAP",
+  [XCB_ATOM_RGB_GRAY_MAP]        = "RGB_GRAY_MAP",
+  [XCB_ATOM_RGB_GREEN_MAP]       = "RGB_GREEN_MAP",
+  [XCB_ATOM_RGB_RED_MAP]         = "RGB_RED_MAP",
+  [XCB_ATOM_STRING]              = "STRING",
+  [XCB_ATOM_VISUALID]            = "VISUALID",
+  [XCB_ATOM_WINDOW]              = "WINDOW",
+  [XCB_ATOM_WM_COMMAND]          = "WM_COMMAND",
+  [XCB_ATOM_WM_HINTS]            = "WM_HINTS",
+  [XCB_ATOM_WM_CLIENT_MACHINE]   = "WM_CLIENT_MACHINE",
+  [XCB_ATOM_WM_ICON_NAME]        = "WM_ICON_NAME",
+  [XCB_ATOM_WM_ICON_SIZE]        = "WM_ICON_SIZE",
+  [XCB_ATOM_WM_NAME]             = "WM_NAME",
+  [XCB_ATOM_WM_NORMAL_HINTS]     = "WM_NORMAL_HINTS",
+  [XCB_ATOM_WM_SIZE_HINTS]       = "WM_SIZE_HINTS",
+  [XCB_ATOM_WM_ZOOM_HINTS]       = "WM_ZOOM_HINTS",
+  [XCB_ATOM_MIN_SPACE]           = "MIN_SPACE",
+  [XCB_ATOM_NORM_SPACE]          = "NORM_SPACE",
+  [XCB_ATOM_MAX_SPACE]           = "MAX_SPACE",
+  [XCB_ATOM_END_SPACE]           = "END_SPACE",
+  [XCB_ATOM_SUPERSCRIPT_X]       = "SUPERSCRIPT_X",
+  [XCB_ATOM_SUPERSCRIPT_Y]       = "SUPERSCRIPT_Y",
+  [XCB_ATOM_SUBSCRIPT_X]         = "SUBSCRIPT_X",
+  [XCB_ATOM_SUBSCRIPT_Y]         = "SUBSCRIPT_Y",
+  [XCB_ATOM_UNDERLINE_POSITION]  = "UNDERLINE_POSITION",
+  [XCB_ATOM_UNDERLINE_THICKNESS] = "UNDERLINE_THICKNESS",
+  [XCB_ATOM_STRIKEOUT_ASCENT]    = "STRIKEOUT_ASCENT",
+  [XCB_ATOM_STRIKEOUT_DESCENT]   = "STRIKEOUT_DESCENT",
+  [XCB_ATOM_ITALIC_ANGLE]        = "ITALIC_ANGLE",
+  [XCB_ATOM_X_HEIGHT]            = "X_HEIGHT",
+  [XCB_ATOM_QUAD_WIDTH]          = "QUAD_WIDTH",
+  [XCB_ATOM_WEIGHT]              = "WEIGHT",
+  [XCB_ATOM_POINT_SIZE]          = "POINT_SIZE",
+  [XCB_ATOM_RESOLUTION]          = "RESOLUTION",
+  [XCB_ATOM_COPYRIGHT]           = "COPYRIGHT",
+  [XCB_ATOM_NOTICE]              = "NOTICE",
+  [XCB_ATOM_FONT_NAME]           = "FONT_NAME",
+  [XCB_ATOM_FAMILY_NAME]         = "FAMILY_NAME",
+  [XCB_ATOM_FULL_NAME]           = "FULL_NAME",
+  [XCB_ATOM_CAP_HEIGHT]          = "CAP_HEIGHT",
+  [XCB_ATOM_WM_CLASS]            = "WM_CLASS",
+  [XCB_ATOM_WM_TRANSIENT_FOR]    = "WM_TRANSIENT_FOR",
+};
+
+/*
+ * Name cache entry. atom == XCB_ATOM_NONE marks an empty slot; linear
+ * probing, and entries are never removed before xcb_atoms_clear().
+ */
+typedef struct AtomEntry {
+  xcb_atom_t  atom;
+  WmAtom      id;      /* table index, or ATOM_COUNT */
+  const char* name;    /* NULL while unknown */
+  bool        owned;   /* name was allocated by the cache */
+  bool        pending; /* a GetAtomName request is in flight */
+} AtomEntry;
+
+static xcb_atom_t   table[ATOM_COUNT];
+static AtomEntry*   entries  = NULL;
+static uint32_t     capacity = 0; /* power of two */
+static uint32_t     count    = 0;
+static XCBAtomStats stats;
+
+static uint32_t
+slot_for(xcb_atom_t atom)
+{
+  uint32_t h = atom * 0x9E3779B1U;
+  return (h ^ (h >> 16)) & (capacity - 1);
+}
+
+static AtomEntry*
+lookup(xcb_atom_t atom)
+{
+  if (capacity == 0)
+    return NULL;
+
+  for (uint32_t i = slot_for(atom);; i = (i + 1) & (capacity - 1)) {
+    if (entries[i].atom == atom)
+      return &entries[i];
+    if (entries[i].atom == XCB_ATOM_NONE)
+      return NULL;
+  }
+}
+
+static bool
+grow(void)
+{
+  uint32_t   old_capacity = capacity;
+  AtomEntry* old_entries  = entries;
+  uint32_t   new_capacity = capacity ? capacity * 2 : XCB_ATOMS_INITIAL_CAPACITY;
+
+  AtomEntry* new_entries = calloc(new_capacity, sizeof(AtomEntry));
+  if (new_entries == NULL) {
+    LOG_ERROR("xcb-atoms: cannot grow name cache to %u entries", new_capacity);
+    return false;
+  }
+
+  entries  = new_entries;
+  capacity = new_capacity;
+
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old_entries[i].atom == XCB_ATOM_NONE)
+      continue;
+    uint32_t j = slot_for(old_entries[i].atom);
+    while (entries[j].atom != XCB_ATOM_NONE)
+      j = (j + 1) & (capacity - 1);
+    entries[j] = old_entries[i];
+  }
+
+  free(old_entries);
+  return true;
+}
+
+/* Find or add the cache entry for an atom */
+static AtomEntry*
+insert(xcb_atom_t atom)
+{
+  AtomEntry* e = lookup(atom);
+  if (e != NULL)
+    return e;
+
+  /* keep the load factor under one half */
+  if ((count + 1) * 2 > capacity && !grow())
+    return NULL;
+
+  uint32_t i = slot_for(atom);
+  while (entries[i].atom != XCB_ATOM_NONE)
+    i = (i + 1) & (capacity - 1);
+
+  e       = &entries[i];
+  e->atom = atom;
+  e->id   = ATOM_COUNT;
+  count++;
+  return e;
+}
+
+uint32_t
+xcb_atoms_intern(xcb_connection_t* conn)
+{
+  xcb_intern_atom_cookie_t cookies[ATOM_COUNT];
+  uint32_t                 interned = 0;
+
+  if (conn == NULL)
+    return 0;
+
+  for (int i = 0; i < ATOM_COUNT; i++)
+    cookies[i] = xcb_intern_atom(conn, 0, (uint16_t) strlen(table_names[i]), table_names[i]);
+
+  for (int i = 0; i < ATOM_COUNT; i++) {
+    xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(conn, cookies[i], NULL);
+    if (reply == NULL) {
+      LOG_WARN("xcb-atoms: failed to intern %s", table_names[i]);
+      continue;
+    }
+    xcb_atoms_set((WmAtom) i, reply->atom);
+    free(reply);
+    interned++;
+  }
+
+  LOG_DEBUG("xcb-atoms: interned %u of %d atoms", interned, ATOM_COUNT);
+  return interned;
+}
+
+void
+xcb_atoms_set(WmAtom id, xcb_atom_t atom)
+{
+  if (id >= ATOM_COUNT)
+    return;
+
+  table[id] = atom;
+  if (atom == XCB_ATOM_NONE)
+    return;
+
+  AtomEntry* e = insert(atom);
+  if (e == NULL)
+    return;
+  if (e->owned)
+    free((char*) e->name);
+  e->id    = id;
+  e->name  = table_names[id];
+  e->owned = false;
+}
+
+xcb_atom_t
+xcb_atom_get(WmAtom id)
+{
+  return id < ATOM_COUNT ? table[id] : XCB_ATOM_NONE;
+}
+
+WmAtom
+xcb_atom_id(xcb_atom_t atom)
+{
+  AtomEntry* e = lookup(atom);
+  return e != NULL ? e->id : ATOM_COUNT;
+}
+
+const char*
+xcb_atom_name(xcb_atom_t atom)
+{
+  stats.lookups++;
+
+  if (atom <= XCB_ATOM_WM_TRANSIENT_FOR && predefined_names[atom] != NULL)
+    return predefined_names[atom];
+
+  AtomEntry* e = lookup(atom);
+  if (e == NULL || e->name == NULL) {
+    stats.misses++;
+    return NULL;
+  }
+  return e->name;
+}
+
+void
+xcb_atom_cache_name(xcb_atom_t atom, const char* name, int length)
+{
+  if (atom == XCB_ATOM_NONE || name == NULL || length < 0)
+    return;
+
+  AtomEntry* e = insert(atom);
+  if (e == NULL || e->id != ATOM_COUNT)
+    return;
+
+  char* copy = strndup(name, (size_t) length);
+  if (copy == NULL)
+    return;
+  if (e->owned)
+    free((char*) e->name);
+  e->name    = copy;
+  e->owned   = true;
+  e->pending = false;
+}
+
+static void
+on_atom_name(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  xcb_atom_t atom = (xcb_atom_t) (uintptr_t) userdata;
+  (void) target;
+
+  if (reply == NULL) {
+    LOG_DEBUG("xcb-atoms: no name for atom %u (error %d)", atom, error ? error->error_code : 0);
+    return;
+  }
+
+  xcb_get_atom_name_reply_t* r = (xcb_get_atom_name_reply_t*) reply;
+  xcb_atom_cache_name(atom, xcb_get_atom_name_name(r), xcb_get_atom_name_name_length(r));
+}
+
+void
+xcb_atom_resolve(xcb_connection_t* conn, xcb_atom_t atom)
+{
+  if (conn == NULL || atom == XCB_ATOM_NONE)
+    return;
+  if (atom <= XCB_ATOM_WM_TRANSIENT_FOR && predefined_names[atom] != NULL)
+    return;
+
+  /* one request per atom, ever: a failed lookup keeps its entry */
+  AtomEntry* e = insert(atom);
+  if (e == NULL || e->name != NULL || e->pending)
+    return;
+
+  xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(conn, atom);
+  if (!xcb_reply_register(cookie.sequence, TARGET_ID_NONE, on_atom_name, (void*) (uintptr_t) atom))
+    return;
+  e->pending = true;
+  stats.resolves++;
+}
+
+void
+xcb_atoms_clear(void)
+{
+  for (uint32_t i = 0; i < capacity; i++) {
+    if (entries[i].owned)
+      free((char*) entries[i].name);
+  }
+  free(entries);
+  entries  = NULL;
+  capacity = 0;
+  count    = 0;
+  memset(table, 0, sizeof(table));
+}
+
+XCBAtomStats
+xcb_atoms_get_stats(void)
+{
+  return stats;
+}
+
+void
+xcb_atoms_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,129 @@
+/*
+ * XCB Atoms - Atom table interned at startup, and atom names
+ *
+ * Every atom the window manager uses is listed once in WM_ATOM_LIST.
+ * setup_xcb() interns the whole table in one pipelined batch (all
+ * InternAtom requests first, then all replies), and components read
+ * atoms by enum index:
+ *
+ *   if (e->atom == xcb_atom_get(ATOM_NET_WM_STATE))
+ *
+ * Predefined atoms (XCB_ATOM_WM_NAME, XCB_ATOM_WM_CLASS, ...) need no
+ * interning and are used directly.
+ *
+ * Reverse lookup (atom to name) never blocks. Predefined atoms are
+ * indexed by value, table atoms and names learned from the server live
+ * in a hash cache. Names of other atoms are only fetched on request
+ * with xcb_atom_resolve(), asynchronously and once per atom.
+ */
+
+#ifndef _WM_XCB_ATOMS_H_
+#define _WM_XCB_ATOMS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/*
+ * Atom table: X(ENUM_SUFFIX, "atom name")
+ */
+#define WM_ATOM_LIST(X)                                                       \
+  X(WM_PROTOCOLS, "WM_PROTOCOLS")                                             \
+  X(WM_DELETE_WINDOW, "WM_DELETE_WINDOW")                                     \
+  X(WM_TAKE_FOCUS, "WM_TAKE_FOCUS")                                           \
+  X(WM_STATE, "WM_STATE")                                                     \
+  X(WM_CHANGE_STATE, "WM_CHANGE_STATE")                                       \
+  X(UTF8_STRING, "UTF8_STRING")                                               \
+  X(NET_SUPPORTED, "_NET_SUPPORTED")                                          \
+  X(NET_SUPPORTING_WM_CHECK, "_NET_SUPPORTING_WM_CHECK")                      \
+  X(NET_CLIENT_LIST, "_NET_CLIENT_LIST")                                      \
+  X(NET_ACTIVE_WINDOW, "_NET_ACTIVE_WINDOW")                                  \
+  X(NET_CURRENT_DESKTOP, "_NET_CURRENT_DESKTOP")                              \
+  X(NET_WM_NAME, "_NET_WM_NAME")                                              \
+  X(NET_WM_PID, "_NET_WM_PID")                                                \
+  X(NET_WM_DESKTOP, "_NET_WM_DESKTOP")                                        \
+  X(NET_WM_STATE, "_NET_WM_STATE")                                            \
+  X(NET_WM_STATE_FULLSCREEN, "_NET_WM_STATE_FULLSCREEN")                      \
+  X(NET_WM_STATE_DEMANDS_ATTENTION, "_NET_WM_STATE_DEMANDS_ATTENTION")        \
+  X(NET_WM_STATE_HIDDEN, "_NET_WM_STATE_HIDDEN")                              \
+  X(NET_WM_STATE_ABOVE, "_NET_WM_STATE_ABOVE")                                \
+  X(NET_WM_WINDOW_TYPE, "_NET_WM_WINDOW_TYPE")                                \
+  X(NET_WM_WINDOW_TYPE_NORMAL, "_NET_WM_WINDOW_TYPE_NORMAL")                  \
+  X(NET_WM_WINDOW_TYPE_DIALOG, "_NET_WM_WINDOW_TYPE_DIALOG")                  \
+  X(NET_WM_WINDOW_TYPE_DOCK, "_NET_WM_WINDOW_TYPE_DOCK")                      \
+  X(NET_WM_WINDOW_TYPE_DESKTOP, "_NET_WM_WINDOW_TYPE_DESKTOP")                \
+  X(NET_WM_WINDOW_TYPE_SPLASH, "_NET_WM_WINDOW_TYPE_SPLASH")                  \
+  X(NET_WM_WINDOW_TYPE_UTILITY, "_NET_WM_WINDOW_TYPE_UTILITY")                \
+  X(NET_WM_WINDOW_TYPE_TOOLBAR, "_NET_WM_WINDOW_TYPE_TOOLBAR")                \
+  X(NET_WM_WINDOW_TYPE_MENU, "_NET_WM_WINDOW_TYPE_MENU")
+
+/*
+ * Atom table indices
+ */
+typedef enum WmAtom {
+#define WM_ATOM_ENUM(id, name) ATOM_##id,
+  WM_ATOM_LIST(WM_ATOM_ENUM)
+#undef WM_ATOM_ENUM
+    ATOM_COUNT
+} WmAtom;
+
+/*
+ * Atom statistics
+ */
+typedef struct XCBAtomStats {
+  uint64_t lookups;  /* xcb_atom_name() calls */
+  uint64_t misses;   /* lookups for atoms with no known name */
+  uint64_t resolves; /* GetAtomName requests sent */
+} XCBAtomStats;
+
+/*
+ * Intern the whole atom table: one request per atom, sent back to back,
+ * then the replies. Atoms the server refuses stay XCB_ATOM_NONE.
+ * Returns the number of atoms interned.
+ */
+uint32_t xcb_atoms_intern(xcb_connection_t* conn);
+
+/*
+ * Record the value of a table atom (done by xcb_atoms_intern()).
+ */
+void xcb_atoms_set(WmAtom id, xcb_atom_t atom);
+
+/*
+ * Value of a table atom, or XCB_ATOM_NONE before interning.
+ */
+xcb_atom_t xcb_atom_get(WmAtom id);
+
+/*
+ * Table index of an atom, or ATOM_COUNT if it is not in the table.
+ */
+WmAtom xcb_atom_id(xcb_atom_t atom);
+
+/*
+ * Name of an atom, or NULL if it is not known yet. Never talks to the
+ * server. The string stays valid until xcb_atoms_clear().
+ */
+const char* xcb_atom_name(xcb_atom_t atom);
+
+/*
+ * Ask the server for the name of an atom not in the cache. The reply
+ * fills the cache; repeated calls for the same atom send nothing.
+ */
+void xcb_atom_resolve(xcb_connection_t* conn, xcb_atom_t atom);
+
+/*
+ * Add a name to the cache (the string is copied).
+ */
+void xcb_atom_cache_name(xcb_atom_t atom, const char* name, int length);
+
+/*
+ * Forget the table values and every cached name.
+ */
+void xcb_atoms_clear(void);
+
+/*
+ * Statistics
+ */
+XCBAtomStats xcb_atoms_get_stats(void);
+void         xcb_atoms_reset_stats(void);
+
+#endif /* _WM_XCB_ATOMS_H_ */
@@ -0,0 +1,495 @@
+#include "xcb-batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <xcb/xinput.h>
+
+#include "wm-log.h"
+
+#define XCB_BATCH_INITIAL_CAPACITY 64
+
+static uint8_t       xinput_opcode = 0;
+static XCBBatchStats stats;
+
+/* Scratch hash set of (window, atom) keys used by the PROPERTY_NOTIFY pass */
+static uint64_t* seen_keys     = NULL;
+static uint32_t  seen_capacity = 0;
+
+/* Scratch space of the lane pass: lane per event, window -> latest lane */
+static uint8_t*              lanes           = NULL;
+static xcb_generic_event_t** sorted          = NULL;
+static uint32_t              lanes_capacity  = 0;
+static xcb_window_t*         lane_windows    = NULL;
+static uint8_t*              lane_of_window  = NULL;
+static uint32_t              window_capacity = 0;
+
+bool
+xcb_batch_push(XCBBatch* batch, xcb_generic_event_t* event)
+{
+  if (batch->count == batch->capacity) {
+    uint32_t              capacity = batch->capacity ? batch->capacity * 2 : XCB_BATCH_INITIAL_CAPACITY;
+    xcb_generic_event_t** events   = realloc(batch->events, capacity * sizeof(*events));
+    if (events == NULL) {
+      LOG_ERROR("xcb-batch: cannot grow batch to %u events", capacity);
+      return false;
+    }
+    batch->events   = events;
+    batch->capacity = capacity;
+  }
+
+  batch->events[batch->count++] = event;
+  stats.events++;
+  return true;
+}
+
+static uint8_t
+event_type(const xcb_generic_event_t* event)
+{
+  return event->response_type & ~0x80;
+}
+
+static bool
+is_raw_motion(const xcb_generic_event_t* event)
+{
+  const xcb_ge_generic_event_t* ge = (const xcb_ge_generic_event_t*) event;
+
+  return xinput_opcode != 0 && event_type(event) == XCB_GE_GENERIC && ge->extension == xinput_opcode && ge->event_type == XCB_INPUT_RAW_MOTION;
+}
+
+/* Index of the next event still in the batch after i, or count */
+static uint32_t
+next_live(xcb_generic_event_t** events, uint32_t count, uint32_t i)
+{
+  for (i++; i < count; i++) {
+    if (events[i] != NULL)
+      break;
+  }
+  return i;
+}
+
+static void
+drop(xcb_generic_event_t** events, uint32_t i)
+{
+  free(events[i]);
+  events[i] = NULL;
+}
+
+/*
+ * ENTER followed by a LEAVE of the same window, with no other crossing
+ * event in between, means the pointer merely passed over it. Not when
+ * either is an Inferior crossing: a LEAVE into a child leaves the pointer
+ * inside the window, and focus-follows-mouse still needs the ENTER.
+ */
+static void
+coalesce_crossing(xcb_generic_event_t** events, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    if (events[i] == NULL || event_type(events[i]) != XCB_ENTER_NOTIFY)
+      continue;
+
+    xcb_enter_notify_event_t* enter = (xcb_enter_notify_event_t*) events[i];
+
+    for (uint32_t j = i + 1; j < count; j++) {
+      if (events[j] == NULL)
+        continue;
+      uint8_t type = event_type(events[j]);
+      if (type != XCB_ENTER_NOTIFY && type != XCB_LEAVE_NOTIFY)
+        continue;
+
+      xcb_leave_notify_event_t* leave = (xcb_leave_notify_event_t*) events[j];
+      if (type == XCB_LEAVE_NOTIFY && leave->event == enter->event && leave->mode == enter->mode
+          && enter->detail != XCB_NOTIFY_DETAIL_INFERIOR && leave->detail != XCB_NOTIFY_DETAIL_INFERIOR) {
+        drop(events, i);
+        drop(events, j);
+        stats.dropped_crossing += 2;
+      }
+      break;
+    }
+  }
+}
+
+/*
+ * Only the last of a run of motion events matters: the handlers look at
+ * the pointer position, not at the path it took.
+ */
+static void
+coalesce_motion(xcb_generic_event_t** events, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    if (events[i] == NULL)
+      continue;
+
+    uint32_t j = next_live(events, count, i);
+    if (j == count)
+      break;
+
+    if (event_type(events[i]) == XCB_MOTION_NOTIFY && event_type(events[j]) == XCB_MOTION_NOTIFY) {
+      xcb_motion_notify_event_t* a = (xcb_motion_notify_event_t*) events[i];
+      xcb_motion_notify_event_t* b = (xcb_motion_notify_event_t*) events[j];
+      if (a->event == b->event) {
+        drop(events, i);
+        stats.dropped_motion++;
+      }
+    } else if (is_raw_motion(events[i]) && is_raw_motion(events[j])) {
+      xcb_input_raw_motion_event_t* a = (xcb_input_raw_motion_event_t*) events[i];
+      xcb_input_raw_motion_event_t* b = (xcb_input_raw_motion_event_t*) events[j];
+      if (a->deviceid == b->deviceid) {
+        drop(events, i);
+        stats.dropped_motion++;
+      }
+    }
+  }
+}
+
+/* Size and clear the scratch set for count keys; returns its capacity or 0 */
+static uint32_t
+reset_seen(uint32_t count)
+{
+  uint32_t capacity = 64;
+  while (capacity < count * 2)
+    capacity *= 2;
+
+  if (capacity > seen_capacity) {
+    uint64_t* keys = realloc(seen_keys, capacity * sizeof(*keys));
+    if (keys == NULL)
+      return 0;
+    seen_keys     = keys;
+    seen_capacity = capacity;
+  }
+  memset(seen_keys, 0, capacity * sizeof(*seen_keys));
+  return capacity;
+}
+
+/* Returns true if the key was already in the set */
+static bool
+seen_insert(uint64_t key, uint32_t mask)
+{
+  uint32_t slot = (uint32_t) ((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+
+  while (seen_keys[slot] != 0) {
+    if (seen_keys[slot] == key)
+      return true;
+    slot = (slot + 1) & mask;
+  }
+  seen_keys[slot] = key;
+  return false;
+}
+
+/*
+ * Handlers re-read the property anyway, so a PROPERTY_NOTIFY is superseded
+ * by any later one for the same (window, atom). Walk backwards and keep
+ * the first occurrence seen.
+ */
+static void
+coalesce_property(xcb_generic_event_t** events, uint32_t count)
+{
+  uint32_t properties = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (events[i] != NULL && event_type(events[i]) == XCB_PROPERTY_NOTIFY)
+      properties++;
+  }
+  if (properties < 2)
+    return;
+
+  uint32_t capacity = reset_seen(properties);
+  if (capacity == 0)
+    return;
+
+  for (uint32_t i = count; i-- > 0;) {
+    if (events[i] == NULL || event_type(events[i]) != XCB_PROPERTY_NOTIFY)
+      continue;
+
+    xcb_property_notify_event_t* ev = (xcb_property_notify_event_t*) events[i];
+    /* window is never None, so a key of 0 marks an empty slot */
+    uint64_t key = ((uint64_t) ev->window << 32) | ev->atom;
+    if (seen_insert(key, capacity - 1)) {
+      drop(events, i);
+      stats.dropped_property++;
+    }
+  }
+}
+
+uint32_t
+xcb_batch_coalesce(XCBBatch* batch)
+{
+  if (batch->count == 0)
+    return 0;
+
+  stats.batches++;
+
+  if (batch->count > 1) {
+    coalesce_crossing(batch->events, batch->count);
+    coalesce_motion(batch->events, batch->count);
+    coalesce_property(batch->events, batch->count);
+
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < batch->count; i++) {
+      if (batch->events[i] != NULL)
+        batch->events[kept++] = batch->events[i];
+    }
+    batch->count = kept;
+  }
+
+  stats.dispatched += batch->count;
+  return batch->count;
+}
+
+XCBLane
+xcb_batch_lane(const xcb_generic_event_t* event)
+{
+  /* Pointer and focus moves stay in order with the keys: a binding acts
+   * on the window the pointer entered before it was pressed */
+  switch (event_type(event)) {
+  case XCB_KEY_PRESS:
+  case XCB_KEY_RELEASE:
+  case XCB_BUTTON_PRESS:
+  case XCB_BUTTON_RELEASE:
+  case XCB_MOTION_NOTIFY:
+  case XCB_ENTER_NOTIFY:
+  case XCB_LEAVE_NOTIFY:
+  case XCB_FOCUS_IN:
+  case XCB_FOCUS_OUT:
+    return XCB_LANE_INPUT;
+
+  case XCB_MAP_REQUEST:
+  case XCB_UNMAP_NOTIFY:
+  case XCB_DESTROY_NOTIFY:
+  case XCB_CONFIGURE_REQUEST:
+    return XCB_LANE_STRUCTURAL;
+
+  case XCB_GE_GENERIC: {
+    const xcb_ge_generic_event_t* ge = (const xcb_ge_generic_event_t*) event;
+    if (xinput_opcode == 0 || ge->extension != xinput_opcode)
+      return XCB_LANE_BULK;
+    switch (ge->event_type) {
+    case XCB_INPUT_KEY_PRESS:
+    case XCB_INPUT_KEY_RELEASE:
+    case XCB_INPUT_BUTTON_PRESS:
+    case XCB_INPUT_BUTTON_RELEASE:
+    case XCB_INPUT_RAW_KEY_PRESS:
+    case XCB_INPUT_RAW_KEY_RELEASE:
+    case XCB_INPUT_RAW_BUTTON_PRESS:
+    case XCB_INPUT_RAW_BUTTON_RELEASE:
+    case XCB_INPUT_MOTION:
+    case XCB_INPUT_RAW_MOTION:
+    case XCB_INPUT_ENTER:
+    case XCB_INPUT_LEAVE:
+    case XCB_INPUT_FOCUS_IN:
+    case XCB_INPUT_FOCUS_OUT:
+      return XCB_LANE_INPUT;
+    default:
+      return XCB_LANE_BULK;
+    }
+  }
+
+  default:
+    return XCB_LANE_BULK;
+  }
+}
+
+/* Window an event is about, or XCB_NONE if it has none */
+static xcb_window_t
+event_window(const xcb_generic_event_t* event)
+{
+  switch (event_type(event)) {
+  case XCB_KEY_PRESS:
+  case XCB_KEY_RELEASE:
+  case XCB_BUTTON_PRESS:
+  case XCB_BUTTON_RELEASE:
+    return ((const xcb_key_press_event_t*) event)->event;
+  case XCB_MOTION_NOTIFY:
+    return ((const xcb_motion_notify_event_t*) event)->event;
+  case XCB_ENTER_NOTIFY:
+  case XCB_LEAVE_NOTIFY:
+    return ((const xcb_enter_notify_event_t*) event)->event;
+  case XCB_FOCUS_IN:
+  case XCB_FOCUS_OUT:
+    return ((const xcb_focus_in_event_t*) event)->event;
+  case XCB_EXPOSE:
+    return ((const xcb_expose_event_t*) event)->window;
+  case XCB_CREATE_NOTIFY:
+    return ((const xcb_create_notify_event_t*) event)->window;
+  case XCB_DESTROY_NOTIFY:
+    return ((const xcb_destroy_notify_event_t*) event)->window;
+  case XCB_UNMAP_NOTIFY:
+    return ((const xcb_unmap_notify_event_t*) event)->window;
+  case XCB_MAP_NOTIFY:
+    return ((const xcb_map_notify_event_t*) event)->window;
+  case XCB_MAP_REQUEST:
+    return ((const xcb_map_request_event_t*) event)->window;
+  case XCB_REPARENT_NOTIFY:
+    return ((const xcb_reparent_notify_event_t*) event)->window;
+  case XCB_CONFIGURE_NOTIFY:
+    return ((const xcb_configure_notify_event_t*) event)->window;
+  case XCB_CONFIGURE_REQUEST:
+    return ((const xcb_configure_request_event_t*) event)->window;
+  case XCB_PROPERTY_NOTIFY:
+    return ((const xcb_property_notify_event_t*) event)->window;
+  case XCB_CLIENT_MESSAGE:
+    return ((const xcb_client_message_event_t*) event)->window;
+  case XCB_GE_GENERIC: {
+    const xcb_ge_generic_event_t* ge = (const xcb_ge_generic_event_t*) event;
+    if (xinput_opcode == 0 || ge->extension != xinput_opcode)
+      return XCB_NONE;
+    switch (ge->event_type) {
+    case XCB_INPUT_KEY_PRESS:
+    case XCB_INPUT_KEY_RELEASE:
+    case XCB_INPUT_BUTTON_PRESS:
+    case XCB_INPUT_BUTTON_RELEASE:
+    case XCB_INPUT_MOTION:
+      return ((const xcb_input_key_press_event_t*) event)->event;
+    default:
+      return XCB_NONE;
+    }
+  }
+  default:
+    return XCB_NONE;
+  }
+}
+
+/*
+ * Size the lane scratch space for count events and clear the window table.
+ * Returns the table size to probe, which may be smaller than what an
+ * earlier batch allocated, or 0 on allocation failure.
+ */
+static uint32_t
+reserve_lanes(uint32_t count)
+{
+  if (count > lanes_capacity) {
+    uint8_t*              l = realloc(lanes, count * sizeof(*l));
+    xcb_generic_event_t** e = l != NULL ? realloc(sorted, count * sizeof(*e)) : NULL;
+    if (l != NULL)
+      lanes = l;
+    if (e == NULL)
+      return 0;
+    sorted         = e;
+    lanes_capacity = count;
+  }
+
+  uint32_t capacity = 64;
+  while (capacity < count * 2)
+    capacity *= 2;
+
+  if (capacity > window_capacity) {
+    xcb_window_t* w = realloc(lane_windows, capacity * sizeof(*w));
+    uint8_t*      v = w != NULL ? realloc(lane_of_window, capacity * sizeof(*v)) : NULL;
+    if (w != NULL)
+      lane_windows = w;
+    if (v == NULL)
+      return 0;
+    lane_of_window  = v;
+    window_capacity = capacity;
+  }
+  memset(lane_windows, 0, capacity * sizeof(*lane_windows));
+  return capacity;
+}
+
+/*
+ * Lane of the previous event of a window, recording the new one.
+ * Returns the lane the event must go in to stay behind its window's
+ * earlier events.
+ */
+static uint8_t
+window_lane(xcb_window_t window, uint8_t lane, uint32_t mask)
+{
+  uint32_t slot = (window * 0x9E3779B1U) & mask;
+
+  while (lane_windows[slot] != XCB_NONE && lane_windows[slot] != window)
+    slot = (slot + 1) & mask;
+
+  if (lane_windows[slot] == window && lane_of_window[slot] > lane)
+    lane = lane_of_window[slot];
+  lane_windows[slot]   = window;
+  lane_of_window[slot] = lane;
+  return lane;
+}
+
+void
+xcb_batch_prioritize(XCBBatch* batch)
+{
+  uint32_t count = batch->count;
+  if (count < 2)
+    return;
+
+  /* Skip the sort when the batch is already in lane order */
+  bool    ordered = true;
+  uint8_t last    = XCB_LANE_INPUT;
+  for (uint32_t i = 0; i < count && ordered; i++) {
+    uint8_t lane = xcb_batch_lane(batch->events[i]);
+    ordered      = lane >= last;
+    last         = lane;
+  }
+  if (ordered)
+    return;
+
+  /* Only the cleared part of the table is probed */
+  uint32_t capacity = reserve_lanes(count);
+  if (capacity == 0) {
+    LOG_ERROR("xcb-batch: no memory to prioritize %u events, dispatching in order", count);
+    return;
+  }
+
+  uint32_t per_lane[XCB_LANE_COUNT] = { 0 };
+  uint32_t mask                     = capacity - 1;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint8_t      lane   = xcb_batch_lane(batch->events[i]);
+    xcb_window_t window = event_window(batch->events[i]);
+    if (window != XCB_NONE) {
+      uint8_t held = window_lane(window, lane, mask);
+      stats.held += held != lane;
+      lane        = held;
+    }
+    lanes[i] = lane;
+    per_lane[lane]++;
+  }
+
+  /* Counting sort: stable within each lane */
+  uint32_t next[XCB_LANE_COUNT];
+  next[0] = 0;
+  for (int l = 1; l < XCB_LANE_COUNT; l++)
+    next[l] = next[l - 1] + per_lane[l - 1];
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t to = next[lanes[i]]++;
+    stats.promoted += to < i;
+    sorted[to] = batch->events[i];
+  }
+  memcpy(batch->events, sorted, count * sizeof(*sorted));
+}
+
+void
+xcb_batch_free(XCBBatch* batch)
+{
+  for (uint32_t i = 0; i < batch->count; i++)
+    free(batch->events[i]);
+  free(batch->events);
+  batch->events   = NULL;
+  batch->count    = 0;
+  batch->capacity = 0;
+}
+
+void
+xcb_batch_set_xinput_opcode(uint8_t opcode)
+{
+  xinput_opcode = opcode;
+}
+
+XCBBatchStats
+xcb_batch_get_stats(void)
+{
+  return stats;
+}
+
+void
+xcb_batch_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+void
+xcb_batch_count_flush(void)
+{
+  stats.flushes++;
+}
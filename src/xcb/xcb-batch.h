@@ -0,0 +1,117 @@
+/*
+ * XCB Event Batch - Drain-and-coalesce buffer for one loop wakeup
+ *
+ * Every wakeup of the main loop drains all events XCB has queued into a
+ * batch, drops the ones a later event in the same batch supersedes and
+ * dispatches the rest, followed by a single xcb_flush().
+ *
+ * Dropped events:
+ * - MOTION_NOTIFY followed by another MOTION_NOTIFY for the same window
+ * - XI2 raw motion followed by another raw motion from the same device
+ * - ENTER_NOTIFY matched by a LEAVE_NOTIFY for the same window (the
+ *   pointer only crossed it); both events of the pair are dropped,
+ *   unless either one crosses to or from a child (detail Inferior)
+ * - PROPERTY_NOTIFY for a (window, atom) that changes again later
+ *
+ * The kept events are then dispatched in priority lanes, so a key press
+ * does not wait behind a storm of notifications from some other client:
+ *
+ *   XCB_LANE_INPUT       KEY_*, BUTTON_*, motion, ENTER/LEAVE, FOCUS_*,
+ *                        and their XI2 counterparts
+ *   XCB_LANE_STRUCTURAL  MAP_REQUEST, UNMAP_NOTIFY, DESTROY_NOTIFY,
+ *                        CONFIGURE_REQUEST
+ *   XCB_LANE_BULK        everything else (PROPERTY_NOTIFY, CREATE_NOTIFY,
+ *                        EXPOSE, ...)
+ *
+ * Pointer and focus moves share the lane with key presses so that a
+ * binding acts on the window the pointer was in when it was pressed.
+ *
+ * Events of one window are never reordered: an event that follows a
+ * lower-priority event of its window stays behind it.
+ */
+
+#ifndef _WM_XCB_BATCH_H_
+#define _WM_XCB_BATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/*
+ * Batch buffer - owns the events it holds until they are dispatched
+ */
+typedef struct XCBBatch {
+  xcb_generic_event_t** events;
+  uint32_t              count;
+  uint32_t              capacity;
+} XCBBatch;
+
+/*
+ * Dispatch lanes, in dispatch order
+ */
+typedef enum XCBLane {
+  XCB_LANE_INPUT,
+  XCB_LANE_STRUCTURAL,
+  XCB_LANE_BULK,
+  XCB_LANE_COUNT,
+} XCBLane;
+
+/*
+ * Batch statistics
+ */
+typedef struct XCBBatchStats {
+  uint64_t batches;          /* non-empty batches processed */
+  uint64_t events;           /* events pushed into batches */
+  uint64_t dispatched;       /* events left after coalescing */
+  uint64_t dropped_motion;   /* core and XI2 raw motion events dropped */
+  uint64_t dropped_crossing; /* ENTER/LEAVE events dropped (2 per pair) */
+  uint64_t dropped_property; /* PROPERTY_NOTIFY events dropped */
+  uint64_t flushes;          /* xcb_flush() calls made for batches */
+  uint64_t promoted;         /* events dispatched ahead of an earlier event */
+  uint64_t held;             /* events kept behind an earlier event of their window */
+} XCBBatchStats;
+
+/*
+ * Append an event to the batch, taking ownership.
+ * Returns false on allocation failure; the caller keeps ownership then.
+ */
+bool xcb_batch_push(XCBBatch* batch, xcb_generic_event_t* event);
+
+/*
+ * Drop superseded events (freeing them) and compact the batch in place.
+ * Returns the number of events left.
+ */
+uint32_t xcb_batch_coalesce(XCBBatch* batch);
+
+/*
+ * Stable-sort the batch into lanes, keeping each window's events in
+ * arrival order. Call after xcb_batch_coalesce().
+ */
+void xcb_batch_prioritize(XCBBatch* batch);
+
+/*
+ * Lane an event is dispatched in, ignoring the window ordering rule.
+ */
+XCBLane xcb_batch_lane(const xcb_generic_event_t* event);
+
+/*
+ * Free all remaining events and the batch storage.
+ */
+void xcb_batch_free(XCBBatch* batch);
+
+/*
+ * Set the XInput major opcode used to recognise XI2 generic events.
+ * Zero (the default) disables XI2 coalescing.
+ */
+void xcb_batch_set_xinput_opcode(uint8_t opcode);
+
+/*
+ * Statistics
+ */
+XCBBatchStats xcb_batch_get_stats(void);
+void          xcb_batch_reset_stats(void);
+
+/* Record a batch flush (called by the event loop after dispatching) */
+void xcb_batch_count_flush(void);
+
+#endif /* _WM_XCB_BATCH_H_ */
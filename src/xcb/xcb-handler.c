@@ -1,7 +1,10 @@
 #include "xcb-handler.h"
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <xcb/randr.h>
+#include <xcb/xinput.h>
 
 #include "wm-hub.h"
 #include "wm-log.h"
@@ -13,15 +16,241 @@
 #define MAX_EVENT_TYPES       256
 #define MAX_HANDLERS_PER_TYPE 16
 
-/* Handler storage per event type */
+/*
+ * Handler storage per event type. handlers[] is kept sorted by priority
+ * and compiled[] mirrors it as a NULL-terminated array of function
+ * pointers, which is all dispatch reads.
+ */
 typedef struct {
-  XCBHandler handlers[MAX_HANDLERS_PER_TYPE];
-  int        count;
+  XCBHandlerFn compiled[MAX_HANDLERS_PER_TYPE + 1];
+  XCBHandler   handlers[MAX_HANDLERS_PER_TYPE];
+  int          count;
 } handler_bucket_t;
 
 static handler_bucket_t handlers[MAX_EVENT_TYPES];
 static uint32_t         total_handlers = 0;
 
+/*
+ * Extension events, one bucket table per extension indexed by the event
+ * number within the extension. Dispatch maps a response_type (or a
+ * GenericEvent's opcode) to its extension with one table lookup.
+ */
+static handler_bucket_t ext_handlers[XCB_EXT_COUNT - 1][XCB_HANDLER_MAX_EXT_EVENTS];
+
+typedef struct ExtensionInfo {
+  uint8_t major_opcode; /* 0 while unresolved */
+  uint8_t first_event;
+} ExtensionInfo;
+
+/* Events an extension sends outside GenericEvents */
+static const uint8_t extension_event_count[XCB_EXT_COUNT] = {
+  [XCB_EXT_RANDR]  = XCB_RANDR_NOTIFY + 1,
+  [XCB_EXT_XINPUT] = 0,
+};
+
+static ExtensionInfo extensions[XCB_EXT_COUNT];
+static uint8_t       extension_by_event[MAX_EVENT_TYPES]; /* response_type -> XCBExtension */
+static uint8_t       extension_by_opcode[256];            /* major opcode -> XCBExtension */
+
+static handler_bucket_t*
+bucket_for(XCBExtension extension, uint16_t event_type)
+{
+  if (extension == XCB_EXT_CORE)
+    return event_type < MAX_EVENT_TYPES ? &handlers[event_type] : NULL;
+  if ((unsigned int) extension >= XCB_EXT_COUNT || event_type >= XCB_HANDLER_MAX_EXT_EVENTS)
+    return NULL;
+  return &ext_handlers[extension - 1][event_type];
+}
+
+/* Rebuild a bucket's dispatch array after handlers[] changed */
+static void
+compile_bucket(handler_bucket_t* bucket)
+{
+  for (int i = 0; i < bucket->count; i++)
+    bucket->compiled[i] = bucket->handlers[i].handler;
+  bucket->compiled[bucket->count] = NULL;
+}
+
+/* Call a bucket's handlers until one consumes the event */
+static XCBHandlerResult
+run_bucket(const handler_bucket_t* bucket, void* event)
+{
+  for (const XCBHandlerFn* fn = bucket->compiled; *fn != NULL; fn++) {
+    if ((*fn)(event) == XCB_HANDLER_CONSUMED)
+      return XCB_HANDLER_CONSUMED;
+  }
+  return XCB_HANDLER_CONTINUE;
+}
+
+static void
+extensions_clear(void)
+{
+  memset(extensions, 0, sizeof(extensions));
+  memset(extension_by_event, XCB_EXT_CORE, sizeof(extension_by_event));
+  memset(extension_by_opcode, XCB_EXT_CORE, sizeof(extension_by_opcode));
+}
+
+/*
+ * PROPERTY_NOTIFY subscriptions, keyed by (atom, window) with
+ * window == XCB_NONE for "any window". Open addressing with linear
+ * probing; atom == XCB_ATOM_NONE marks an empty slot.
+ */
+#define MAX_HANDLERS_PER_PROPERTY 8
+#define PROPERTY_INITIAL_CAPACITY 32
+
+typedef struct PropertySub {
+  HubComponent* component;
+  XCBHandlerFn  handler;
+} PropertySub;
+
+typedef struct PropertySlot {
+  xcb_atom_t   atom;
+  xcb_window_t window;
+  int          count;
+  PropertySub  subs[MAX_HANDLERS_PER_PROPERTY];
+} PropertySlot;
+
+static PropertySlot*    property_slots    = NULL;
+static uint32_t         property_capacity = 0; /* power of two */
+static uint32_t         property_count    = 0; /* keys in use */
+static XCBPropertyStats property_stats;
+
+static uint32_t
+property_slot_for(xcb_atom_t atom, xcb_window_t window)
+{
+  uint32_t h = atom * 0x9E3779B1U ^ window * 0x85EBCA77U;
+  return (h ^ (h >> 16)) & (property_capacity - 1);
+}
+
+static PropertySlot*
+property_lookup(xcb_atom_t atom, xcb_window_t window)
+{
+  if (property_count == 0)
+    return NULL;
+
+  for (uint32_t i = property_slot_for(atom, window);; i = (i + 1) & (property_capacity - 1)) {
+    PropertySlot* s = &property_slots[i];
+    if (s->atom == atom && s->window == window)
+      return s;
+    if (s->atom == XCB_ATOM_NONE)
+      return NULL;
+  }
+}
+
+/* Rebuild the table at a given capacity, keeping only keys with handlers */
+static bool
+property_rehash(uint32_t new_capacity)
+{
+  PropertySlot* old_slots    = property_slots;
+  uint32_t      old_capacity = property_capacity;
+
+  PropertySlot* new_slots = calloc(new_capacity, sizeof(PropertySlot));
+  if (new_slots == NULL) {
+    LOG_ERROR("Cannot grow property subscriptions to %u keys", new_capacity);
+    return false;
+  }
+
+  property_slots    = new_slots;
+  property_capacity = new_capacity;
+  property_count    = 0;
+
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    PropertySlot* s = &old_slots[i];
+    if (s->atom == XCB_ATOM_NONE || s->count == 0)
+      continue;
+    uint32_t j = property_slot_for(s->atom, s->window);
+    while (property_slots[j].atom != XCB_ATOM_NONE)
+      j = (j + 1) & (property_capacity - 1);
+    property_slots[j] = *s;
+    property_count++;
+  }
+
+  free(old_slots);
+  return true;
+}
+
+static PropertySlot*
+property_lookup_or_insert(xcb_atom_t atom, xcb_window_t window)
+{
+  PropertySlot* s = property_lookup(atom, window);
+  if (s != NULL)
+    return s;
+
+  /* keep the load factor at or below one half */
+  if ((property_count + 1) * 2 > property_capacity) {
+    uint32_t new_capacity = property_capacity ? property_capacity * 2 : PROPERTY_INITIAL_CAPACITY;
+    if (!property_rehash(new_capacity))
+      return NULL;
+  }
+
+  uint32_t i = property_slot_for(atom, window);
+  while (property_slots[i].atom != XCB_ATOM_NONE)
+    i = (i + 1) & (property_capacity - 1);
+
+  s         = &property_slots[i];
+  s->atom   = atom;
+  s->window = window;
+  s->count  = 0;
+  property_count++;
+  return s;
+}
+
+/* Backward-shift deletion of an emptied key */
+static void
+property_remove(PropertySlot* s)
+{
+  uint32_t hole = (uint32_t) (s - property_slots);
+  uint32_t i    = hole;
+
+  for (;;) {
+    i = (i + 1) & (property_capacity - 1);
+    if (property_slots[i].atom == XCB_ATOM_NONE)
+      break;
+
+    uint32_t home = property_slot_for(property_slots[i].atom, property_slots[i].window);
+    if (((i - home) & (property_capacity - 1)) >= ((i - hole) & (property_capacity - 1))) {
+      property_slots[hole] = property_slots[i];
+      hole                 = i;
+    }
+  }
+
+  memset(&property_slots[hole], 0, sizeof(PropertySlot));
+  property_count--;
+}
+
+static void
+property_clear(void)
+{
+  free(property_slots);
+  property_slots    = NULL;
+  property_capacity = 0;
+  property_count    = 0;
+}
+
+/*
+ * Call the handlers of one key, adding the number called to *called.
+ * Returns XCB_HANDLER_CONSUMED if one of them consumed the event.
+ */
+static XCBHandlerResult
+property_deliver(xcb_atom_t atom, xcb_window_t window, void* event, int* called)
+{
+  PropertySlot* s = property_lookup(atom, window);
+  if (s == NULL)
+    return XCB_HANDLER_CONTINUE;
+
+  /* a handler may unsubscribe: iterate over a copy */
+  PropertySub subs[MAX_HANDLERS_PER_PROPERTY];
+  int         count = s->count;
+  memcpy(subs, s->subs, (size_t) count * sizeof(PropertySub));
+
+  for (int i = 0; i < count; i++) {
+    (*called)++;
+    if (subs[i].handler(event) == XCB_HANDLER_CONSUMED)
+      return XCB_HANDLER_CONSUMED;
+  }
+  return XCB_HANDLER_CONTINUE;
+}
+
 /*
  * Initialize the handler registry.
  */
@@ -29,7 +258,10 @@ void
 xcb_handler_init(void)
 {
   memset(handlers, 0, sizeof(handlers));
+  memset(ext_handlers, 0, sizeof(ext_handlers));
   total_handlers = 0;
+  property_clear();
+  extensions_clear();
   LOG_DEBUG("XCB handler registry initialized");
 }
 
@@ -40,7 +272,10 @@ void
 xcb_handler_shutdown(void)
 {
   memset(handlers, 0, sizeof(handlers));
+  memset(ext_handlers, 0, sizeof(ext_handlers));
   total_handlers = 0;
+  property_clear();
+  extensions_clear();
   LOG_DEBUG("XCB handler registry shutdown");
 }
 
@@ -48,7 +283,29 @@ xcb_handler_shutdown(void)
  * Register a handler for an XCB event type.
  */
 int
-xcb_handler_register(XCBEventType event_type, HubComponent* component, void (*handler)(void*))
+xcb_handler_register(XCBEventType event_type, HubComponent* component, XCBHandlerFn handler)
+{
+  return xcb_handler_register_priority(XCB_EXT_CORE, event_type, XCB_HANDLER_PRIORITY_DEFAULT,
+                                       component, handler);
+}
+
+/*
+ * Register a handler for an event of a given extension.
+ */
+int
+xcb_handler_register_ext(XCBExtension extension, uint16_t event_type, HubComponent* component,
+                         XCBHandlerFn handler)
+{
+  return xcb_handler_register_priority(extension, event_type, XCB_HANDLER_PRIORITY_DEFAULT,
+                                       component, handler);
+}
+
+/*
+ * Register a handler at its priority and recompile the bucket.
+ */
+int
+xcb_handler_register_priority(XCBExtension extension, uint16_t event_type, int priority,
+                              HubComponent* component, XCBHandlerFn handler)
 {
   if (handler == NULL) {
     LOG_ERROR("Cannot register NULL handler for event type %u", event_type);
@@ -60,34 +317,208 @@ xcb_handler_register(XCBEventType event_type, HubComponent* component, void (*ha
     return -1;
   }
 
-  if ((unsigned int) event_type >= MAX_EVENT_TYPES) {
-    LOG_ERROR("Event type %u exceeds maximum (%d)", event_type, MAX_EVENT_TYPES - 1);
+  handler_bucket_t* bucket = bucket_for(extension, event_type);
+  if (bucket == NULL) {
+    LOG_ERROR("Event type %u out of range for extension %d", event_type, extension);
     return -1;
   }
 
-  handler_bucket_t* bucket = &handlers[event_type];
   if (bucket->count >= MAX_HANDLERS_PER_TYPE) {
     LOG_ERROR("Too many handlers for event type %u (max %d)",
               event_type, MAX_HANDLERS_PER_TYPE);
     return -1;
   }
 
-  /* Add to array - no linked list management needed */
-  XCBHandler* h = &bucket->handlers[bucket->count];
-  h->event_type = event_type;
+  /* Insert after every handler of the same or higher priority */
+  int pos = bucket->count;
+  while (pos > 0 && bucket->handlers[pos - 1].priority < priority)
+    pos--;
+  memmove(&bucket->handlers[pos + 1], &bucket->handlers[pos],
+          (size_t) (bucket->count - pos) * sizeof(XCBHandler));
+
+  XCBHandler* h = &bucket->handlers[pos];
+  h->event_type = (XCBEventType) event_type;
+  h->extension  = extension;
+  h->priority   = priority;
   h->component  = component;
   h->handler    = handler;
   h->next       = NULL;
 
   bucket->count++;
   total_handlers++;
+  compile_bucket(bucket);
+
+  LOG_DEBUG("Registered handler for event type %u of extension %d at priority %d (component: %p)",
+            event_type, extension, priority, (void*) component);
+
+  return 0;
+}
+
+/*
+ * Resolve the event offsets of the extensions we dispatch.
+ */
+void
+xcb_handler_resolve_extensions(xcb_connection_t* conn)
+{
+  xcb_extension_t* ids[XCB_EXT_COUNT] = {
+    [XCB_EXT_RANDR]  = &xcb_randr_id,
+    [XCB_EXT_XINPUT] = &xcb_input_id,
+  };
+
+  /* Send every QueryExtension before waiting on the first */
+  for (int i = XCB_EXT_CORE + 1; i < XCB_EXT_COUNT; i++)
+    xcb_prefetch_extension_data(conn, ids[i]);
+
+  for (int i = XCB_EXT_CORE + 1; i < XCB_EXT_COUNT; i++) {
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(conn, ids[i]);
+    if (ext == NULL || !ext->present) {
+      LOG_DEBUG("Extension %d not present", i);
+      continue;
+    }
+    xcb_handler_set_extension((XCBExtension) i, ext->major_opcode, ext->first_event);
+  }
+}
+
+/*
+ * Record an extension's opcode and event base.
+ */
+void
+xcb_handler_set_extension(XCBExtension extension, uint8_t major_opcode, uint8_t first_event)
+{
+  if (extension == XCB_EXT_CORE || (unsigned int) extension >= XCB_EXT_COUNT)
+    return;
+
+  extensions[extension].major_opcode = major_opcode;
+  extensions[extension].first_event  = first_event;
+  extension_by_opcode[major_opcode]  = (uint8_t) extension;
+
+  for (int i = 0; i < extension_event_count[extension]; i++) {
+    if (first_event + i < MAX_EVENT_TYPES)
+      extension_by_event[first_event + i] = (uint8_t) extension;
+  }
+
+  LOG_DEBUG("Extension %d: opcode %u, first event %u", extension, major_opcode, first_event);
+}
+
+/*
+ * Major opcode of a resolved extension.
+ */
+uint8_t
+xcb_handler_extension_opcode(XCBExtension extension)
+{
+  if (extension == XCB_EXT_CORE || (unsigned int) extension >= XCB_EXT_COUNT)
+    return 0;
+  return extensions[extension].major_opcode;
+}
 
-  LOG_DEBUG("Registered handler for event type %u (component: %p)",
-            event_type, (void*) component);
+/*
+ * Subscribe to PROPERTY_NOTIFY for one atom (and optionally one window).
+ */
+int
+xcb_handler_register_property(xcb_atom_t atom, xcb_window_t window, HubComponent* component,
+                              XCBHandlerFn handler)
+{
+  if (handler == NULL || component == NULL) {
+    LOG_ERROR("Cannot register property handler without handler and component (atom %u)", atom);
+    return -1;
+  }
 
+  if (atom == XCB_ATOM_NONE) {
+    LOG_ERROR("Cannot subscribe to property XCB_ATOM_NONE");
+    return -1;
+  }
+
+  PropertySlot* s = property_lookup_or_insert(atom, window);
+  if (s == NULL)
+    return -1;
+
+  if (s->count >= MAX_HANDLERS_PER_PROPERTY) {
+    LOG_ERROR("Too many handlers for property %u on window %u (max %d)",
+              atom, window, MAX_HANDLERS_PER_PROPERTY);
+    return -1;
+  }
+
+  s->subs[s->count].component = component;
+  s->subs[s->count].handler   = handler;
+  s->count++;
+  total_handlers++;
+
+  LOG_DEBUG("Registered property handler for atom %u window %u (component: %p)",
+            atom, window, (void*) component);
   return 0;
 }
 
+/*
+ * Remove a component's subscription to (atom, window).
+ */
+int
+xcb_handler_unregister_property(xcb_atom_t atom, xcb_window_t window, HubComponent* component)
+{
+  PropertySlot* s = property_lookup(atom, window);
+  if (s == NULL)
+    return -1;
+
+  for (int i = 0; i < s->count; i++) {
+    if (s->subs[i].component != component)
+      continue;
+
+    memmove(&s->subs[i], &s->subs[i + 1], (size_t) (s->count - i - 1) * sizeof(PropertySub));
+    s->count--;
+    total_handlers--;
+    if (s->count == 0)
+      property_remove(s);
+    return 0;
+  }
+
+  return -1;
+}
+
+/*
+ * Number of handlers subscribed to exactly (atom, window).
+ */
+uint32_t
+xcb_handler_count_for_property(xcb_atom_t atom, xcb_window_t window)
+{
+  PropertySlot* s = property_lookup(atom, window);
+  return s ? (uint32_t) s->count : 0;
+}
+
+XCBPropertyStats
+xcb_handler_get_property_stats(void)
+{
+  return property_stats;
+}
+
+void
+xcb_handler_reset_property_stats(void)
+{
+  memset(&property_stats, 0, sizeof(property_stats));
+}
+
+/*
+ * Route a PROPERTY_NOTIFY: subscribers of (atom, any window), then of
+ * (atom, this window), then generic PROPERTY_NOTIFY handlers.
+ */
+static void
+dispatch_property_notify(xcb_property_notify_event_t* event)
+{
+  handler_bucket_t* bucket = &handlers[XCB_PROPERTY_NOTIFY];
+  int               called = 0;
+
+  XCBHandlerResult result = property_deliver(event->atom, XCB_NONE, event, &called);
+  if (result == XCB_HANDLER_CONTINUE && event->window != XCB_NONE)
+    result = property_deliver(event->atom, event->window, event, &called);
+  if (result == XCB_HANDLER_CONTINUE && bucket->count > 0) {
+    called++;
+    run_bucket(bucket, event);
+  }
+
+  if (called > 0)
+    property_stats.delivered++;
+  else
+    property_stats.dropped++;
+}
+
 /*
  * Lookup handlers for an event type.
  */
@@ -105,6 +536,42 @@ xcb_handler_lookup(XCBEventType event_type)
   return &handlers[event_type].handlers[0];
 }
 
+/*
+ * Lookup handlers for an extension event.
+ */
+XCBHandler*
+xcb_handler_lookup_ext(XCBExtension extension, uint16_t event_type)
+{
+  handler_bucket_t* bucket = bucket_for(extension, event_type);
+  if (bucket == NULL || bucket->count == 0) {
+    return NULL;
+  }
+
+  return &bucket->handlers[0];
+}
+
+/*
+ * Bucket for an event: extension events by their number within the
+ * extension, GenericEvents by opcode and event_type.
+ */
+static handler_bucket_t*
+bucket_for_event(const void* event, XCBEventType response_type)
+{
+  if (response_type == XCB_GE_GENERIC) {
+    const xcb_ge_generic_event_t* ge        = event;
+    XCBExtension                  extension = extension_by_opcode[ge->extension];
+    if (extension != XCB_EXT_CORE)
+      return bucket_for(extension, ge->event_type);
+    return &handlers[XCB_GE_GENERIC];
+  }
+
+  XCBExtension extension = extension_by_event[response_type];
+  if (extension != XCB_EXT_CORE)
+    return bucket_for(extension, response_type - extensions[extension].first_event);
+
+  return &handlers[response_type];
+}
+
 /*
  * Get next handler in chain.
  * Uses the event_type stored in the handler to directly access its bucket.
@@ -116,18 +583,19 @@ xcb_handler_next(XCBHandler* handler)
     return NULL;
   }
 
-  /* Direct bucket lookup using event_type stored in handler */
-  XCBEventType      event_type = handler->event_type;
-  handler_bucket_t* bucket     = &handlers[event_type];
+  /* Direct bucket lookup using the event stored in handler */
+  handler_bucket_t* bucket = bucket_for(handler->extension, handler->event_type);
+  if (bucket == NULL) {
+    return NULL;
+  }
 
-  /* Find current position in bucket */
-  for (int i = 0; i < bucket->count; i++) {
-    if (&bucket->handlers[i] == handler && i + 1 < bucket->count) {
-      return &bucket->handlers[i + 1];
-    }
+  /* Position in the bucket follows from the address */
+  ptrdiff_t i = handler - bucket->handlers;
+  if (i < 0 || i + 1 >= bucket->count) {
+    return NULL;
   }
 
-  return NULL;
+  return &bucket->handlers[i + 1];
 }
 
 /*
@@ -148,26 +616,45 @@ xcb_handler_dispatch(void* event)
    */
   XCBEventType event_type = ((uint8_t*) event)[0] & (uint8_t) ~0x80;
 
-  /* Look up first handler for this event type */
-  XCBHandler* handler = xcb_handler_lookup(event_type);
-  if (handler == NULL) {
+  /* Property changes are routed by atom, not woken up wholesale */
+  if (event_type == XCB_PROPERTY_NOTIFY) {
+    dispatch_property_notify((xcb_property_notify_event_t*) event);
+    return;
+  }
+
+  handler_bucket_t* bucket = bucket_for_event(event, event_type);
+  if (bucket == NULL || bucket->count == 0) {
     LOG_DEBUG("No handler registered for event type %u", event_type);
     return;
   }
 
-  /* Call all handlers for this event type */
-  int call_count = 0;
-  while (handler != NULL) {
-    if (handler->handler != NULL) {
-      LOG_DEBUG("Dispatching event type %u to handler (component: %p)",
-                event_type, (void*) handler->component);
-      handler->handler(event);
-      call_count++;
+  /* Compiled, priority-ordered handlers until one consumes the event */
+  run_bucket(bucket, event);
+}
+
+/* Remove a component's handlers from a bucket, keeping the order */
+static int
+remove_component(handler_bucket_t* bucket, HubComponent* component)
+{
+  int removed = 0;
+
+  for (int j = 0; j < bucket->count;) {
+    if (bucket->handlers[j].component == component) {
+      /* Stable removal: shift remaining handlers left */
+      memmove(&bucket->handlers[j],
+              &bucket->handlers[j + 1],
+              (bucket->count - j - 1) * sizeof(XCBHandler));
+      bucket->count--;
+      total_handlers--;
+      removed++;
+      /* Don't increment j - check the shifted element */
+    } else {
+      j++;
     }
-    handler = xcb_handler_next(handler);
   }
-
-  LOG_DEBUG("Dispatched event type %u to %d handler(s)", event_type, call_count);
+  if (removed > 0)
+    compile_bucket(bucket);
+  return removed;
 }
 
 /*
@@ -183,26 +670,32 @@ xcb_handler_unregister_component(HubComponent* component)
 
   int removed = 0;
 
-  /* Iterate through all event type buckets */
-  for (int i = 0; i < MAX_EVENT_TYPES; i++) {
-    handler_bucket_t* bucket = &handlers[i];
-
-    /* Scan bucket and remove matching handlers while preserving order */
-    for (int j = 0; j < bucket->count;) {
-      if (bucket->handlers[j].component == component) {
-        /* Stable removal: shift remaining handlers left */
-        memmove(&bucket->handlers[j],
-                &bucket->handlers[j + 1],
-                (bucket->count - j - 1) * sizeof(XCBHandler));
-        bucket->count--;
+  /* Iterate through all event type buckets, core then extensions */
+  for (int i = 0; i < MAX_EVENT_TYPES; i++)
+    removed += remove_component(&handlers[i], component);
+  for (int e = 0; e < XCB_EXT_COUNT - 1; e++) {
+    for (int i = 0; i < XCB_HANDLER_MAX_EXT_EVENTS; i++)
+      removed += remove_component(&ext_handlers[e][i], component);
+  }
+
+  /* Property subscriptions: drop the component's, then compact the table */
+  bool emptied = false;
+  for (uint32_t i = 0; i < property_capacity; i++) {
+    PropertySlot* s = &property_slots[i];
+    for (int j = 0; j < s->count;) {
+      if (s->subs[j].component == component) {
+        memmove(&s->subs[j], &s->subs[j + 1], (size_t) (s->count - j - 1) * sizeof(PropertySub));
+        s->count--;
         total_handlers--;
         removed++;
-        /* Don't increment j - check the shifted element */
+        emptied |= s->count == 0;
       } else {
         j++;
       }
     }
   }
+  if (emptied)
+    property_rehash(property_capacity);
 
   if (removed > 0) {
     LOG_DEBUG("Unregistered %d handler(s) for component: %p", removed, (void*) component);
@@ -229,4 +722,17 @@ xcb_handler_count_for_type(XCBEventType event_type)
   }
 
   return (uint32_t) handlers[event_type].count;
-}
\ No newline at end of file
+}
+/*
+ * Get handler count for an extension event.
+ */
+uint32_t
+xcb_handler_count_for_ext(XCBExtension extension, uint16_t event_type)
+{
+  handler_bucket_t* bucket = bucket_for(extension, event_type);
+  if (bucket == NULL) {
+    return 0;
+  }
+
+  return (uint32_t) bucket->count;
+}
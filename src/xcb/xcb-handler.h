@@ -14,13 +14,54 @@ typedef struct HubComponent HubComponent;
  */
 typedef uint8_t XCBEventType;
 
+/*
+ * Event sources. Extension events are registered by their number within
+ * the extension (XCB_RANDR_NOTIFY, XCB_INPUT_KEY_PRESS, ...); the offsets
+ * the server assigned are resolved at startup.
+ */
+typedef enum XCBExtension {
+  XCB_EXT_CORE,   /* core protocol, keyed by response_type */
+  XCB_EXT_RANDR,  /* keyed by response_type - first_event */
+  XCB_EXT_XINPUT, /* XI2 GenericEvents, keyed by event_type */
+  XCB_EXT_COUNT,
+} XCBExtension;
+
+/* Event types per extension bucket table */
+#define XCB_HANDLER_MAX_EXT_EVENTS 64
+
+/*
+ * What a handler did with an event
+ */
+typedef enum XCBHandlerResult {
+  XCB_HANDLER_CONTINUE, /* later handlers see the event too */
+  XCB_HANDLER_CONSUMED, /* stop propagation */
+} XCBHandlerResult;
+
+typedef XCBHandlerResult (*XCBHandlerFn)(void* event);
+
+/*
+ * Handler priorities: higher runs first, equal priorities run in
+ * registration order.
+ */
+#define XCB_HANDLER_PRIORITY_DEFAULT 0
+
+/*
+ * PROPERTY_NOTIFY routing statistics
+ */
+typedef struct XCBPropertyStats {
+  uint64_t delivered; /* events that reached at least one handler */
+  uint64_t dropped;   /* events for atoms nobody subscribed to */
+} XCBPropertyStats;
+
 /*
  * Handler structure - stores registration info
  */
 typedef struct XCBHandler {
   XCBEventType  event_type;
+  XCBExtension  extension;
+  int           priority;
   HubComponent* component;
-  void (*handler)(void* event);
+  XCBHandlerFn  handler;
   struct XCBHandler* next;
 } XCBHandler;
 
@@ -45,9 +86,92 @@ void xcb_handler_shutdown(void);
  * @return             0 on success, -1 on failure
  *
  * Multiple handlers can be registered for the same event type.
- * All handlers will be called in registration order.
+ * They are called in registration order until one returns
+ * XCB_HANDLER_CONSUMED.
+ */
+int xcb_handler_register(XCBEventType event_type, HubComponent* component, XCBHandlerFn handler);
+
+/*
+ * Register a handler for an extension event.
+ *
+ * @param extension    Extension the event belongs to
+ * @param event_type   Event number within the extension (for XI2, the
+ *                     GenericEvent event_type)
+ * @param component    Component owning this handler
+ * @param handler      Handler function to call when event occurs
+ * @return             0 on success, -1 on failure
+ *
+ * Can be called before the extension is resolved; events only arrive
+ * once xcb_handler_resolve_extensions() has run. XCB_EXT_CORE is the
+ * same as xcb_handler_register().
+ */
+int xcb_handler_register_ext(XCBExtension extension, uint16_t event_type, HubComponent* component,
+                             XCBHandlerFn handler);
+
+/*
+ * Register a handler with an explicit priority.
+ *
+ * @param priority     Higher runs earlier; XCB_HANDLER_PRIORITY_DEFAULT
+ *                     is what the other register functions use
+ *
+ * Each event type keeps its handlers compiled into a priority-sorted,
+ * NULL-terminated array of function pointers. It is rebuilt here and on
+ * unregistration, so dispatch is a plain loop over that array.
+ */
+int xcb_handler_register_priority(XCBExtension extension, uint16_t event_type, int priority,
+                                  HubComponent* component, XCBHandlerFn handler);
+
+/*
+ * Look up where the server put each extension's events (first_event for
+ * RandR, major opcode for XI2). Cached by XCB, so no extra round trip
+ * after the extensions have been queried once.
+ */
+void xcb_handler_resolve_extensions(xcb_connection_t* conn);
+
+/*
+ * Record an extension's offsets (done by xcb_handler_resolve_extensions()).
+ */
+void xcb_handler_set_extension(XCBExtension extension, uint8_t major_opcode, uint8_t first_event);
+
+/*
+ * Major opcode of a resolved extension, or 0 if it is not present.
+ */
+uint8_t xcb_handler_extension_opcode(XCBExtension extension);
+
+/*
+ * Subscribe to PROPERTY_NOTIFY for one atom.
+ *
+ * @param atom         Property atom (must not be XCB_ATOM_NONE)
+ * @param window       Window to watch, or XCB_NONE for every window
+ * @param component    Component owning this handler
+ * @param handler      Called with the xcb_property_notify_event_t
+ * @return             0 on success, -1 on failure
+ *
+ * Dispatch looks up (atom, XCB_NONE) and (atom, window) directly, so a
+ * property event costs two hash lookups however many atoms are watched.
+ * Events for atoms with no subscriber and no generic PROPERTY_NOTIFY
+ * handler are dropped before any component code runs.
+ * XCB_HANDLER_CONSUMED stops the event there, generic handlers included.
+ */
+int xcb_handler_register_property(xcb_atom_t atom, xcb_window_t window, HubComponent* component,
+                                  XCBHandlerFn handler);
+
+/*
+ * Remove a component's subscription to (atom, window).
+ * Returns 0 if a subscription was removed, -1 otherwise.
+ */
+int xcb_handler_unregister_property(xcb_atom_t atom, xcb_window_t window, HubComponent* component);
+
+/*
+ * Number of handlers subscribed to exactly (atom, window).
+ */
+uint32_t xcb_handler_count_for_property(xcb_atom_t atom, xcb_window_t window);
+
+/*
+ * PROPERTY_NOTIFY routing statistics
  */
-int xcb_handler_register(XCBEventType event_type, HubComponent* component, void (*handler)(void*));
+XCBPropertyStats xcb_handler_get_property_stats(void);
+void             xcb_handler_reset_property_stats(void);
 
 /*
  * Lookup handlers for an event type.
@@ -60,7 +184,12 @@ int xcb_handler_register(XCBEventType event_type, HubComponent* component, void
 XCBHandler* xcb_handler_lookup(XCBEventType event_type);
 
 /*
- * Get next handler in chain for same event type.
+ * Lookup handlers for an extension event.
+ */
+XCBHandler* xcb_handler_lookup_ext(XCBExtension extension, uint16_t event_type);
+
+/*
+ * Get next handler in chain for same event type, in dispatch order.
  * Use after xcb_handler_lookup() to iterate all handlers.
  */
 XCBHandler* xcb_handler_next(XCBHandler* handler);
@@ -71,12 +200,17 @@ XCBHandler* xcb_handler_next(XCBHandler* handler);
  * @param event        The XCB event to dispatch (void* for type independence)
  *
  * Calls all handlers registered for the event's response_type (with synthetic
- * event flag masked off). The event is NOT freed - caller retains ownership.
+ * event flag masked off). Events in a resolved extension's range go to that
+ * extension's handlers, and GenericEvents are routed by extension opcode and
+ * event_type; GenericEvents of other extensions go to XCB_GE_GENERIC
+ * handlers. Stops at the first handler returning XCB_HANDLER_CONSUMED.
+ * The event is NOT freed - caller retains ownership.
  */
 void xcb_handler_dispatch(void* event);
 
 /*
- * Unregister all handlers for a component.
+ * Unregister all handlers for a component, property subscriptions
+ * included.
  *
  * @param component    Component whose handlers to remove
  *
@@ -94,4 +228,9 @@ uint32_t xcb_handler_count(void);
  */
 uint32_t xcb_handler_count_for_type(XCBEventType event_type);
 
+/*
+ * Get handler count for an extension event.
+ */
+uint32_t xcb_handler_count_for_ext(XCBExtension extension, uint16_t event_type);
+
 #endif /* _WM_XCB_HANDLER_H_ */
\ No newline at end of file
@@ -0,0 +1,377 @@
+#include "xcb-mirror.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "wm-log.h"
+
+#define XCB_MIRROR_INITIAL_CAPACITY 64
+
+/* Map state as far as the mirror knows */
+enum {
+  MIRROR_MAP_UNKNOWN = 0,
+  MIRROR_MAP_MAPPED,
+  MIRROR_MAP_UNMAPPED,
+};
+
+/*
+ * Mirror entry. window == XCB_NONE marks an empty slot; the table uses
+ * linear probing with backward-shift deletion, so there are no tombstones.
+ */
+typedef struct MirrorEntry {
+  xcb_window_t   window;
+  uint16_t       known; /* XCB_CONFIG_WINDOW_* bits with a valid value */
+  uint8_t        map_state;
+  bool           stacked; /* linked into the stacking order below */
+  xcb_window_t   above;   /* next window up, XCB_NONE at the top */
+  xcb_window_t   below;   /* next window down, XCB_NONE at the bottom */
+  XCBWindowState state;
+} MirrorEntry;
+
+static MirrorEntry*   entries  = NULL;
+static uint32_t       capacity = 0; /* power of two */
+static uint32_t       count    = 0;
+static XCBMirrorStats stats;
+
+/*
+ * Stacking order of the windows restacked so far, linked by window ID so
+ * the links survive the table moving entries around.
+ */
+static xcb_window_t stack_top    = XCB_NONE;
+static xcb_window_t stack_bottom = XCB_NONE;
+
+static uint32_t
+slot_for(xcb_window_t window)
+{
+  /* XIDs share their high bits per client: mix before masking */
+  uint32_t h = window * 0x9E3779B1U;
+  return (h ^ (h >> 16)) & (capacity - 1);
+}
+
+static MirrorEntry*
+lookup(xcb_window_t window)
+{
+  if (capacity == 0)
+    return NULL;
+
+  for (uint32_t i = slot_for(window);; i = (i + 1) & (capacity - 1)) {
+    if (entries[i].window == window)
+      return &entries[i];
+    if (entries[i].window == XCB_NONE)
+      return NULL;
+  }
+}
+
+static bool
+grow(void)
+{
+  uint32_t     old_capacity = capacity;
+  MirrorEntry* old_entries  = entries;
+  uint32_t     new_capacity = capacity ? capacity * 2 : XCB_MIRROR_INITIAL_CAPACITY;
+
+  MirrorEntry* new_entries = calloc(new_capacity, sizeof(MirrorEntry));
+  if (new_entries == NULL) {
+    LOG_ERROR("xcb-mirror: cannot grow to %u windows", new_capacity);
+    return false;
+  }
+
+  entries  = new_entries;
+  capacity = new_capacity;
+
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old_entries[i].window == XCB_NONE)
+      continue;
+    uint32_t j = slot_for(old_entries[i].window);
+    while (entries[j].window != XCB_NONE)
+      j = (j + 1) & (capacity - 1);
+    entries[j] = old_entries[i];
+  }
+
+  free(old_entries);
+  return true;
+}
+
+/* Find or create the entry for a window; NULL only on allocation failure */
+static MirrorEntry*
+lookup_or_insert(xcb_window_t window)
+{
+  MirrorEntry* e = lookup(window);
+  if (e != NULL)
+    return e;
+
+  /* keep the load factor below 3/4 */
+  if ((count + 1) * 4 > capacity * 3 && !grow())
+    return NULL;
+
+  uint32_t i = slot_for(window);
+  while (entries[i].window != XCB_NONE)
+    i = (i + 1) & (capacity - 1);
+
+  memset(&entries[i], 0, sizeof(MirrorEntry));
+  entries[i].window = window;
+  count++;
+  return &entries[i];
+}
+
+/* Take a window out of the stacking order: its position is unknown */
+static void
+stack_unlink(MirrorEntry* e)
+{
+  if (!e->stacked)
+    return;
+
+  if (e->above != XCB_NONE)
+    lookup(e->above)->below = e->below;
+  else
+    stack_top = e->below;
+
+  if (e->below != XCB_NONE)
+    lookup(e->below)->above = e->above;
+  else
+    stack_bottom = e->above;
+
+  e->stacked = false;
+  e->above   = XCB_NONE;
+  e->below   = XCB_NONE;
+}
+
+/* Link an unstacked window in between two adjacent ones */
+static void
+stack_link(MirrorEntry* e, xcb_window_t above, xcb_window_t below)
+{
+  e->stacked = true;
+  e->above   = above;
+  e->below   = below;
+
+  if (above != XCB_NONE)
+    lookup(above)->below = e->window;
+  else
+    stack_top = e->window;
+
+  if (below != XCB_NONE)
+    lookup(below)->above = e->window;
+  else
+    stack_bottom = e->window;
+}
+
+/*
+ * Whether restacking e changes nothing: it already sits where the request
+ * would put it. TopIf, BottomIf and Opposite depend on overlaps, so they
+ * are never known to be no-ops.
+ */
+static bool
+stack_in_place(const MirrorEntry* e, const MirrorEntry* sibling, uint8_t stack_mode)
+{
+  if (!e->stacked || (sibling != NULL && !sibling->stacked))
+    return false;
+
+  switch (stack_mode) {
+  case XCB_STACK_MODE_ABOVE:
+    return sibling ? e->below == sibling->window : e->above == XCB_NONE;
+  case XCB_STACK_MODE_BELOW:
+    return sibling ? e->above == sibling->window : e->below == XCB_NONE;
+  default:
+    return false;
+  }
+}
+
+/* Move e where a restack that was sent puts it */
+static void
+stack_apply(MirrorEntry* e, xcb_window_t sibling_window, uint8_t stack_mode)
+{
+  stack_unlink(e);
+
+  MirrorEntry* sibling = sibling_window != XCB_NONE ? lookup(sibling_window) : NULL;
+  if (sibling_window != XCB_NONE && (sibling == NULL || !sibling->stacked))
+    return;
+
+  switch (stack_mode) {
+  case XCB_STACK_MODE_ABOVE:
+    if (sibling)
+      stack_link(e, sibling->above, sibling->window);
+    else
+      stack_link(e, XCB_NONE, stack_top);
+    break;
+  case XCB_STACK_MODE_BELOW:
+    if (sibling)
+      stack_link(e, sibling->window, sibling->below);
+    else
+      stack_link(e, stack_bottom, XCB_NONE);
+    break;
+  default:
+    break;
+  }
+}
+
+uint16_t
+xcb_mirror_filter_configure(xcb_window_t window, uint16_t mask, const XCBWindowState* wanted, uint32_t* values)
+{
+  MirrorEntry  scratch = { .window = window };
+  MirrorEntry* e       = lookup_or_insert(window);
+
+  /* no mirror entry: nothing is known, so everything is sent */
+  if (e == NULL)
+    e = &scratch;
+
+  mask &= XCB_MIRROR_CONFIG_MASK | XCB_MIRROR_RESTACK_MASK;
+
+  /* a sibling without a stack mode is a protocol error: drop it */
+  if (!(mask & XCB_CONFIG_WINDOW_STACK_MODE))
+    mask &= (uint16_t) ~XCB_CONFIG_WINDOW_SIBLING;
+
+  uint16_t changed = 0;
+  uint32_t n       = 0;
+
+  /* X protocol order: x, y, width, height, border, sibling, stack mode */
+#define MIRROR_FIELD(BIT, FIELD, VALUE)                                \
+  if (mask & (BIT)) {                                                  \
+    if (!(e->known & (BIT)) || e->state.FIELD != wanted->FIELD) {      \
+      changed |= (BIT);                                                \
+      values[n++]    = (VALUE);                                        \
+      e->state.FIELD = wanted->FIELD;                                  \
+    }                                                                  \
+  }
+
+  MIRROR_FIELD(XCB_CONFIG_WINDOW_X, x, (uint32_t) wanted->x)
+  MIRROR_FIELD(XCB_CONFIG_WINDOW_Y, y, (uint32_t) wanted->y)
+  MIRROR_FIELD(XCB_CONFIG_WINDOW_WIDTH, width, wanted->width)
+  MIRROR_FIELD(XCB_CONFIG_WINDOW_HEIGHT, height, wanted->height)
+  MIRROR_FIELD(XCB_CONFIG_WINDOW_BORDER_WIDTH, border_width, wanted->border_width)
+
+#undef MIRROR_FIELD
+
+  /* Sent as a whole unless the window already sits where it would go */
+  if (mask & XCB_CONFIG_WINDOW_STACK_MODE) {
+    xcb_window_t sibling = (mask & XCB_CONFIG_WINDOW_SIBLING) ? wanted->sibling : XCB_NONE;
+    MirrorEntry* other   = sibling != XCB_NONE ? lookup(sibling) : NULL;
+
+    if (e == &scratch || sibling == window ||
+        (sibling != XCB_NONE && other == NULL) ||
+        !stack_in_place(e, other, wanted->stack_mode)) {
+      changed |= mask & XCB_MIRROR_RESTACK_MASK;
+      if (sibling != XCB_NONE)
+        values[n++] = sibling;
+      values[n++] = wanted->stack_mode;
+      if (e != &scratch)
+        stack_apply(e, sibling, wanted->stack_mode);
+    }
+  }
+
+  e->known |= mask & XCB_MIRROR_CONFIG_MASK;
+
+  if (changed == 0) {
+    stats.configures_elided++;
+  } else {
+    stats.configures_sent++;
+    stats.fields_elided += (uint64_t) (__builtin_popcount(mask) - __builtin_popcount(changed));
+  }
+
+  return changed;
+}
+
+bool
+xcb_mirror_filter_map(xcb_window_t window, bool mapped)
+{
+  uint8_t      wanted = mapped ? MIRROR_MAP_MAPPED : MIRROR_MAP_UNMAPPED;
+  MirrorEntry* e      = lookup_or_insert(window);
+
+  if (e != NULL && e->map_state == wanted) {
+    stats.maps_elided++;
+    return false;
+  }
+
+  if (e != NULL)
+    e->map_state = wanted;
+  stats.maps_sent++;
+  return true;
+}
+
+void
+xcb_mirror_seed(xcb_window_t window, uint16_t mask, const XCBWindowState* state, bool mapped)
+{
+  MirrorEntry* e = lookup_or_insert(window);
+  if (e == NULL)
+    return;
+
+  mask &= XCB_MIRROR_CONFIG_MASK;
+  if (mask & XCB_CONFIG_WINDOW_X)
+    e->state.x = state->x;
+  if (mask & XCB_CONFIG_WINDOW_Y)
+    e->state.y = state->y;
+  if (mask & XCB_CONFIG_WINDOW_WIDTH)
+    e->state.width = state->width;
+  if (mask & XCB_CONFIG_WINDOW_HEIGHT)
+    e->state.height = state->height;
+  if (mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+    e->state.border_width = state->border_width;
+
+  e->known |= mask;
+  e->map_state = mapped ? MIRROR_MAP_MAPPED : MIRROR_MAP_UNMAPPED;
+}
+
+void
+xcb_mirror_note_unmapped(xcb_window_t window)
+{
+  MirrorEntry* e = lookup(window);
+  if (e != NULL)
+    e->map_state = MIRROR_MAP_UNMAPPED;
+}
+
+void
+xcb_mirror_forget(xcb_window_t window)
+{
+  MirrorEntry* e = lookup(window);
+  if (e == NULL)
+    return;
+
+  stack_unlink(e);
+
+  /* backward-shift: pull later members of the probe run into the hole */
+  uint32_t hole = (uint32_t) (e - entries);
+  uint32_t i    = hole;
+
+  for (;;) {
+    i = (i + 1) & (capacity - 1);
+    if (entries[i].window == XCB_NONE)
+      break;
+
+    uint32_t home = slot_for(entries[i].window);
+    /* entry i may move to hole only if hole lies within [home, i) cyclically */
+    if (((i - home) & (capacity - 1)) >= ((i - hole) & (capacity - 1))) {
+      entries[hole] = entries[i];
+      hole          = i;
+    }
+  }
+
+  entries[hole].window = XCB_NONE;
+  count--;
+}
+
+void
+xcb_mirror_clear(void)
+{
+  free(entries);
+  entries      = NULL;
+  capacity     = 0;
+  count        = 0;
+  stack_top    = XCB_NONE;
+  stack_bottom = XCB_NONE;
+}
+
+uint32_t
+xcb_mirror_count(void)
+{
+  return count;
+}
+
+XCBMirrorStats
+xcb_mirror_get_stats(void)
+{
+  return stats;
+}
+
+void
+xcb_mirror_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,116 @@
+/*
+ * XCB Window Mirror - What we last told the X server about each window
+ *
+ * Keeps, per window, the geometry, border width and map state most
+ * recently sent, and the stacking order the restacks sent so far produced.
+ * Configure requests are reduced to the fields that differ from the
+ * mirror, and configures, restacks or maps that would change nothing are
+ * not sent at all.
+ *
+ * Only the window manager moves, resizes or maps managed windows
+ * (SubstructureRedirect), so the mirror stays accurate as long as
+ * server-side changes are reported to it:
+ * - xcb_mirror_note_unmapped() on UNMAP_NOTIFY (client withdrew itself)
+ * - xcb_mirror_forget() on DESTROY_NOTIFY
+ *
+ * Stacking is relative to the other windows, so a restack is only elided
+ * when the window already sits where it would go: directly above or below
+ * its sibling, or at the top or bottom without one. The order covers only
+ * windows restacked through the mirror; an unknown sibling and TopIf,
+ * BottomIf or Opposite are always sent, and leave the window's position
+ * unknown until its next Above or Below.
+ */
+
+#ifndef _WM_XCB_MIRROR_H_
+#define _WM_XCB_MIRROR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/* Configure fields tracked by the mirror */
+#define XCB_MIRROR_CONFIG_MASK                                           \
+  (XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | \
+   XCB_CONFIG_WINDOW_HEIGHT | XCB_CONFIG_WINDOW_BORDER_WIDTH)
+
+/* Restack fields, sent or elided together */
+#define XCB_MIRROR_RESTACK_MASK (XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE)
+
+/*
+ * Window state as requested by the caller
+ */
+typedef struct XCBWindowState {
+  int16_t      x;
+  int16_t      y;
+  uint16_t     width;
+  uint16_t     height;
+  uint16_t     border_width;
+  xcb_window_t sibling;    /* stack_mode is relative to it, XCB_NONE for all windows */
+  uint8_t      stack_mode; /* checked against the stacking order, not stored */
+} XCBWindowState;
+
+/*
+ * Mirror statistics
+ */
+typedef struct XCBMirrorStats {
+  uint64_t configures_sent;   /* configure requests that went out */
+  uint64_t configures_elided; /* configure requests dropped as no-ops */
+  uint64_t fields_elided;     /* individual fields left out of sent configures */
+  uint64_t maps_sent;         /* map and unmap requests that went out */
+  uint64_t maps_elided;       /* map and unmap requests dropped as no-ops */
+} XCBMirrorStats;
+
+/*
+ * Reduce a configure to the fields that changed.
+ *
+ * @param window  Window being configured
+ * @param mask    XCB_CONFIG_WINDOW_* bits the caller wants to set: those
+ *                in XCB_MIRROR_CONFIG_MASK and XCB_MIRROR_RESTACK_MASK
+ *                (other bits are ignored, SIBLING without STACK_MODE too)
+ * @param wanted  Requested values
+ * @param values  Output value list in X protocol order, room for 7 entries
+ * @return        Mask of fields to send, 0 if the request is a no-op
+ *
+ * The mirror is updated as if the returned request was sent.
+ */
+uint16_t xcb_mirror_filter_configure(xcb_window_t window, uint16_t mask, const XCBWindowState* wanted, uint32_t* values);
+
+/*
+ * Check whether a map (mapped = true) or unmap request is needed.
+ * Returns true if it must be sent; the mirror is updated accordingly.
+ */
+bool xcb_mirror_filter_map(xcb_window_t window, bool mapped);
+
+/*
+ * Record state a window already has on the server without counting a
+ * request (windows adopted at startup). Only fields in mask are stored.
+ */
+void xcb_mirror_seed(xcb_window_t window, uint16_t mask, const XCBWindowState* state, bool mapped);
+
+/*
+ * Record that the server unmapped a window on its own.
+ */
+void xcb_mirror_note_unmapped(xcb_window_t window);
+
+/*
+ * Drop everything known about a window (destroyed or unmanaged).
+ */
+void xcb_mirror_forget(xcb_window_t window);
+
+/*
+ * Drop all windows and free the mirror storage.
+ */
+void xcb_mirror_clear(void);
+
+/*
+ * Number of windows currently mirrored.
+ */
+uint32_t xcb_mirror_count(void);
+
+/*
+ * Statistics
+ */
+XCBMirrorStats xcb_mirror_get_stats(void);
+void           xcb_mirror_reset_stats(void);
+
+#endif /* _WM_XCB_MIRROR_H_ */
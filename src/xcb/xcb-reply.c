@@ -0,0 +1,192 @@
+#include "xcb-reply.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <xcb/xcbext.h>
+
+#include "wm-log.h"
+
+#define XCB_REPLY_INITIAL_CAPACITY 32
+
+/*
+ * Pending continuation. Continuations sit in a ring in request order;
+ * handler == NULL marks one completed out of order by xcb_reply_complete().
+ */
+typedef struct ReplyEntry {
+  unsigned int    sequence;
+  TargetID        target;
+  XCBReplyHandler handler;
+  void*           userdata;
+} ReplyEntry;
+
+static ReplyEntry*   entries  = NULL;
+static uint32_t      capacity = 0; /* power of two */
+static uint32_t      head     = 0;
+static uint32_t      count    = 0; /* ring slots in use, including holes */
+static uint32_t      live     = 0; /* continuations still waiting */
+static XCBReplyStats stats;
+
+static bool
+grow(void)
+{
+  uint32_t    new_capacity = capacity ? capacity * 2 : XCB_REPLY_INITIAL_CAPACITY;
+  ReplyEntry* new_entries  = malloc(new_capacity * sizeof(ReplyEntry));
+  if (new_entries == NULL) {
+    LOG_ERROR("xcb-reply: cannot grow to %u continuations", new_capacity);
+    return false;
+  }
+
+  /* unwrap the ring so it starts at index 0 */
+  for (uint32_t i = 0; i < count; i++)
+    new_entries[i] = entries[(head + i) & (capacity - 1)];
+
+  free(entries);
+  entries  = new_entries;
+  capacity = new_capacity;
+  head     = 0;
+  return true;
+}
+
+static void
+pop_head(void)
+{
+  head = (head + 1) & (capacity - 1);
+  count--;
+}
+
+/* Drop completed holes from the front of the ring */
+static void
+trim_head(void)
+{
+  while (count > 0 && entries[head].handler == NULL)
+    pop_head();
+}
+
+/* Run (or drop) a continuation that was already taken off the ring */
+static void
+run(const ReplyEntry* e, void* reply, xcb_generic_error_t* error)
+{
+  if (e->target != TARGET_ID_NONE && hub_get_target_by_id(e->target) == NULL) {
+    LOG_DEBUG("xcb-reply: target %" PRIu64 " gone, dropping reply for sequence %u",
+              e->target, e->sequence);
+    stats.dropped++;
+  } else {
+    if (error != NULL)
+      stats.errors++;
+    else
+      stats.completed++;
+    e->handler(e->target, reply, error, e->userdata);
+  }
+
+  free(reply);
+  free(error);
+}
+
+bool
+xcb_reply_register(unsigned int sequence, TargetID target, XCBReplyHandler handler, void* userdata)
+{
+  if (handler == NULL)
+    return false;
+
+  if (count == capacity && !grow())
+    return false;
+
+  ReplyEntry* e = &entries[(head + count) & (capacity - 1)];
+  e->sequence   = sequence;
+  e->target     = target;
+  e->handler    = handler;
+  e->userdata   = userdata;
+
+  count++;
+  live++;
+  stats.registered++;
+  return true;
+}
+
+uint32_t
+xcb_reply_process(xcb_connection_t* conn)
+{
+  uint32_t done = 0;
+
+  if (conn == NULL)
+    return 0;
+
+  trim_head();
+  while (count > 0) {
+    void*                reply = NULL;
+    xcb_generic_error_t* error = NULL;
+
+    if (!xcb_poll_for_reply(conn, entries[head].sequence, &reply, &error))
+      break;
+
+    /* the handler may register new continuations and move the ring */
+    ReplyEntry e = entries[head];
+    pop_head();
+    live--;
+
+    run(&e, reply, error);
+    done++;
+    trim_head();
+  }
+
+  return done;
+}
+
+bool
+xcb_reply_complete(unsigned int sequence, void* reply, xcb_generic_error_t* error)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    ReplyEntry* slot = &entries[(head + i) & (capacity - 1)];
+    if (slot->handler == NULL || slot->sequence != sequence)
+      continue;
+
+    ReplyEntry e  = *slot;
+    slot->handler = NULL;
+    live--;
+    trim_head();
+
+    run(&e, reply, error);
+    return true;
+  }
+
+  free(reply);
+  free(error);
+  return false;
+}
+
+void
+xcb_reply_clear(xcb_connection_t* conn)
+{
+  if (conn != NULL) {
+    for (uint32_t i = 0; i < count; i++) {
+      ReplyEntry* e = &entries[(head + i) & (capacity - 1)];
+      if (e->handler != NULL)
+        xcb_discard_reply(conn, e->sequence);
+    }
+  }
+
+  free(entries);
+  entries  = NULL;
+  capacity = 0;
+  head     = 0;
+  count    = 0;
+  live     = 0;
+}
+
+uint32_t
+xcb_reply_pending(void)
+{
+  return live;
+}
+
+XCBReplyStats
+xcb_reply_get_stats(void)
+{
+  return stats;
+}
+
+void
+xcb_reply_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,92 @@
+/*
+ * XCB Reply Continuations - Complete requests without blocking on replies
+ *
+ * Instead of calling xcb_*_reply() right after sending a request, a caller
+ * registers the request's sequence number with a handler. The main loop
+ * collects replies with xcb_poll_for_reply() on every wakeup and runs the
+ * handlers in request order, so a slow X server never stalls the WM.
+ *
+ * A continuation may be tied to a hub target. If that target is no longer
+ * registered when the reply arrives (the window was destroyed, the output
+ * disconnected) the continuation is dropped without running its handler.
+ *
+ * Requests must be sent with the checked variant (xcb_get_property(), not
+ * xcb_get_property_unchecked()) so errors are delivered to the handler
+ * instead of the event queue.
+ */
+
+#ifndef _WM_XCB_REPLY_H_
+#define _WM_XCB_REPLY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "wm-hub.h"
+
+/*
+ * Reply handler.
+ *
+ * @param target    Target the continuation was registered for
+ * @param reply     Reply structure (cast to the request's reply type) or NULL
+ * @param error     Error or NULL
+ * @param userdata  Value given at registration
+ *
+ * Reply and error are freed after the handler returns.
+ */
+typedef void (*XCBReplyHandler)(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata);
+
+/*
+ * Continuation statistics
+ */
+typedef struct XCBReplyStats {
+  uint64_t registered; /* continuations registered */
+  uint64_t completed;  /* handlers run with a reply */
+  uint64_t errors;     /* handlers run with an error */
+  uint64_t dropped;    /* continuations dropped because their target is gone */
+} XCBReplyStats;
+
+/*
+ * Register a continuation for a request.
+ *
+ * @param sequence  cookie.sequence of the request
+ * @param target    Target the reply is for, or TARGET_ID_NONE
+ * @param handler   Called once the reply or error is available
+ * @param userdata  Passed to the handler; must not own memory, since a
+ *                  dropped continuation never reaches its handler
+ * @return          true on success, false on allocation failure
+ */
+bool xcb_reply_register(unsigned int sequence, TargetID target, XCBReplyHandler handler, void* userdata);
+
+/*
+ * Run the handlers of every continuation whose reply has arrived.
+ * Stops at the first request still in flight: replies come back in order.
+ * Returns the number of continuations completed or dropped.
+ */
+uint32_t xcb_reply_process(xcb_connection_t* conn);
+
+/*
+ * Complete the continuation for a sequence with a reply obtained
+ * elsewhere. Takes ownership of reply and error.
+ * Returns false if no continuation is registered for the sequence.
+ */
+bool xcb_reply_complete(unsigned int sequence, void* reply, xcb_generic_error_t* error);
+
+/*
+ * Discard all pending continuations without running them. With a
+ * connection, XCB is told to discard the replies as well.
+ */
+void xcb_reply_clear(xcb_connection_t* conn);
+
+/*
+ * Number of continuations waiting for a reply.
+ */
+uint32_t xcb_reply_pending(void);
+
+/*
+ * Statistics
+ */
+XCBReplyStats xcb_reply_get_stats(void);
+void          xcb_reply_reset_stats(void);
+
+#endif /* _WM_XCB_REPLY_H_ */
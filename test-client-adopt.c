@@ -0,0 +1,335 @@
+/*
+ * Client Adoption Tests
+ *
+ * Tests for parsing, filtering and bulk creation of pre-existing windows.
+ * Requires: hub, client, xcb-atoms, xcb-mirror
+ */
+
+#include "test-registry.h" /* Must be first - defines TEST_GROUP macro */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/components/client-adopt.h"
+#include "src/target/client.h"
+#include "src/xcb/xcb-atoms.h"
+#include "src/xcb/xcb-mirror.h"
+#include "test-client-adopt.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+
+#define FAKE_ATOM_DOCK       100
+#define FAKE_ATOM_DESKTOP    101
+#define FAKE_ATOM_NORMAL     102
+#define FAKE_ATOM_STATE_FULL 103
+
+/* Property reply followed by its value, as the server would send it */
+static xcb_get_property_reply_t*
+fake_property(uint8_t format, const void* value, uint32_t bytes)
+{
+  xcb_get_property_reply_t* r = calloc(1, sizeof(*r) + bytes + 4);
+  r->response_type            = XCB_GET_PROPERTY;
+  r->format                   = format;
+  r->value_len                = bytes / (format / 8);
+  memcpy(r + 1, value, bytes);
+  return r;
+}
+
+static xcb_get_window_attributes_reply_t*
+fake_attributes(bool override_redirect, uint8_t map_state)
+{
+  xcb_get_window_attributes_reply_t* r = calloc(1, sizeof(*r));
+  r->override_redirect                 = override_redirect;
+  r->map_state                         = map_state;
+  return r;
+}
+
+static xcb_get_geometry_reply_t*
+fake_geometry(int16_t x, int16_t y, uint16_t width, uint16_t height)
+{
+  xcb_get_geometry_reply_t* r = calloc(1, sizeof(*r));
+  r->x                        = x;
+  r->y                        = y;
+  r->width                    = width;
+  r->height                   = height;
+  r->border_width             = 2;
+  return r;
+}
+
+/* Replies of an ordinary mapped application window */
+static void
+fake_window(ClientAdoptReplies* replies, xcb_atom_t type)
+{
+  static const char     wm_class[] = "xterm\0XTerm";
+  static const char     wm_name[]  = "shell";
+  static const uint32_t hints[]    = { 1, 1 };
+
+  replies->attributes  = fake_attributes(false, XCB_MAP_STATE_VIEWABLE);
+  replies->geometry    = fake_geometry(10, 20, 300, 200);
+  replies->wm_class    = fake_property(8, wm_class, sizeof(wm_class));
+  replies->wm_name     = fake_property(8, wm_name, sizeof(wm_name) - 1);
+  replies->wm_hints    = fake_property(32, hints, sizeof(hints));
+  replies->wm_state    = NULL;
+  replies->window_type = fake_property(32, &type, sizeof(type));
+}
+
+static void
+free_fake_window(ClientAdoptReplies* replies)
+{
+  free(replies->attributes);
+  free(replies->geometry);
+  free(replies->wm_class);
+  free(replies->wm_name);
+  free(replies->wm_hints);
+  free(replies->wm_state);
+  free(replies->window_type);
+}
+
+/* Atom values the server would have handed out */
+static void
+fake_atoms(void)
+{
+  xcb_atoms_set(ATOM_NET_WM_WINDOW_TYPE_DOCK, FAKE_ATOM_DOCK);
+  xcb_atoms_set(ATOM_NET_WM_WINDOW_TYPE_DESKTOP, FAKE_ATOM_DESKTOP);
+  xcb_atoms_set(ATOM_NET_WM_STATE_FULLSCREEN, FAKE_ATOM_STATE_FULL);
+}
+
+void
+test_adopt_parse_properties(void)
+{
+  LOG_CLEAN("== Testing adoption parses window replies");
+  ClientAdoptReplies replies;
+  ClientAdoptInfo    info;
+  const uint32_t     hints[] = { 1 | 256, 0 };
+
+  fake_atoms();
+  fake_window(&replies, FAKE_ATOM_NORMAL);
+  free(replies.wm_hints);
+  replies.wm_hints = fake_property(32, hints, sizeof(hints));
+  xcb_atom_t state = FAKE_ATOM_STATE_FULL;
+  replies.wm_state = fake_property(32, &state, sizeof(state));
+
+  client_adopt_parse(&info, 0x200, &replies);
+  assert(info.window == 0x200);
+  assert(info.override_redirect == false);
+  assert(info.viewable == true);
+  assert(info.has_geometry == true);
+  assert(info.x == 10 && info.y == 20);
+  assert(info.width == 300 && info.height == 200);
+  assert(info.border_width == 2);
+  assert(info.title != NULL && strcmp(info.title, "shell") == 0);
+  assert(info.class_name != NULL && strcmp(info.class_name, "XTerm") == 0);
+  assert(info.urgent == true);
+  assert(info.focusable == false);
+  assert(info.fullscreen == true);
+  assert(info.window_type == FAKE_ATOM_NORMAL);
+  assert(client_adopt_wanted(&info) == true);
+
+  client_adopt_info_free(&info);
+  free_fake_window(&replies);
+  xcb_atoms_clear();
+}
+
+void
+test_adopt_parse_missing_replies(void)
+{
+  LOG_CLEAN("== Testing adoption tolerates missing replies");
+  ClientAdoptReplies replies = { 0 };
+  ClientAdoptInfo    info;
+  static const char  instance_only[] = "dialog";
+
+  client_adopt_parse(&info, 0x201, &replies);
+  assert(info.viewable == false);
+  assert(info.has_geometry == false);
+  assert(info.title == NULL);
+  assert(info.class_name == NULL);
+  assert(info.focusable == true);
+  assert(info.fullscreen == false);
+  assert(client_adopt_wanted(&info) == false);
+  client_adopt_info_free(&info);
+
+  /* WM_CLASS without the class part falls back to the instance */
+  replies.wm_class = fake_property(8, instance_only, sizeof(instance_only) - 1);
+  client_adopt_parse(&info, 0x201, &replies);
+  assert(info.class_name != NULL && strcmp(info.class_name, "dialog") == 0);
+  client_adopt_info_free(&info);
+  free(replies.wm_class);
+}
+
+void
+test_adopt_skips_unwanted(void)
+{
+  LOG_CLEAN("== Testing adoption skips popups, unmapped windows, docks and desktops");
+  ClientAdoptReplies replies;
+  ClientAdoptInfo    info;
+
+  fake_atoms();
+
+  fake_window(&replies, FAKE_ATOM_NORMAL);
+  replies.attributes->override_redirect = 1;
+  client_adopt_parse(&info, 0x300, &replies);
+  assert(client_adopt_wanted(&info) == false);
+  client_adopt_info_free(&info);
+  free_fake_window(&replies);
+
+  fake_window(&replies, FAKE_ATOM_NORMAL);
+  replies.attributes->map_state = XCB_MAP_STATE_UNMAPPED;
+  client_adopt_parse(&info, 0x301, &replies);
+  assert(client_adopt_wanted(&info) == false);
+  client_adopt_info_free(&info);
+  free_fake_window(&replies);
+
+  fake_window(&replies, FAKE_ATOM_DOCK);
+  client_adopt_parse(&info, 0x302, &replies);
+  assert(client_adopt_wanted(&info) == false);
+  client_adopt_info_free(&info);
+  free_fake_window(&replies);
+
+  fake_window(&replies, FAKE_ATOM_DESKTOP);
+  client_adopt_parse(&info, 0x303, &replies);
+  assert(client_adopt_wanted(&info) == false);
+  client_adopt_info_free(&info);
+  free_fake_window(&replies);
+
+  xcb_atoms_clear();
+}
+
+void
+test_adopt_apply_populates_clients(void)
+{
+  LOG_CLEAN("== Testing adoption creates populated, managed clients");
+  ClientAdoptReplies replies;
+  ClientAdoptInfo    infos[3];
+
+  hub_init();
+  client_list_init();
+  xcb_mirror_clear();
+  fake_atoms();
+
+  for (int i = 0; i < 3; i++) {
+    fake_window(&replies, i == 1 ? FAKE_ATOM_DOCK : FAKE_ATOM_NORMAL);
+    client_adopt_parse(&infos[i], (xcb_window_t) (0x400 + i), &replies);
+    free_fake_window(&replies);
+  }
+
+  assert(client_adopt_apply(infos, 3) == 2);
+  assert(infos[0].client != NULL);
+  assert(infos[1].client == NULL);
+  assert(infos[2].client != NULL);
+  assert(client_get_by_window(0x401) == NULL);
+
+  Client* c = client_get_by_window(0x400);
+  assert_or_abort(c != NULL);
+  assert(c == infos[0].client);
+  assert(client_is_managed(c));
+  assert(client_is_mapped(c));
+  assert(c->x == 10 && c->y == 20 && c->width == 300 && c->height == 200);
+  assert(c->border_width == 2);
+  assert(c->title != NULL && strcmp(c->title, "shell") == 0);
+  assert(c->class_name != NULL && strcmp(c->class_name, "XTerm") == 0);
+  /* strings moved into the client */
+  assert(infos[0].title == NULL);
+  assert(infos[0].class_name == NULL);
+
+  /* the mirror knows the geometry, so an unchanged layout sends nothing */
+  uint32_t       values[6];
+  XCBWindowState same = { .x = 10, .y = 20, .width = 300, .height = 200, .border_width = 2 };
+  uint16_t       mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH |
+                  XCB_CONFIG_WINDOW_HEIGHT | XCB_CONFIG_WINDOW_BORDER_WIDTH;
+  assert(xcb_mirror_filter_configure(0x400, mask, &same, values) == 0);
+  assert(xcb_mirror_filter_map(0x400, true) == false);
+
+  for (int i = 0; i < 3; i++)
+    client_adopt_info_free(&infos[i]);
+  xcb_atoms_clear();
+  client_list_shutdown();
+  hub_shutdown();
+  xcb_mirror_clear();
+}
+
+void
+test_adopt_apply_skips_known_windows(void)
+{
+  LOG_CLEAN("== Testing adoption leaves already managed windows alone");
+  ClientAdoptReplies replies;
+  ClientAdoptInfo    info;
+
+  hub_init();
+  client_list_init();
+
+  Client* existing = client_create(0x500);
+  assert_or_abort(existing != NULL);
+
+  fake_window(&replies, FAKE_ATOM_NORMAL);
+  client_adopt_parse(&info, 0x500, &replies);
+  free_fake_window(&replies);
+
+  assert(client_adopt_apply(&info, 1) == 0);
+  assert(info.client == NULL);
+  assert(client_get_by_window(0x500) == existing);
+  assert(existing->title == NULL);
+
+  client_adopt_info_free(&info);
+  client_list_shutdown();
+  hub_shutdown();
+  xcb_mirror_clear();
+}
+
+static double
+now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/*
+ * Startup benchmark: parse and adopt 200 windows in one batch.
+ * The server side is two round trips regardless of the count; this
+ * measures the WM-side cost of turning the replies into clients.
+ */
+void
+test_adopt_startup_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: adopting 200 existing windows");
+  const uint32_t     nwindows = 200;
+  ClientAdoptInfo*   infos    = calloc(nwindows, sizeof(ClientAdoptInfo));
+  ClientAdoptReplies replies;
+
+  assert_or_abort(infos != NULL);
+  hub_init();
+  client_list_init();
+  xcb_mirror_clear();
+
+  double start = now_ms();
+  for (uint32_t i = 0; i < nwindows; i++) {
+    fake_window(&replies, FAKE_ATOM_NORMAL);
+    client_adopt_parse(&infos[i], (xcb_window_t) (0x1000 + i), &replies);
+    free_fake_window(&replies);
+  }
+  uint32_t adopted = client_adopt_apply(infos, nwindows);
+  double   elapsed = now_ms() - start;
+
+  LOG_CLEAN("  adopted %u windows in %.3fms (%.2fus/window)",
+            adopted, elapsed, elapsed * 1000.0 / nwindows);
+  assert(adopted == nwindows);
+  assert(client_count_managed() == nwindows);
+  assert(xcb_mirror_count() == nwindows);
+
+  for (uint32_t i = 0; i < nwindows; i++)
+    client_adopt_info_free(&infos[i]);
+  free(infos);
+  client_list_shutdown();
+  hub_shutdown();
+  xcb_mirror_clear();
+}
+
+TEST_GROUP(ClientAdopt, {
+  test_adopt_parse_properties();
+  test_adopt_parse_missing_replies();
+  test_adopt_skips_unwanted();
+  test_adopt_apply_populates_clients();
+  test_adopt_apply_skips_known_windows();
+  test_adopt_startup_benchmark();
+});
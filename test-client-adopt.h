@@ -0,0 +1,17 @@
+/*
+ * test-client-adopt.h - Header for startup window adoption tests
+ */
+
+#ifndef TEST_CLIENT_ADOPT_H
+#define TEST_CLIENT_ADOPT_H
+
+#include "src/components/client-adopt.h"
+
+void test_adopt_parse_properties(void);
+void test_adopt_parse_missing_replies(void);
+void test_adopt_skips_unwanted(void);
+void test_adopt_apply_populates_clients(void);
+void test_adopt_apply_skips_known_windows(void);
+void test_adopt_startup_benchmark(void);
+
+#endif /* TEST_CLIENT_ADOPT_H */
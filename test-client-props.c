@@ -0,0 +1,272 @@
+/*
+ * Client Property Cache Tests
+ *
+ * Tests for parsing, per-atom invalidation, lazy refetch and title
+ * debouncing of cached client properties.
+ * Requires: hub, client, client-list component, xcb-atoms, loop
+ */
+
+#include "test-registry.h" /* Must be first - defines TEST_GROUP macro */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/components/client-list.h"
+#include "src/components/client-props.h"
+#include "src/target/client.h"
+#include "src/xcb/xcb-atoms.h"
+#include "src/xcb/xcb-handler.h"
+#include "test-client-props.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+#include "wm-loop.h"
+
+#define FAKE_ATOM_NET_WM_NAME 400
+#define FAKE_ATOM_WINDOW_TYPE 401
+#define FAKE_ATOM_USER_TIME   402
+#define FAKE_ATOM_DIALOG      403
+
+static xcb_get_property_reply_t*
+fake_property(uint8_t format, const void* value, uint32_t bytes)
+{
+  xcb_get_property_reply_t* r = calloc(1, sizeof(*r) + bytes + 4);
+  r->format                   = format;
+  r->value_len                = bytes / (format / 8);
+  memcpy(r + 1, value, bytes);
+  return r;
+}
+
+static Client*
+setup(void)
+{
+  hub_init();
+  client_list_init();
+  xcb_atoms_set(ATOM_NET_WM_NAME, FAKE_ATOM_NET_WM_NAME);
+  xcb_atoms_set(ATOM_NET_WM_WINDOW_TYPE, FAKE_ATOM_WINDOW_TYPE);
+  client_props_reset_stats();
+  return client_create(0x700);
+}
+
+static void
+teardown(void)
+{
+  client_props_shutdown();
+  client_list_shutdown();
+  hub_shutdown();
+  xcb_atoms_clear();
+}
+
+void
+test_props_apply_parses_replies(void)
+{
+  LOG_CLEAN("== Testing property replies fill the cache");
+  Client* c = setup();
+  assert_or_abort(c != NULL);
+
+  static const char     name[]      = "Mozilla Firefox";
+  static const char     wm_class[]  = "Navigator\0firefox";
+  static const uint32_t hints[]     = { 1 | 256, 0 };
+  static const uint32_t size[18]    = { [0] = 16 | 32 | 64 | 256, [5] = 100, [6] = 50, [7] = 800,
+                                        [8] = 600, [9] = 10, [10] = 20, [15] = 4, [16] = 2 };
+  const xcb_window_t    parent      = 0x123;
+  const xcb_atom_t      window_type = FAKE_ATOM_DIALOG;
+
+  xcb_get_property_reply_t* r;
+  r = fake_property(8, name, sizeof(name) - 1);
+  client_props_apply(c, CLIENT_PROP_NAME, r);
+  free(r);
+  r = fake_property(8, wm_class, sizeof(wm_class));
+  client_props_apply(c, CLIENT_PROP_CLASS, r);
+  free(r);
+  r = fake_property(32, hints, sizeof(hints));
+  client_props_apply(c, CLIENT_PROP_HINTS, r);
+  free(r);
+  r = fake_property(32, size, sizeof(size));
+  client_props_apply(c, CLIENT_PROP_NORMAL_HINTS, r);
+  free(r);
+  r = fake_property(32, &parent, sizeof(parent));
+  client_props_apply(c, CLIENT_PROP_TRANSIENT_FOR, r);
+  free(r);
+  r = fake_property(32, &window_type, sizeof(window_type));
+  client_props_apply(c, CLIENT_PROP_WINDOW_TYPE, r);
+  free(r);
+
+  assert(c->props.valid == CLIENT_PROP_ALL);
+  assert(strcmp(client_props_title(c), "Mozilla Firefox") == 0);
+  assert(strcmp(client_props_class(c), "firefox") == 0);
+  assert(client_props_urgent(c) == true);
+  assert(c->focusable == false);
+  assert(client_props_transient_for(c) == 0x123);
+  assert(client_props_window_type(c) == FAKE_ATOM_DIALOG);
+
+  const ClientSizeHints* sh = client_props_size_hints(c);
+  assert(sh->flags == (CLIENT_SIZE_HINT_P_MIN_SIZE | CLIENT_SIZE_HINT_P_MAX_SIZE |
+                       CLIENT_SIZE_HINT_P_RESIZE_INC | CLIENT_SIZE_HINT_P_BASE_SIZE));
+  assert(sh->min_width == 100 && sh->min_height == 50);
+  assert(sh->max_width == 800 && sh->max_height == 600);
+  assert(sh->width_inc == 10 && sh->height_inc == 20);
+  assert(sh->base_width == 4 && sh->base_height == 2);
+
+  /* every read came from the cache */
+  ClientPropsStats stats = client_props_get_stats();
+  assert(stats.fetches == 0);
+  assert(stats.hits == 6);
+
+  /* a missing property clears the value */
+  client_props_apply(c, CLIENT_PROP_TRANSIENT_FOR, NULL);
+  assert(c->props.transient_for == XCB_NONE);
+  assert(client_props_is_valid(c, CLIENT_PROP_TRANSIENT_FOR));
+
+  teardown();
+}
+
+void
+test_props_atom_mapping(void)
+{
+  LOG_CLEAN("== Testing atoms map to cached properties");
+  setup();
+
+  assert(client_props_for_atom(XCB_ATOM_WM_NAME) == CLIENT_PROP_NAME);
+  assert(client_props_for_atom(FAKE_ATOM_NET_WM_NAME) == CLIENT_PROP_NAME);
+  assert(client_props_for_atom(XCB_ATOM_WM_CLASS) == CLIENT_PROP_CLASS);
+  assert(client_props_for_atom(XCB_ATOM_WM_HINTS) == CLIENT_PROP_HINTS);
+  assert(client_props_for_atom(XCB_ATOM_WM_NORMAL_HINTS) == CLIENT_PROP_NORMAL_HINTS);
+  assert(client_props_for_atom(XCB_ATOM_WM_TRANSIENT_FOR) == CLIENT_PROP_TRANSIENT_FOR);
+  assert(client_props_for_atom(FAKE_ATOM_WINDOW_TYPE) == CLIENT_PROP_WINDOW_TYPE);
+  assert(client_props_for_atom(FAKE_ATOM_USER_TIME) == 0);
+  assert(client_props_for_atom(XCB_ATOM_WM_COMMAND) == 0);
+
+  teardown();
+}
+
+void
+test_props_invalidate_per_atom(void)
+{
+  LOG_CLEAN("== Testing PROPERTY_NOTIFY invalidates only its property");
+  Client* c = setup();
+  assert_or_abort(c != NULL);
+
+  xcb_handler_init();
+  client_list_component_init();
+  assert(xcb_handler_count_for_property(FAKE_ATOM_NET_WM_NAME, XCB_NONE) == 1);
+  assert(xcb_handler_count_for_property(XCB_ATOM_WM_HINTS, XCB_NONE) == 1);
+  assert(xcb_handler_count_for_property(FAKE_ATOM_USER_TIME, XCB_NONE) == 0);
+
+  for (uint32_t bit = 1; bit & CLIENT_PROP_ALL; bit <<= 1)
+    client_props_apply(c, (ClientProp) bit, NULL);
+  assert(c->props.valid == CLIENT_PROP_ALL);
+
+  xcb_property_notify_event_t ev = { 0 };
+  ev.response_type               = XCB_PROPERTY_NOTIFY;
+  ev.window                      = c->window;
+  ev.atom                        = FAKE_ATOM_NET_WM_NAME;
+  client_list_on_property_notify(&ev);
+  assert(c->props.valid == (CLIENT_PROP_ALL & ~CLIENT_PROP_NAME));
+
+  ev.atom = XCB_ATOM_WM_HINTS;
+  client_list_on_property_notify(&ev);
+  assert(c->props.valid == (CLIENT_PROP_ALL & ~(CLIENT_PROP_NAME | CLIENT_PROP_HINTS)));
+
+  /* uncached atoms change nothing */
+  ev.atom = FAKE_ATOM_USER_TIME;
+  client_list_on_property_notify(&ev);
+  assert(c->props.valid == (CLIENT_PROP_ALL & ~(CLIENT_PROP_NAME | CLIENT_PROP_HINTS)));
+
+  ClientPropsStats stats = client_props_get_stats();
+  assert(stats.invalidations == 2);
+  assert(stats.ignored == 1);
+  /* invalidation alone fetches nothing */
+  assert(stats.fetches == 0);
+
+  client_list_component_shutdown();
+  xcb_handler_shutdown();
+  teardown();
+}
+
+void
+test_props_lazy_refetch_on_read(void)
+{
+  LOG_CLEAN("== Testing stale properties are fetched only when read");
+  Client* c = setup();
+  assert_or_abort(c != NULL);
+
+  client_props_apply(c, CLIENT_PROP_CLASS, NULL);
+  client_props_invalidate_atom(c, XCB_ATOM_WM_CLASS);
+  client_props_invalidate_atom(c, XCB_ATOM_WM_CLASS);
+  assert(client_props_get_stats().fetches == 0);
+
+  client_props_class(c);
+  assert(client_props_get_stats().fetches == 1);
+  assert(client_props_get_stats().hits == 0);
+
+  /* a valid value is a hit */
+  client_props_apply(c, CLIENT_PROP_CLASS, NULL);
+  client_props_class(c);
+  assert(client_props_get_stats().fetches == 1);
+  assert(client_props_get_stats().hits == 1);
+
+  teardown();
+}
+
+void
+test_props_dirty_while_in_flight(void)
+{
+  LOG_CLEAN("== Testing a change during a fetch keeps the property stale");
+  Client* c = setup();
+  assert_or_abort(c != NULL);
+
+  /* a fetch is in flight when the window changes the property again */
+  c->props.pending = CLIENT_PROP_WINDOW_TYPE;
+  client_props_invalidate_atom(c, FAKE_ATOM_WINDOW_TYPE);
+  assert(c->props.dirty == CLIENT_PROP_WINDOW_TYPE);
+
+  /* fetching again is pointless until the reply is in */
+  client_props_window_type(c);
+  assert(client_props_get_stats().fetches == 0);
+
+  teardown();
+}
+
+/*
+ * A terminal rewrites its title 50 times in a burst while a bar reads it
+ * after every change: one fetch goes out immediately, the rest are folded
+ * into a single deferred fetch once the debounce window closes.
+ */
+void
+test_props_title_debounce(void)
+{
+  LOG_CLEAN("== Testing title refreshes are debounced");
+  Client* c = setup();
+  assert_or_abort(c != NULL);
+  assert_or_abort(loop_init() == 0);
+
+  for (int i = 0; i < 50; i++) {
+    client_props_invalidate_atom(c, FAKE_ATOM_NET_WM_NAME);
+    client_props_title(c);
+  }
+
+  ClientPropsStats stats = client_props_get_stats();
+  LOG_CLEAN("  50 renames: %llu fetches, %llu deferred",
+            (unsigned long long) stats.fetches, (unsigned long long) stats.titles_deferred);
+  assert(stats.fetches == 1);
+  assert(stats.titles_deferred == 49);
+  assert(c->props.title_wanted == true);
+
+  /* the deferred fetch runs when the window closes */
+  for (int i = 0; i < 10 && client_props_get_stats().fetches == 1; i++)
+    loop_iterate(CLIENT_PROPS_TITLE_DEBOUNCE_MS);
+  assert(client_props_get_stats().fetches == 2);
+  assert(c->props.title_wanted == false);
+
+  teardown();
+  loop_shutdown();
+}
+
+TEST_GROUP(ClientProps, {
+  test_props_apply_parses_replies();
+  test_props_atom_mapping();
+  test_props_invalidate_per_atom();
+  test_props_lazy_refetch_on_read();
+  test_props_dirty_while_in_flight();
+  test_props_title_debounce();
+});
@@ -0,0 +1,17 @@
+/*
+ * test-client-props.h - Header for client property cache tests
+ */
+
+#ifndef TEST_CLIENT_PROPS_H
+#define TEST_CLIENT_PROPS_H
+
+#include "src/components/client-props.h"
+
+void test_props_apply_parses_replies(void);
+void test_props_atom_mapping(void);
+void test_props_invalidate_per_atom(void);
+void test_props_lazy_refetch_on_read(void);
+void test_props_dirty_while_in_flight(void);
+void test_props_title_debounce(void);
+
+#endif /* TEST_CLIENT_PROPS_H */
@@ -22,15 +22,26 @@
 /*
  * Include all test headers to register their test groups
  */
+#include "test-client-adopt.h"
 #include "test-client-list-component.h"
+#include "test-client-props.h"
 #include "test-focus-component.h"
 #include "test-launcher.h"
+#include "test-state-snapshot.h"
 #include "test-target-client.h"
 #include "test-terminal.h"
 #include "test-wm-hub.h"
+#include "test-wm-intern.h"
+#include "test-wm-ipc.h"
+#include "test-wm-loop.h"
 #include "test-wm-monitor-manager.h"
 #include "test-wm-monitor.h"
 #include "test-wm-window-list.h"
+#include "test-wm-xcb-atoms.h"
+#include "test-wm-xcb-batch.h"
+#include "test-wm-xcb-mirror.h"
+#include "test-wm-xcb-property.h"
+#include "test-wm-xcb-reply.h"
 #include "test-wm-xcb-handler.h"
 #include "test-wm.h"
 
@@ -0,0 +1,302 @@
+/*
+ * State Snapshot Tests
+ *
+ * Tests for publishing, reading and reclaiming state snapshots, including
+ * readers on other threads.
+ * Requires: hub, client, monitor, tag, tag manager
+ */
+
+#include "test-registry.h" /* Must be first - defines TEST_GROUP macro */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/components/state-snapshot.h"
+#include "src/components/tag-manager.h"
+#include "src/components/tiling.h"
+#include "src/target/client.h"
+#include "src/target/monitor.h"
+#include "src/target/tag.h"
+#include "test-state-snapshot.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+
+static void
+snapshot_test_setup(void)
+{
+  hub_init();
+  client_list_init();
+  monitor_list_init();
+  tag_list_init();
+}
+
+static void
+snapshot_test_teardown(void)
+{
+  snapshot_shutdown();
+  tag_list_shutdown();
+  client_list_shutdown();
+  monitor_list_shutdown();
+  hub_shutdown();
+}
+
+void
+test_snapshot_none_before_publish(void)
+{
+  LOG_CLEAN("== Testing no snapshot is current before the first publish");
+
+  const WmSnapshot* s = snapshot_acquire();
+  assert(s == NULL);
+  snapshot_release(s);
+}
+
+void
+test_snapshot_copies_state(void)
+{
+  LOG_CLEAN("== Testing a snapshot copies clients, monitors and tags");
+  snapshot_test_setup();
+
+  tag_manager_component_init();
+
+  (void) monitor_create(10);
+  Monitor* m2 = monitor_create(11);
+  monitor_set_geometry(m2, 1920, 0, 1280, 1024);
+  monitor_set_selected(m2);
+
+  /* the view changes the way a keybinding does it, through the hub */
+  uint32_t view = 3;
+  hub_send_request_data(REQ_TAG_VIEW, m2->target.id, &view);
+  assert(tag_manager_get_visible_tags(m2) == TAG_MASK(2));
+
+  Client* a = client_create(100);
+  Client* b = client_create(101);
+  client_set_title(a, strdup("editor"));
+  client_set_class(a, strdup("Emacs"));
+  client_set_monitor(a, m2);
+  client_set_tags(a, TAG_MASK(2));
+  client_set_geometry(a, 1920, 0, 640, 480);
+  client_set_urgent(b, true);
+
+  snapshot_publish();
+
+  const WmSnapshot* s = snapshot_acquire();
+  assert(s != NULL);
+  assert(s->sequence == 1);
+  assert(s->client_count == 2);
+  assert(s->monitor_count == 2);
+  assert(s->tag_count == TAG_NUM_TAGS);
+  assert(s->selected_monitor == m2->target.id);
+  assert(s->focused_client == TARGET_ID_NONE);
+
+  const WmSnapshotClient* ca = NULL;
+  const WmSnapshotClient* cb = NULL;
+  for (uint32_t i = 0; i < s->client_count; i++) {
+    if (s->clients[i].window == 100)
+      ca = &s->clients[i];
+    if (s->clients[i].window == 101)
+      cb = &s->clients[i];
+  }
+  assert(ca != NULL && cb != NULL);
+  assert(ca->id == a->target.id);
+  assert(ca->monitor == m2->target.id);
+  assert(ca->tags == TAG_MASK(2));
+  assert(ca->x == 1920 && ca->width == 640 && ca->height == 480);
+  assert(ca->title != NULL && strcmp(ca->title, "editor") == 0);
+  assert(ca->class_name != NULL && strcmp(ca->class_name, "Emacs") == 0);
+  assert(!ca->fullscreen && !ca->focused);
+  assert(cb->monitor == TARGET_ID_NONE);
+  assert(cb->title == NULL);
+  assert(cb->urgent);
+
+  const WmSnapshotMonitor* sm2 = NULL;
+  for (uint32_t i = 0; i < s->monitor_count; i++) {
+    if (s->monitors[i].id == m2->target.id)
+      sm2 = &s->monitors[i];
+  }
+  assert(sm2 != NULL);
+  assert(sm2->selected);
+  assert(sm2->x == 1920 && sm2->width == 1280 && sm2->height == 1024);
+  assert(sm2->tagset == TAG_MASK(2));
+  assert(sm2->layout == LAYOUT_STATE_TILE);
+
+  int masks_ok = 0;
+  for (uint32_t i = 0; i < s->tag_count; i++) {
+    if (s->tags[i].mask == TAG_MASK(s->tags[i].index))
+      masks_ok++;
+  }
+  assert(masks_ok == TAG_NUM_TAGS);
+
+  /* the snapshot does not follow later changes, strings included */
+  client_set_title(a, strdup("changed"));
+  client_set_tags(a, TAG_MASK(5));
+  assert(strcmp(ca->title, "editor") == 0);
+  assert(ca->tags == TAG_MASK(2));
+  snapshot_release(s);
+
+  snapshot_publish();
+  s = snapshot_acquire();
+  assert(s->sequence == 2);
+  snapshot_release(s);
+
+  /* a later view change reaches the next snapshot */
+  view = 5;
+  hub_send_request_data(REQ_TAG_VIEW, m2->target.id, &view);
+  snapshot_publish();
+  s = snapshot_acquire();
+  for (uint32_t i = 0; i < s->monitor_count; i++) {
+    if (s->monitors[i].id == m2->target.id)
+      assert(s->monitors[i].tagset == TAG_MASK(4));
+  }
+  snapshot_release(s);
+
+  tag_manager_component_shutdown();
+  snapshot_test_teardown();
+}
+
+void
+test_snapshot_nested_acquire(void)
+{
+  LOG_CLEAN("== Testing nested acquires keep the outer snapshot alive");
+  snapshot_test_setup();
+
+  snapshot_publish();
+  const WmSnapshot* outer = snapshot_acquire();
+  snapshot_publish();
+  const WmSnapshot* inner = snapshot_acquire();
+
+  assert(outer->sequence == 1);
+  assert(inner->sequence == 2);
+
+  snapshot_release(inner);
+  snapshot_publish();
+  assert(snapshot_get_stats().reclaimed == 0); /* outer still held */
+  assert(outer->sequence == 1);
+
+  snapshot_release(outer);
+  snapshot_publish();
+  assert(snapshot_get_stats().retired == 0);
+  assert(snapshot_get_stats().reclaimed == 3);
+
+  snapshot_test_teardown();
+}
+
+void
+test_snapshot_reclaim_waits_for_readers(void)
+{
+  LOG_CLEAN("== Testing replaced snapshots are freed once no reader holds them");
+  snapshot_test_setup();
+
+  snapshot_publish();
+  snapshot_publish();
+  assert(snapshot_get_stats().reclaimed == 1); /* nobody was reading */
+  assert(snapshot_get_stats().retired == 0);
+
+  const WmSnapshot* held = snapshot_acquire();
+  assert(held->sequence == 2);
+
+  snapshot_publish();
+  snapshot_publish();
+  assert(snapshot_get_stats().retired == 2);
+  assert(snapshot_get_stats().reclaimed == 1);
+  assert(held->sequence == 2);
+  assert(held->tag_count == TAG_NUM_TAGS);
+
+  snapshot_release(held);
+  snapshot_publish();
+  assert(snapshot_get_stats().retired == 0);
+  assert(snapshot_get_stats().reclaimed == 4);
+  assert(snapshot_get_stats().published == 5);
+
+  snapshot_reader_exit();
+  snapshot_test_teardown();
+}
+
+/*
+ * Concurrent readers: the main thread republishes with a new title each
+ * time, readers check every snapshot they see is whole and never older
+ * than the last one they saw.
+ */
+#define SNAPSHOT_READERS 4
+#define SNAPSHOT_ROUNDS  2000
+#define SNAPSHOT_READS   10000
+
+static atomic_bool          readers_stop;
+static atomic_uint          reader_errors;
+static atomic_uint_fast64_t reader_reads;
+
+static void*
+snapshot_reader(void* arg)
+{
+  (void) arg;
+  uint64_t last = 0;
+  char     expected[32];
+
+  while (!atomic_load(&readers_stop)) {
+    const WmSnapshot* s = snapshot_acquire();
+    if (s != NULL) {
+      snprintf(expected, sizeof(expected), "title %" PRIu64, s->sequence);
+      if (s->sequence < last || s->client_count != 1 || s->clients[0].title == NULL
+          || strcmp(s->clients[0].title, expected) != 0)
+        atomic_fetch_add(&reader_errors, 1);
+      last = s->sequence;
+      atomic_fetch_add(&reader_reads, 1);
+    }
+    snapshot_release(s);
+  }
+
+  snapshot_reader_exit();
+  return NULL;
+}
+
+void
+test_snapshot_concurrent_readers(void)
+{
+  LOG_CLEAN("== Testing snapshots read from other threads while publishing");
+  snapshot_test_setup();
+
+  Client* c = client_create(200);
+  char    title[32];
+
+  atomic_store(&readers_stop, false);
+  atomic_store(&reader_errors, 0);
+  atomic_store(&reader_reads, 0);
+
+  pthread_t threads[SNAPSHOT_READERS];
+  for (int i = 0; i < SNAPSHOT_READERS; i++)
+    pthread_create(&threads[i], NULL, snapshot_reader, NULL);
+
+  /* keep publishing until the readers have had a real go at it */
+  int rounds = 0;
+  while (rounds < SNAPSHOT_ROUNDS || atomic_load(&reader_reads) < SNAPSHOT_READS) {
+    snprintf(title, sizeof(title), "title %d", ++rounds);
+    client_set_title(c, strdup(title));
+    snapshot_publish();
+  }
+
+  atomic_store(&readers_stop, true);
+  for (int i = 0; i < SNAPSHOT_READERS; i++)
+    pthread_join(threads[i], NULL);
+
+  LOG_CLEAN("  %" PRIu64 " reads during %d publishes", (uint64_t) atomic_load(&reader_reads), rounds);
+  assert(atomic_load(&reader_reads) >= SNAPSHOT_READS);
+  assert(atomic_load(&reader_errors) == 0);
+
+  /* with every reader gone, the next publish frees all replaced snapshots */
+  snapshot_publish();
+  assert(snapshot_get_stats().retired == 0);
+  assert(snapshot_get_stats().reclaimed == (uint64_t) rounds);
+
+  snapshot_test_teardown();
+}
+
+TEST_GROUP(StateSnapshot, {
+  test_snapshot_none_before_publish();
+  test_snapshot_copies_state();
+  test_snapshot_nested_acquire();
+  test_snapshot_reclaim_waits_for_readers();
+  test_snapshot_concurrent_readers();
+});
@@ -0,0 +1,16 @@
+/*
+ * test-state-snapshot.h - Header for state snapshot tests
+ */
+
+#ifndef TEST_STATE_SNAPSHOT_H
+#define TEST_STATE_SNAPSHOT_H
+
+#include "src/components/state-snapshot.h"
+
+void test_snapshot_none_before_publish(void);
+void test_snapshot_copies_state(void);
+void test_snapshot_nested_acquire(void);
+void test_snapshot_reclaim_waits_for_readers(void);
+void test_snapshot_concurrent_readers(void);
+
+#endif /* TEST_STATE_SNAPSHOT_H */
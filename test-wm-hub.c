@@ -1,5 +1,7 @@
 #include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "test-registry.h"
 #include "test-wm.h"
 #include "wm-hub.h"
@@ -550,6 +552,368 @@ test_target_type_null_termination(void)
   hub_shutdown();
 }
 
+/*
+ * Registry growth: no fixed limits on targets, types or components
+ */
+
+#define STRESS_TARGETS 100000
+
+void
+test_registry_stress_targets(void)
+{
+  LOG_CLEAN("== Testing registry with %d targets", STRESS_TARGETS);
+  hub_init();
+
+  HubTarget* many = calloc(STRESS_TARGETS, sizeof(HubTarget));
+  assert_or_abort(many != NULL);
+
+  TargetTypeId client_type = hub_get_target_type_id_by_name("client");
+  for (uint32_t i = 0; i < STRESS_TARGETS; i++) {
+    many[i].id      = 1000 + i;
+    many[i].type_id = client_type;
+    hub_register_target(&many[i]);
+  }
+  assert(hub_target_count() == STRESS_TARGETS);
+  assert(many[STRESS_TARGETS - 1].registered == true);
+  assert(hub_get_target_by_id(1000) == &many[0]);
+  assert(hub_get_target_by_id(1000 + STRESS_TARGETS / 2) == &many[STRESS_TARGETS / 2]);
+  assert(hub_get_target_by_id(1000 + STRESS_TARGETS - 1) == &many[STRESS_TARGETS - 1]);
+
+  HubTarget** clients = hub_get_targets_by_type(client_type);
+  uint32_t    count   = 0;
+  while (clients[count] != NULL)
+    count++;
+  assert(count == STRESS_TARGETS);
+
+  /* Destroyed newest first, as a session winding down would */
+  for (uint32_t i = STRESS_TARGETS; i-- > 0;)
+    hub_unregister_target(many[i].id);
+  assert(hub_target_count() == 0);
+  assert(hub_get_targets_by_type(client_type)[0] == NULL);
+  assert(hub_get_target_by_id(1000) == NULL);
+
+  /* Freed slots are reused rather than growing the registry */
+  for (uint32_t i = 0; i < STRESS_TARGETS / 2; i++)
+    hub_register_target(&many[i]);
+  bool reused = true;
+  for (uint32_t i = 0; i < STRESS_TARGETS / 2; i++)
+    reused = reused && many[i].slot < STRESS_TARGETS;
+  assert(reused);
+  assert(hub_target_count() == STRESS_TARGETS / 2);
+
+  hub_shutdown();
+  assert(many[0].registered == false);
+  free(many);
+}
+
+void
+test_registry_many_target_types(void)
+{
+  LOG_CLEAN("== Testing registry beyond 16 target types");
+  hub_init();
+
+  static char    names[40][16];
+  HubTargetType* client = hub_get_target_type_by_name("client");
+
+  for (int i = 0; i < 40; i++) {
+    snprintf(names[i], sizeof(names[i]), "type-%d", i);
+    assert(hub_register_target_type(names[i], NULL) != NULL);
+  }
+  assert(hub_target_type_count() == 43);
+
+  /* Growing the type registry does not move existing types */
+  assert(hub_get_target_type_by_name("client") == client);
+  assert(client->id == 0);
+
+  HubTargetType* last = hub_get_target_type_by_name("type-39");
+  assert_or_abort(last != NULL);
+  assert(last->id == 42);
+  assert(hub_get_target_type_by_id(42) == last);
+
+  uint32_t        count = 0;
+  HubTargetType** all   = hub_get_all_target_types(&count);
+  assert(count == 43);
+  assert(all[42] == last);
+
+  HubTarget target = { .id = 4242, .type_id = last->id };
+  hub_register_target(&target);
+  assert(hub_get_targets_by_type(last->id)[0] == &target);
+  assert(hub_get_targets_by_type(last->id)[1] == NULL);
+
+  hub_shutdown();
+}
+
+void
+test_registry_many_components(void)
+{
+  LOG_CLEAN("== Testing registry beyond 64 components");
+  hub_init();
+
+  static HubComponent comps[100];
+  static char         names[100][16];
+
+  for (int i = 0; i < 100; i++) {
+    snprintf(names[i], sizeof(names[i]), "comp-%d", i);
+    comps[i] = (HubComponent) {
+      .name                  = names[i],
+      .accepted_target_names = client_target_names,
+    };
+    hub_register_component(&comps[i]);
+  }
+  assert(hub_component_count() == 100);
+  assert(hub_get_component_by_name("comp-99") == &comps[99]);
+
+  HubComponent** accepting = hub_get_components_for_target_type_name("client");
+  int            count     = 0;
+  while (accepting[count] != NULL)
+    count++;
+  assert(count == 100);
+
+  hub_unregister_component("comp-0");
+  assert(hub_component_count() == 99);
+  assert(hub_get_component_by_name("comp-0") == NULL);
+  assert(hub_get_component_by_name("comp-99") == &comps[99]);
+
+  hub_shutdown();
+  assert(comps[99].registered == false);
+}
+
+/*
+ * Target ID map: random register/unregister churn checked against a plain
+ * array, with XID-like IDs that share their high bits.
+ */
+#define CHURN_TARGETS 2048
+
+void
+test_target_id_map_churn(void)
+{
+  LOG_CLEAN("== Testing target ID map under register/unregister churn");
+  hub_init();
+
+  HubTarget* pool = calloc(CHURN_TARGETS, sizeof(HubTarget));
+  assert_or_abort(pool != NULL);
+  for (uint32_t i = 0; i < CHURN_TARGETS; i++) {
+    pool[i].id      = ((TargetID) (i % 8 + 1) << 21) | (i / 8 + 1);
+    pool[i].type_id = TARGET_TYPE_CLIENT;
+  }
+
+  uint32_t seed  = 12345;
+  uint32_t live  = 0;
+  bool     found = true;
+  for (int round = 0; round < 50000; round++) {
+    seed          = seed * 1103515245U + 12345U;
+    HubTarget* t  = &pool[(seed >> 8) % CHURN_TARGETS];
+    if (t->registered) {
+      hub_unregister_target(t->id);
+      live--;
+    } else {
+      hub_register_target(t);
+      live++;
+    }
+
+    /* Every 1000 rounds, every ID must resolve exactly as registered */
+    if (round % 1000 == 0) {
+      for (uint32_t i = 0; i < CHURN_TARGETS; i++)
+        found = found && hub_get_target_by_id(pool[i].id) == (pool[i].registered ? &pool[i] : NULL);
+    }
+  }
+  assert(found);
+  assert(hub_target_count() == live);
+
+  hub_shutdown();
+  free(pool);
+}
+
+/*
+ * The chained map the registry used before: 512 buckets, one malloc per
+ * target, reached through the same calls hub_get_target_by_id() made.
+ * Kept here only as the benchmark baseline.
+ */
+typedef struct chained_entry {
+  TargetID              id;
+  HubTarget*            target;
+  struct chained_entry* next;
+} chained_entry_t;
+
+static chained_entry_t* chained_map[512];
+
+static uint32_t
+chained_hash(TargetID id)
+{
+  return (uint32_t) ((id ^ (id >> 16)) % 512);
+}
+
+static void
+chained_insert(HubTarget* target)
+{
+  uint32_t         hash  = chained_hash(target->id);
+  chained_entry_t* entry = malloc(sizeof(chained_entry_t));
+  entry->id              = target->id;
+  entry->target          = target;
+  entry->next            = chained_map[hash];
+  chained_map[hash]      = entry;
+}
+
+static HubTarget*
+chained_lookup(TargetID id)
+{
+  for (chained_entry_t* e = chained_map[chained_hash(id)]; e != NULL; e = e->next) {
+    if (e->id == id)
+      return e->target;
+  }
+  return NULL;
+}
+
+static HubTarget*
+chained_get_target_by_id(TargetID id)
+{
+  if (id == TARGET_ID_NONE)
+    return NULL;
+
+  return chained_lookup(id);
+}
+
+static void
+chained_clear(void)
+{
+  for (int i = 0; i < 512; i++) {
+    while (chained_map[i] != NULL) {
+      chained_entry_t* next = chained_map[i]->next;
+      free(chained_map[i]);
+      chained_map[i] = next;
+    }
+  }
+}
+
+static double
+elapsed_ns(struct timespec t0, struct timespec t1)
+{
+  return (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+}
+
+/*
+ * Lookup benchmark: client_get_by_window() resolves a target ID for every
+ * event, so lookups must stay flat as the number of windows grows.
+ */
+void
+test_target_id_lookup_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: target ID lookups, open addressing vs chained");
+  const int       lookups = 1000000;
+  const uint32_t  sizes[] = { 100, 1000, 10000 };
+  struct timespec t0, t1;
+
+  for (int s = 0; s < 3; s++) {
+    uint32_t   n       = sizes[s];
+    HubTarget* targets = calloc(n, sizeof(HubTarget));
+    assert_or_abort(targets != NULL);
+
+    hub_init();
+    for (uint32_t i = 0; i < n; i++) {
+      /* XIDs of 16 X clients, each with a 2^21 resource range */
+      targets[i].id      = ((TargetID) (i % 16 + 1) << 21) | (i / 16 + 1);
+      targets[i].type_id = TARGET_TYPE_CLIENT;
+      hub_register_target(&targets[i]);
+      chained_insert(&targets[i]);
+    }
+
+    size_t hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < lookups; i++)
+      hits += hub_get_target_by_id(targets[(uint32_t) i * 7919U % n].id) != NULL;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double open_ns = elapsed_ns(t0, t1) / lookups;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < lookups; i++)
+      hits += chained_get_target_by_id(targets[(uint32_t) i * 7919U % n].id) != NULL;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double chained_ns = elapsed_ns(t0, t1) / lookups;
+
+    LOG_CLEAN("  %5u targets: %.1fns/lookup (chained: %.1fns/lookup)", n, open_ns, chained_ns);
+    assert(hits == 2 * (size_t) lookups);
+
+    chained_clear();
+    hub_shutdown();
+    free(targets);
+  }
+}
+
+/*
+ * Back-indices: every target records where it sits in its type list, and
+ * removal from the middle keeps that true for the target moved into the gap.
+ */
+void
+test_target_type_index_kept(void)
+{
+  LOG_CLEAN("== Testing type list back-indices across removals");
+  hub_init();
+
+  HubTarget clients[6];
+  for (int i = 0; i < 6; i++) {
+    clients[i] = (HubTarget) { .id = 500 + i, .type_id = TARGET_TYPE_CLIENT };
+    hub_register_target(&clients[i]);
+  }
+
+  hub_unregister_target(501); /* from the middle */
+  hub_unregister_target(500); /* from the front */
+  hub_unregister_target(505); /* from the back */
+
+  HubTarget** list  = hub_get_targets_by_type(TARGET_TYPE_CLIENT);
+  uint32_t    count = 0;
+  bool        found = true;
+  for (; list[count] != NULL; count++)
+    found = found && list[count]->type_index == count && list[count]->registered;
+  assert(count == 3);
+  assert(found);
+
+  hub_shutdown();
+}
+
+static double
+destroy_storm_ns(uint32_t n)
+{
+  struct timespec t0, t1;
+  HubTarget*      clients = calloc(n, sizeof(HubTarget));
+  assert_or_abort(clients != NULL);
+
+  hub_init();
+  for (uint32_t i = 0; i < n; i++) {
+    clients[i].id      = 0x400000 + i;
+    clients[i].type_id = TARGET_TYPE_CLIENT;
+    hub_register_target(&clients[i]);
+  }
+
+  /* Oldest first: the order a scan from either end handles worst */
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (uint32_t i = 0; i < n; i++)
+    hub_unregister_target(clients[i].id);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  assert(hub_target_count() == 0);
+  hub_shutdown();
+  free(clients);
+  return elapsed_ns(t0, t1);
+}
+
+/*
+ * Destroy-storm benchmark: a browser quitting unregisters hundreds of
+ * windows in one batch. The total cost must grow linearly with the count.
+ */
+void
+test_destroy_storm_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: destroy storm");
+  double small = destroy_storm_ns(5000);
+  double large = destroy_storm_ns(20000);
+
+  LOG_CLEAN("   5000 clients: %.2fms (%.1fns/client)", small / 1e6, small / 5000);
+  LOG_CLEAN("  20000 clients: %.2fms (%.1fns/client)", large / 1e6, large / 20000);
+
+  /* Linear: 4x the clients may not cost 16x the time */
+  assert(large < small * 10);
+}
+
 /*
  * Event Bus Tests
  */
@@ -1278,12 +1642,89 @@ test_unadoption_hooks_called_on_target_unregister(void)
   hub_shutdown();
 }
 
+void
+test_adoption_for_type_registered_later(void)
+{
+  LOG_CLEAN("== Testing adoption for a target type registered after its component");
+  hub_init();
+  adopt_count_client   = 0;
+  unadopt_count_client = 0;
+
+  static const char* panel_names[] = { "panel", "client", NULL };
+  HubComponent       panel_comp    = {
+             .name                  = "panel-comp",
+             .accepted_target_names = panel_names,
+             .on_adopt              = on_adopt_client,
+             .on_unadopt            = on_unadopt_client,
+  };
+  hub_register_component(&panel_comp);
+
+  /* "panel" is unknown until now: the component is added to its list */
+  HubTargetType* panel = hub_register_target_type("panel", NULL);
+  assert_or_abort(panel != NULL);
+  assert(hub_get_components_for_target_type(panel->id)[0] == &panel_comp);
+  assert(hub_get_components_for_target_type(panel->id)[1] == NULL);
+
+  HubTarget bar = { .id = 700, .type_id = panel->id };
+  hub_register_target(&bar);
+  assert(adopt_count_client == 1);
+
+  /* Unregistering the component takes it off every list it was on */
+  hub_unregister_component("panel-comp");
+  assert(hub_get_components_for_target_type(panel->id)[0] == NULL);
+  assert(hub_get_components_for_target_type_name("client")[0] == NULL);
+  hub_unregister_target(bar.id);
+  assert(unadopt_count_client == 0);
+
+  hub_shutdown();
+}
+
+/*
+ * Adoption benchmark: each new client walks the components accepting
+ * "client", with 32 components registered.
+ */
+void
+test_adoption_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: target register/unregister with 32 components");
+  const int           rounds = 200000;
+  static HubComponent comps[32];
+  static char         names[32][16];
+  struct timespec     t0, t1;
+
+  hub_init();
+  for (int i = 0; i < 32; i++) {
+    snprintf(names[i], sizeof(names[i]), "bench-%d", i);
+    comps[i] = (HubComponent) {
+      .name                  = names[i],
+      .accepted_target_names = (i % 2) ? client_target_names : monitor_target_names,
+    };
+    hub_register_component(&comps[i]);
+  }
+
+  HubTarget client = { .id = 800, .type_id = TARGET_TYPE_CLIENT };
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < rounds; i++) {
+    hub_register_target(&client);
+    hub_unregister_target(client.id);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+  LOG_CLEAN("  %d register/unregister pairs: %.1fns/pair", rounds, ns / rounds);
+  assert(hub_target_count() == 0);
+
+  hub_shutdown();
+}
+
 TEST_GROUP(HubComponentAdoption, {
   test_adoption_hooks_called_on_target_register();
   test_adoption_only_for_compatible_targets();
   test_adoption_for_multiple_targets_of_same_type();
   test_get_components_for_target_type();
   test_unadoption_hooks_called_on_target_unregister();
+  test_adoption_for_type_registered_later();
+  test_adoption_benchmark();
 });
 
 TEST_GROUP(HubRegistry, {
@@ -1308,6 +1749,13 @@ TEST_GROUP(HubRegistry, {
   test_duplicate_target_id_rejected();
   test_large_target_id_lookup();
   test_target_type_null_termination();
+  test_registry_stress_targets();
+  test_registry_many_target_types();
+  test_registry_many_components();
+  test_target_id_map_churn();
+  test_target_id_lookup_benchmark();
+  test_target_type_index_kept();
+  test_destroy_storm_benchmark();
 });
 
 TEST_GROUP(HubEventBus, {
@@ -1556,3 +2004,1145 @@ TEST_GROUP(HubTargetTypeRegistry, {
   test_components_for_target_type_name();
   test_target_type_with_component_owner();
 });
+
+/*
+ * Deferred Relayout Tests
+ */
+
+static int        relayout_calls       = 0;
+static HubTarget* last_relayout_target = NULL;
+
+static void
+count_relayout(HubTarget* target)
+{
+  relayout_calls++;
+  last_relayout_target = target;
+}
+
+/* Re-schedules itself: must not run again within the same pass */
+static void
+reschedule_relayout(HubTarget* target)
+{
+  relayout_calls++;
+  hub_schedule_relayout(target->id);
+}
+
+void
+test_relayout_runs_once_per_target(void)
+{
+  LOG_CLEAN("== Testing deferred relayout runs once per dirty target");
+  hub_init();
+  relayout_calls = 0;
+
+  HubTarget mon1 = { .id = 300, .type_id = TARGET_TYPE_MONITOR };
+  HubTarget mon2 = { .id = 301, .type_id = TARGET_TYPE_MONITOR };
+  hub_register_target(&mon1);
+  hub_register_target(&mon2);
+  hub_register_relayout_handler(hub_get_target_type_id_by_name("monitor"), count_relayout);
+
+  /* 50 windows mapped on each monitor in one batch */
+  for (int i = 0; i < 50; i++) {
+    hub_schedule_relayout(mon1.id);
+    hub_schedule_relayout(mon2.id);
+  }
+  assert(relayout_calls == 0);
+  assert(hub_pending_relayout_count() == 2);
+  assert(mon1.dirty == true);
+
+  hub_run_scheduled_relayouts();
+  assert(relayout_calls == 2);
+  assert(hub_pending_relayout_count() == 0);
+  assert(mon1.dirty == false);
+  assert(mon2.dirty == false);
+
+  HubRelayoutStats stats = hub_get_relayout_stats();
+  assert(stats.requested == 100);
+  assert(stats.executed == 2);
+
+  /* nothing left to do */
+  hub_run_scheduled_relayouts();
+  assert(relayout_calls == 2);
+
+  hub_shutdown();
+}
+
+void
+test_relayout_skips_unregistered_target(void)
+{
+  LOG_CLEAN("== Testing deferred relayout skips targets unregistered meanwhile");
+  hub_init();
+  relayout_calls = 0;
+
+  HubTarget mon = { .id = 300, .type_id = TARGET_TYPE_MONITOR };
+  hub_register_target(&mon);
+  hub_register_relayout_handler(hub_get_target_type_id_by_name("monitor"), count_relayout);
+
+  hub_schedule_relayout(mon.id);
+  hub_unregister_target(mon.id);
+  hub_run_scheduled_relayouts();
+  assert(relayout_calls == 0);
+  assert(hub_get_relayout_stats().executed == 0);
+
+  /* unknown targets are counted but never scheduled */
+  hub_schedule_relayout(999);
+  assert(hub_pending_relayout_count() == 0);
+  assert(hub_get_relayout_stats().requested == 2);
+
+  hub_shutdown();
+}
+
+void
+test_relayout_handler_per_type(void)
+{
+  LOG_CLEAN("== Testing deferred relayout dispatches by target type");
+  hub_init();
+  relayout_calls       = 0;
+  last_relayout_target = NULL;
+
+  HubTarget mon    = { .id = 300, .type_id = TARGET_TYPE_MONITOR };
+  HubTarget client = { .id = 100, .type_id = TARGET_TYPE_CLIENT };
+  hub_register_target(&mon);
+  hub_register_target(&client);
+  hub_register_relayout_handler(hub_get_target_type_id_by_name("monitor"), count_relayout);
+
+  /* no handler for clients: cleared without running */
+  hub_schedule_relayout(client.id);
+  hub_schedule_relayout(mon.id);
+  hub_run_scheduled_relayouts();
+  assert(relayout_calls == 1);
+  assert(last_relayout_target == &mon);
+  assert(client.dirty == false);
+
+  hub_unregister_relayout_handler(hub_get_target_type_id_by_name("monitor"));
+  hub_schedule_relayout(mon.id);
+  hub_run_scheduled_relayouts();
+  assert(relayout_calls == 1);
+
+  hub_shutdown();
+}
+
+void
+test_relayout_rescheduled_from_handler(void)
+{
+  LOG_CLEAN("== Testing deferred relayout scheduled from a handler waits for next pass");
+  hub_init();
+  relayout_calls = 0;
+
+  HubTarget mon = { .id = 300, .type_id = TARGET_TYPE_MONITOR };
+  hub_register_target(&mon);
+  hub_register_relayout_handler(hub_get_target_type_id_by_name("monitor"), reschedule_relayout);
+
+  hub_schedule_relayout(mon.id);
+  hub_run_scheduled_relayouts();
+  assert(relayout_calls == 1);
+  assert(hub_pending_relayout_count() == 1);
+
+  hub_run_scheduled_relayouts();
+  assert(relayout_calls == 2);
+
+  hub_shutdown();
+}
+
+static uint32_t settle_events = 0;
+
+/* Relayouts post EVT_TEST_A for their target */
+static void
+relayout_post(HubTarget* target)
+{
+  relayout_calls++;
+  hub_post(EVT_TEST_A, target->id, NULL);
+}
+
+/* The first EVT_TEST_A schedules another relayout */
+static void
+handler_schedule_relayout(struct Event e)
+{
+  settle_events++;
+  if (settle_events == 1)
+    hub_schedule_relayout(e.target);
+}
+
+void
+test_settle_runs_until_idle(void)
+{
+  LOG_CLEAN("== Testing settle runs relayouts and events until neither is left");
+  hub_init();
+  hub_set_event_deferral(true);
+  relayout_calls = 0;
+  settle_events  = 0;
+
+  HubTarget mon = { .id = 300, .type_id = TARGET_TYPE_MONITOR };
+  hub_register_target(&mon);
+  hub_register_relayout_handler(hub_get_target_type_id_by_name("monitor"), relayout_post);
+  hub_subscribe(EVT_TEST_A, handler_schedule_relayout, NULL);
+
+  /* relayout -> event -> relayout -> event, all in one call */
+  hub_schedule_relayout(mon.id);
+  hub_settle();
+  assert(relayout_calls == 2);
+  assert(settle_events == 2);
+  assert(hub_pending_relayout_count() == 0);
+  assert(hub_get_event_stats().queue_depth == 0);
+
+  /* a relayout that always reschedules itself still returns */
+  hub_register_relayout_handler(hub_get_target_type_id_by_name("monitor"), reschedule_relayout);
+  hub_schedule_relayout(mon.id);
+  hub_settle();
+  assert(hub_pending_relayout_count() == 1);
+
+  hub_shutdown();
+}
+
+TEST_GROUP(HubRelayoutScheduler, {
+  test_relayout_runs_once_per_target();
+  test_relayout_skips_unregistered_target();
+  test_relayout_handler_per_type();
+  test_relayout_rescheduled_from_handler();
+  test_settle_runs_until_idle();
+});
+
+/*
+ * Queued Event Delivery Tests
+ */
+
+static char      delivery_log[64];
+static uint32_t  delivery_log_len = 0;
+static TargetID  posted_targets   = 0; /* targets handler_post_many posts */
+static uintptr_t last_posted_data = 0;
+
+static void
+log_delivery(char c)
+{
+  if (delivery_log_len < sizeof(delivery_log) - 1)
+    delivery_log[delivery_log_len++] = c;
+  delivery_log[delivery_log_len] = '\0';
+}
+
+static void
+reset_delivery_log(void)
+{
+  delivery_log_len = 0;
+  delivery_log[0]  = '\0';
+}
+
+/* Posts an event of EVT_TEST_B, then logs its own return */
+static void
+handler_post_b(struct Event e)
+{
+  (void) e;
+  log_delivery('a');
+  hub_post(EVT_TEST_B, 1, NULL);
+  log_delivery('A');
+}
+
+static void
+handler_log_b(struct Event e)
+{
+  log_delivery('b');
+  last_target      = e.target;
+  last_posted_data = (uintptr_t) e.data;
+  handler_b_calls++;
+}
+
+/* Posts EVT_TEST_B three times for target 1 and once for target 2 */
+static void
+handler_post_repeated(struct Event e)
+{
+  (void) e;
+  hub_post(EVT_TEST_B, 1, (void*) 1);
+  hub_post(EVT_TEST_B, 2, (void*) 2);
+  hub_post(EVT_TEST_B, 1, (void*) 3);
+  hub_post(EVT_TEST_B, 1, (void*) 4);
+}
+
+/* Posts EVT_TEST_B for posted_targets distinct targets */
+static void
+handler_post_many(struct Event e)
+{
+  (void) e;
+  for (TargetID t = 1; t <= posted_targets; t++)
+    hub_post(EVT_TEST_B, t, NULL);
+}
+
+/* Unsubscribes handler_c and subscribes handler_b while delivering */
+static void
+handler_reshuffle(struct Event e)
+{
+  (void) e;
+  hub_unsubscribe(EVT_TEST_A, handler_c);
+  hub_subscribe(EVT_TEST_A, handler_b, NULL);
+}
+
+void
+test_post_outside_delivery_is_immediate(void)
+{
+  LOG_CLEAN("== Testing hub_post outside a delivery delivers right away");
+  hub_init();
+  handler_b_calls = 0;
+
+  hub_subscribe(EVT_TEST_B, handler_log_b, NULL);
+  hub_post(EVT_TEST_B, 7, NULL);
+
+  assert(handler_b_calls == 1);
+  assert(last_target == 7);
+
+  HubEventStats stats = hub_get_event_stats();
+  assert(stats.posted == 1);
+  assert(stats.emitted == 1);
+  assert(stats.queue_depth == 0);
+
+  hub_shutdown();
+}
+
+void
+test_post_deferred_until_drain(void)
+{
+  LOG_CLEAN("== Testing deferred posts wait for the loop's drain");
+  hub_init();
+  hub_set_event_deferral(true);
+  hub_set_event_coalescing(EVT_TEST_B, true);
+  handler_b_calls = 0;
+
+  hub_subscribe(EVT_TEST_A, handler_post_repeated, NULL);
+  hub_subscribe(EVT_TEST_B, handler_log_b, NULL);
+
+  /* posts outside a delivery and after one all wait */
+  hub_post(EVT_TEST_B, 1, (void*) 0);
+  hub_emit(EVT_TEST_A, 1, NULL);
+  hub_emit(EVT_TEST_A, 1, NULL);
+  assert(handler_b_calls == 0);
+  assert(hub_get_event_stats().queue_depth == 2);
+
+  /* one delivery per target for the whole iteration, latest data */
+  hub_drain_events();
+  assert(handler_b_calls == 2);
+  assert(hub_get_event_stats().coalesced == 7);
+  assert(last_target == 2);
+
+  /* turning deferral off delivers what is still waiting */
+  hub_post(EVT_TEST_B, 3, NULL);
+  assert(handler_b_calls == 2);
+  hub_set_event_deferral(false);
+  assert(handler_b_calls == 3 && last_target == 3);
+
+  hub_post(EVT_TEST_B, 4, NULL);
+  assert(handler_b_calls == 4);
+
+  hub_shutdown();
+}
+
+void
+test_post_from_handler_runs_after_handler(void)
+{
+  LOG_CLEAN("== Testing an event posted by a handler is delivered after it returns");
+  hub_init();
+  reset_delivery_log();
+
+  hub_subscribe(EVT_TEST_A, handler_post_b, NULL);
+  hub_subscribe(EVT_TEST_B, handler_log_b, NULL);
+
+  hub_emit(EVT_TEST_A, 1, NULL);
+  LOG_CLEAN("  delivery order: %s", delivery_log);
+  assert(strcmp(delivery_log, "aAb") == 0);
+
+  /* hub_emit stays synchronous: the same chain nests when emitted */
+  assert(hub_get_event_stats().max_queue_depth == 1);
+  assert(hub_get_event_stats().queue_depth == 0);
+
+  hub_shutdown();
+}
+
+void
+test_post_coalesces_per_target(void)
+{
+  LOG_CLEAN("== Testing queued events coalesce per (type, target)");
+  hub_init();
+
+  hub_subscribe(EVT_TEST_A, handler_post_repeated, NULL);
+  hub_subscribe(EVT_TEST_B, handler_log_b, NULL);
+
+  /* Without coalescing every post is delivered */
+  handler_b_calls = 0;
+  hub_emit(EVT_TEST_A, 1, NULL);
+  assert(handler_b_calls == 4);
+  assert(hub_get_event_stats().coalesced == 0);
+
+  /* With coalescing, target 1 is delivered once with the latest data */
+  hub_set_event_coalescing(EVT_TEST_B, true);
+  hub_reset_event_stats();
+  handler_b_calls = 0;
+  reset_delivery_log();
+  hub_emit(EVT_TEST_A, 1, NULL);
+
+  assert(handler_b_calls == 2);
+  assert(hub_get_event_stats().coalesced == 2);
+  assert(hub_get_event_stats().posted == 4);
+  /* queue order is kept: target 1 first, target 2 last */
+  assert(last_target == 2);
+  assert(last_posted_data == 2);
+
+  hub_shutdown();
+}
+
+void
+test_subscribe_changes_during_delivery(void)
+{
+  LOG_CLEAN("== Testing subscribe and unsubscribe from a handler");
+  hub_init();
+  handler_b_calls = 0;
+  handler_c_calls = 0;
+
+  hub_subscribe(EVT_TEST_A, handler_reshuffle, NULL);
+  hub_subscribe(EVT_TEST_A, handler_c, NULL);
+
+  /* handler_c is removed before its turn, handler_b joins too late */
+  hub_emit(EVT_TEST_A, 1, NULL);
+  assert(handler_c_calls == 0);
+  assert(handler_b_calls == 0);
+
+  /* The next delivery sees the new subscriber list */
+  hub_emit(EVT_TEST_A, 2, NULL);
+  assert(handler_c_calls == 0);
+  assert(handler_b_calls == 1);
+
+  hub_shutdown();
+}
+
+void
+test_event_queue_growth(void)
+{
+  LOG_CLEAN("== Testing event queue grows past its initial capacity");
+  hub_init();
+  handler_b_calls = 0;
+  posted_targets  = 1000;
+
+  hub_subscribe(EVT_TEST_A, handler_post_many, NULL);
+  hub_subscribe(EVT_TEST_B, handler_log_b, NULL);
+  hub_set_event_coalescing(EVT_TEST_B, true);
+
+  hub_emit(EVT_TEST_A, 1, NULL);
+  assert(handler_b_calls == 1000);
+  assert(last_target == 1000);
+  assert(hub_get_event_stats().max_queue_depth == 1000);
+  assert(hub_get_event_stats().coalesced == 0);
+
+  hub_shutdown();
+}
+
+/*
+ * Coalescing posts look their queued event up by (type, target) instead of
+ * scanning a queue that holds many targets.
+ */
+void
+test_post_coalesces_in_deep_queue(void)
+{
+  LOG_CLEAN("== Benchmark: coalescing posts into 1000 queued events");
+  const uint32_t  targets = 1000;
+  struct timespec t0, t1;
+
+  hub_init();
+  hub_set_event_deferral(true);
+  hub_set_event_coalescing(EVT_TEST_B, true);
+  hub_subscribe(EVT_TEST_B, handler_log_b, NULL);
+  handler_b_calls = 0;
+
+  for (uint32_t t = 1; t <= targets; t++)
+    hub_post(EVT_TEST_B, t, (void*) 0);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (uintptr_t round = 1; round <= 100; round++) {
+    for (uint32_t t = 1; t <= targets; t++)
+      hub_post(EVT_TEST_B, t, (void*) round);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  LOG_CLEAN("  %u coalescing posts: %.1fns/post", 100 * targets, elapsed_ns(t0, t1) / (100 * targets));
+  assert(hub_get_event_stats().queue_depth == targets);
+  assert(hub_get_event_stats().coalesced == 100 * targets);
+
+  /* Events queued before coalescing was on are folded into too */
+  hub_post(EVT_TEST_C, 5, NULL);
+  hub_post(EVT_TEST_C, 5, NULL);
+  hub_set_event_coalescing(EVT_TEST_C, true);
+  hub_post(EVT_TEST_C, 5, NULL);
+  assert(hub_get_event_stats().queue_depth == targets + 2);
+
+  hub_drain_events();
+  assert(handler_b_calls == targets);
+  assert(last_target == targets);
+  assert(last_posted_data == 100);
+
+  /* Delivered events are no longer folded into */
+  hub_post(EVT_TEST_B, 1, NULL);
+  assert(hub_get_event_stats().queue_depth == 1);
+  assert(hub_get_event_stats().coalesced == 100 * targets + 1);
+
+  hub_shutdown();
+}
+
+static uint64_t counted_events = 0;
+
+static void
+count_event(struct Event e)
+{
+  (void) e;
+  counted_events++;
+}
+
+static void
+count_event_too(struct Event e)
+{
+  (void) e;
+  counted_events++;
+}
+
+/*
+ * Emit benchmark: delivery walks the live subscriber array instead of
+ * copying it to the stack first.
+ */
+void
+test_emit_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: hub_emit with 2 subscribers");
+  const int       rounds = 1000000;
+  struct timespec t0, t1;
+
+  hub_init();
+  counted_events = 0;
+  hub_subscribe(EVT_TEST_C, count_event, NULL);
+  hub_subscribe(EVT_TEST_C, count_event_too, NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < rounds; i++)
+    hub_emit(EVT_TEST_C, (TargetID) i, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  LOG_CLEAN("  %d emits: %.1fns/emit", rounds, elapsed_ns(t0, t1) / rounds);
+  assert(counted_events == 2 * (uint64_t) rounds);
+
+  hub_shutdown();
+}
+
+TEST_GROUP(HubEventQueue, {
+  test_post_outside_delivery_is_immediate();
+  test_post_deferred_until_drain();
+  test_post_from_handler_runs_after_handler();
+  test_post_coalesces_per_target();
+  test_subscribe_changes_during_delivery();
+  test_event_queue_growth();
+  test_post_coalesces_in_deep_queue();
+  test_emit_benchmark();
+});
+
+/*
+ * Target-Scoped Subscription Tests
+ */
+
+#define COUNTING_HANDLER(n)            \
+  static void                          \
+  counting_handler_##n(struct Event e) \
+  {                                    \
+    (void) e;                          \
+    counted_events++;                  \
+  }
+
+COUNTING_HANDLER(0)
+COUNTING_HANDLER(1)
+COUNTING_HANDLER(2)
+COUNTING_HANDLER(3)
+COUNTING_HANDLER(4)
+COUNTING_HANDLER(5)
+COUNTING_HANDLER(6)
+COUNTING_HANDLER(7)
+COUNTING_HANDLER(8)
+COUNTING_HANDLER(9)
+COUNTING_HANDLER(10)
+COUNTING_HANDLER(11)
+COUNTING_HANDLER(12)
+COUNTING_HANDLER(13)
+COUNTING_HANDLER(14)
+COUNTING_HANDLER(15)
+COUNTING_HANDLER(16)
+COUNTING_HANDLER(17)
+COUNTING_HANDLER(18)
+COUNTING_HANDLER(19)
+
+static EventHandler counting_handlers[] = {
+  counting_handler_0,  counting_handler_1,  counting_handler_2,  counting_handler_3,
+  counting_handler_4,  counting_handler_5,  counting_handler_6,  counting_handler_7,
+  counting_handler_8,  counting_handler_9,  counting_handler_10, counting_handler_11,
+  counting_handler_12, counting_handler_13, counting_handler_14, counting_handler_15,
+  counting_handler_16, counting_handler_17, counting_handler_18, counting_handler_19,
+};
+
+static void
+log_global(struct Event e)
+{
+  (void) e;
+  log_delivery('g');
+}
+
+static void
+log_scoped(struct Event e)
+{
+  (void) e;
+  log_delivery('s');
+}
+
+/* Unregisters the event's target, then logs */
+static void
+unregister_event_target(struct Event e)
+{
+  hub_unregister_target(e.target);
+  log_delivery('u');
+}
+
+void
+test_subscribe_target_filters(void)
+{
+  LOG_CLEAN("== Testing target-scoped subscriptions only see their target");
+  hub_init();
+  reset_delivery_log();
+
+  HubTarget one = { .id = 501, .type_id = TARGET_TYPE_CLIENT };
+  HubTarget two = { .id = 502, .type_id = TARGET_TYPE_CLIENT };
+  hub_register_target(&one);
+  hub_register_target(&two);
+
+  hub_subscribe_target(EVT_TEST_A, one.id, log_scoped, NULL);
+  hub_subscribe(EVT_TEST_A, log_global, NULL);
+  assert(one.subscriptions == 1);
+  assert(two.subscriptions == 0);
+
+  /* global handlers first, then the target's */
+  hub_emit(EVT_TEST_A, one.id, NULL);
+  hub_emit(EVT_TEST_A, two.id, NULL);
+  hub_emit(EVT_TEST_B, one.id, NULL);
+  LOG_CLEAN("  delivery order: %s", delivery_log);
+  assert(strcmp(delivery_log, "gsg") == 0);
+
+  hub_unsubscribe_target(EVT_TEST_A, one.id, log_scoped);
+  assert(one.subscriptions == 0);
+  hub_emit(EVT_TEST_A, one.id, NULL);
+  assert(strcmp(delivery_log, "gsgg") == 0);
+
+  hub_shutdown();
+}
+
+void
+test_subscribe_target_requires_registered(void)
+{
+  LOG_CLEAN("== Testing target-scoped subscription to an unknown target is refused");
+  hub_init();
+  reset_delivery_log();
+
+  hub_subscribe_target(EVT_TEST_A, 503, log_scoped, NULL);
+  hub_emit(EVT_TEST_A, 503, NULL);
+  assert(delivery_log_len == 0);
+
+  hub_shutdown();
+}
+
+void
+test_target_subscriptions_dropped_on_unregister(void)
+{
+  LOG_CLEAN("== Testing target-scoped subscriptions end with the target");
+  hub_init();
+  reset_delivery_log();
+
+  HubTarget target = { .id = 504, .type_id = TARGET_TYPE_MONITOR };
+  hub_register_target(&target);
+  hub_subscribe_target(EVT_TEST_A, target.id, log_scoped, NULL);
+  hub_subscribe_target(EVT_TEST_B, target.id, log_scoped, NULL);
+  assert(target.subscriptions == 2);
+
+  hub_unregister_target(target.id);
+  assert(target.subscriptions == 0);
+
+  /* A new target reusing the ID starts without subscriptions */
+  HubTarget again = { .id = 504, .type_id = TARGET_TYPE_MONITOR };
+  hub_register_target(&again);
+  hub_emit(EVT_TEST_A, again.id, NULL);
+  hub_emit(EVT_TEST_B, again.id, NULL);
+  assert(delivery_log_len == 0);
+
+  hub_shutdown();
+}
+
+void
+test_unregister_target_from_scoped_handler(void)
+{
+  LOG_CLEAN("== Testing a scoped handler may unregister its target");
+  hub_init();
+  reset_delivery_log();
+
+  HubTarget target = { .id = 505, .type_id = TARGET_TYPE_CLIENT };
+  hub_register_target(&target);
+  hub_subscribe_target(EVT_TEST_A, target.id, unregister_event_target, NULL);
+  hub_subscribe_target(EVT_TEST_A, target.id, log_scoped, NULL);
+
+  /* the second handler belongs to the target and is skipped */
+  hub_emit(EVT_TEST_A, target.id, NULL);
+  assert(strcmp(delivery_log, "u") == 0);
+  assert(hub_get_target_by_id(target.id) == NULL);
+
+  hub_emit(EVT_TEST_A, target.id, NULL);
+  assert(strcmp(delivery_log, "u") == 0);
+
+  hub_shutdown();
+}
+
+void
+test_subscribers_unbounded(void)
+{
+  LOG_CLEAN("== Testing an event type takes more than 16 subscribers");
+  hub_init();
+  counted_events = 0;
+
+  HubTarget target = { .id = 506, .type_id = TARGET_TYPE_CLIENT };
+  hub_register_target(&target);
+
+  uint32_t handlers = sizeof(counting_handlers) / sizeof(counting_handlers[0]);
+  for (uint32_t i = 0; i < handlers; i++) {
+    hub_subscribe(EVT_TEST_A, counting_handlers[i], NULL);
+    hub_subscribe_target(EVT_TEST_A, target.id, counting_handlers[i], NULL);
+  }
+
+  hub_emit(EVT_TEST_A, target.id, NULL);
+  assert(counted_events == 2 * handlers);
+
+  hub_shutdown();
+}
+
+/*
+ * Scoped emit benchmark: with one listener per target, an emit costs the
+ * same whether 10 or 10000 targets have listeners.
+ */
+static double
+scoped_emit_ns(uint32_t targets)
+{
+  const int       rounds = 200000;
+  struct timespec t0, t1;
+
+  hub_init();
+  counted_events = 0;
+
+  HubTarget* pool = calloc(targets, sizeof(HubTarget));
+  for (uint32_t i = 0; i < targets; i++) {
+    pool[i] = (HubTarget) { .id = 0x1000000 + i, .type_id = TARGET_TYPE_CLIENT };
+    hub_register_target(&pool[i]);
+    hub_subscribe_target(EVT_TEST_A, pool[i].id, count_event, NULL);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < rounds; i++)
+    hub_emit(EVT_TEST_A, pool[(uint32_t) i % targets].id, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  assert(counted_events == (uint64_t) rounds);
+
+  hub_shutdown();
+  free(pool);
+  return elapsed_ns(t0, t1) / rounds;
+}
+
+void
+test_scoped_emit_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: emit to target-scoped listeners");
+
+  double small = scoped_emit_ns(10);
+  double large = scoped_emit_ns(10000);
+
+  LOG_CLEAN("  10 listening targets: %.1fns/emit, 10000: %.1fns/emit", small, large);
+  assert(large < small * 10);
+}
+
+TEST_GROUP(HubTargetSubscriptions, {
+  test_subscribe_target_filters();
+  test_subscribe_target_requires_registered();
+  test_target_subscriptions_dropped_on_unregister();
+  test_unregister_target_from_scoped_handler();
+  test_subscribers_unbounded();
+  test_scoped_emit_benchmark();
+});
+
+/*
+ * Batched Request Tests
+ */
+
+#define REQ_TEST_BATCH_EACH ((RequestType) 20)
+#define REQ_TEST_BATCH_ALL  ((RequestType) 21)
+
+static TargetID batch_monitor_id     = 600;
+static uint32_t batch_targets_seen   = 0;
+static int      calls_seen_by_events = -1;
+
+/* Per-target executor: dirties the monitor and posts its change event */
+static void
+exec_batch_each(struct HubRequest* req)
+{
+  executor_call_count++;
+  last_exec_target = req->target;
+  hub_schedule_relayout(batch_monitor_id);
+  hub_post(EVT_TEST_B, batch_monitor_id, req->data);
+}
+
+static void
+exec_batch_all(struct HubRequestBatch* batch)
+{
+  executor_call_count++;
+  batch_targets_seen = batch->count;
+  last_exec_target   = batch->targets[batch->count - 1];
+  last_exec_data     = batch->data;
+}
+
+/* Records how many executor calls happened before the event arrived */
+static void
+note_batch_event(struct Event e)
+{
+  (void) e;
+  handler_b_calls++;
+  calls_seen_by_events = executor_call_count;
+}
+
+static HubComponent batch_each_component = {
+  .name     = "batch-each",
+  .requests = (RequestType[]) { REQ_TEST_BATCH_EACH, 0 },
+  .executor = exec_batch_each,
+};
+
+static HubComponent batch_all_component = {
+  .name           = "batch-all",
+  .requests       = (RequestType[]) { REQ_TEST_BATCH_ALL, 0 },
+  .executor       = exec_fullscreen,
+  .batch_executor = exec_batch_all,
+};
+
+void
+test_batch_runs_executor_per_target(void)
+{
+  LOG_CLEAN("== Testing a batch without batch executor runs once per target");
+  hub_init();
+  hub_register_component(&batch_each_component);
+
+  TargetID targets[] = { 11, 12, 13, 14 };
+  executor_call_count = 0;
+  hub_send_request_batch(REQ_TEST_BATCH_EACH, targets, 4, NULL);
+
+  assert(executor_call_count == 4);
+  assert(last_exec_target == 14);
+
+  /* empty batches and unknown request types are ignored */
+  hub_send_request_batch(REQ_TEST_BATCH_EACH, targets, 0, NULL);
+  hub_send_request_batch(REQ_TEST_BATCH_EACH, NULL, 4, NULL);
+  hub_send_request_batch(99, targets, 4, NULL);
+  assert(executor_call_count == 4);
+
+  hub_shutdown();
+}
+
+void
+test_batch_executor_gets_all_targets(void)
+{
+  LOG_CLEAN("== Testing a batch executor receives the whole target array");
+  hub_init();
+  hub_register_component(&batch_all_component);
+
+  TargetID targets[] = { 21, 22, 23 };
+  int      data      = 7;
+  executor_call_count = 0;
+  hub_send_request_batch(REQ_TEST_BATCH_ALL, targets, 3, &data);
+
+  assert(executor_call_count == 1);
+  assert(batch_targets_seen == 3);
+  assert(last_exec_target == 23);
+  assert(last_exec_data == &data);
+
+  /* single requests still use the regular executor */
+  hub_send_request(REQ_TEST_BATCH_ALL, 24);
+  assert(executor_call_count == 2);
+  assert(last_exec_target == 24);
+
+  hub_shutdown();
+}
+
+void
+test_batch_commits_side_effects_once(void)
+{
+  LOG_CLEAN("== Testing a batch commits one relayout and one event per target");
+  hub_init();
+  hub_register_component(&batch_each_component);
+
+  HubTarget mon = { .id = batch_monitor_id, .type_id = TARGET_TYPE_MONITOR };
+  hub_register_target(&mon);
+  hub_register_relayout_handler(hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR), count_relayout);
+  hub_subscribe(EVT_TEST_B, note_batch_event, NULL);
+  hub_set_event_coalescing(EVT_TEST_B, true);
+
+  TargetID targets[30];
+  for (uint32_t i = 0; i < 30; i++)
+    targets[i] = 1000 + i;
+
+  executor_call_count  = 0;
+  handler_b_calls      = 0;
+  relayout_calls       = 0;
+  calls_seen_by_events = -1;
+  hub_send_request_batch(REQ_TEST_BATCH_EACH, targets, 30, NULL);
+
+  assert(executor_call_count == 30);
+  assert(relayout_calls == 1);
+  assert(hub_pending_relayout_count() == 0);
+  assert(handler_b_calls == 1);
+  assert(calls_seen_by_events == 30); /* delivered after the whole batch */
+  assert(hub_get_event_stats().coalesced == 29);
+
+  hub_shutdown();
+}
+
+TEST_GROUP(HubRequestBatch, {
+  test_batch_runs_executor_per_target();
+  test_batch_executor_gets_all_targets();
+  test_batch_commits_side_effects_once();
+});
+
+/*
+ * Request Queue Tests
+ */
+
+#define REQ_TEST_QUEUED ((RequestType) 22)
+
+#define QUEUE_FAIL_TARGET  ((TargetID) 666)
+#define QUEUE_REQUEUE_DATA ((void*) 1)
+#define QUEUE_MAX_RESULTS  16
+
+static uint64_t  result_cids[QUEUE_MAX_RESULTS];
+static EventType result_types[QUEUE_MAX_RESULTS];
+static uint32_t  result_count         = 0;
+static int       calls_seen_by_result = -1;
+
+static void
+exec_queued(struct HubRequest* req)
+{
+  executor_call_count++;
+  last_exec_target = req->target;
+  last_exec_cid    = req->correlation_id;
+
+  if (req->target == QUEUE_FAIL_TARGET)
+    req->failed = true;
+
+  /* a request queued by an executor waits for the next run */
+  if (req->data == QUEUE_REQUEUE_DATA)
+    hub_queue_request(REQ_TEST_QUEUED, req->target + 1, NULL, req->correlation_id + 1);
+}
+
+static void
+note_request_result(struct Event e)
+{
+  struct HubRequest* req = e.data;
+
+  if (result_count < QUEUE_MAX_RESULTS) {
+    result_cids[result_count]  = req->correlation_id;
+    result_types[result_count] = e.type;
+    result_count++;
+  }
+  calls_seen_by_result = executor_call_count;
+}
+
+static HubComponent queue_component = {
+  .name     = "queued",
+  .requests = (RequestType[]) { REQ_TEST_QUEUED, 0 },
+  .executor = exec_queued,
+};
+
+static void
+queue_test_setup(void)
+{
+  hub_init();
+  hub_register_component(&queue_component);
+  hub_subscribe(EVT_REQUEST_COMPLETED, note_request_result, NULL);
+  hub_subscribe(EVT_REQUEST_FAILED, note_request_result, NULL);
+
+  executor_call_count  = 0;
+  result_count         = 0;
+  calls_seen_by_result = -1;
+}
+
+void
+test_queued_request_runs_on_drain(void)
+{
+  LOG_CLEAN("== Testing a queued request runs when the queue is drained");
+  queue_test_setup();
+
+  assert(hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 0xC1D));
+  assert(executor_call_count == 0);
+  assert(hub_get_request_stats().pending == 1);
+
+  hub_run_queued_requests();
+
+  assert(executor_call_count == 1);
+  assert(last_exec_target == 100);
+  assert(last_exec_cid == 0xC1D);
+  assert(result_count == 1);
+  assert(result_types[0] == EVT_REQUEST_COMPLETED);
+  assert(result_cids[0] == 0xC1D);
+  assert(hub_get_request_stats().pending == 0);
+  assert(hub_get_request_stats().completed == 1);
+
+  /* draining an empty queue does nothing */
+  hub_run_queued_requests();
+  assert(executor_call_count == 1);
+  assert(result_count == 1);
+
+  hub_shutdown();
+}
+
+void
+test_queued_request_failures(void)
+{
+  LOG_CLEAN("== Testing failed queued requests report their correlation id");
+  queue_test_setup();
+
+  hub_queue_request(99, 100, NULL, 1);                            /* no component */
+  hub_queue_request(REQ_TEST_QUEUED, QUEUE_FAIL_TARGET, NULL, 2); /* executor fails */
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 3);
+  hub_run_queued_requests();
+
+  assert(executor_call_count == 2);
+  assert(result_count == 3);
+  assert(result_types[0] == EVT_REQUEST_FAILED && result_cids[0] == 1);
+  assert(result_types[1] == EVT_REQUEST_FAILED && result_cids[1] == 2);
+  assert(result_types[2] == EVT_REQUEST_COMPLETED && result_cids[2] == 3);
+  assert(hub_get_request_stats().failed == 2);
+  assert(hub_get_request_stats().completed == 1);
+
+  hub_shutdown();
+}
+
+void
+test_queued_requests_merge(void)
+{
+  LOG_CLEAN("== Testing duplicate queued requests run once when merging is on");
+  queue_test_setup();
+
+  /* without merging every request runs */
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 1);
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 2);
+  hub_run_queued_requests();
+  assert(executor_call_count == 2);
+
+  hub_set_request_merging(REQ_TEST_QUEUED, true);
+  executor_call_count = 0;
+  result_count        = 0;
+  hub_reset_request_stats();
+
+  int data = 5;
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 11);
+  hub_queue_request(REQ_TEST_QUEUED, 200, NULL, 12);
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 13);
+  hub_queue_request(REQ_TEST_QUEUED, 100, &data, 14); /* other data: no merge */
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 15);
+  hub_run_queued_requests();
+
+  assert(executor_call_count == 3);
+  assert(hub_get_request_stats().merged == 2);
+
+  /* every caller hears back, in queue order */
+  assert(result_count == 5);
+  for (uint32_t i = 0; i < 5; i++) {
+    assert(result_types[i] == EVT_REQUEST_COMPLETED);
+    assert(result_cids[i] == 11 + i);
+  }
+
+  /* a merged request shares the outcome of the one that ran */
+  result_count = 0;
+  hub_queue_request(REQ_TEST_QUEUED, QUEUE_FAIL_TARGET, NULL, 21);
+  hub_queue_request(REQ_TEST_QUEUED, QUEUE_FAIL_TARGET, NULL, 22);
+  hub_run_queued_requests();
+  assert(result_count == 2);
+  assert(result_types[0] == EVT_REQUEST_FAILED && result_cids[0] == 21);
+  assert(result_types[1] == EVT_REQUEST_FAILED && result_cids[1] == 22);
+
+  hub_shutdown();
+}
+
+void
+test_queued_requests_commit_once(void)
+{
+  LOG_CLEAN("== Testing a queue run commits after every request has run");
+  queue_test_setup();
+
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 1);
+  hub_queue_request(REQ_TEST_QUEUED, 101, NULL, 2);
+  hub_queue_request(REQ_TEST_QUEUED, 102, NULL, 3);
+  hub_run_queued_requests();
+
+  assert(executor_call_count == 3);
+  assert(result_count == 3);
+  assert(calls_seen_by_result == 3); /* results delivered after all ran */
+
+  hub_shutdown();
+}
+
+void
+test_requests_queued_while_running_wait(void)
+{
+  LOG_CLEAN("== Testing requests queued during a run wait for the next one");
+  queue_test_setup();
+
+  hub_queue_request(REQ_TEST_QUEUED, 100, QUEUE_REQUEUE_DATA, 1);
+  hub_run_queued_requests();
+
+  assert(executor_call_count == 1);
+  assert(hub_get_request_stats().pending == 1);
+
+  hub_run_queued_requests();
+  assert(executor_call_count == 2);
+  assert(last_exec_target == 101);
+  assert(last_exec_cid == 2);
+  assert(hub_get_request_stats().pending == 0);
+
+  /* the synchronous path is unchanged */
+  hub_send_request_with_cid(REQ_TEST_QUEUED, 300, 9);
+  assert(executor_call_count == 3);
+  assert(hub_get_request_stats().pending == 0);
+
+  hub_shutdown();
+}
+
+/*
+ * The loop defers posted events to its drain, but completions point into
+ * the queue the run frees: they must be out before it returns.
+ */
+void
+test_queued_requests_with_deferral(void)
+{
+  LOG_CLEAN("== Testing queued request completions with deferred events");
+  queue_test_setup();
+  hub_set_event_deferral(true);
+
+  hub_queue_request(REQ_TEST_QUEUED, 100, NULL, 1);
+  hub_queue_request(REQ_TEST_QUEUED, QUEUE_FAIL_TARGET, NULL, 2);
+  hub_run_queued_requests();
+
+  assert(executor_call_count == 2);
+  assert(result_count == 2);
+  assert(result_types[0] == EVT_REQUEST_COMPLETED && result_cids[0] == 1);
+  assert(result_types[1] == EVT_REQUEST_FAILED && result_cids[1] == 2);
+  assert(hub_get_event_stats().queue_depth == 0);
+
+  /* nothing left for the loop's drain to deliver */
+  hub_drain_events();
+  assert(result_count == 2);
+
+  hub_shutdown();
+}
+
+TEST_GROUP(HubRequestQueue, {
+  test_queued_request_runs_on_drain();
+  test_queued_request_failures();
+  test_queued_requests_merge();
+  test_queued_requests_commit_once();
+  test_requests_queued_while_running_wait();
+  test_queued_requests_with_deferral();
+});
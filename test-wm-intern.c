@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/actions/action-registry.h"
+#include "src/sm/sm-registry.h"
+#include "test-registry.h"
+#include "test-wm-intern.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+#include "wm-intern.h"
+
+void
+test_intern_well_known_atoms(void)
+{
+  LOG_CLEAN("== Testing well-known name atoms");
+
+  assert(name_atom_find("client") == NAME_ATOM_CLIENT);
+  assert(name_atom_find("monitor") == NAME_ATOM_MONITOR);
+  assert(name_atom_find("tag") == NAME_ATOM_TAG);
+  assert(name_atom_find("focus") == NAME_ATOM_FOCUS);
+  assert(name_atom_find("fullscreen") == NAME_ATOM_FULLSCREEN);
+  assert(name_atom_find("tiling") == NAME_ATOM_TILING);
+  assert(name_atom_find("pertag") == NAME_ATOM_PERTAG);
+  assert(name_atom_find("tag-view") == NAME_ATOM_TAG_VIEW);
+
+  assert(strcmp(name_atom_string(NAME_ATOM_CLIENT), "client") == 0);
+  assert(strcmp(name_atom_string(NAME_ATOM_TAG_VIEW), "tag-view") == 0);
+  assert(name_atom_string(NAME_ATOM_NONE) == NULL);
+  assert(name_atom_count() >= NAME_ATOM_WELL_KNOWN_COUNT - 1);
+}
+
+void
+test_intern_idempotent(void)
+{
+  LOG_CLEAN("== Testing name interning is idempotent and copies names");
+
+  char name[32];
+  snprintf(name, sizeof(name), "intern.test.idempotent");
+
+  NameAtom atom = name_intern(name);
+  assert(atom >= NAME_ATOM_WELL_KNOWN_COUNT);
+  assert(name_intern("intern.test.idempotent") == atom);
+  assert(name_intern(NULL) == NAME_ATOM_NONE);
+
+  /* the atom keeps its own copy of the name */
+  name[0] = 'X';
+  assert(strcmp(name_atom_string(atom), "intern.test.idempotent") == 0);
+  assert(name_atom_find("intern.test.idempotent") == atom);
+  assert(name_intern(name) != atom);
+}
+
+void
+test_intern_find_does_not_add(void)
+{
+  LOG_CLEAN("== Testing name_atom_find never adds a name");
+
+  uint32_t count = name_atom_count();
+
+  assert(name_atom_find("intern.test.never-interned") == NAME_ATOM_NONE);
+  assert(name_atom_find(NULL) == NAME_ATOM_NONE);
+  assert(name_atom_count() == count);
+  assert(name_atom_string(count + 1) == NULL);
+}
+
+void
+test_intern_growth(void)
+{
+  LOG_CLEAN("== Testing name table growth");
+
+  enum { NAMES = 2000 };
+  static NameAtom atoms[NAMES];
+  char            name[48];
+
+  uint32_t count = name_atom_count();
+  for (int i = 0; i < NAMES; i++) {
+    snprintf(name, sizeof(name), "intern.test.grow.%d", i);
+    atoms[i] = name_intern(name);
+  }
+  assert(name_atom_count() == count + NAMES);
+
+  int found = 0;
+  for (int i = 0; i < NAMES; i++) {
+    snprintf(name, sizeof(name), "intern.test.grow.%d", i);
+    if (name_atom_find(name) == atoms[i] && strcmp(name_atom_string(atoms[i]), name) == 0)
+      found++;
+  }
+  assert(found == NAMES);
+
+  /* well-known atoms are unaffected by growth */
+  assert(name_atom_find("pertag") == NAME_ATOM_PERTAG);
+}
+
+static bool
+test_intern_action_cb(ActionInvocation* inv)
+{
+  (void) inv;
+  return true;
+}
+
+static bool
+test_intern_sm_action(StateMachine* sm, void* data)
+{
+  (void) sm;
+  (void) data;
+  return true;
+}
+
+void
+test_intern_registries_by_atom(void)
+{
+  LOG_CLEAN("== Testing registry lookups by atom");
+
+  hub_init();
+
+  /* target types */
+  assert(hub_get_target_type_id_by_atom(NAME_ATOM_CLIENT) == hub_get_target_type_id_by_name("client"));
+  assert(hub_get_target_type_id_by_atom(NAME_ATOM_MONITOR) == hub_get_target_type_id_by_name("monitor"));
+  assert(hub_get_target_type_by_atom(NAME_ATOM_CLIENT) == hub_get_target_type_by_name("client"));
+  assert(hub_get_target_type_by_atom(NAME_ATOM_CLIENT)->atom == NAME_ATOM_CLIENT);
+
+  /* components */
+  HubComponent component = {
+    .name = "intern.test.component",
+  };
+  hub_register_component(&component);
+  assert(component.atom == name_atom_find("intern.test.component"));
+  assert(hub_get_component_by_atom(component.atom) == &component);
+  hub_unregister_component("intern.test.component");
+  assert(hub_get_component_by_atom(component.atom) == NULL);
+
+  hub_shutdown();
+
+  /* actions */
+  action_registry_init();
+  Action action = {
+    .name     = "intern.test.action",
+    .callback = test_intern_action_cb,
+  };
+  assert(action_register(&action));
+  assert(action.atom == name_atom_find("intern.test.action"));
+  assert(action_lookup_atom(action.atom) == &action);
+  assert(action_invoke_atom(action.atom, NULL));
+  assert(action_unregister("intern.test.action"));
+  assert(action_lookup_atom(action.atom) == NULL);
+  assert(!action_invoke_atom(action.atom, NULL));
+  action_registry_shutdown();
+
+  /* SM guards and actions */
+  sm_registry_init();
+  sm_register_action("intern.test.sm-action", test_intern_sm_action);
+  NameAtom sm_action = name_atom_find("intern.test.sm-action");
+  assert(sm_action != NAME_ATOM_NONE);
+  assert(sm_lookup_action_atom(sm_action) == test_intern_sm_action);
+  assert(sm_lookup_action("intern.test.sm-action") == test_intern_sm_action);
+  sm_registry_shutdown();
+}
+
+static double
+elapsed_ns(struct timespec t0, struct timespec t1)
+{
+  return (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+}
+
+/*
+ * Lookup benchmark: by-name lookups hash the name, by-atom lookups are an
+ * array index. Hot paths keep atoms, so the latter is what they pay.
+ */
+void
+test_intern_lookup_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: registry lookups by name and by atom");
+  const int       rounds = 1000000;
+  struct timespec t0, t1;
+  uint64_t        total = 0;
+
+  hub_init();
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < rounds; i++)
+    total += hub_get_target_type_id_by_name((i & 1) ? "client" : "monitor");
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double by_name = elapsed_ns(t0, t1) / rounds;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < rounds; i++)
+    total += hub_get_target_type_id_by_atom((i & 1) ? NAME_ATOM_CLIENT : NAME_ATOM_MONITOR);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double by_atom = elapsed_ns(t0, t1) / rounds;
+
+  LOG_CLEAN("  target type id: %.1fns by name, %.1fns by atom", by_name, by_atom);
+  assert(total > 0);
+  assert(by_atom < by_name);
+
+  hub_shutdown();
+}
+
+TEST_GROUP(NameAtoms, {
+  test_intern_well_known_atoms();
+  test_intern_idempotent();
+  test_intern_find_does_not_add();
+  test_intern_growth();
+  test_intern_registries_by_atom();
+  test_intern_lookup_benchmark();
+});
@@ -0,0 +1,17 @@
+/*
+ * test-wm-intern.h - Header for name atom tests
+ */
+
+#ifndef TEST_WM_INTERN_H
+#define TEST_WM_INTERN_H
+
+#include "wm-intern.h"
+
+void test_intern_well_known_atoms(void);
+void test_intern_idempotent(void);
+void test_intern_find_does_not_add(void);
+void test_intern_growth(void);
+void test_intern_registries_by_atom(void);
+void test_intern_lookup_benchmark(void);
+
+#endif /* TEST_WM_INTERN_H */
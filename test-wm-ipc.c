@@ -0,0 +1,773 @@
+/*
+ * IPC Tests
+ *
+ * Tests for the IPC socket: framing, pipelining, queries answered from
+ * the state snapshot, action invocation by name and by id, and the
+ * batched event stream with its handling of slow subscribers.
+ * Requires: loop, hub, action registry, client, monitor, state snapshot
+ */
+
+#include "test-registry.h" /* Must be first - defines TEST_GROUP macro */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/actions/action-registry.h"
+#include "src/components/connection-sm.h"
+#include "src/components/focus.h"
+#include "src/components/fullscreen.h"
+#include "src/components/state-snapshot.h"
+#include "src/components/tag-manager.h"
+#include "src/components/tiling.h"
+#include "src/target/client.h"
+#include "src/target/monitor.h"
+#include "test-wm-ipc.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+#include "wm-ipc.h"
+#include "wm-loop.h"
+
+#define IPC_TEST_ACTION_FAIL 13
+
+static int      ipc_action_calls = 0;
+static TargetID ipc_action_target;
+static intptr_t ipc_action_arg;
+static uint64_t ipc_action_cid;
+
+static bool
+ipc_test_action(ActionInvocation* inv)
+{
+  ipc_action_calls++;
+  ipc_action_target = inv->target;
+  ipc_action_arg    = (intptr_t) inv->data;
+  ipc_action_cid    = inv->correlation_id;
+  return ipc_action_arg != IPC_TEST_ACTION_FAIL;
+}
+
+static Action ipc_action = {
+  .name        = "ipc.test",
+  .callback    = ipc_test_action,
+  .target_type = ACTION_TARGET_ANY,
+};
+
+static char ipc_test_path[64];
+
+static void
+ipc_test_setup(void)
+{
+  loop_init();
+  hub_init();
+  client_list_init();
+  monitor_list_init();
+  action_registry_init();
+  action_register(&ipc_action);
+  ipc_action_calls = 0;
+
+  snprintf(ipc_test_path, sizeof(ipc_test_path), "/tmp/wm-ipc-test-%d.sock", (int) getpid());
+  assert(ipc_init(ipc_test_path) == 0);
+}
+
+static void
+ipc_test_teardown(void)
+{
+  ipc_shutdown();
+  assert(access(ipc_test_path, F_OK) != 0);
+  snapshot_shutdown();
+  action_registry_shutdown();
+  client_list_shutdown();
+  monitor_list_shutdown();
+  hub_shutdown();
+  loop_shutdown();
+}
+
+/* Connect a client and let the loop accept it */
+static int
+ipc_connect(void)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", ipc_socket_path());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0)
+    return -1;
+
+  loop_iterate(100);
+  return fd;
+}
+
+/* Append one request frame to buf, returns the bytes added */
+static uint32_t
+frame(uint8_t* buf, uint16_t op, uint32_t seq, const void* payload, uint32_t len)
+{
+  IpcHeader header = { .length = len, .op = op, .status = 0, .seq = seq };
+  memcpy(buf, &header, sizeof(header));
+  if (len > 0)
+    memcpy(buf + sizeof(header), payload, len);
+  return sizeof(header) + len;
+}
+
+/* Run the loop until `want` response bytes arrived, returns the bytes read */
+static uint32_t
+receive(int fd, uint8_t* buf, uint32_t want)
+{
+  uint32_t got = 0;
+  for (int tries = 0; got < want && tries < 1000; tries++) {
+    loop_iterate(10);
+    ssize_t n;
+    while (got < want && (n = recv(fd, buf + got, want - got, MSG_DONTWAIT)) > 0)
+      got += n;
+  }
+  return got;
+}
+
+/* Send one request and read its response header and payload */
+static IpcHeader
+roundtrip(int fd, uint16_t op, uint32_t seq, const void* payload, uint32_t len, void* reply, uint32_t reply_len)
+{
+  uint8_t   buf[512];
+  IpcHeader header = { 0 };
+
+  uint32_t n = frame(buf, op, seq, payload, len);
+  if (write(fd, buf, n) != (ssize_t) n)
+    return header;
+
+  if (receive(fd, (uint8_t*) &header, sizeof(header)) == sizeof(header) && header.length > 0)
+    receive(fd, reply, header.length < reply_len ? header.length : reply_len);
+  return header;
+}
+
+void
+test_ipc_ping_and_framing(void)
+{
+  LOG_CLEAN("== Testing IPC ping, partial frames and unknown ops");
+  ipc_test_setup();
+
+  int fd = ipc_connect();
+  assert(fd >= 0);
+  assert(ipc_get_stats().connections == 1);
+
+  char      reply[16] = { 0 };
+  IpcHeader r         = roundtrip(fd, IPC_OP_PING, 7, "hello", 5, reply, sizeof(reply));
+  assert(r.op == IPC_OP_PING && r.seq == 7 && r.status == IPC_STATUS_OK);
+  assert(r.length == 5 && memcmp(reply, "hello", 5) == 0);
+
+  /* a frame split across writes is handled once complete */
+  uint8_t  buf[64];
+  uint32_t n = frame(buf, IPC_OP_PING, 8, "split", 5);
+  assert(write(fd, buf, 7) == 7);
+  loop_iterate(10);
+  assert(write(fd, buf + 7, n - 7) == (ssize_t) (n - 7));
+  assert(receive(fd, buf, sizeof(IpcHeader) + 5) == sizeof(IpcHeader) + 5);
+  memcpy(&r, buf, sizeof(r));
+  assert(r.seq == 8 && r.length == 5);
+
+  r = roundtrip(fd, 999, 9, NULL, 0, NULL, 0);
+  assert(r.seq == 9 && r.status == IPC_STATUS_UNKNOWN_OP && r.length == 0);
+
+  close(fd);
+  loop_iterate(10);
+  assert(ipc_get_stats().connections == 0);
+
+  ipc_test_teardown();
+}
+
+void
+test_ipc_oversized_frame_drops_client(void)
+{
+  LOG_CLEAN("== Testing an oversized IPC frame drops the client");
+  ipc_test_setup();
+
+  int fd = ipc_connect();
+  assert(fd >= 0);
+
+  IpcHeader header = { .length = IPC_MAX_PAYLOAD + 1, .op = IPC_OP_PING, .seq = 1 };
+  assert(write(fd, &header, sizeof(header)) == sizeof(header));
+  loop_iterate(10);
+
+  char c;
+  assert(recv(fd, &c, 1, 0) == 0); /* server hung up */
+  assert(ipc_get_stats().connections == 0);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+void
+test_ipc_socket_path_ownership(void)
+{
+  LOG_CLEAN("== Testing the IPC server only replaces stale sockets");
+  ipc_test_setup();
+
+  struct stat st;
+  assert(stat(ipc_test_path, &st) == 0);
+  assert(S_ISSOCK(st.st_mode) && (st.st_mode & 0777) == (S_IRUSR | S_IWUSR));
+
+  /* a live socket is not taken over */
+  int live = socket(AF_UNIX, SOCK_STREAM, 0);
+  assert(live >= 0);
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s.live", ipc_test_path);
+  assert(bind(live, (struct sockaddr*) &addr, sizeof(addr)) == 0 && listen(live, 1) == 0);
+  assert(ipc_init(addr.sun_path) == 0); /* already listening, a no-op */
+  ipc_shutdown();
+  assert(ipc_init(addr.sun_path) == -1);
+  assert(stat(addr.sun_path, &st) == 0 && S_ISSOCK(st.st_mode));
+
+  /* once nobody answers on it, the socket is stale and replaced */
+  close(live);
+  assert(ipc_init(addr.sun_path) == 0);
+  ipc_shutdown();
+  assert(access(addr.sun_path, F_OK) != 0);
+
+  /* anything else at the path is left alone */
+  FILE* f = fopen(addr.sun_path, "w");
+  assert(f != NULL);
+  fputs("keep", f);
+  fclose(f);
+  assert(ipc_init(addr.sun_path) == -1);
+  assert(stat(addr.sun_path, &st) == 0 && S_ISREG(st.st_mode) && st.st_size == 4);
+  unlink(addr.sun_path);
+
+  assert(ipc_init(ipc_test_path) == 0);
+  ipc_test_teardown();
+}
+
+void
+test_ipc_invoke_actions(void)
+{
+  LOG_CLEAN("== Testing IPC action lookup and invocation");
+  ipc_test_setup();
+
+  int fd = ipc_connect();
+  assert(fd >= 0);
+
+  uint32_t  id = 0;
+  IpcHeader r  = roundtrip(fd, IPC_OP_ACTION_LOOKUP, 1, "ipc.test", 8, &id, sizeof(id));
+  assert(r.status == IPC_STATUS_OK && r.length == sizeof(id));
+  assert(id == ipc_action.atom);
+
+  r = roundtrip(fd, IPC_OP_ACTION_LOOKUP, 2, "ipc.missing", 11, NULL, 0);
+  assert(r.status == IPC_STATUS_NOT_FOUND);
+
+  IpcInvoke args = { .action = id, .flags = IPC_INVOKE_HAS_ARG, .target = 42, .arg = 3 };
+  r              = roundtrip(fd, IPC_OP_ACTION_INVOKE, 3, &args, sizeof(args), NULL, 0);
+  assert(r.status == IPC_STATUS_OK);
+  assert(ipc_action_calls == 1);
+  assert(ipc_action_target == 42 && ipc_action_arg == 3 && ipc_action_cid == 3);
+
+  args.arg = IPC_TEST_ACTION_FAIL;
+  r        = roundtrip(fd, IPC_OP_ACTION_INVOKE, 4, &args, sizeof(args), NULL, 0);
+  assert(r.status == IPC_STATUS_FAILED);
+
+  /* by name: the invocation, then the name */
+  uint8_t payload[64];
+  args.arg = 5;
+  memcpy(payload, &args, sizeof(args));
+  memcpy(payload + sizeof(args), "ipc.test", 8);
+  r = roundtrip(fd, IPC_OP_ACTION_INVOKE_NAME, 5, payload, sizeof(args) + 8, NULL, 0);
+  assert(r.status == IPC_STATUS_OK);
+  assert(ipc_action_calls == 3 && ipc_action_arg == 5);
+
+  args.action = 0xFFFFFF;
+  r           = roundtrip(fd, IPC_OP_ACTION_INVOKE, 6, &args, sizeof(args), NULL, 0);
+  assert(r.status == IPC_STATUS_NOT_FOUND);
+  r = roundtrip(fd, IPC_OP_ACTION_INVOKE, 7, &args, 3, NULL, 0);
+  assert(r.status == IPC_STATUS_BAD_REQUEST);
+  assert(ipc_action_calls == 3);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+void
+test_ipc_pipelined_commands(void)
+{
+  LOG_CLEAN("== Testing pipelined IPC commands are answered in order");
+  ipc_test_setup();
+
+  int fd = ipc_connect();
+  assert(fd >= 0);
+
+  enum { COMMANDS = 200 };
+  static uint8_t out[COMMANDS * (sizeof(IpcHeader) + sizeof(IpcInvoke))];
+  static uint8_t in[COMMANDS * sizeof(IpcHeader)];
+
+  uint32_t len = 0;
+  for (uint32_t i = 0; i < COMMANDS; i++) {
+    IpcInvoke args = { .action = ipc_action.atom, .flags = IPC_INVOKE_HAS_ARG, .arg = 100 + i };
+    len += frame(out + len, IPC_OP_ACTION_INVOKE, 1000 + i, &args, sizeof(args));
+  }
+  assert(write(fd, out, len) == (ssize_t) len);
+
+  assert(receive(fd, in, sizeof(in)) == sizeof(in));
+  assert(ipc_action_calls == COMMANDS);
+
+  int in_order = 0;
+  for (uint32_t i = 0; i < COMMANDS; i++) {
+    IpcHeader r;
+    memcpy(&r, in + i * sizeof(IpcHeader), sizeof(r));
+    if (r.seq == 1000 + i && r.status == IPC_STATUS_OK && r.length == 0)
+      in_order++;
+  }
+  assert(in_order == COMMANDS);
+  assert(ipc_get_stats().requests == COMMANDS);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+/*
+ * A client that keeps reading a little behind: the server always has
+ * output the socket did not take, and its buffer must not grow with the
+ * total it ever sent.
+ */
+void
+test_ipc_reader_behind_output_bounded(void)
+{
+  LOG_CLEAN("== Testing output to a reader that stays behind stays bounded");
+  ipc_test_setup();
+
+  int fd = ipc_connect();
+  assert(fd >= 0);
+
+  enum { PAYLOAD = 4096, RESPONSE = sizeof(IpcHeader) + PAYLOAD, ROUNDS = 2000 };
+  static uint8_t request[sizeof(IpcHeader) + PAYLOAD];
+  static uint8_t response[RESPONSE];
+  uint32_t       len = frame(request, IPC_OP_PING, 0, response, PAYLOAD);
+
+  /* fill the socket until the server holds output back */
+  int fill = 0;
+  while (ipc_get_stats().output_pending == 0 && fill++ < 1000) {
+    if (write(fd, request, len) != (ssize_t) len)
+      break;
+    loop_iterate(0);
+  }
+  assert(ipc_get_stats().output_pending > 0);
+
+  /* then read a little less than one response per request sent */
+  int behind = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    if (write(fd, request, len) != (ssize_t) len)
+      break;
+    loop_iterate(0);
+
+    uint32_t got = 0;
+    ssize_t  n;
+    while (got < RESPONSE - 64 && (n = recv(fd, response + got, RESPONSE - 64 - got, MSG_DONTWAIT)) > 0)
+      got += n;
+    if (ipc_get_stats().output_pending > 0)
+      behind++;
+  }
+
+  IpcStats stats = ipc_get_stats();
+  LOG_CLEAN("  %d rounds behind, %llu bytes pending in a %llu byte buffer", behind,
+            (unsigned long long) stats.output_pending, (unsigned long long) stats.output_capacity);
+  assert(behind > ROUNDS / 2 && stats.output_pending > 0);
+  assert(stats.output_capacity <= 2 * stats.output_pending + IPC_MAX_PAYLOAD);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+void
+test_ipc_queries(void)
+{
+  LOG_CLEAN("== Testing IPC state queries");
+  ipc_test_setup();
+
+  int fd = ipc_connect();
+  assert(fd >= 0);
+
+  IpcHeader r = roundtrip(fd, IPC_OP_STATE, 1, NULL, 0, NULL, 0);
+  assert(r.status == IPC_STATUS_NO_STATE);
+
+  Monitor* m = monitor_create(10);
+  monitor_set_geometry(m, 0, 0, 1920, 1080);
+  Client* c = client_create(300);
+  client_set_title(c, strdup("term"));
+  client_set_monitor(c, m);
+  client_set_tags(c, 4);
+  (void) client_create(301);
+  snapshot_publish();
+
+  IpcState state;
+  r = roundtrip(fd, IPC_OP_STATE, 2, NULL, 0, &state, sizeof(state));
+  assert(r.status == IPC_STATUS_OK && r.length == sizeof(state));
+  assert(state.client_count == 2 && state.monitor_count == 1);
+  assert(state.selected_monitor == m->target.id);
+
+  IpcClient clients[2];
+  r = roundtrip(fd, IPC_OP_CLIENTS, 3, NULL, 0, clients, sizeof(clients));
+  assert(r.length == sizeof(clients));
+  assert(clients[0].window == 300 || clients[1].window == 300);
+
+  IpcMonitor monitor;
+  r = roundtrip(fd, IPC_OP_MONITORS, 4, NULL, 0, &monitor, sizeof(monitor));
+  assert(r.length == sizeof(monitor));
+  assert(monitor.id == m->target.id && monitor.width == 1920 && monitor.selected == 1);
+
+  uint8_t  reply[128];
+  uint64_t id = c->target.id;
+  r           = roundtrip(fd, IPC_OP_CLIENT, 5, &id, sizeof(id), reply, sizeof(reply));
+  assert(r.status == IPC_STATUS_OK);
+  IpcClient client;
+  memcpy(&client, reply, sizeof(client));
+  assert(client.window == 300 && client.tags == 4 && client.monitor == m->target.id);
+  assert(strcmp((char*) reply + sizeof(client), "term") == 0);
+  assert(r.length == sizeof(client) + 5 + 1); /* "term\0" and an empty class */
+
+  id = 12345;
+  r  = roundtrip(fd, IPC_OP_CLIENT, 6, &id, sizeof(id), NULL, 0);
+  assert(r.status == IPC_STATUS_NOT_FOUND);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+/*
+ * Event stream
+ */
+#define IPC_TEST_EVT_A    50
+#define IPC_TEST_EVT_B    51
+#define IPC_TEST_EVT_C    52
+#define IPC_TEST_EVT_MASK ((UINT64_C(1) << IPC_TEST_EVT_A) | (UINT64_C(1) << IPC_TEST_EVT_B))
+
+static int
+ipc_subscriber(uint64_t mask)
+{
+  int fd = ipc_connect();
+  if (fd < 0)
+    return -1;
+
+  IpcHeader r = roundtrip(fd, IPC_OP_SUBSCRIBE, 1, &mask, sizeof(mask), NULL, 0);
+  return r.status == IPC_STATUS_OK ? fd : -1;
+}
+
+/* Run the loop and read until the server has sent nothing for a while */
+static uint32_t
+drain(int fd, uint8_t* buf, uint32_t cap)
+{
+  uint32_t got  = 0;
+  int      idle = 0;
+  while (idle < 5 && got < cap) {
+    loop_iterate(10);
+    ssize_t n = recv(fd, buf + got, cap - got, MSG_DONTWAIT);
+    if (n > 0) {
+      got += n;
+      idle = 0;
+    } else {
+      idle++;
+    }
+  }
+  return got;
+}
+
+void
+test_ipc_event_stream_batches(void)
+{
+  LOG_CLEAN("== Testing IPC event batches coalesce per type and target");
+  ipc_test_setup();
+
+  int fd = ipc_subscriber(IPC_TEST_EVT_MASK);
+  assert(fd >= 0);
+
+  hub_emit(IPC_TEST_EVT_A, 1, NULL);
+  hub_emit(IPC_TEST_EVT_B, 1, NULL);
+  hub_emit(IPC_TEST_EVT_A, 1, NULL);
+  hub_emit(IPC_TEST_EVT_C, 1, NULL); /* not subscribed */
+  hub_emit(IPC_TEST_EVT_A, 2, NULL);
+  hub_emit(IPC_TEST_EVT_A, 1, NULL);
+
+  uint8_t  buf[256];
+  uint32_t want = sizeof(IpcHeader) + sizeof(IpcEventBatch) + 3 * sizeof(IpcEvent);
+  assert(drain(fd, buf, sizeof(buf)) == want);
+
+  IpcHeader     header;
+  IpcEventBatch batch;
+  IpcEvent      events[3];
+  memcpy(&header, buf, sizeof(header));
+  memcpy(&batch, buf + sizeof(header), sizeof(batch));
+  memcpy(events, buf + sizeof(header) + sizeof(batch), sizeof(events));
+
+  assert(header.op == IPC_OP_EVENTS && header.seq == 0);
+  assert(header.length == want - sizeof(IpcHeader));
+  assert(batch.count == 3 && batch.flags == 0);
+  assert(events[0].type == IPC_TEST_EVT_A && events[0].target == 1 && events[0].count == 3);
+  assert(events[1].type == IPC_TEST_EVT_B && events[1].target == 1 && events[1].count == 1);
+  assert(events[2].type == IPC_TEST_EVT_A && events[2].target == 2 && events[2].count == 1);
+  assert(ipc_get_stats().events == 5);
+  assert(ipc_get_stats().events_coalesced == 2);
+
+  /* one batch per iteration, numbered */
+  hub_emit(IPC_TEST_EVT_B, 7, NULL);
+  assert(drain(fd, buf, sizeof(buf)) == sizeof(IpcHeader) + sizeof(IpcEventBatch) + sizeof(IpcEvent));
+  memcpy(&header, buf, sizeof(header));
+  assert(header.seq == 1);
+  assert(ipc_get_stats().event_batches == 2);
+
+  /* an empty mask stops the stream and the hub subscription */
+  uint64_t none = 0;
+  IpcHeader r   = roundtrip(fd, IPC_OP_SUBSCRIBE, 2, &none, sizeof(none), NULL, 0);
+  assert(r.status == IPC_STATUS_OK);
+  hub_emit(IPC_TEST_EVT_A, 1, NULL);
+  assert(drain(fd, buf, sizeof(buf)) == 0);
+  assert(ipc_get_stats().events == 6);
+
+  r = roundtrip(fd, IPC_OP_SUBSCRIBE, 3, &none, 4, NULL, 0);
+  assert(r.status == IPC_STATUS_BAD_REQUEST);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+void
+test_ipc_event_stream_component_types(void)
+{
+  LOG_CLEAN("== Testing component event types are distinct on the wire");
+
+  EventType types[] = {
+    EVT_TAG_CHANGED,          EVT_FULLSCREEN_ENTERED,  EVT_FULLSCREEN_EXITED, EVT_FULLSCREEN_FAILED,
+    EVT_CLIENT_UNFOCUSED,     EVT_CLIENT_FOCUSED,      EVT_MONITOR_CONNECTED, EVT_MONITOR_DISCONNECTED,
+    EVT_LAYOUT_CHANGED,       EVT_REQUEST_COMPLETED,   EVT_REQUEST_FAILED,
+  };
+  uint64_t seen = 0;
+  for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+    assert(types[i] < IPC_MAX_EVENT_TYPES);
+    assert((seen & (UINT64_C(1) << types[i])) == 0);
+    seen |= UINT64_C(1) << types[i];
+  }
+
+  ipc_test_setup();
+
+  int fd = ipc_subscriber(UINT64_C(1) << EVT_TAG_CHANGED);
+  assert(fd >= 0);
+
+  hub_emit(EVT_FULLSCREEN_ENTERED, 1, NULL);
+  hub_emit(EVT_MONITOR_CONNECTED, 1, NULL);
+  hub_emit(EVT_TAG_CHANGED, 2, NULL);
+
+  uint8_t  buf[256];
+  uint32_t want = sizeof(IpcHeader) + sizeof(IpcEventBatch) + sizeof(IpcEvent);
+  assert(drain(fd, buf, sizeof(buf)) == want);
+
+  IpcEvent event;
+  memcpy(&event, buf + sizeof(IpcHeader) + sizeof(IpcEventBatch), sizeof(event));
+  assert(event.type == EVT_TAG_CHANGED && event.target == 2 && event.count == 1);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+void
+test_ipc_event_stream_closing_unsubscribes(void)
+{
+  LOG_CLEAN("== Testing closed subscribers no longer receive hub events");
+  ipc_test_setup();
+
+  int a = ipc_subscriber(UINT64_C(1) << IPC_TEST_EVT_A);
+  int b = ipc_subscriber(IPC_TEST_EVT_MASK);
+  assert(a >= 0 && b >= 0);
+
+  hub_emit(IPC_TEST_EVT_B, 1, NULL);
+  uint8_t buf[256];
+  assert(drain(a, buf, sizeof(buf)) == 0); /* not its type */
+  assert(drain(b, buf, sizeof(buf)) > 0);
+
+  close(b);
+  loop_iterate(10);
+  hub_emit(IPC_TEST_EVT_B, 1, NULL);
+  hub_emit(IPC_TEST_EVT_A, 1, NULL);
+  assert(drain(a, buf, sizeof(buf)) == sizeof(IpcHeader) + sizeof(IpcEventBatch) + sizeof(IpcEvent));
+  assert(ipc_get_stats().events == 2); /* B no longer collected */
+
+  close(a);
+  ipc_test_teardown();
+}
+
+/* Emit a full iteration's worth of distinct pairs, then run it */
+static void
+emit_tick(uint32_t tick)
+{
+  for (uint32_t target = 0; target < IPC_MAX_PENDING_EVENTS; target++)
+    hub_emit(IPC_TEST_EVT_A, tick * IPC_MAX_PENDING_EVENTS + target, NULL);
+  loop_iterate(0);
+}
+
+void
+test_ipc_event_stream_slow_subscriber(void)
+{
+  LOG_CLEAN("== Testing a slow subscriber is resynced, then dropped");
+  ipc_test_setup();
+
+  int fd = ipc_subscriber(UINT64_C(1) << IPC_TEST_EVT_A);
+  assert(fd >= 0);
+
+  /* overflowing one iteration resyncs instead of sending a partial batch */
+  for (uint32_t target = 0; target <= IPC_MAX_PENDING_EVENTS; target++)
+    hub_emit(IPC_TEST_EVT_A, target, NULL);
+
+  static uint8_t buf[2 * 1024 * 1024];
+  uint32_t       len = drain(fd, buf, sizeof(buf));
+  assert(len == sizeof(IpcHeader) + sizeof(IpcEventBatch) + sizeof(IpcState));
+  IpcEventBatch batch;
+  memcpy(&batch, buf + sizeof(IpcHeader), sizeof(batch));
+  assert(batch.flags == IPC_EVENTS_RESYNC && batch.count == 0);
+
+  /* stop reading until an iteration's batch is skipped, the loop never blocks */
+  uint32_t ticks = 0;
+  uint64_t before;
+  do {
+    before = ipc_get_stats().event_batches;
+    emit_tick(ticks++);
+  } while (ipc_get_stats().event_batches > before && ticks < 1000);
+  uint64_t sent = ipc_get_stats().event_batches;
+  assert(ticks < 1000);
+  assert(ipc_get_stats().connections == 1);
+
+  /* once read, the missed batches are replaced by a single resync */
+  len = drain(fd, buf, sizeof(buf));
+  assert(ipc_get_stats().event_batches == sent + 1);
+  assert(ipc_get_stats().resyncs == 2);
+
+  uint32_t pos      = 0;
+  uint32_t frames   = 0;
+  uint32_t in_order = 0;
+  uint32_t resyncs  = 0;
+  while (pos + sizeof(IpcHeader) <= len) {
+    IpcHeader header;
+    memcpy(&header, buf + pos, sizeof(header));
+    memcpy(&batch, buf + pos + sizeof(header), sizeof(batch));
+    if (header.seq == frames + 1)
+      in_order++;
+    if (batch.flags & IPC_EVENTS_RESYNC)
+      resyncs++;
+    frames++;
+    pos += sizeof(header) + header.length;
+  }
+  assert(pos == len);
+  assert(frames == sent && in_order == frames);
+  assert(resyncs == 1 && (batch.flags & IPC_EVENTS_RESYNC)); /* the last frame */
+
+  /* a subscriber that stays behind is dropped */
+  for (uint32_t i = 0; i < 2000 && ipc_get_stats().connections > 0; i++)
+    emit_tick(ticks++);
+  assert(ipc_get_stats().connections == 0);
+  assert(ipc_get_stats().dropped_lagging == 1);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+static double
+elapsed_ns(struct timespec t0, struct timespec t1)
+{
+  return (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+}
+
+/*
+ * Event stream benchmark: hub events collected, coalesced and pushed to
+ * four subscribers, measured per emitted event.
+ */
+void
+test_ipc_event_stream_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: IPC event stream");
+  ipc_test_setup();
+
+  enum { SUBSCRIBERS = 4, TICKS = 1000, EVENTS = 1000, TARGETS = 32 };
+  int fds[SUBSCRIBERS];
+  for (int i = 0; i < SUBSCRIBERS; i++) {
+    fds[i] = ipc_subscriber(IPC_TEST_EVT_MASK);
+    assert(fds[i] >= 0);
+  }
+
+  static uint8_t  buf[64 * 1024];
+  struct timespec t0, t1;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int tick = 0; tick < TICKS; tick++) {
+    for (int e = 0; e < EVENTS; e++)
+      hub_emit(e & 1 ? IPC_TEST_EVT_A : IPC_TEST_EVT_B, e % TARGETS, NULL);
+    loop_iterate(0);
+    for (int i = 0; i < SUBSCRIBERS; i++)
+      while (recv(fds[i], buf, sizeof(buf), MSG_DONTWAIT) > 0)
+        ;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  LOG_CLEAN("  %d events to %d subscribers: %.1fns per event", TICKS * EVENTS, SUBSCRIBERS,
+            elapsed_ns(t0, t1) / (TICKS * EVENTS));
+  assert(ipc_get_stats().event_batches == (uint64_t) SUBSCRIBERS * TICKS);
+  assert(ipc_get_stats().events_coalesced == (uint64_t) TICKS * (EVENTS - TARGETS));
+  assert(ipc_get_stats().resyncs == 0);
+
+  for (int i = 0; i < SUBSCRIBERS; i++)
+    close(fds[i]);
+  ipc_test_teardown();
+}
+
+/*
+ * Round-trip benchmark: pipelined pings and action invocations, written
+ * in batches and read back through the loop.
+ */
+void
+test_ipc_pipeline_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: pipelined IPC commands");
+  ipc_test_setup();
+
+  int fd = ipc_connect();
+  assert(fd >= 0);
+
+  enum { BATCH = 500, BATCHES = 40 };
+  static uint8_t out[BATCH * (sizeof(IpcHeader) + sizeof(IpcInvoke))];
+  static uint8_t in[BATCH * sizeof(IpcHeader)];
+  struct timespec t0, t1;
+
+  uint32_t len = 0;
+  for (uint32_t i = 0; i < BATCH; i++) {
+    IpcInvoke args = { .action = ipc_action.atom };
+    len += frame(out + len, IPC_OP_ACTION_INVOKE, i, &args, sizeof(args));
+  }
+
+  uint32_t received = 0;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int b = 0; b < BATCHES; b++) {
+    if (write(fd, out, len) != (ssize_t) len)
+      break;
+    received += receive(fd, in, sizeof(in));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double per_command = elapsed_ns(t0, t1) / (BATCH * BATCHES);
+  LOG_CLEAN("  %d invocations: %.0fns per command", BATCH * BATCHES, per_command);
+  assert(received == sizeof(in) * BATCHES);
+  assert(ipc_action_calls == BATCH * BATCHES);
+
+  close(fd);
+  ipc_test_teardown();
+}
+
+TEST_GROUP(IpcServer, {
+  test_ipc_ping_and_framing();
+  test_ipc_oversized_frame_drops_client();
+  test_ipc_socket_path_ownership();
+  test_ipc_invoke_actions();
+  test_ipc_pipelined_commands();
+  test_ipc_reader_behind_output_bounded();
+  test_ipc_queries();
+  test_ipc_pipeline_benchmark();
+  test_ipc_event_stream_batches();
+  test_ipc_event_stream_component_types();
+  test_ipc_event_stream_closing_unsubscribes();
+  test_ipc_event_stream_slow_subscriber();
+  test_ipc_event_stream_benchmark();
+});
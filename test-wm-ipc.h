@@ -0,0 +1,24 @@
+/*
+ * test-wm-ipc.h - Header for IPC socket tests
+ */
+
+#ifndef TEST_WM_IPC_H
+#define TEST_WM_IPC_H
+
+#include "wm-ipc.h"
+
+void test_ipc_ping_and_framing(void);
+void test_ipc_oversized_frame_drops_client(void);
+void test_ipc_socket_path_ownership(void);
+void test_ipc_invoke_actions(void);
+void test_ipc_pipelined_commands(void);
+void test_ipc_reader_behind_output_bounded(void);
+void test_ipc_queries(void);
+void test_ipc_pipeline_benchmark(void);
+void test_ipc_event_stream_batches(void);
+void test_ipc_event_stream_component_types(void);
+void test_ipc_event_stream_closing_unsubscribes(void);
+void test_ipc_event_stream_slow_subscriber(void);
+void test_ipc_event_stream_benchmark(void);
+
+#endif /* TEST_WM_IPC_H */
@@ -0,0 +1,345 @@
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "test-registry.h"
+#include "test-wm-loop.h"
+#include "test-wm.h"
+#include "wm-loop.h"
+
+/* Track callback invocations */
+static int      fd_call_count    = 0;
+static uint32_t last_fd_events   = 0;
+static int      timer_call_count = 0;
+static int      prepare_count    = 0;
+
+static void
+count_fd(int fd, uint32_t events, void* userdata)
+{
+  char buf[16];
+  (void) read(fd, buf, sizeof(buf));
+  fd_call_count++;
+  last_fd_events = events;
+}
+
+static void
+remove_self(int fd, uint32_t events, void* userdata)
+{
+  char buf[16];
+  (void) read(fd, buf, sizeof(buf));
+  fd_call_count++;
+  loop_remove_fd(fd);
+}
+
+static void
+remove_other(int fd, uint32_t events, void* userdata)
+{
+  char buf[16];
+  (void) read(fd, buf, sizeof(buf));
+  fd_call_count++;
+  loop_remove_fd(*(int*) userdata);
+}
+
+static void
+count_timer(uint64_t expirations, void* userdata)
+{
+  timer_call_count += (int) expirations;
+}
+
+static void
+set_flag_timer(uint64_t expirations, void* userdata)
+{
+  *(bool*) userdata = true;
+}
+
+static void
+count_prepare(void* userdata)
+{
+  prepare_count++;
+}
+
+static void
+reset_counters(void)
+{
+  fd_call_count    = 0;
+  last_fd_events   = 0;
+  timer_call_count = 0;
+  prepare_count    = 0;
+}
+
+static double
+cpu_seconds(void)
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return (double) ru.ru_utime.tv_sec + (double) ru.ru_utime.tv_usec / 1e6 + (double) ru.ru_stime.tv_sec + (double) ru.ru_stime.tv_usec / 1e6;
+}
+
+static double
+wall_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+void
+test_loop_init_shutdown(void)
+{
+  LOG_CLEAN("== Testing loop init and shutdown");
+
+  assert(loop_init() == 0);
+  assert(loop_source_count() == 0);
+  /* init is idempotent */
+  assert(loop_init() == 0);
+  loop_shutdown();
+
+  /* operations after shutdown fail cleanly */
+  assert(loop_add_fd(0, EPOLLIN, count_fd, NULL) == -1);
+  assert(loop_iterate(0) == -1);
+}
+
+void
+test_loop_fd_dispatch(void)
+{
+  LOG_CLEAN("== Testing loop fd dispatch");
+  int p[2];
+
+  reset_counters();
+  loop_init();
+  assert_or_abort(pipe(p) == 0);
+
+  assert(loop_add_fd(p[0], EPOLLIN, count_fd, NULL) == 0);
+  assert(loop_source_count() == 1);
+
+  /* nothing readable: times out without dispatching */
+  assert(loop_iterate(0) == 0);
+  assert(fd_call_count == 0);
+
+  assert(write(p[1], "x", 1) == 1);
+  assert(loop_iterate(100) == 1);
+  assert(fd_call_count == 1);
+  assert((last_fd_events & EPOLLIN) != 0);
+
+  loop_shutdown();
+  close(p[0]);
+  close(p[1]);
+}
+
+void
+test_loop_remove_fd(void)
+{
+  LOG_CLEAN("== Testing loop remove fd");
+  int p[2];
+
+  reset_counters();
+  loop_init();
+  assert_or_abort(pipe(p) == 0);
+
+  loop_add_fd(p[0], EPOLLIN, count_fd, NULL);
+  assert(loop_remove_fd(p[0]) == 0);
+  assert(loop_source_count() == 0);
+  assert(loop_remove_fd(p[0]) == -1);
+
+  assert(write(p[1], "x", 1) == 1);
+  loop_iterate(0);
+  assert(fd_call_count == 0);
+
+  loop_shutdown();
+  close(p[0]);
+  close(p[1]);
+}
+
+void
+test_loop_remove_fd_from_callback(void)
+{
+  LOG_CLEAN("== Testing loop remove fd from a callback in the same batch");
+  int a[2], b[2];
+
+  reset_counters();
+  loop_init();
+  assert_or_abort(pipe(a) == 0);
+  assert_or_abort(pipe(b) == 0);
+
+  /* whichever fires first removes the other, so only one callback runs */
+  loop_add_fd(a[0], EPOLLIN, remove_other, &b[0]);
+  loop_add_fd(b[0], EPOLLIN, remove_other, &a[0]);
+  assert(write(a[1], "x", 1) == 1);
+  assert(write(b[1], "x", 1) == 1);
+
+  loop_iterate(100);
+  assert(fd_call_count == 1);
+  assert(loop_source_count() == 1);
+
+  /* a callback removing its own fd */
+  loop_shutdown();
+  reset_counters();
+  loop_init();
+  loop_add_fd(a[0], EPOLLIN, remove_self, NULL);
+  assert(write(a[1], "x", 1) == 1);
+  loop_iterate(100);
+  assert(fd_call_count == 1);
+  assert(loop_source_count() == 0);
+
+  loop_shutdown();
+  close(a[0]);
+  close(a[1]);
+  close(b[0]);
+  close(b[1]);
+}
+
+void
+test_loop_duplicate_fd_fails(void)
+{
+  LOG_CLEAN("== Testing loop rejects duplicate fd");
+  int p[2];
+
+  loop_init();
+  assert_or_abort(pipe(p) == 0);
+
+  assert(loop_add_fd(p[0], EPOLLIN, count_fd, NULL) == 0);
+  assert(loop_add_fd(p[0], EPOLLIN, count_fd, NULL) == -1);
+  assert(loop_add_fd(p[0], EPOLLIN, NULL, NULL) == -1);
+  assert(loop_source_count() == 1);
+
+  loop_shutdown();
+  close(p[0]);
+  close(p[1]);
+}
+
+void
+test_loop_oneshot_timer(void)
+{
+  LOG_CLEAN("== Testing loop one-shot timer");
+
+  reset_counters();
+  loop_init();
+
+  LoopTimer t = loop_add_timer(5, 0, count_timer, NULL);
+  assert(t >= 0);
+  assert(loop_source_count() == 1);
+
+  assert(loop_iterate(200) == 1);
+  assert(timer_call_count == 1);
+
+  /* disarmed afterwards */
+  assert(loop_iterate(20) == 0);
+  assert(timer_call_count == 1);
+
+  /* rearm reuses the same handle */
+  assert(loop_rearm_timer(t, 5, 0) == 0);
+  loop_iterate(200);
+  assert(timer_call_count == 2);
+
+  loop_shutdown();
+}
+
+void
+test_loop_periodic_timer(void)
+{
+  LOG_CLEAN("== Testing loop periodic timer");
+
+  reset_counters();
+  loop_init();
+
+  assert(loop_add_timer(2, 2, count_timer, NULL) >= 0);
+  while (timer_call_count < 3)
+    assert_or_abort(loop_iterate(200) >= 0);
+  assert(timer_call_count >= 3);
+
+  LoopStats stats = loop_get_stats();
+  assert(stats.timer_runs >= 1);
+  assert(stats.timer_runs <= (uint64_t) timer_call_count);
+
+  loop_shutdown();
+}
+
+void
+test_loop_cancel_timer(void)
+{
+  LOG_CLEAN("== Testing loop cancel timer");
+
+  reset_counters();
+  loop_init();
+
+  LoopTimer t = loop_add_timer(5, 0, count_timer, NULL);
+  assert(loop_cancel_timer(t) == 0);
+  assert(loop_source_count() == 0);
+  assert(loop_cancel_timer(t) == -1);
+
+  loop_iterate(20);
+  assert(timer_call_count == 0);
+
+  loop_shutdown();
+}
+
+void
+test_loop_prepare_hook(void)
+{
+  LOG_CLEAN("== Testing loop prepare hook");
+
+  reset_counters();
+  loop_init();
+
+  assert(loop_add_prepare_hook(count_prepare, NULL) == 0);
+  loop_iterate(0);
+  loop_iterate(0);
+  assert(prepare_count == 2);
+
+  loop_remove_prepare_hook(count_prepare);
+  loop_iterate(0);
+  assert(prepare_count == 2);
+
+  loop_shutdown();
+}
+
+/*
+ * Idle benchmark: one quiet fd and a single timer 250ms out.
+ * A blocking loop must wake up exactly once (for the timer) and burn
+ * next to no CPU; the old poll loop spun at 100% for the whole period.
+ */
+void
+test_loop_idle_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: idle loop wakeups and CPU time");
+  int  p[2];
+  bool done = false;
+
+  loop_init();
+  assert_or_abort(pipe(p) == 0);
+  loop_add_fd(p[0], EPOLLIN, count_fd, NULL);
+  loop_add_timer(250, 0, set_flag_timer, &done);
+  loop_reset_stats();
+
+  double wall_start = wall_seconds();
+  double cpu_start  = cpu_seconds();
+  while (!done)
+    assert_or_abort(loop_iterate(-1) >= 0);
+  double wall = wall_seconds() - wall_start;
+  double cpu  = cpu_seconds() - cpu_start;
+
+  LoopStats stats = loop_get_stats();
+  LOG_CLEAN("  idle %.3fs: %llu wakeups (%.1f/s), cpu %.3fms",
+            wall, (unsigned long long) stats.wakeups,
+            (double) stats.wakeups / wall, cpu * 1000.0);
+
+  assert(stats.wakeups == 1);
+  assert(cpu < wall / 10);
+
+  loop_shutdown();
+  close(p[0]);
+  close(p[1]);
+}
+
+TEST_GROUP(EventLoop, {
+  test_loop_init_shutdown();
+  test_loop_fd_dispatch();
+  test_loop_remove_fd();
+  test_loop_remove_fd_from_callback();
+  test_loop_duplicate_fd_fails();
+  test_loop_oneshot_timer();
+  test_loop_periodic_timer();
+  test_loop_cancel_timer();
+  test_loop_prepare_hook();
+  test_loop_idle_benchmark();
+});
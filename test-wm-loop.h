@@ -0,0 +1,21 @@
+/*
+ * test-wm-loop.h - Header for main event loop tests
+ */
+
+#ifndef TEST_WM_LOOP_H
+#define TEST_WM_LOOP_H
+
+#include "wm-loop.h"
+
+void test_loop_init_shutdown(void);
+void test_loop_fd_dispatch(void);
+void test_loop_remove_fd(void);
+void test_loop_remove_fd_from_callback(void);
+void test_loop_duplicate_fd_fails(void);
+void test_loop_oneshot_timer(void);
+void test_loop_periodic_timer(void);
+void test_loop_cancel_timer(void);
+void test_loop_prepare_hook(void);
+void test_loop_idle_benchmark(void);
+
+#endif /* TEST_WM_LOOP_H */
@@ -14,8 +14,11 @@
 #include "src/components/monitor-manager.h"
 #include "src/target/monitor.h"
 #include "src/xcb/xcb-handler.h"
+#include "src/xcb/xcb-reply.h"
 #include "test-wm.h"
+#include "test-xcb-fake.h"
 #include "wm-hub.h"
+#include "wm-xcb.h"
 
 void
 test_monitor_manager_component_init_shutdown(void)
@@ -58,7 +61,7 @@ test_monitor_manager_handler_registration(void)
   monitor_manager_init();
 
   /* Verify RandR handler is registered */
-  XCBHandler* handlers = xcb_handler_lookup(XCB_RANDR_NOTIFY);
+  XCBHandler* handlers = xcb_handler_lookup_ext(XCB_EXT_RANDR, XCB_RANDR_NOTIFY);
   if (handlers == NULL) {
     abort();
   }
@@ -238,6 +241,356 @@ test_monitor_manager_with_monitors(void)
   hub_shutdown();
 }
 
+/* Fake RandR notify events as the server sends them */
+static void
+send_crtc_change(xcb_randr_crtc_t crtc, xcb_randr_mode_t mode, int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+  xcb_randr_notify_event_t ev = { 0 };
+  ev.response_type            = XCB_RANDR_NOTIFY;
+  ev.subCode                  = XCB_RANDR_NOTIFY_CRTC_CHANGE;
+  ev.u.cc.crtc                = crtc;
+  ev.u.cc.mode                = mode;
+  ev.u.cc.x                   = x;
+  ev.u.cc.y                   = y;
+  ev.u.cc.width               = w;
+  ev.u.cc.height              = h;
+  monitor_manager_handle_randr_notify(&ev);
+}
+
+static void
+send_output_change(xcb_randr_output_t output, xcb_randr_crtc_t crtc, uint8_t connection)
+{
+  xcb_randr_notify_event_t ev = { 0 };
+  ev.response_type            = XCB_RANDR_NOTIFY;
+  ev.subCode                  = XCB_RANDR_NOTIFY_OUTPUT_CHANGE;
+  ev.u.oc.output              = output;
+  ev.u.oc.crtc                = crtc;
+  ev.u.oc.connection          = connection;
+  monitor_manager_handle_randr_notify(&ev);
+}
+
+/*
+ * No X connection here: any geometry that shows up must have come from
+ * the CRTC index, not from a request.
+ */
+void
+test_monitor_manager_crtc_index_from_notify(void)
+{
+  LOG_CLEAN("== Testing monitor manager CRTC index from RandR notify");
+
+  hub_init();
+  xcb_handler_init();
+  monitor_list_init();
+  monitor_manager_init();
+
+  /* the server reports the CRTC first, then the output on it */
+  send_crtc_change(50, 1, 0, 0, 1920, 1080);
+  send_output_change(100, 50, XCB_RANDR_CONNECTION_CONNECTED);
+
+  Monitor* m = monitor_get_by_output(100);
+  assert_or_abort(m != NULL);
+  assert(m->crtc == 50);
+  assert(m->x == 0 && m->y == 0);
+  assert(m->width == 1920 && m->height == 1080);
+  assert(hub_pending_relayout_count() == 1);
+
+  /* mode switch: geometry follows the event alone */
+  send_crtc_change(50, 2, 0, 0, 2560, 1440);
+  assert(m->width == 2560 && m->height == 1440);
+
+  /* a disabled CRTC leaves the last geometry in place */
+  send_crtc_change(50, XCB_NONE, 0, 0, 0, 0);
+  assert(m->width == 2560 && m->height == 1440);
+
+  /* other CRTCs do not touch this monitor */
+  send_crtc_change(51, 1, 2560, 0, 1280, 1024);
+  assert(m->x == 0);
+
+  send_output_change(100, XCB_NONE, XCB_RANDR_CONNECTION_DISCONNECTED);
+  assert(monitor_get_by_output(100) == NULL);
+
+  hub_run_scheduled_relayouts();
+  monitor_manager_shutdown();
+  xcb_handler_shutdown();
+  monitor_list_shutdown();
+  hub_shutdown();
+}
+
+void
+test_monitor_manager_dock_three_outputs(void)
+{
+  LOG_CLEAN("== Testing monitor manager docking three outputs");
+
+  hub_init();
+  xcb_handler_init();
+  monitor_list_init();
+  monitor_manager_init();
+
+  for (uint16_t i = 0; i < 3; i++)
+    send_crtc_change(60 + i, 1, (int16_t) (i * 1920), 0, 1920, 1080);
+  for (uint16_t i = 0; i < 3; i++)
+    send_output_change(200 + i, 60 + i, XCB_RANDR_CONNECTION_CONNECTED);
+
+  for (uint16_t i = 0; i < 3; i++) {
+    Monitor* m = monitor_get_by_output(200 + i);
+    assert_or_abort(m != NULL);
+    assert(m->crtc == (xcb_randr_crtc_t) (60 + i));
+    assert(m->x == (int16_t) (i * 1920));
+    assert(m->width == 1920);
+  }
+
+  /* an output moving to another CRTC picks up that CRTC's geometry */
+  send_output_change(202, 60, XCB_RANDR_CONNECTION_CONNECTED);
+  Monitor* moved = monitor_get_by_output(202);
+  assert_or_abort(moved != NULL);
+  assert(moved->crtc == 60);
+  assert(moved->x == 0);
+
+  hub_run_scheduled_relayouts();
+  monitor_manager_shutdown();
+  xcb_handler_shutdown();
+  monitor_list_shutdown();
+  hub_shutdown();
+}
+
+/*
+ * Discovery against the fake X server. Its requests are read back from
+ * the wire; their replies are built here and handed to the continuations.
+ * Requests are numbered in the order they were sent, so a no-op sent
+ * just before tells the sequence of the ones that follow.
+ */
+#define RANDR_REQUESTS() fake_xcb_count_requests(dpy, FAKE_XCB_RANDR_OPCODE, -1)
+
+static unsigned int
+last_sequence(void)
+{
+  return xcb_no_operation(dpy).sequence;
+}
+
+static void
+discovery_setup(void)
+{
+  hub_init();
+  xcb_handler_init();
+  monitor_list_init();
+
+  dpy = fake_xcb_connect(true);
+  assert_or_abort(dpy != NULL);
+  root = 1;
+}
+
+static void
+discovery_teardown(void)
+{
+  hub_run_scheduled_relayouts();
+  monitor_manager_shutdown();
+  xcb_reply_clear(dpy);
+  fake_xcb_disconnect(dpy);
+  dpy  = NULL;
+  root = XCB_NONE;
+  xcb_handler_shutdown();
+  monitor_list_shutdown();
+  hub_shutdown();
+}
+
+static void
+reply_version(unsigned int seq, uint32_t major, uint32_t minor)
+{
+  xcb_randr_query_version_reply_t* r = calloc(1, sizeof(*r));
+  assert_or_abort(r != NULL);
+  r->response_type = XCB_RANDR_QUERY_VERSION;
+  r->major_version = major;
+  r->minor_version = minor;
+  assert(xcb_reply_complete(seq, r, NULL));
+}
+
+static void
+reply_resources(unsigned int seq, const xcb_randr_output_t* outputs, uint16_t output_count,
+                const xcb_randr_crtc_t* crtcs, uint16_t crtc_count)
+{
+  xcb_randr_get_screen_resources_current_reply_t* r =
+      calloc(1, sizeof(*r) + sizeof(uint32_t) * (output_count + crtc_count));
+  assert_or_abort(r != NULL);
+  r->num_crtcs   = crtc_count;
+  r->num_outputs = output_count;
+  memcpy(xcb_randr_get_screen_resources_current_crtcs(r), crtcs, sizeof(*crtcs) * crtc_count);
+  memcpy(xcb_randr_get_screen_resources_current_outputs(r), outputs, sizeof(*outputs) * output_count);
+  assert(xcb_reply_complete(seq, r, NULL));
+}
+
+/* A monitor list with one monitor on one output */
+static void
+reply_monitors(unsigned int seq, xcb_randr_output_t output, int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+  xcb_randr_get_monitors_reply_t* r =
+      calloc(1, sizeof(*r) + sizeof(xcb_randr_monitor_info_t) + sizeof(output));
+  assert_or_abort(r != NULL);
+  r->nMonitors = 1;
+  r->nOutputs  = 1;
+
+  xcb_randr_monitor_info_t* info = (xcb_randr_monitor_info_t*) (r + 1);
+  info->nOutput                  = 1;
+  info->x                        = x;
+  info->y                        = y;
+  info->width                    = w;
+  info->height                   = h;
+  xcb_randr_monitor_info_outputs(info)[0] = output;
+  assert(xcb_reply_complete(seq, r, NULL));
+}
+
+static void
+reply_error(unsigned int seq)
+{
+  xcb_generic_error_t* e = calloc(1, sizeof(*e));
+  assert_or_abort(e != NULL);
+  e->error_code = XCB_REQUEST;
+  assert(xcb_reply_complete(seq, NULL, e));
+}
+
+static void
+reply_output_info(unsigned int seq, xcb_randr_crtc_t crtc, uint8_t connection)
+{
+  xcb_randr_get_output_info_reply_t* r = calloc(1, sizeof(*r));
+  assert_or_abort(r != NULL);
+  r->crtc       = crtc;
+  r->connection = connection;
+  assert(xcb_reply_complete(seq, r, NULL));
+}
+
+static void
+reply_crtc_info(unsigned int seq, xcb_randr_mode_t mode, int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+  xcb_randr_get_crtc_info_reply_t* r = calloc(1, sizeof(*r));
+  assert_or_abort(r != NULL);
+  r->mode   = mode;
+  r->x      = x;
+  r->y      = y;
+  r->width  = w;
+  r->height = h;
+  assert(xcb_reply_complete(seq, r, NULL));
+}
+
+static void
+send_resource_change(void)
+{
+  xcb_randr_notify_event_t ev = { 0 };
+  ev.response_type            = XCB_RANDR_NOTIFY;
+  ev.subCode                  = XCB_RANDR_NOTIFY_RESOURCE_CHANGE;
+  monitor_manager_handle_randr_notify(&ev);
+}
+
+void
+test_monitor_manager_discovery_pipeline(void)
+{
+  LOG_CLEAN("== Testing monitor manager discovery pipeline");
+  discovery_setup();
+
+  /* select input, then version, resources and monitors together */
+  unsigned int s = last_sequence();
+  monitor_manager_init();
+  assert(RANDR_REQUESTS() == 4);
+  assert(xcb_reply_pending() == 3);
+
+  reply_version(s + 2, 1, 5);
+
+  /* the monitor list alone creates the monitor with its geometry */
+  reply_monitors(s + 4, 300, 0, 0, 1920, 1080);
+  Monitor* m = monitor_get_by_output(300);
+  assert_or_abort(m != NULL);
+  assert(m->width == 1920 && m->height == 1080);
+  assert(m->crtc == XCB_NONE);
+
+  /* resources send every output and CRTC query at once */
+  xcb_randr_output_t outputs[] = { 300, 301 };
+  xcb_randr_crtc_t   crtcs[]   = { 60, 61 };
+  unsigned int       r         = last_sequence();
+  reply_resources(s + 3, outputs, 2, crtcs, 2);
+  assert(RANDR_REQUESTS() == 4);
+  assert(xcb_reply_pending() == 4);
+
+  reply_output_info(r + 1, 60, XCB_RANDR_CONNECTION_CONNECTED);
+  reply_output_info(r + 2, XCB_NONE, XCB_RANDR_CONNECTION_DISCONNECTED);
+  reply_crtc_info(r + 3, 1, 0, 0, 1920, 1080);
+  assert(m->crtc == XCB_NONE); /* applied after the last reply only */
+  reply_crtc_info(r + 4, XCB_NONE, 0, 0, 0, 0);
+
+  assert(xcb_reply_pending() == 0);
+  assert(m->crtc == 60);
+  assert(monitor_get_by_output(301) == NULL);
+
+  /* the CRTC index is filled: a new output on CRTC 60 costs no request */
+  send_output_change(301, 60, XCB_RANDR_CONNECTION_CONNECTED);
+  Monitor* other = monitor_get_by_output(301);
+  assert_or_abort(other != NULL);
+  assert(other->width == 1920 && other->height == 1080);
+  assert(RANDR_REQUESTS() == 0);
+
+  discovery_teardown();
+}
+
+/*
+ * A server without monitor lists, and resources changing while the
+ * first pass is still waiting for replies.
+ */
+void
+test_monitor_manager_discovery_restart(void)
+{
+  LOG_CLEAN("== Testing monitor manager discovery restart while in flight");
+  discovery_setup();
+
+  unsigned int s = last_sequence();
+  monitor_manager_init();
+  assert(RANDR_REQUESTS() == 4);
+
+  reply_version(s + 2, 1, 4);
+
+  /* no second pass while the first one is in flight */
+  send_resource_change();
+  assert(RANDR_REQUESTS() == 0);
+
+  /* an error for the monitor list leaves the monitors to the CRTC path */
+  reply_error(s + 4);
+  assert(monitor_get_by_output(300) == NULL);
+
+  xcb_randr_output_t outputs[] = { 300, 301 };
+  xcb_randr_crtc_t   crtcs[]   = { 60, 61 };
+  unsigned int       r         = last_sequence();
+  reply_resources(s + 3, outputs, 1, crtcs, 1);
+  assert(RANDR_REQUESTS() == 2);
+
+  reply_output_info(r + 1, 60, XCB_RANDR_CONNECTION_CONNECTED);
+
+  /* the last reply applies the first pass and starts the second: only
+   * resources, the version is known and has no monitor list */
+  unsigned int t = last_sequence();
+  reply_crtc_info(r + 2, 1, 0, 0, 1280, 1024);
+  Monitor* m = monitor_get_by_output(300);
+  assert_or_abort(m != NULL);
+  assert(m->crtc == 60 && m->width == 1280 && m->height == 1024);
+  assert(RANDR_REQUESTS() == 1);
+  assert(xcb_reply_pending() == 1);
+
+  /* the second pass sees the output that was added */
+  unsigned int u = last_sequence();
+  reply_resources(t + 1, outputs, 2, crtcs, 2);
+  assert(RANDR_REQUESTS() == 4);
+  reply_output_info(u + 1, 60, XCB_RANDR_CONNECTION_CONNECTED);
+  reply_output_info(u + 2, 61, XCB_RANDR_CONNECTION_CONNECTED);
+  reply_crtc_info(u + 3, 1, 0, 0, 1280, 1024);
+  reply_crtc_info(u + 4, 1, 1280, 0, 1920, 1080);
+
+  Monitor* added = monitor_get_by_output(301);
+  assert_or_abort(added != NULL);
+  assert(added->crtc == 61 && added->x == 1280 && added->width == 1920);
+  assert(m->crtc == 60 && m->width == 1280);
+
+  /* and is the last one */
+  assert(xcb_reply_pending() == 0);
+  assert(RANDR_REQUESTS() == 0);
+
+  discovery_teardown();
+}
+
 TEST_GROUP(MonitorManager, {
   test_monitor_manager_component_init_shutdown();
   test_monitor_manager_handler_registration();
@@ -245,4 +598,8 @@ TEST_GROUP(MonitorManager, {
   test_monitor_manager_no_requests();
   test_monitor_manager_accepts_monitor_target();
   test_monitor_manager_with_monitors();
+  test_monitor_manager_crtc_index_from_notify();
+  test_monitor_manager_dock_three_outputs();
+  test_monitor_manager_discovery_pipeline();
+  test_monitor_manager_discovery_restart();
 });
@@ -14,6 +14,10 @@ void test_monitor_manager_multiple_init(void);
 void test_monitor_manager_no_requests(void);
 void test_monitor_manager_accepts_monitor_target(void);
 void test_monitor_manager_with_monitors(void);
+void test_monitor_manager_crtc_index_from_notify(void);
+void test_monitor_manager_dock_three_outputs(void);
+void test_monitor_manager_discovery_pipeline(void);
+void test_monitor_manager_discovery_restart(void);
 
 #define TEST_GROUP_MonitorManager                 \
   test_monitor_manager_component_init_shutdown(); \
@@ -21,6 +25,10 @@ void test_monitor_manager_with_monitors(void);
   test_monitor_manager_multiple_init();           \
   test_monitor_manager_no_requests();             \
   test_monitor_manager_accepts_monitor_target();  \
-  test_monitor_manager_with_monitors();
+  test_monitor_manager_with_monitors();           \
+  test_monitor_manager_crtc_index_from_notify();  \
+  test_monitor_manager_dock_three_outputs();      \
+  test_monitor_manager_discovery_pipeline();      \
+  test_monitor_manager_discovery_restart();
 
 #endif /* _TEST_WM_MONITOR_MANAGER_H_ */
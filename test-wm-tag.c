@@ -16,6 +16,7 @@
 #include <string.h>
 
 #include "src/components/pertag.h"
+#include "src/components/tag-manager.h"
 #include "src/target/monitor.h"
 #include "src/target/tag.h"
 #include "test-wm-tag.h"
@@ -36,6 +37,22 @@ tag_iteration_callback(Tag* t)
   }
 }
 
+/*
+ * EVT_TAG_CHANGED deliveries seen by tag_changed_listener
+ */
+static int      tag_changed_count = 0;
+static TargetID tag_changed_target;
+static uint32_t tag_changed_mask;
+
+static void
+tag_changed_listener(Event e)
+{
+  tag_changed_count++;
+  tag_changed_target = e.target;
+  if (e.data != NULL)
+    tag_changed_mask = *(uint32_t*) e.data;
+}
+
 /*
  * Test: tag_create_destroy
  * Tests creating and destroying a single tag using a specific index.
@@ -395,6 +412,50 @@ test_tag_multiple_monitors_reference(void)
   hub_shutdown();
 }
 
+/*
+ * Test: tag_view_coalesces_per_iteration
+ * Tests that view changes of one loop iteration reach listeners once.
+ */
+void
+test_tag_view_coalesces_per_iteration(void)
+{
+  LOG_CLEAN("== Testing tag view events coalesce per loop iteration");
+
+  hub_init();
+  tag_list_init();
+  monitor_list_init();
+  tag_manager_component_init();
+  hub_set_event_deferral(true);
+
+  hub_subscribe(EVT_TAG_CHANGED, tag_changed_listener, NULL);
+
+  Monitor* m = monitor_create(100);
+  assert(m != NULL);
+  tag_manager_on_adopt(&m->target);
+  hub_drain_events();
+  tag_changed_count = 0;
+
+  /* two requests in one iteration, each posting EVT_TAG_CHANGED */
+  uint32_t tag = 3;
+  hub_send_request_data(REQ_TAG_VIEW, m->target.id, &tag);
+  tag = 5;
+  hub_send_request_data(REQ_TAG_VIEW, m->target.id, &tag);
+  assert(tag_changed_count == 0);
+
+  /* the loop drains once: one delivery with the final view */
+  hub_drain_events();
+  assert(tag_changed_count == 1);
+  assert(tag_changed_target == m->target.id);
+  assert(tag_changed_mask == TAG_MASK(4));
+
+  hub_unsubscribe(EVT_TAG_CHANGED, tag_changed_listener);
+  monitor_destroy(m);
+  monitor_list_shutdown();
+  tag_list_shutdown();
+  tag_manager_component_shutdown();
+  hub_shutdown();
+}
+
 TEST_GROUP(Tag, {
   test_tag_create_destroy();
   test_tag_list_init_shutdown();
@@ -405,4 +466,5 @@ TEST_GROUP(Tag, {
   test_tag_with_hub_integration();
   test_tag_iterate_by_mask();
   test_tag_multiple_monitors_reference();
+  test_tag_view_coalesces_per_iteration();
 });
@@ -62,4 +62,10 @@ void test_tag_iterate_by_mask(void);
  */
 void test_tag_multiple_monitors_reference(void);
 
+/*
+ * Test: tag_view_coalesces_per_iteration
+ * Tests that view changes of one loop iteration reach listeners once.
+ */
+void test_tag_view_coalesces_per_iteration(void);
+
 #endif /* TEST_WM_TAG_H */
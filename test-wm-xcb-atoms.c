@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/xcb/xcb-atoms.h"
+#include "test-registry.h"
+#include "test-wm-xcb-atoms.h"
+#include "test-wm.h"
+
+/* Server-side values start after the predefined atoms */
+#define FIRST_ATOM 300
+
+static void
+set_all(void)
+{
+  for (int i = 0; i < ATOM_COUNT; i++)
+    xcb_atoms_set((WmAtom) i, (xcb_atom_t) (FIRST_ATOM + i));
+}
+
+void
+test_atoms_table_set_get(void)
+{
+  LOG_CLEAN("== Testing atom table lookup by enum index");
+
+  xcb_atoms_clear();
+  assert(xcb_atom_get(ATOM_NET_WM_STATE) == XCB_ATOM_NONE);
+
+  set_all();
+  assert(xcb_atom_get(ATOM_WM_PROTOCOLS) == FIRST_ATOM + ATOM_WM_PROTOCOLS);
+  assert(xcb_atom_get(ATOM_NET_WM_STATE) == FIRST_ATOM + ATOM_NET_WM_STATE);
+  assert(xcb_atom_get(ATOM_COUNT) == XCB_ATOM_NONE);
+
+  /* reverse: value to index and name */
+  assert(xcb_atom_id(FIRST_ATOM + ATOM_NET_WM_STATE) == ATOM_NET_WM_STATE);
+  assert(xcb_atom_id(FIRST_ATOM + ATOM_COUNT) == ATOM_COUNT);
+  assert(strcmp(xcb_atom_name(FIRST_ATOM + ATOM_NET_WM_STATE), "_NET_WM_STATE") == 0);
+  assert(strcmp(xcb_atom_name(FIRST_ATOM + ATOM_NET_WM_WINDOW_TYPE_DOCK), "_NET_WM_WINDOW_TYPE_DOCK") == 0);
+  assert(strcmp(xcb_atom_name(FIRST_ATOM + ATOM_UTF8_STRING), "UTF8_STRING") == 0);
+
+  xcb_atoms_clear();
+}
+
+void
+test_atoms_predefined_names(void)
+{
+  LOG_CLEAN("== Testing predefined atom names need no cache");
+
+  xcb_atoms_clear();
+  xcb_atoms_reset_stats();
+
+  assert(strcmp(xcb_atom_name(XCB_ATOM_PRIMARY), "PRIMARY") == 0);
+  assert(strcmp(xcb_atom_name(XCB_ATOM_WM_NAME), "WM_NAME") == 0);
+  assert(strcmp(xcb_atom_name(XCB_ATOM_WM_CLASS), "WM_CLASS") == 0);
+  assert(strcmp(xcb_atom_name(XCB_ATOM_WM_HINTS), "WM_HINTS") == 0);
+  assert(strcmp(xcb_atom_name(XCB_ATOM_WM_NORMAL_HINTS), "WM_NORMAL_HINTS") == 0);
+  assert(strcmp(xcb_atom_name(XCB_ATOM_WM_TRANSIENT_FOR), "WM_TRANSIENT_FOR") == 0);
+  assert(xcb_atom_name(XCB_ATOM_NONE) == NULL);
+  assert(xcb_atoms_get_stats().misses == 1);
+}
+
+void
+test_atoms_unknown_and_cached_names(void)
+{
+  LOG_CLEAN("== Testing unknown atoms and cached names");
+
+  xcb_atoms_clear();
+  xcb_atoms_reset_stats();
+  set_all();
+
+  /* unknown atom: no name, no request */
+  assert(xcb_atom_name(900) == NULL);
+  assert(xcb_atoms_get_stats().misses == 1);
+  assert(xcb_atoms_get_stats().resolves == 0);
+  xcb_atom_resolve(NULL, 900);
+  assert(xcb_atoms_get_stats().resolves == 0);
+
+  /* a name learned from the server; length-bounded, not NUL-terminated */
+  xcb_atom_cache_name(900, "_GTK_THEME_VARIANTxxx", 18);
+  assert(xcb_atom_name(900) != NULL);
+  assert(strcmp(xcb_atom_name(900), "_GTK_THEME_VARIANT") == 0);
+  assert(xcb_atom_id(900) == ATOM_COUNT);
+
+  /* replacing a cached name frees the old one */
+  xcb_atom_cache_name(900, "_GTK_OTHER", 10);
+  assert(strcmp(xcb_atom_name(900), "_GTK_OTHER") == 0);
+
+  /* table names are never overridden */
+  xcb_atom_cache_name(FIRST_ATOM + ATOM_NET_WM_NAME, "bogus", 5);
+  assert(strcmp(xcb_atom_name(FIRST_ATOM + ATOM_NET_WM_NAME), "_NET_WM_NAME") == 0);
+  assert(xcb_atom_id(FIRST_ATOM + ATOM_NET_WM_NAME) == ATOM_NET_WM_NAME);
+
+  xcb_atoms_clear();
+}
+
+void
+test_atoms_cache_growth(void)
+{
+  LOG_CLEAN("== Testing atom name cache grows past its initial size");
+  char name[32];
+
+  xcb_atoms_clear();
+  set_all();
+  for (xcb_atom_t a = 1000; a < 3000; a++) {
+    int len = snprintf(name, sizeof(name), "ATOM_%u", a);
+    xcb_atom_cache_name(a, name, len);
+  }
+
+  int found = 0;
+  for (xcb_atom_t a = 1000; a < 3000; a++) {
+    snprintf(name, sizeof(name), "ATOM_%u", a);
+    const char* cached = xcb_atom_name(a);
+    if (cached != NULL && strcmp(cached, name) == 0)
+      found++;
+  }
+  assert(found == 2000);
+  assert(xcb_atom_id(FIRST_ATOM + ATOM_WM_STATE) == ATOM_WM_STATE);
+
+  xcb_atoms_clear();
+}
+
+void
+test_atoms_clear(void)
+{
+  LOG_CLEAN("== Testing atom table clear");
+
+  set_all();
+  xcb_atom_cache_name(900, "X", 1);
+  xcb_atoms_clear();
+
+  assert(xcb_atom_get(ATOM_NET_WM_STATE) == XCB_ATOM_NONE);
+  assert(xcb_atom_name(FIRST_ATOM + ATOM_NET_WM_STATE) == NULL);
+  assert(xcb_atom_name(900) == NULL);
+  assert(xcb_atom_id(FIRST_ATOM + ATOM_NET_WM_STATE) == ATOM_COUNT);
+  /* predefined names do not depend on the cache */
+  assert(strcmp(xcb_atom_name(XCB_ATOM_WM_NAME), "WM_NAME") == 0);
+}
+
+/*
+ * Reverse lookup benchmark: the PROPERTY_NOTIFY path resolves every
+ * event's atom, so it must stay a few nanoseconds and never miss.
+ */
+void
+test_atoms_lookup_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: atom name lookups");
+  const int       rounds = 1000000;
+  struct timespec t0, t1;
+  size_t          total = 0;
+
+  xcb_atoms_clear();
+  xcb_atoms_reset_stats();
+  set_all();
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < rounds; i++) {
+    xcb_atom_t  atom = (i & 1) ? XCB_ATOM_WM_NAME : (xcb_atom_t) (FIRST_ATOM + i % ATOM_COUNT);
+    const char* name = xcb_atom_name(atom);
+    total += name != NULL ? name[0] : 0;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+  LOG_CLEAN("  %d lookups: %.1fns/lookup", rounds, ns / rounds);
+  assert(total > 0);
+  assert(xcb_atoms_get_stats().misses == 0);
+  assert(xcb_atoms_get_stats().resolves == 0);
+
+  xcb_atoms_clear();
+}
+
+TEST_GROUP(XCBAtoms, {
+  test_atoms_table_set_get();
+  test_atoms_predefined_names();
+  test_atoms_unknown_and_cached_names();
+  test_atoms_cache_growth();
+  test_atoms_clear();
+  test_atoms_lookup_benchmark();
+});
@@ -0,0 +1,17 @@
+/*
+ * test-wm-xcb-atoms.h - Header for atom table and name cache tests
+ */
+
+#ifndef TEST_WM_XCB_ATOMS_H
+#define TEST_WM_XCB_ATOMS_H
+
+#include "src/xcb/xcb-atoms.h"
+
+void test_atoms_table_set_get(void);
+void test_atoms_predefined_names(void);
+void test_atoms_unknown_and_cached_names(void);
+void test_atoms_cache_growth(void);
+void test_atoms_clear(void);
+void test_atoms_lookup_benchmark(void);
+
+#endif /* TEST_WM_XCB_ATOMS_H */
@@ -0,0 +1,609 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xinput.h>
+
+#include "src/xcb/xcb-batch.h"
+#include "src/xcb/xcb-handler.h"
+#include "test-registry.h"
+#include "test-wm-xcb-batch.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+
+#define TEST_XINPUT_OPCODE 131
+
+/* Fake core events, allocated like XCB does (32 bytes + full_sequence) */
+static xcb_generic_event_t*
+alloc_event(uint8_t type)
+{
+  xcb_generic_event_t* ev = calloc(1, sizeof(*ev));
+  assert_or_abort(ev != NULL);
+  ev->response_type = type;
+  return ev;
+}
+
+static xcb_generic_event_t*
+motion(xcb_window_t window)
+{
+  xcb_motion_notify_event_t* ev = (xcb_motion_notify_event_t*) alloc_event(XCB_MOTION_NOTIFY);
+  ev->event                     = window;
+  return (xcb_generic_event_t*) ev;
+}
+
+static xcb_generic_event_t*
+crossing(uint8_t type, xcb_window_t window)
+{
+  xcb_enter_notify_event_t* ev = (xcb_enter_notify_event_t*) alloc_event(type);
+  ev->event                    = window;
+  ev->mode                     = XCB_NOTIFY_MODE_NORMAL;
+  return (xcb_generic_event_t*) ev;
+}
+
+static xcb_generic_event_t*
+property(xcb_window_t window, xcb_atom_t atom, uint8_t state)
+{
+  xcb_property_notify_event_t* ev = (xcb_property_notify_event_t*) alloc_event(XCB_PROPERTY_NOTIFY);
+  ev->window                      = window;
+  ev->atom                        = atom;
+  ev->state                       = state;
+  return (xcb_generic_event_t*) ev;
+}
+
+static xcb_generic_event_t*
+raw_motion(uint16_t deviceid)
+{
+  xcb_input_raw_motion_event_t* ev = calloc(1, sizeof(*ev));
+  assert_or_abort(ev != NULL);
+  ev->response_type = XCB_GE_GENERIC;
+  ev->extension     = TEST_XINPUT_OPCODE;
+  ev->event_type    = XCB_INPUT_RAW_MOTION;
+  ev->deviceid      = deviceid;
+  return (xcb_generic_event_t*) ev;
+}
+
+static xcb_generic_event_t*
+key_press(xcb_window_t window)
+{
+  xcb_key_press_event_t* ev = (xcb_key_press_event_t*) alloc_event(XCB_KEY_PRESS);
+  ev->event                 = window;
+  return (xcb_generic_event_t*) ev;
+}
+
+static xcb_generic_event_t*
+map_request(xcb_window_t window)
+{
+  xcb_map_request_event_t* ev = (xcb_map_request_event_t*) alloc_event(XCB_MAP_REQUEST);
+  ev->window                  = window;
+  return (xcb_generic_event_t*) ev;
+}
+
+static xcb_generic_event_t*
+configure_request(xcb_window_t window)
+{
+  xcb_configure_request_event_t* ev = (xcb_configure_request_event_t*) alloc_event(XCB_CONFIGURE_REQUEST);
+  ev->window                        = window;
+  return (xcb_generic_event_t*) ev;
+}
+
+static xcb_generic_event_t*
+xi2_event(uint16_t event_type, xcb_window_t window)
+{
+  xcb_input_key_press_event_t* ev = calloc(1, sizeof(*ev));
+  assert_or_abort(ev != NULL);
+  ev->response_type = XCB_GE_GENERIC;
+  ev->extension     = TEST_XINPUT_OPCODE;
+  ev->event_type    = event_type;
+  ev->event         = window;
+  return (xcb_generic_event_t*) ev;
+}
+
+static uint8_t
+type_at(XCBBatch* batch, uint32_t i)
+{
+  return batch->events[i]->response_type & ~0x80;
+}
+
+void
+test_batch_push_grows(void)
+{
+  LOG_CLEAN("== Testing batch push grows storage");
+  XCBBatch batch = { 0 };
+
+  for (int i = 0; i < 200; i++)
+    assert_or_abort(xcb_batch_push(&batch, alloc_event(XCB_KEY_PRESS)));
+  assert(batch.count == 200);
+  assert(batch.capacity >= 200);
+
+  /* nothing to coalesce among key presses */
+  assert(xcb_batch_coalesce(&batch) == 200);
+
+  xcb_batch_free(&batch);
+  assert(batch.events == NULL);
+  assert(batch.count == 0);
+}
+
+void
+test_batch_motion_run_keeps_last(void)
+{
+  LOG_CLEAN("== Testing batch motion run keeps last event");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_reset_stats();
+  xcb_generic_event_t* last = motion(0x100);
+  xcb_batch_push(&batch, motion(0x100));
+  xcb_batch_push(&batch, motion(0x100));
+  xcb_batch_push(&batch, motion(0x100));
+  xcb_batch_push(&batch, last);
+
+  assert(xcb_batch_coalesce(&batch) == 1);
+  assert(batch.events[0] == last);
+  assert(xcb_batch_get_stats().dropped_motion == 3);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_motion_different_windows_kept(void)
+{
+  LOG_CLEAN("== Testing batch motion over different windows is kept");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_push(&batch, motion(0x100));
+  xcb_batch_push(&batch, motion(0x200));
+  /* a key press breaks the run */
+  xcb_batch_push(&batch, alloc_event(XCB_KEY_PRESS));
+  xcb_batch_push(&batch, motion(0x200));
+
+  assert(xcb_batch_coalesce(&batch) == 4);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_raw_motion_coalesced(void)
+{
+  LOG_CLEAN("== Testing batch XI2 raw motion coalescing");
+  XCBBatch batch = { 0 };
+
+  /* without the opcode, GE events are left alone */
+  xcb_batch_set_xinput_opcode(0);
+  xcb_batch_push(&batch, raw_motion(2));
+  xcb_batch_push(&batch, raw_motion(2));
+  assert(xcb_batch_coalesce(&batch) == 2);
+  xcb_batch_free(&batch);
+
+  xcb_batch_set_xinput_opcode(TEST_XINPUT_OPCODE);
+  xcb_batch_push(&batch, raw_motion(2));
+  xcb_batch_push(&batch, raw_motion(2));
+  xcb_batch_push(&batch, raw_motion(2));
+  xcb_batch_push(&batch, raw_motion(3));
+  assert(xcb_batch_coalesce(&batch) == 2);
+  assert(((xcb_input_raw_motion_event_t*) batch.events[0])->deviceid == 2);
+  assert(((xcb_input_raw_motion_event_t*) batch.events[1])->deviceid == 3);
+  xcb_batch_free(&batch);
+
+  xcb_batch_set_xinput_opcode(0);
+}
+
+void
+test_batch_enter_leave_pair_dropped(void)
+{
+  LOG_CLEAN("== Testing batch drops matched ENTER/LEAVE pairs");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_reset_stats();
+  /* pointer crosses 0x100 and 0x200, ends in 0x300 */
+  xcb_batch_push(&batch, crossing(XCB_ENTER_NOTIFY, 0x100));
+  xcb_batch_push(&batch, motion(0x100));
+  xcb_batch_push(&batch, crossing(XCB_LEAVE_NOTIFY, 0x100));
+  xcb_batch_push(&batch, crossing(XCB_ENTER_NOTIFY, 0x200));
+  xcb_batch_push(&batch, crossing(XCB_LEAVE_NOTIFY, 0x200));
+  xcb_batch_push(&batch, crossing(XCB_ENTER_NOTIFY, 0x300));
+
+  assert(xcb_batch_coalesce(&batch) == 2);
+  assert(type_at(&batch, 0) == XCB_MOTION_NOTIFY);
+  assert(type_at(&batch, 1) == XCB_ENTER_NOTIFY);
+  assert(((xcb_enter_notify_event_t*) batch.events[1])->event == 0x300);
+  assert(xcb_batch_get_stats().dropped_crossing == 4);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_unmatched_crossing_kept(void)
+{
+  LOG_CLEAN("== Testing batch keeps unmatched crossing events");
+  XCBBatch batch = { 0 };
+
+  /* LEAVE before ENTER is a real transition out of 0x100 */
+  xcb_batch_push(&batch, crossing(XCB_LEAVE_NOTIFY, 0x100));
+  xcb_batch_push(&batch, crossing(XCB_ENTER_NOTIFY, 0x200));
+  /* ENTER followed by LEAVE of a different window */
+  xcb_batch_push(&batch, crossing(XCB_LEAVE_NOTIFY, 0x300));
+
+  assert(xcb_batch_coalesce(&batch) == 3);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_inferior_crossing_kept(void)
+{
+  LOG_CLEAN("== Testing batch keeps crossings into a child window");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_reset_stats();
+  /* the pointer enters 0x100, then moves on into a child of it */
+  xcb_batch_push(&batch, crossing(XCB_ENTER_NOTIFY, 0x100));
+  xcb_generic_event_t* leave = crossing(XCB_LEAVE_NOTIFY, 0x100);
+  ((xcb_leave_notify_event_t*) leave)->detail = XCB_NOTIFY_DETAIL_INFERIOR;
+  xcb_batch_push(&batch, leave);
+
+  /* and back out of the child into 0x200's parent, then away */
+  xcb_generic_event_t* enter = crossing(XCB_ENTER_NOTIFY, 0x200);
+  ((xcb_enter_notify_event_t*) enter)->detail = XCB_NOTIFY_DETAIL_INFERIOR;
+  xcb_batch_push(&batch, enter);
+  xcb_batch_push(&batch, crossing(XCB_LEAVE_NOTIFY, 0x200));
+
+  assert(xcb_batch_coalesce(&batch) == 4);
+  assert(type_at(&batch, 0) == XCB_ENTER_NOTIFY);
+  assert(xcb_batch_get_stats().dropped_crossing == 0);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_property_keeps_last(void)
+{
+  LOG_CLEAN("== Testing batch keeps last PROPERTY_NOTIFY per window and atom");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_reset_stats();
+  xcb_batch_push(&batch, property(0x100, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, property(0x100, 40, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, property(0x200, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, property(0x100, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, property(0x100, 39, XCB_PROPERTY_DELETE));
+
+  assert(xcb_batch_coalesce(&batch) == 3);
+  assert(xcb_batch_get_stats().dropped_property == 2);
+
+  xcb_property_notify_event_t* last = (xcb_property_notify_event_t*) batch.events[2];
+  assert(last->window == 0x100);
+  assert(last->atom == 39);
+  assert(last->state == XCB_PROPERTY_DELETE);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_preserves_order(void)
+{
+  LOG_CLEAN("== Testing batch preserves order of kept events");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_push(&batch, alloc_event(XCB_MAP_REQUEST));
+  xcb_batch_push(&batch, motion(0x100));
+  xcb_batch_push(&batch, motion(0x100));
+  xcb_batch_push(&batch, alloc_event(XCB_KEY_PRESS));
+  xcb_batch_push(&batch, alloc_event(XCB_DESTROY_NOTIFY));
+
+  assert(xcb_batch_coalesce(&batch) == 4);
+  assert(type_at(&batch, 0) == XCB_MAP_REQUEST);
+  assert(type_at(&batch, 1) == XCB_MOTION_NOTIFY);
+  assert(type_at(&batch, 2) == XCB_KEY_PRESS);
+  assert(type_at(&batch, 3) == XCB_DESTROY_NOTIFY);
+
+  xcb_batch_free(&batch);
+}
+
+/*
+ * Pointer sweep across 1000 windows, 10 motion events per window, with a
+ * title update storm on one window: the handlers should see a small
+ * fraction of the raw events.
+ */
+void
+test_batch_pointer_sweep_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: pointer sweep across 1000 windows");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_reset_stats();
+  for (xcb_window_t w = 1; w <= 1000; w++) {
+    xcb_batch_push(&batch, crossing(XCB_ENTER_NOTIFY, w));
+    for (int i = 0; i < 10; i++)
+      xcb_batch_push(&batch, motion(w));
+    xcb_batch_push(&batch, crossing(XCB_LEAVE_NOTIFY, w));
+    xcb_batch_push(&batch, property(0x5000, 39, XCB_PROPERTY_NEW_VALUE));
+  }
+
+  uint32_t raw  = batch.count;
+  uint32_t kept = xcb_batch_coalesce(&batch);
+  LOG_CLEAN("  %u events in, %u dispatched (%.1fx fewer handler calls)",
+            raw, kept, (double) raw / kept);
+
+  XCBBatchStats stats = xcb_batch_get_stats();
+  assert(stats.batches == 1);
+  assert(stats.events == raw);
+  assert(stats.dispatched == kept);
+  assert(raw >= kept * 10);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_lane_classification(void)
+{
+  LOG_CLEAN("== Testing batch lane classification");
+
+  xcb_generic_event_t* key   = key_press(1);
+  xcb_generic_event_t* map   = map_request(1);
+  xcb_generic_event_t* prop  = property(1, 39, XCB_PROPERTY_NEW_VALUE);
+  xcb_generic_event_t* xkey  = xi2_event(XCB_INPUT_KEY_PRESS, 1);
+  xcb_generic_event_t* xbtn  = xi2_event(XCB_INPUT_RAW_BUTTON_PRESS, XCB_NONE);
+  xcb_generic_event_t* xmove = raw_motion(2);
+
+  assert(xcb_batch_lane(key) == XCB_LANE_INPUT);
+  assert(xcb_batch_lane(map) == XCB_LANE_STRUCTURAL);
+  assert(xcb_batch_lane(prop) == XCB_LANE_BULK);
+
+  /* XI2 events are only recognised once the opcode is known */
+  xcb_batch_set_xinput_opcode(0);
+  assert(xcb_batch_lane(xkey) == XCB_LANE_BULK);
+  xcb_batch_set_xinput_opcode(TEST_XINPUT_OPCODE);
+  assert(xcb_batch_lane(xkey) == XCB_LANE_INPUT);
+  assert(xcb_batch_lane(xbtn) == XCB_LANE_INPUT);
+  assert(xcb_batch_lane(xmove) == XCB_LANE_INPUT);
+  xcb_batch_set_xinput_opcode(0);
+
+  free(key);
+  free(map);
+  free(prop);
+  free(xkey);
+  free(xbtn);
+  free(xmove);
+}
+
+void
+test_batch_input_first(void)
+{
+  LOG_CLEAN("== Testing batch dispatches input, then structural, then bulk");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_reset_stats();
+  xcb_batch_push(&batch, property(0x100, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, property(0x200, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, configure_request(0x300));
+  xcb_batch_push(&batch, key_press(0x400));
+  xcb_batch_push(&batch, map_request(0x500));
+
+  xcb_batch_coalesce(&batch);
+  xcb_batch_prioritize(&batch);
+  assert(batch.count == 5);
+  assert(type_at(&batch, 0) == XCB_KEY_PRESS);
+  assert(type_at(&batch, 1) == XCB_CONFIGURE_REQUEST);
+  assert(type_at(&batch, 2) == XCB_MAP_REQUEST);
+  assert(type_at(&batch, 3) == XCB_PROPERTY_NOTIFY);
+  assert(((xcb_property_notify_event_t*) batch.events[3])->window == 0x100);
+  assert(((xcb_property_notify_event_t*) batch.events[4])->window == 0x200);
+  assert(xcb_batch_get_stats().promoted == 3);
+
+  xcb_batch_free(&batch);
+}
+
+void
+test_batch_lanes_keep_window_order(void)
+{
+  LOG_CLEAN("== Testing batch lanes never reorder one window's events");
+  XCBBatch batch = { 0 };
+
+  xcb_batch_reset_stats();
+  xcb_batch_push(&batch, property(0x100, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, key_press(0x100));
+  xcb_batch_push(&batch, map_request(0x100));
+  xcb_batch_push(&batch, map_request(0x200));
+  xcb_batch_push(&batch, key_press(0x300));
+
+  xcb_batch_coalesce(&batch);
+  xcb_batch_prioritize(&batch);
+  assert(type_at(&batch, 0) == XCB_KEY_PRESS);
+  assert(((xcb_key_press_event_t*) batch.events[0])->event == 0x300);
+  assert(type_at(&batch, 1) == XCB_MAP_REQUEST);
+  assert(((xcb_map_request_event_t*) batch.events[1])->window == 0x200);
+
+  /* 0x100 keeps property, key, map in arrival order */
+  assert(type_at(&batch, 2) == XCB_PROPERTY_NOTIFY);
+  assert(type_at(&batch, 3) == XCB_KEY_PRESS);
+  assert(type_at(&batch, 4) == XCB_MAP_REQUEST);
+  assert(xcb_batch_get_stats().held == 2);
+
+  xcb_batch_free(&batch);
+}
+
+/*
+ * The pointer enters B and a root binding is pressed in the same wakeup:
+ * the binding must see the crossing and focus change first.
+ */
+void
+test_batch_crossing_stays_before_input(void)
+{
+  LOG_CLEAN("== Testing batch keeps crossing and focus ahead of later input");
+  XCBBatch batch = { 0 };
+
+  xcb_generic_event_t* focus = alloc_event(XCB_FOCUS_IN);
+  ((xcb_focus_in_event_t*) focus)->event = 0x200;
+
+  xcb_batch_push(&batch, property(0x300, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, crossing(XCB_LEAVE_NOTIFY, 0x100));
+  xcb_batch_push(&batch, crossing(XCB_ENTER_NOTIFY, 0x200));
+  xcb_batch_push(&batch, motion(0x200));
+  xcb_batch_push(&batch, focus);
+  xcb_batch_push(&batch, key_press(0x10));
+
+  xcb_batch_coalesce(&batch);
+  xcb_batch_prioritize(&batch);
+  assert(batch.count == 6);
+  assert(type_at(&batch, 0) == XCB_LEAVE_NOTIFY);
+  assert(type_at(&batch, 1) == XCB_ENTER_NOTIFY);
+  assert(type_at(&batch, 2) == XCB_MOTION_NOTIFY);
+  assert(type_at(&batch, 3) == XCB_FOCUS_IN);
+  assert(type_at(&batch, 4) == XCB_KEY_PRESS);
+  assert(type_at(&batch, 5) == XCB_PROPERTY_NOTIFY);
+
+  xcb_batch_free(&batch);
+}
+
+/*
+ * A large batch grows the window table; a later small batch must not see
+ * what the large one left in it.
+ */
+void
+test_batch_window_table_cleared_between_batches(void)
+{
+  LOG_CLEAN("== Testing batch window order does not leak into the next batch");
+  XCBBatch     batch = { 0 };
+  xcb_window_t root  = 0x10;
+
+  for (xcb_window_t w = 0; w < 999; w++)
+    xcb_batch_push(&batch, property(0x1000 + w, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, property(root, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, key_press(0x20));
+  xcb_batch_coalesce(&batch);
+  xcb_batch_prioritize(&batch);
+  for (uint32_t i = 0; i < batch.count; i++)
+    free(batch.events[i]);
+  batch.count = 0;
+
+  xcb_batch_reset_stats();
+  xcb_batch_push(&batch, property(0x5000, 39, XCB_PROPERTY_NEW_VALUE));
+  xcb_batch_push(&batch, key_press(root));
+  xcb_batch_coalesce(&batch);
+  xcb_batch_prioritize(&batch);
+
+  assert(type_at(&batch, 0) == XCB_KEY_PRESS);
+  assert(type_at(&batch, 1) == XCB_PROPERTY_NOTIFY);
+  assert(xcb_batch_get_stats().held == 0);
+
+  xcb_batch_free(&batch);
+}
+
+/* Latency benchmark: handlers with a fixed cost per background event */
+#define BACKGROUND_COST_NS 2000
+
+static HubComponent lane_component = {
+  .name     = "lane-bench",
+  .requests = (RequestType[]) { 0 },
+};
+
+static struct timespec key_seen;
+
+static uint64_t
+elapsed_ns(const struct timespec* a, const struct timespec* b)
+{
+  return (uint64_t) ((b->tv_sec - a->tv_sec) * 1000000000LL + (b->tv_nsec - a->tv_nsec));
+}
+
+static XCBHandlerResult
+on_background(void* event)
+{
+  struct timespec t0, t;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  do
+    clock_gettime(CLOCK_MONOTONIC, &t);
+  while (elapsed_ns(&t0, &t) < BACKGROUND_COST_NS);
+  return XCB_HANDLER_CONTINUE;
+}
+
+static XCBHandlerResult
+on_key(void* event)
+{
+  clock_gettime(CLOCK_MONOTONIC, &key_seen);
+  return XCB_HANDLER_CONSUMED;
+}
+
+/* Run one second of 10k events/s in 16ms wakeups, a key press last in each */
+static double
+key_latency_us(bool lanes)
+{
+  const int wakeups = 62;
+  const int per     = 10000 / wakeups;
+  uint64_t  total   = 0;
+  XCBBatch  batch   = { 0 };
+
+  for (int w = 0; w < wakeups; w++) {
+    for (int i = 0; i < per; i++) {
+      xcb_window_t window = 0x1000 + (xcb_window_t) (w * per + i);
+      switch (i % 3) {
+      case 0:
+        xcb_batch_push(&batch, property(window, 39, XCB_PROPERTY_NEW_VALUE));
+        break;
+      case 1:
+        xcb_batch_push(&batch, configure_request(window));
+        break;
+      default:
+        xcb_batch_push(&batch, alloc_event(XCB_CREATE_NOTIFY));
+        break;
+      }
+    }
+    xcb_batch_push(&batch, key_press(0x10));
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t count = xcb_batch_coalesce(&batch);
+    if (lanes)
+      xcb_batch_prioritize(&batch);
+    for (uint32_t i = 0; i < count; i++) {
+      xcb_handler_dispatch(batch.events[i]);
+      free(batch.events[i]);
+    }
+    batch.count = 0;
+    total += elapsed_ns(&start, &key_seen);
+  }
+
+  xcb_batch_free(&batch);
+  return (double) total / wakeups / 1000.0;
+}
+
+/*
+ * KEY_PRESS-to-handler latency under a 10k events/s storm of property,
+ * configure and create events from other windows.
+ */
+void
+test_batch_key_latency_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: key press latency under 10k events/s");
+
+  hub_init();
+  xcb_handler_init();
+  xcb_handler_register(XCB_KEY_PRESS, &lane_component, on_key);
+  xcb_handler_register(XCB_PROPERTY_NOTIFY, &lane_component, on_background);
+  xcb_handler_register(XCB_CONFIGURE_REQUEST, &lane_component, on_background);
+  xcb_handler_register(XCB_CREATE_NOTIFY, &lane_component, on_background);
+
+  double fifo  = key_latency_us(false);
+  double lanes = key_latency_us(true);
+  LOG_CLEAN("  fifo: %.1fus, input lane: %.1fus", fifo, lanes);
+  assert(lanes * 10 < fifo);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+TEST_GROUP(XCBBatch, {
+  test_batch_push_grows();
+  test_batch_motion_run_keeps_last();
+  test_batch_motion_different_windows_kept();
+  test_batch_raw_motion_coalesced();
+  test_batch_enter_leave_pair_dropped();
+  test_batch_unmatched_crossing_kept();
+  test_batch_inferior_crossing_kept();
+  test_batch_property_keeps_last();
+  test_batch_preserves_order();
+  test_batch_pointer_sweep_benchmark();
+  test_batch_lane_classification();
+  test_batch_input_first();
+  test_batch_lanes_keep_window_order();
+  test_batch_crossing_stays_before_input();
+  test_batch_window_table_cleared_between_batches();
+  test_batch_key_latency_benchmark();
+});
@@ -0,0 +1,27 @@
+/*
+ * test-wm-xcb-batch.h - Header for XCB event batch tests
+ */
+
+#ifndef TEST_WM_XCB_BATCH_H
+#define TEST_WM_XCB_BATCH_H
+
+#include "src/xcb/xcb-batch.h"
+
+void test_batch_push_grows(void);
+void test_batch_motion_run_keeps_last(void);
+void test_batch_motion_different_windows_kept(void);
+void test_batch_raw_motion_coalesced(void);
+void test_batch_enter_leave_pair_dropped(void);
+void test_batch_unmatched_crossing_kept(void);
+void test_batch_inferior_crossing_kept(void);
+void test_batch_property_keeps_last(void);
+void test_batch_preserves_order(void);
+void test_batch_pointer_sweep_benchmark(void);
+void test_batch_lane_classification(void);
+void test_batch_input_first(void);
+void test_batch_lanes_keep_window_order(void);
+void test_batch_crossing_stays_before_input(void);
+void test_batch_window_table_cleared_between_batches(void);
+void test_batch_key_latency_benchmark(void);
+
+#endif /* TEST_WM_XCB_BATCH_H */
@@ -1,3 +1,7 @@
+#include <time.h>
+#include <xcb/randr.h>
+#include <xcb/xinput.h>
+
 #include "src/xcb/xcb-handler.h"
 #include "test-registry.h"
 #include "test-wm.h"
@@ -24,17 +28,19 @@ static HubComponent mock_component2 = {
 static int   handler_call_count = 0;
 static void* last_handler_event = NULL;
 
-static void
+static XCBHandlerResult
 test_handler(void* event)
 {
   handler_call_count++;
   last_handler_event = event;
+  return XCB_HANDLER_CONTINUE;
 }
 
-static void
+static XCBHandlerResult
 test_handler2(void* event)
 {
   handler_call_count++;
+  return XCB_HANDLER_CONTINUE;
 }
 
 static void
@@ -396,6 +402,308 @@ test_dispatch_null_event(void)
   hub_shutdown();
 }
 
+/* Extension offsets as a typical server assigns them */
+#define RANDR_OPCODE      140
+#define RANDR_FIRST_EVENT 89
+#define XINPUT_OPCODE     131
+#define OTHER_GE_OPCODE   150
+
+void
+test_dispatch_randr_by_first_event(void)
+{
+  LOG_CLEAN("== Testing RandR events dispatch relative to first_event");
+
+  hub_init();
+  xcb_handler_init();
+  reset_handler_state();
+
+  assert(xcb_handler_register_ext(XCB_EXT_RANDR, XCB_RANDR_NOTIFY, &mock_component, test_handler) == 0);
+  assert(xcb_handler_count_for_ext(XCB_EXT_RANDR, XCB_RANDR_NOTIFY) == 1);
+  assert(xcb_handler_count_for_type(XCB_RANDR_NOTIFY) == 0);
+
+  xcb_handler_set_extension(XCB_EXT_RANDR, RANDR_OPCODE, RANDR_FIRST_EVENT);
+  assert(xcb_handler_extension_opcode(XCB_EXT_RANDR) == RANDR_OPCODE);
+
+  xcb_randr_notify_event_t ev = { 0 };
+  ev.response_type            = RANDR_FIRST_EVENT + XCB_RANDR_NOTIFY;
+  xcb_handler_dispatch(&ev);
+  assert(handler_call_count == 1);
+  assert(last_handler_event == &ev);
+
+  /* response_type 1 is a reply, never a RandR event */
+  ev.response_type = XCB_RANDR_NOTIFY;
+  xcb_handler_dispatch(&ev);
+  assert(handler_call_count == 1);
+
+  /* ScreenChangeNotify sits at first_event and has no handler */
+  ev.response_type = RANDR_FIRST_EVENT + XCB_RANDR_SCREEN_CHANGE_NOTIFY;
+  xcb_handler_dispatch(&ev);
+  assert(handler_call_count == 1);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+void
+test_dispatch_xi2_by_event_type(void)
+{
+  LOG_CLEAN("== Testing XI2 GenericEvents dispatch by opcode and event_type");
+
+  hub_init();
+  xcb_handler_init();
+  reset_handler_state();
+
+  xcb_handler_set_extension(XCB_EXT_XINPUT, XINPUT_OPCODE, 0);
+  xcb_handler_register_ext(XCB_EXT_XINPUT, XCB_INPUT_KEY_PRESS, &mock_component, test_handler);
+  xcb_handler_register(XCB_GE_GENERIC, &mock_component2, test_handler2);
+
+  xcb_ge_generic_event_t ge = { 0 };
+  ge.response_type          = XCB_GE_GENERIC;
+  ge.extension              = XINPUT_OPCODE;
+  ge.event_type             = XCB_INPUT_KEY_PRESS;
+  xcb_handler_dispatch(&ge);
+  assert(handler_call_count == 1);
+  assert(last_handler_event == &ge);
+
+  /* other XI2 event types have their own buckets */
+  ge.event_type = XCB_INPUT_RAW_MOTION;
+  xcb_handler_dispatch(&ge);
+  assert(handler_call_count == 1);
+
+  /* GenericEvents of unknown extensions fall back to XCB_GE_GENERIC */
+  ge.extension  = OTHER_GE_OPCODE;
+  ge.event_type = XCB_INPUT_KEY_PRESS;
+  xcb_handler_dispatch(&ge);
+  assert(handler_call_count == 2);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+void
+test_register_ext_validation(void)
+{
+  LOG_CLEAN("== Testing extension registration bounds and cleanup");
+
+  hub_init();
+  xcb_handler_init();
+
+  assert(xcb_handler_register_ext(XCB_EXT_XINPUT, XCB_HANDLER_MAX_EXT_EVENTS, &mock_component, test_handler) == -1);
+  assert(xcb_handler_register_ext(XCB_EXT_COUNT, 0, &mock_component, test_handler) == -1);
+  assert(xcb_handler_register_ext(XCB_EXT_RANDR, XCB_RANDR_NOTIFY, NULL, test_handler) == -1);
+  assert(xcb_handler_count() == 0);
+
+  /* XCB_EXT_CORE is a plain registration */
+  assert(xcb_handler_register_ext(XCB_EXT_CORE, XCB_KEY_PRESS, &mock_component, test_handler) == 0);
+  assert(xcb_handler_count_for_type(XCB_KEY_PRESS) == 1);
+
+  xcb_handler_register_ext(XCB_EXT_RANDR, XCB_RANDR_NOTIFY, &mock_component, test_handler);
+  xcb_handler_register_ext(XCB_EXT_XINPUT, XCB_INPUT_FOCUS_IN, &mock_component, test_handler);
+  xcb_handler_register_ext(XCB_EXT_XINPUT, XCB_INPUT_FOCUS_IN, &mock_component2, test_handler2);
+
+  XCBHandler* h = xcb_handler_lookup_ext(XCB_EXT_XINPUT, XCB_INPUT_FOCUS_IN);
+  assert(h != NULL && h->component == &mock_component);
+  h = xcb_handler_next(h);
+  assert(h != NULL && h->component == &mock_component2);
+  assert(xcb_handler_next(h) == NULL);
+
+  xcb_handler_unregister_component(&mock_component);
+  assert(xcb_handler_count() == 1);
+  assert(xcb_handler_count_for_ext(XCB_EXT_RANDR, XCB_RANDR_NOTIFY) == 0);
+  assert(xcb_handler_count_for_ext(XCB_EXT_XINPUT, XCB_INPUT_FOCUS_IN) == 1);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+/*
+ * XI2 dispatch benchmark: a motion-heavy stream where only key presses
+ * have a handler. Each event is one opcode lookup plus one bucket.
+ */
+void
+test_dispatch_xi2_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: XI2 GenericEvent dispatch");
+  const int       events = 1000000;
+  struct timespec t0, t1;
+
+  hub_init();
+  xcb_handler_init();
+  reset_handler_state();
+
+  xcb_handler_set_extension(XCB_EXT_XINPUT, XINPUT_OPCODE, 0);
+  xcb_handler_register_ext(XCB_EXT_XINPUT, XCB_INPUT_KEY_PRESS, &mock_component, test_handler);
+
+  xcb_ge_generic_event_t ge = { 0 };
+  ge.response_type          = XCB_GE_GENERIC;
+  ge.extension              = XINPUT_OPCODE;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < events; i++) {
+    ge.event_type = (i & 7) == 0 ? XCB_INPUT_KEY_PRESS : XCB_INPUT_RAW_MOTION;
+    xcb_handler_dispatch(&ge);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+  LOG_CLEAN("  %d events: %.1fns/event", events, ns / events);
+  assert(handler_call_count == events / 8);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+/* Dispatch order log */
+static int order_log[8];
+static int order_count = 0;
+
+static XCBHandlerResult
+order_first(void* event)
+{
+  order_log[order_count++] = 1;
+  return XCB_HANDLER_CONTINUE;
+}
+
+static XCBHandlerResult
+order_second(void* event)
+{
+  order_log[order_count++] = 2;
+  return XCB_HANDLER_CONTINUE;
+}
+
+static XCBHandlerResult
+order_third(void* event)
+{
+  order_log[order_count++] = 3;
+  return XCB_HANDLER_CONTINUE;
+}
+
+static XCBHandlerResult
+order_consume(void* event)
+{
+  order_log[order_count++] = 9;
+  return XCB_HANDLER_CONSUMED;
+}
+
+void
+test_dispatch_priority_order(void)
+{
+  LOG_CLEAN("== Testing handlers run by priority, then registration order");
+
+  hub_init();
+  xcb_handler_init();
+  order_count = 0;
+
+  xcb_handler_register_priority(XCB_EXT_CORE, XCB_KEY_PRESS, -10, &mock_component, order_third);
+  xcb_handler_register(XCB_KEY_PRESS, &mock_component, order_second);
+  xcb_handler_register_priority(XCB_EXT_CORE, XCB_KEY_PRESS, 10, &mock_component2, order_first);
+  xcb_handler_register(XCB_KEY_PRESS, &mock_component2, order_second);
+
+  xcb_key_press_event_t ev = { .response_type = XCB_KEY_PRESS };
+  xcb_handler_dispatch(&ev);
+  assert(order_count == 4);
+  assert(order_log[0] == 1);
+  assert(order_log[1] == 2);
+  assert(order_log[2] == 2);
+  assert(order_log[3] == 3);
+
+  /* lookup/next walks the same order */
+  XCBHandler* h = xcb_handler_lookup(XCB_KEY_PRESS);
+  assert(h != NULL && h->priority == 10);
+  h = xcb_handler_next(xcb_handler_next(xcb_handler_next(h)));
+  assert(h != NULL && h->priority == -10);
+  assert(xcb_handler_next(h) == NULL);
+
+  /* unregistering recompiles the dispatch array */
+  xcb_handler_unregister_component(&mock_component2);
+  order_count = 0;
+  xcb_handler_dispatch(&ev);
+  assert(order_count == 2);
+  assert(order_log[0] == 2);
+  assert(order_log[1] == 3);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+void
+test_dispatch_consumed_stops_propagation(void)
+{
+  LOG_CLEAN("== Testing a consumed event stops propagation");
+
+  hub_init();
+  xcb_handler_init();
+  order_count = 0;
+
+  xcb_handler_register(XCB_KEY_PRESS, &mock_component, order_second);
+  xcb_handler_register_priority(XCB_EXT_CORE, XCB_KEY_PRESS, 5, &mock_component, order_consume);
+
+  xcb_key_press_event_t ev = { .response_type = XCB_KEY_PRESS };
+  xcb_handler_dispatch(&ev);
+  assert(order_count == 1);
+  assert(order_log[0] == 9);
+
+  /* a consuming property subscriber hides the event from generic handlers */
+  order_count = 0;
+  xcb_handler_register_property(500, XCB_NONE, &mock_component, order_consume);
+  xcb_handler_register(XCB_PROPERTY_NOTIFY, &mock_component2, order_second);
+
+  xcb_property_notify_event_t pe = { .response_type = XCB_PROPERTY_NOTIFY, .window = 1, .atom = 500 };
+  xcb_handler_dispatch(&pe);
+  assert(order_count == 1);
+  assert(order_log[0] == 9);
+
+  pe.atom = 501;
+  xcb_handler_dispatch(&pe);
+  assert(order_count == 2);
+  assert(order_log[1] == 2);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+static XCBHandlerResult
+bench_handler(void* event)
+{
+  handler_call_count++;
+  return XCB_HANDLER_CONTINUE;
+}
+
+/*
+ * Dispatch benchmark: eight handlers on one event type. The loop walks
+ * the compiled function-pointer array, so the cost per handler is one
+ * indirect call.
+ */
+void
+test_dispatch_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: core event dispatch to 8 handlers");
+  const int       events   = 1000000;
+  const int       per_type = 8;
+  struct timespec t0, t1;
+
+  hub_init();
+  xcb_handler_init();
+  reset_handler_state();
+
+  for (int i = 0; i < per_type; i++)
+    xcb_handler_register_priority(XCB_EXT_CORE, XCB_MOTION_NOTIFY, i, &mock_component, bench_handler);
+
+  xcb_motion_notify_event_t ev = { .response_type = XCB_MOTION_NOTIFY };
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < events; i++)
+    xcb_handler_dispatch(&ev);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+  LOG_CLEAN("  %d events: %.1fns/event, %.1fns/handler", events, ns / events, ns / events / per_type);
+  assert(handler_call_count == events * per_type);
+
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
 TEST_GROUP(XCBHandler, {
   test_xcb_handler_init_shutdown();
   test_register_single_handler();
@@ -413,4 +721,11 @@ TEST_GROUP(XCBHandler, {
   test_register_with_null_handler_fails();
   test_register_with_null_component_fails();
   test_dispatch_null_event();
+  test_dispatch_randr_by_first_event();
+  test_dispatch_xi2_by_event_type();
+  test_register_ext_validation();
+  test_dispatch_xi2_benchmark();
+  test_dispatch_priority_order();
+  test_dispatch_consumed_stops_propagation();
+  test_dispatch_benchmark();
 });
\ No newline at end of file
@@ -34,5 +34,12 @@ void test_next_returns_null_at_end(void);
 void test_register_with_null_handler_fails(void);
 void test_register_with_null_component_fails(void);
 void test_dispatch_null_event(void);
+void test_dispatch_randr_by_first_event(void);
+void test_dispatch_xi2_by_event_type(void);
+void test_register_ext_validation(void);
+void test_dispatch_xi2_benchmark(void);
+void test_dispatch_priority_order(void);
+void test_dispatch_consumed_stops_propagation(void);
+void test_dispatch_benchmark(void);
 
 #endif /* TEST_WM_XCB_HANDLER_H */
\ No newline at end of file
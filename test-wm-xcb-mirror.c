@@ -0,0 +1,409 @@
+/*
+ * X Server State Mirror Tests
+ *
+ * Tests for redundant configure/map elision.
+ * Requires: hub, client, monitor, tiling, fake X connection
+ */
+
+#include "test-registry.h" /* Must be first - defines TEST_GROUP macro */
+
+#include <stdlib.h>
+
+#include "src/components/tiling.h"
+#include "src/target/client.h"
+#include "src/target/monitor.h"
+#include "src/xcb/xcb-mirror.h"
+#include "test-wm-xcb-mirror.h"
+#include "test-wm.h"
+#include "test-xcb-fake.h"
+#include "wm-hub.h"
+#include "wm-xcb.h"
+
+#define MIRROR_CONFIG_RESTACK (XCB_MIRROR_CONFIG_MASK | XCB_CONFIG_WINDOW_STACK_MODE)
+
+static const XCBWindowState base_state = {
+  .x            = 10,
+  .y            = 20,
+  .width        = 640,
+  .height       = 480,
+  .border_width = 1,
+  .stack_mode   = XCB_STACK_MODE_ABOVE,
+};
+
+void
+test_mirror_first_configure_sends_all(void)
+{
+  LOG_CLEAN("== Testing mirror sends every field for an unknown window");
+  uint32_t values[7];
+
+  xcb_mirror_clear();
+  xcb_mirror_reset_stats();
+
+  uint16_t mask = xcb_mirror_filter_configure(0x100, MIRROR_CONFIG_RESTACK, &base_state, values);
+  assert(mask == MIRROR_CONFIG_RESTACK);
+  assert(values[0] == 10);
+  assert(values[1] == 20);
+  assert(values[2] == 640);
+  assert(values[3] == 480);
+  assert(values[4] == 1);
+  assert(values[5] == XCB_STACK_MODE_ABOVE);
+  assert(xcb_mirror_count() == 1);
+  assert(xcb_mirror_get_stats().configures_sent == 1);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_only_changed_fields(void)
+{
+  LOG_CLEAN("== Testing mirror reduces configure to changed fields");
+  uint32_t values[7];
+
+  xcb_mirror_clear();
+  xcb_mirror_reset_stats();
+  xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &base_state, values);
+
+  XCBWindowState moved = base_state;
+  moved.y              = 200;
+  moved.height         = 300;
+
+  uint16_t mask = xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &moved, values);
+  assert(mask == (XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_HEIGHT));
+  /* value list stays in protocol order */
+  assert(values[0] == 200);
+  assert(values[1] == 300);
+  assert(xcb_mirror_get_stats().fields_elided == 3);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_noop_configure_elided(void)
+{
+  LOG_CLEAN("== Testing mirror drops no-op configures");
+  uint32_t values[7];
+
+  xcb_mirror_clear();
+  xcb_mirror_reset_stats();
+  xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &base_state, values);
+
+  assert(xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &base_state, values) == 0);
+  assert(xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &base_state, values) == 0);
+
+  XCBMirrorStats stats = xcb_mirror_get_stats();
+  assert(stats.configures_sent == 1);
+  assert(stats.configures_elided == 2);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_partial_mask(void)
+{
+  LOG_CLEAN("== Testing mirror only trusts fields it has seen");
+  uint32_t values[7];
+
+  xcb_mirror_clear();
+
+  /* only position known so far */
+  uint16_t mask = xcb_mirror_filter_configure(0x100, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, &base_state, values);
+  assert(mask == (XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y));
+
+  /* size was never sent, so it goes out even though position is unchanged */
+  mask = xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &base_state, values);
+  assert(mask == (XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT | XCB_CONFIG_WINDOW_BORDER_WIDTH));
+  assert(values[0] == 640);
+
+  /* a sibling without a stack mode is never sent */
+  mask = xcb_mirror_filter_configure(0x100, XCB_CONFIG_WINDOW_SIBLING, &base_state, values);
+  assert(mask == 0);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_restack_when_order_changes(void)
+{
+  LOG_CLEAN("== Testing mirror sends restacks that change the order");
+  uint32_t values[7];
+
+  xcb_mirror_clear();
+  xcb_mirror_reset_stats();
+  xcb_mirror_filter_configure(0x100, MIRROR_CONFIG_RESTACK, &base_state, values);
+  xcb_mirror_filter_configure(0x200, MIRROR_CONFIG_RESTACK, &base_state, values);
+
+  /* 0x200 went above 0x100: raising 0x100 again must reach the server */
+  uint16_t mask = xcb_mirror_filter_configure(0x100, MIRROR_CONFIG_RESTACK, &base_state, values);
+  assert(mask == XCB_CONFIG_WINDOW_STACK_MODE);
+  assert(values[0] == XCB_STACK_MODE_ABOVE);
+
+  XCBMirrorStats stats = xcb_mirror_get_stats();
+  assert(stats.configures_sent == 3);
+  assert(stats.configures_elided == 0);
+  assert(stats.fields_elided == 5);
+
+  xcb_mirror_clear();
+}
+
+
+void
+test_mirror_restack_in_place_elided(void)
+{
+  LOG_CLEAN("== Testing mirror drops restacks that leave the window in place");
+  uint32_t values[7];
+
+  XCBWindowState above = { .stack_mode = XCB_STACK_MODE_ABOVE };
+  XCBWindowState below = { .stack_mode = XCB_STACK_MODE_BELOW };
+
+  xcb_mirror_clear();
+  xcb_mirror_reset_stats();
+
+  /* top to bottom: 0x300, 0x200, 0x100 */
+  xcb_mirror_filter_configure(0x300, XCB_CONFIG_WINDOW_STACK_MODE, &above, values);
+  below.sibling = 0x300;
+  xcb_mirror_filter_configure(0x200, XCB_MIRROR_RESTACK_MASK, &below, values);
+  below.sibling = 0x200;
+  xcb_mirror_filter_configure(0x100, XCB_MIRROR_RESTACK_MASK, &below, values);
+
+  /* each already sits where the request puts it */
+  assert(xcb_mirror_filter_configure(0x300, XCB_CONFIG_WINDOW_STACK_MODE, &above, values) == 0);
+  assert(xcb_mirror_filter_configure(0x100, XCB_MIRROR_RESTACK_MASK, &below, values) == 0);
+  above.sibling = 0x100;
+  assert(xcb_mirror_filter_configure(0x200, XCB_MIRROR_RESTACK_MASK, &above, values) == 0);
+  below.sibling = XCB_NONE;
+  assert(xcb_mirror_filter_configure(0x100, XCB_CONFIG_WINDOW_STACK_MODE, &below, values) == 0);
+
+  /* 0x100 above 0x300 moves it: sibling and stack mode go out together */
+  above.sibling = 0x300;
+  uint16_t mask = xcb_mirror_filter_configure(0x100, XCB_MIRROR_RESTACK_MASK, &above, values);
+  assert(mask == XCB_MIRROR_RESTACK_MASK);
+  assert(values[0] == 0x300);
+  assert(values[1] == XCB_STACK_MODE_ABOVE);
+
+  /* now on top */
+  above.sibling = XCB_NONE;
+  assert(xcb_mirror_filter_configure(0x100, XCB_CONFIG_WINDOW_STACK_MODE, &above, values) == 0);
+
+  /* unknown siblings and overlap-dependent modes always go out */
+  above.sibling = 0x999;
+  assert(xcb_mirror_filter_configure(0x200, XCB_MIRROR_RESTACK_MASK, &above, values) == XCB_MIRROR_RESTACK_MASK);
+  above.sibling = 0x100;
+  assert(xcb_mirror_filter_configure(0x200, XCB_MIRROR_RESTACK_MASK, &above, values) == XCB_MIRROR_RESTACK_MASK);
+  XCBWindowState top_if = { .stack_mode = XCB_STACK_MODE_TOP_IF };
+  assert(xcb_mirror_filter_configure(0x300, XCB_CONFIG_WINDOW_STACK_MODE, &top_if, values) != 0);
+  assert(xcb_mirror_filter_configure(0x300, XCB_CONFIG_WINDOW_STACK_MODE, &top_if, values) != 0);
+
+  /* a forgotten window leaves its neighbours adjacent */
+  xcb_mirror_forget(0x200);
+  below.sibling = 0x100;
+  xcb_mirror_filter_configure(0x300, XCB_MIRROR_RESTACK_MASK, &below, values);
+  xcb_mirror_filter_configure(0x400, XCB_MIRROR_RESTACK_MASK, &below, values);
+  xcb_mirror_forget(0x400);
+  assert(xcb_mirror_filter_configure(0x300, XCB_MIRROR_RESTACK_MASK, &below, values) == 0);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_map_unmap(void)
+{
+  LOG_CLEAN("== Testing mirror map state elision");
+
+  xcb_mirror_clear();
+  xcb_mirror_reset_stats();
+
+  assert(xcb_mirror_filter_map(0x100, true) == true);
+  assert(xcb_mirror_filter_map(0x100, true) == false);
+  assert(xcb_mirror_filter_map(0x100, false) == true);
+  assert(xcb_mirror_filter_map(0x100, false) == false);
+  assert(xcb_mirror_filter_map(0x100, true) == true);
+
+  XCBMirrorStats stats = xcb_mirror_get_stats();
+  assert(stats.maps_sent == 3);
+  assert(stats.maps_elided == 2);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_server_unmap(void)
+{
+  LOG_CLEAN("== Testing mirror follows server-side unmaps");
+
+  xcb_mirror_clear();
+
+  assert(xcb_mirror_filter_map(0x100, true) == true);
+  /* the client withdrew its window */
+  xcb_mirror_note_unmapped(0x100);
+  assert(xcb_mirror_filter_map(0x100, true) == true);
+
+  /* unknown windows are ignored */
+  xcb_mirror_note_unmapped(0x999);
+  assert(xcb_mirror_count() == 1);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_forget(void)
+{
+  LOG_CLEAN("== Testing mirror forget");
+  uint32_t values[7];
+
+  xcb_mirror_clear();
+  xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &base_state, values);
+  xcb_mirror_filter_map(0x100, true);
+
+  xcb_mirror_forget(0x100);
+  assert(xcb_mirror_count() == 0);
+
+  /* a new window reusing the XID starts from scratch */
+  assert(xcb_mirror_filter_configure(0x100, XCB_MIRROR_CONFIG_MASK, &base_state, values) == XCB_MIRROR_CONFIG_MASK);
+  assert(xcb_mirror_filter_map(0x100, true) == true);
+
+  xcb_mirror_forget(0x999);
+  assert(xcb_mirror_count() == 1);
+
+  xcb_mirror_clear();
+}
+
+void
+test_mirror_many_windows(void)
+{
+  LOG_CLEAN("== Testing mirror with many windows and removals");
+  uint32_t values[7];
+  bool     ok = true;
+
+  xcb_mirror_clear();
+
+  /* XIDs of two clients: same high bits, dense low bits */
+  for (xcb_window_t w = 0; w < 1000; w++) {
+    xcb_mirror_filter_map(0x00400001 + w, true);
+    xcb_mirror_filter_map(0x00600001 + w, true);
+  }
+  assert(xcb_mirror_count() == 2000);
+
+  /* remove every other window, the rest must still be found */
+  for (xcb_window_t w = 0; w < 1000; w += 2)
+    xcb_mirror_forget(0x00400001 + w);
+  assert(xcb_mirror_count() == 1500);
+
+  for (xcb_window_t w = 0; w < 1000; w++) {
+    bool expect_known = (w % 2) == 1;
+    if (xcb_mirror_filter_map(0x00400001 + w, true) == expect_known)
+      ok = false;
+    if (xcb_mirror_filter_map(0x00600001 + w, true))
+      ok = false;
+  }
+  assert(ok);
+
+  xcb_mirror_filter_configure(0x00400002, XCB_MIRROR_CONFIG_MASK, &base_state, values);
+  assert(xcb_mirror_filter_configure(0x00400002, XCB_MIRROR_CONFIG_MASK, &base_state, values) == 0);
+
+  xcb_mirror_clear();
+}
+
+/*
+ * Re-tile a monitor whose 40 windows already sit where the layout puts
+ * them and are stacked in layout order: no map, no geometry and no
+ * restack may reach the X connection.
+ */
+void
+test_mirror_stable_retile_sends_nothing(void)
+{
+  LOG_CLEAN("== Testing stable re-tile of 40 windows sends nothing");
+  const int nclients = 40;
+  Client*   clients[40];
+  Client*   layout[40];
+  uint32_t  values[7];
+
+  dpy = fake_xcb_connect(false);
+  assert_or_abort(dpy != NULL);
+
+  hub_init();
+  monitor_list_init();
+  client_list_init();
+  xcb_mirror_clear();
+  tiling_component_init();
+
+  Monitor* m = monitor_create(5000);
+  assert_or_abort(m != NULL);
+  monitor_set_geometry(m, 0, 0, 1920, 1080);
+
+  for (int i = 0; i < nclients; i++) {
+    clients[i] = client_create((xcb_window_t) (0x100 + i));
+    assert_or_abort(clients[i] != NULL);
+    client_set_managed(clients[i], true);
+    client_set_monitor(clients[i], m);
+  }
+
+  /* what a previous pass sent: master left half, 39 stack rows right */
+  uint16_t row = 1080 / (nclients - 1);
+  int      i   = 0;
+  for (Client* c = client_list_sentinel()->next; c != client_list_sentinel(); c = c->next, i++) {
+    XCBWindowState s = {
+      .x            = i == 0 ? 0 : 960,
+      .y            = (int16_t) (i == 0 ? 0 : (i - 1) * row),
+      .width        = 960,
+      .height       = i == 0 ? 1080 : row,
+      .border_width = 1,
+    };
+    xcb_mirror_filter_configure(c->window, XCB_MIRROR_CONFIG_MASK, &s, values);
+    xcb_mirror_filter_map(c->window, true);
+    layout[i] = c;
+  }
+  assert_or_abort(i == nclients);
+
+  /* and its stacking: the last client on top, each below the next */
+  XCBWindowState top = { .stack_mode = XCB_STACK_MODE_ABOVE };
+  xcb_mirror_filter_configure(layout[nclients - 1]->window, XCB_CONFIG_WINDOW_STACK_MODE, &top, values);
+  for (i = nclients - 2; i >= 0; i--) {
+    XCBWindowState below = { .sibling = layout[i + 1]->window, .stack_mode = XCB_STACK_MODE_BELOW };
+    xcb_mirror_filter_configure(layout[i]->window, XCB_MIRROR_RESTACK_MASK, &below, values);
+  }
+
+  xcb_mirror_reset_stats();
+  tiling_tile_monitor(m);
+
+  XCBMirrorStats stats = xcb_mirror_get_stats();
+  LOG_CLEAN("  re-tile: %llu configures and %llu maps elided, %llu configures sent",
+            (unsigned long long) stats.configures_elided,
+            (unsigned long long) stats.maps_elided,
+            (unsigned long long) stats.configures_sent);
+  /* a move-resize and a restack per window, all dropped */
+  assert(stats.configures_sent == 0);
+  assert(stats.configures_elided == (uint64_t) nclients * 2);
+  assert(stats.maps_sent == 0);
+  assert(stats.maps_elided == (uint64_t) nclients);
+
+  /* nothing on the wire */
+  assert(fake_xcb_count_requests(dpy, XCB_CONFIGURE_WINDOW, -1) == 0);
+
+  /* raising the bottom window is a restack-only configure, once */
+  client_restack(layout[0]->window, XCB_NONE, XCB_STACK_MODE_ABOVE);
+  client_restack(layout[0]->window, XCB_NONE, XCB_STACK_MODE_ABOVE);
+  assert(fake_xcb_count_requests(dpy, XCB_CONFIGURE_WINDOW, -1) == 1);
+  assert(fake_xcb_last_configure_mask() == XCB_CONFIG_WINDOW_STACK_MODE);
+
+  tiling_component_shutdown();
+  client_list_shutdown();
+  monitor_list_shutdown();
+  hub_shutdown();
+  xcb_mirror_clear();
+  fake_xcb_disconnect(dpy);
+  dpy = NULL;
+}
+
+TEST_GROUP(XCBMirror, {
+  test_mirror_first_configure_sends_all();
+  test_mirror_only_changed_fields();
+  test_mirror_noop_configure_elided();
+  test_mirror_partial_mask();
+  test_mirror_restack_when_order_changes();
+  test_mirror_restack_in_place_elided();
+  test_mirror_map_unmap();
+  test_mirror_server_unmap();
+  test_mirror_forget();
+  test_mirror_many_windows();
+  test_mirror_stable_retile_sends_nothing();
+});
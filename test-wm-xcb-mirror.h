@@ -0,0 +1,22 @@
+/*
+ * test-wm-xcb-mirror.h - Header for X server state mirror tests
+ */
+
+#ifndef TEST_WM_XCB_MIRROR_H
+#define TEST_WM_XCB_MIRROR_H
+
+#include "src/xcb/xcb-mirror.h"
+
+void test_mirror_first_configure_sends_all(void);
+void test_mirror_only_changed_fields(void);
+void test_mirror_noop_configure_elided(void);
+void test_mirror_partial_mask(void);
+void test_mirror_restack_when_order_changes(void);
+void test_mirror_restack_in_place_elided(void);
+void test_mirror_map_unmap(void);
+void test_mirror_server_unmap(void);
+void test_mirror_forget(void);
+void test_mirror_many_windows(void);
+void test_mirror_stable_retile_sends_nothing(void);
+
+#endif /* TEST_WM_XCB_MIRROR_H */
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "src/xcb/xcb-handler.h"
+#include "test-registry.h"
+#include "test-wm-xcb-property.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+
+#define ATOM_STATE     400
+#define ATOM_TITLE     401
+#define ATOM_USER_TIME 402
+#define WINDOW_A       0x100
+#define WINDOW_B       0x200
+
+static HubComponent component_a = {
+  .name     = "property-a",
+  .requests = (RequestType[]) { 0 },
+};
+
+static HubComponent component_b = {
+  .name     = "property-b",
+  .requests = (RequestType[]) { 0 },
+};
+
+static int          calls_a;
+static int          calls_b;
+static xcb_atom_t   last_atom;
+static xcb_window_t last_window;
+
+static XCBHandlerResult
+on_property_a(void* event)
+{
+  xcb_property_notify_event_t* e = event;
+  calls_a++;
+  last_atom   = e->atom;
+  last_window = e->window;
+  return XCB_HANDLER_CONTINUE;
+}
+
+static XCBHandlerResult
+on_property_b(void* event)
+{
+  (void) event;
+  calls_b++;
+  return XCB_HANDLER_CONTINUE;
+}
+
+static void
+setup(void)
+{
+  hub_init();
+  xcb_handler_init();
+  xcb_handler_reset_property_stats();
+  calls_a     = 0;
+  calls_b     = 0;
+  last_atom   = XCB_ATOM_NONE;
+  last_window = XCB_NONE;
+}
+
+static void
+teardown(void)
+{
+  xcb_handler_shutdown();
+  hub_shutdown();
+}
+
+static void
+send_property(xcb_window_t window, xcb_atom_t atom)
+{
+  xcb_property_notify_event_t e = {
+    .response_type = XCB_PROPERTY_NOTIFY,
+    .window        = window,
+    .atom          = atom,
+    .state         = XCB_PROPERTY_NEW_VALUE,
+  };
+  xcb_handler_dispatch((xcb_generic_event_t*) &e);
+}
+
+void
+test_property_routes_by_atom(void)
+{
+  LOG_CLEAN("== Testing PROPERTY_NOTIFY reaches only the atom's subscribers");
+  setup();
+
+  assert(xcb_handler_register_property(ATOM_STATE, XCB_NONE, &component_a, on_property_a) == 0);
+  assert(xcb_handler_register_property(ATOM_TITLE, XCB_NONE, &component_b, on_property_b) == 0);
+  assert(xcb_handler_count_for_property(ATOM_STATE, XCB_NONE) == 1);
+
+  send_property(WINDOW_A, ATOM_STATE);
+  assert(calls_a == 1);
+  assert(calls_b == 0);
+  assert(last_atom == ATOM_STATE);
+  assert(last_window == WINDOW_A);
+
+  send_property(WINDOW_B, ATOM_TITLE);
+  assert(calls_a == 1);
+  assert(calls_b == 1);
+
+  /* nobody watches _NET_WM_USER_TIME: no component code runs */
+  send_property(WINDOW_A, ATOM_USER_TIME);
+  assert(calls_a == 1);
+  assert(calls_b == 1);
+
+  XCBPropertyStats stats = xcb_handler_get_property_stats();
+  assert(stats.delivered == 2);
+  assert(stats.dropped == 1);
+
+  teardown();
+}
+
+void
+test_property_routes_by_window(void)
+{
+  LOG_CLEAN("== Testing per-window property subscriptions");
+  setup();
+
+  xcb_handler_register_property(ATOM_TITLE, WINDOW_A, &component_a, on_property_a);
+  xcb_handler_register_property(ATOM_TITLE, XCB_NONE, &component_b, on_property_b);
+
+  send_property(WINDOW_B, ATOM_TITLE);
+  assert(calls_a == 0);
+  assert(calls_b == 1);
+
+  send_property(WINDOW_A, ATOM_TITLE);
+  assert(calls_a == 1);
+  assert(calls_b == 2);
+  assert(last_window == WINDOW_A);
+
+  teardown();
+}
+
+void
+test_property_generic_handler_sees_all(void)
+{
+  LOG_CLEAN("== Testing generic PROPERTY_NOTIFY handlers still see every atom");
+  setup();
+
+  xcb_handler_register(XCB_PROPERTY_NOTIFY, &component_b, on_property_b);
+  xcb_handler_register_property(ATOM_STATE, XCB_NONE, &component_a, on_property_a);
+
+  send_property(WINDOW_A, ATOM_STATE);
+  send_property(WINDOW_A, ATOM_USER_TIME);
+  assert(calls_a == 1);
+  assert(calls_b == 2);
+  assert(xcb_handler_get_property_stats().dropped == 0);
+
+  teardown();
+}
+
+void
+test_property_unregister(void)
+{
+  LOG_CLEAN("== Testing property unsubscription");
+  setup();
+
+  xcb_handler_register_property(ATOM_STATE, XCB_NONE, &component_a, on_property_a);
+  xcb_handler_register_property(ATOM_STATE, XCB_NONE, &component_b, on_property_b);
+  assert(xcb_handler_count_for_property(ATOM_STATE, XCB_NONE) == 2);
+
+  assert(xcb_handler_unregister_property(ATOM_STATE, XCB_NONE, &component_a) == 0);
+  assert(xcb_handler_unregister_property(ATOM_STATE, XCB_NONE, &component_a) == -1);
+  assert(xcb_handler_count_for_property(ATOM_STATE, XCB_NONE) == 1);
+
+  send_property(WINDOW_A, ATOM_STATE);
+  assert(calls_a == 0);
+  assert(calls_b == 1);
+
+  assert(xcb_handler_unregister_property(ATOM_STATE, XCB_NONE, &component_b) == 0);
+  send_property(WINDOW_A, ATOM_STATE);
+  assert(calls_b == 1);
+  assert(xcb_handler_get_property_stats().dropped == 1);
+
+  teardown();
+}
+
+void
+test_property_unregister_component(void)
+{
+  LOG_CLEAN("== Testing component unregistration drops its property subscriptions");
+  setup();
+
+  xcb_handler_register_property(ATOM_STATE, XCB_NONE, &component_a, on_property_a);
+  xcb_handler_register_property(ATOM_TITLE, WINDOW_A, &component_a, on_property_a);
+  xcb_handler_register_property(ATOM_TITLE, WINDOW_A, &component_b, on_property_b);
+
+  xcb_handler_unregister_component(&component_a);
+  assert(xcb_handler_count_for_property(ATOM_STATE, XCB_NONE) == 0);
+  assert(xcb_handler_count_for_property(ATOM_TITLE, WINDOW_A) == 1);
+
+  send_property(WINDOW_A, ATOM_STATE);
+  send_property(WINDOW_A, ATOM_TITLE);
+  assert(calls_a == 0);
+  assert(calls_b == 1);
+
+  teardown();
+}
+
+void
+test_property_growth(void)
+{
+  LOG_CLEAN("== Testing property table growth across many windows");
+  setup();
+
+  const uint32_t windows = 2000;
+  for (uint32_t i = 0; i < windows; i++)
+    assert_or_abort(xcb_handler_register_property(ATOM_TITLE, WINDOW_A + i, &component_a, on_property_a) == 0);
+
+  for (uint32_t i = 0; i < windows; i++)
+    send_property(WINDOW_A + i, ATOM_TITLE);
+  assert(calls_a == (int) windows);
+
+  /* remove every other window; the rest must still be reachable */
+  for (uint32_t i = 0; i < windows; i += 2)
+    xcb_handler_unregister_property(ATOM_TITLE, WINDOW_A + i, &component_a);
+
+  calls_a = 0;
+  for (uint32_t i = 0; i < windows; i++)
+    send_property(WINDOW_A + i, ATOM_TITLE);
+  assert(calls_a == (int) windows / 2);
+
+  teardown();
+}
+
+void
+test_property_rejects_invalid(void)
+{
+  LOG_CLEAN("== Testing property registration rejects invalid input");
+  setup();
+
+  assert(xcb_handler_register_property(XCB_ATOM_NONE, XCB_NONE, &component_a, on_property_a) == -1);
+  assert(xcb_handler_register_property(ATOM_STATE, XCB_NONE, NULL, on_property_a) == -1);
+  assert(xcb_handler_register_property(ATOM_STATE, XCB_NONE, &component_a, NULL) == -1);
+  assert(xcb_handler_count() == 0);
+
+  teardown();
+}
+
+/*
+ * Flood benchmark: a client spamming _NET_WM_USER_TIME while two atoms
+ * are watched. Unwatched events must cost a lookup, not a handler call.
+ */
+void
+test_property_flood_benchmark(void)
+{
+  LOG_CLEAN("== Benchmark: PROPERTY_NOTIFY flood of an unwatched atom");
+  setup();
+
+  const int       events = 1000000;
+  struct timespec t0, t1;
+
+  xcb_handler_register_property(ATOM_STATE, XCB_NONE, &component_a, on_property_a);
+  xcb_handler_register_property(ATOM_TITLE, XCB_NONE, &component_b, on_property_b);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < events; i++)
+    send_property(WINDOW_A + (i & 63), ATOM_USER_TIME);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+  LOG_CLEAN("  %d events: %.1fns/event", events, ns / events);
+  assert(calls_a == 0);
+  assert(calls_b == 0);
+  assert(xcb_handler_get_property_stats().dropped == (uint64_t) events);
+
+  teardown();
+}
+
+TEST_GROUP(XCBProperty, {
+  test_property_routes_by_atom();
+  test_property_routes_by_window();
+  test_property_generic_handler_sees_all();
+  test_property_unregister();
+  test_property_unregister_component();
+  test_property_growth();
+  test_property_rejects_invalid();
+  test_property_flood_benchmark();
+});
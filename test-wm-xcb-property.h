@@ -0,0 +1,19 @@
+/*
+ * test-wm-xcb-property.h - Header for per-atom PROPERTY_NOTIFY routing tests
+ */
+
+#ifndef TEST_WM_XCB_PROPERTY_H
+#define TEST_WM_XCB_PROPERTY_H
+
+#include "src/xcb/xcb-handler.h"
+
+void test_property_routes_by_atom(void);
+void test_property_routes_by_window(void);
+void test_property_generic_handler_sees_all(void);
+void test_property_unregister(void);
+void test_property_unregister_component(void);
+void test_property_growth(void);
+void test_property_rejects_invalid(void);
+void test_property_flood_benchmark(void);
+
+#endif /* TEST_WM_XCB_PROPERTY_H */
@@ -0,0 +1,279 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/target/client.h"
+#include "src/xcb/xcb-reply.h"
+#include "test-registry.h"
+#include "test-wm-xcb-reply.h"
+#include "test-wm.h"
+#include "wm-hub.h"
+
+/* What the last handler invocation saw */
+static int      calls;
+static TargetID last_target;
+static uint32_t last_value;
+static bool     last_error;
+static void*    last_userdata;
+
+static void
+reset_calls(void)
+{
+  calls         = 0;
+  last_target   = TARGET_ID_NONE;
+  last_value    = 0;
+  last_error    = false;
+  last_userdata = NULL;
+}
+
+/* Replies are freed by the engine, so allocate them like XCB does */
+static void*
+make_reply(uint32_t value)
+{
+  uint32_t* reply = malloc(sizeof(*reply));
+  assert_or_abort(reply != NULL);
+  *reply = value;
+  return reply;
+}
+
+static void
+record_handler(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  calls++;
+  last_target   = target;
+  last_value    = reply ? *(uint32_t*) reply : 0;
+  last_error    = error != NULL;
+  last_userdata = userdata;
+}
+
+/* Sum of the values seen, to check every continuation ran exactly once */
+static uint64_t value_sum;
+
+static void
+sum_handler(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  calls++;
+  value_sum += *(uint32_t*) reply;
+}
+
+static void
+chain_handler(TargetID target, void* reply, xcb_generic_error_t* error, void* userdata)
+{
+  calls++;
+  /* a follow-up request, as discovery does for each output */
+  xcb_reply_register(*(uint32_t*) reply + 1, target, record_handler, NULL);
+}
+
+void
+test_reply_complete_runs_handler(void)
+{
+  LOG_CLEAN("== Testing reply continuation runs its handler");
+  static int cookie_data;
+
+  xcb_reply_clear(NULL);
+  xcb_reply_reset_stats();
+  reset_calls();
+
+  assert(xcb_reply_register(10, TARGET_ID_NONE, record_handler, &cookie_data));
+  assert(xcb_reply_pending() == 1);
+
+  assert(xcb_reply_complete(10, make_reply(42), NULL));
+  assert(calls == 1);
+  assert(last_value == 42);
+  assert(last_error == false);
+  assert(last_userdata == &cookie_data);
+  assert(xcb_reply_pending() == 0);
+
+  XCBReplyStats stats = xcb_reply_get_stats();
+  assert(stats.registered == 1);
+  assert(stats.completed == 1);
+
+  /* a continuation runs only once */
+  assert(!xcb_reply_complete(10, make_reply(42), NULL));
+  assert(calls == 1);
+
+  /* no connection, nothing to poll */
+  assert(xcb_reply_process(NULL) == 0);
+
+  xcb_reply_clear(NULL);
+}
+
+void
+test_reply_error_delivered(void)
+{
+  LOG_CLEAN("== Testing reply continuation receives errors");
+
+  xcb_reply_clear(NULL);
+  xcb_reply_reset_stats();
+  reset_calls();
+
+  xcb_generic_error_t* error = calloc(1, sizeof(*error));
+  assert_or_abort(error != NULL);
+  error->error_code = XCB_WINDOW;
+
+  xcb_reply_register(11, TARGET_ID_NONE, record_handler, NULL);
+  assert(xcb_reply_complete(11, NULL, error));
+  assert(calls == 1);
+  assert(last_error == true);
+  assert(xcb_reply_get_stats().errors == 1);
+
+  xcb_reply_clear(NULL);
+}
+
+void
+test_reply_unknown_sequence(void)
+{
+  LOG_CLEAN("== Testing reply for unknown sequence is discarded");
+
+  xcb_reply_clear(NULL);
+  reset_calls();
+
+  assert(!xcb_reply_register(12, TARGET_ID_NONE, NULL, NULL));
+  assert(xcb_reply_pending() == 0);
+
+  xcb_reply_register(12, TARGET_ID_NONE, record_handler, NULL);
+  assert(!xcb_reply_complete(13, make_reply(1), NULL));
+  assert(calls == 0);
+  assert(xcb_reply_pending() == 1);
+
+  xcb_reply_clear(NULL);
+}
+
+void
+test_reply_dropped_when_target_gone(void)
+{
+  LOG_CLEAN("== Testing reply continuation dropped when its target is destroyed");
+
+  hub_init();
+  client_list_init();
+  xcb_reply_clear(NULL);
+  xcb_reply_reset_stats();
+  reset_calls();
+
+  Client* c = client_create(0x200);
+  assert_or_abort(c != NULL);
+  TargetID id = c->target.id;
+
+  xcb_reply_register(20, id, record_handler, NULL);
+  client_destroy(c);
+
+  assert(xcb_reply_complete(20, make_reply(7), NULL));
+  assert(calls == 0);
+  assert(xcb_reply_pending() == 0);
+  assert(xcb_reply_get_stats().dropped == 1);
+
+  xcb_reply_clear(NULL);
+  client_list_shutdown();
+  hub_shutdown();
+}
+
+void
+test_reply_kept_while_target_alive(void)
+{
+  LOG_CLEAN("== Testing reply continuation runs while its target exists");
+
+  hub_init();
+  client_list_init();
+  xcb_reply_clear(NULL);
+  reset_calls();
+
+  Client* c = client_create(0x201);
+  assert_or_abort(c != NULL);
+
+  xcb_reply_register(21, c->target.id, record_handler, NULL);
+  assert(xcb_reply_complete(21, make_reply(8), NULL));
+  assert(calls == 1);
+  assert(last_target == c->target.id);
+  assert(last_value == 8);
+
+  xcb_reply_clear(NULL);
+  client_list_shutdown();
+  hub_shutdown();
+}
+
+void
+test_reply_out_of_order_and_growth(void)
+{
+  LOG_CLEAN("== Testing many continuations completed out of order");
+  const uint32_t n        = 500;
+  uint64_t       expected = 0;
+
+  xcb_reply_clear(NULL);
+  reset_calls();
+  value_sum = 0;
+
+  for (uint32_t i = 1; i <= n; i++) {
+    xcb_reply_register(1000 + i, TARGET_ID_NONE, sum_handler, NULL);
+    expected += i;
+  }
+  assert(xcb_reply_pending() == n);
+
+  /* odd sequences first, then even ones from the back */
+  for (uint32_t i = 1; i <= n; i += 2)
+    xcb_reply_complete(1000 + i, make_reply(i), NULL);
+  for (uint32_t i = n; i >= 2; i -= 2)
+    xcb_reply_complete(1000 + i, make_reply(i), NULL);
+
+  assert(calls == (int) n);
+  assert(value_sum == expected);
+  assert(xcb_reply_pending() == 0);
+
+  xcb_reply_clear(NULL);
+}
+
+void
+test_reply_register_from_handler(void)
+{
+  LOG_CLEAN("== Testing handler may register follow-up continuations");
+
+  xcb_reply_clear(NULL);
+  reset_calls();
+
+  /* fill the ring, then complete from the middle so the follow-up has to
+   * grow it with a hole still inside */
+  for (uint32_t i = 0; i < 32; i++)
+    xcb_reply_register(100 + i, TARGET_ID_NONE, chain_handler, NULL);
+
+  assert(xcb_reply_complete(101, make_reply(500), NULL));
+  assert(calls == 1);
+  assert(xcb_reply_pending() == 32);
+
+  assert(xcb_reply_complete(501, make_reply(9), NULL));
+  assert(calls == 2);
+  assert(last_value == 9);
+
+  /* entries around the hole survived the move */
+  assert(xcb_reply_complete(100, make_reply(600), NULL));
+  assert(xcb_reply_complete(131, make_reply(700), NULL));
+  assert(calls == 4);
+  assert(xcb_reply_pending() == 31);
+
+  xcb_reply_clear(NULL);
+}
+
+void
+test_reply_clear(void)
+{
+  LOG_CLEAN("== Testing clear discards pending continuations");
+
+  xcb_reply_clear(NULL);
+  reset_calls();
+
+  xcb_reply_register(30, TARGET_ID_NONE, record_handler, NULL);
+  xcb_reply_register(31, TARGET_ID_NONE, record_handler, NULL);
+  xcb_reply_clear(NULL);
+
+  assert(xcb_reply_pending() == 0);
+  assert(!xcb_reply_complete(30, make_reply(1), NULL));
+  assert(calls == 0);
+}
+
+TEST_GROUP(XCBReply, {
+  test_reply_complete_runs_handler();
+  test_reply_error_delivered();
+  test_reply_unknown_sequence();
+  test_reply_dropped_when_target_gone();
+  test_reply_kept_while_target_alive();
+  test_reply_out_of_order_and_growth();
+  test_reply_register_from_handler();
+  test_reply_clear();
+});
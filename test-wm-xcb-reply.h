@@ -0,0 +1,19 @@
+/*
+ * test-wm-xcb-reply.h - Header for XCB reply continuation tests
+ */
+
+#ifndef TEST_WM_XCB_REPLY_H
+#define TEST_WM_XCB_REPLY_H
+
+#include "src/xcb/xcb-reply.h"
+
+void test_reply_complete_runs_handler(void);
+void test_reply_error_delivered(void);
+void test_reply_unknown_sequence(void);
+void test_reply_dropped_when_target_gone(void);
+void test_reply_kept_while_target_alive(void);
+void test_reply_out_of_order_and_growth(void);
+void test_reply_register_from_handler(void);
+void test_reply_clear(void);
+
+#endif /* TEST_WM_XCB_REPLY_H */
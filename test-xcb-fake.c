@@ -0,0 +1,180 @@
+/*
+ * In-process X connection for tests, see test-xcb-fake.h
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <xcb/randr.h>
+
+#include "test-xcb-fake.h"
+#include "wm-log.h"
+
+static int      server_fd           = -1;
+static uint16_t last_configure_mask = 0;
+
+/* Read whatever the client wrote, without blocking */
+static ssize_t
+server_read(uint8_t* buf, size_t size)
+{
+  ssize_t total = 0;
+  while ((size_t) total < size) {
+    ssize_t n = recv(server_fd, buf + total, size - total, MSG_DONTWAIT);
+    if (n <= 0)
+      break;
+    total += n;
+  }
+  return total;
+}
+
+/* Read exactly size bytes, blocking */
+static bool
+server_read_exact(uint8_t* buf, size_t size)
+{
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = read(server_fd, buf + done, size - done);
+    if (n <= 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+
+/*
+ * The server side of the handshake. XCB reads whatever arrives while it
+ * writes, so the answers can only go out once the questions are in: this
+ * runs on a thread while the test thread connects.
+ */
+static void*
+fake_server(void* arg)
+{
+  bool    randr = *(bool*) arg;
+  uint8_t request[16];
+
+  /* Setup request: byte order, protocol version, no authorization */
+  if (!server_read_exact(request, 12))
+    return NULL;
+
+  /* Setup reply: no vendor, formats or screens */
+  xcb_setup_t setup = {
+    .status                 = 1,
+    .protocol_major_version = 11,
+    .length                 = (sizeof(xcb_setup_t) - 8) / 4,
+    .resource_id_base       = 0x00200000,
+    .resource_id_mask       = 0x001fffff,
+    .maximum_request_length = 0xffff,
+    .min_keycode            = 8,
+    .max_keycode            = 255,
+  };
+  if (write(server_fd, &setup, sizeof(setup)) != (ssize_t) sizeof(setup))
+    return NULL;
+
+  /* QueryExtension "RANDR", request 1 */
+  if (randr) {
+    if (!server_read_exact(request, 16))
+      return NULL;
+
+    uint8_t                      reply[32] = { 0 };
+    xcb_query_extension_reply_t* ext       = (xcb_query_extension_reply_t*) reply;
+    ext->response_type                     = 1; /* reply */
+    ext->sequence                          = 1;
+    ext->present                           = 1;
+    ext->major_opcode                      = FAKE_XCB_RANDR_OPCODE;
+    if (write(server_fd, reply, sizeof(reply)) != (ssize_t) sizeof(reply))
+      return NULL;
+  }
+  return arg;
+}
+
+xcb_connection_t*
+fake_xcb_connect(bool randr)
+{
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+    LOG_ERROR("fake-xcb: socketpair failed: %s", strerror(errno));
+    return NULL;
+  }
+  server_fd           = fds[1];
+  last_configure_mask = 0;
+
+  pthread_t server;
+  if (pthread_create(&server, NULL, fake_server, &randr) != 0) {
+    close(fds[0]);
+    close(fds[1]);
+    server_fd = -1;
+    return NULL;
+  }
+
+  xcb_connection_t* conn = xcb_connect_to_fd(fds[0], NULL);
+  bool              ok   = !xcb_connection_has_error(conn);
+
+  /* XCB sends the query before the first RandR request; do it now */
+  if (ok && randr) {
+    const xcb_query_extension_reply_t* ext = xcb_get_extension_data(conn, &xcb_randr_id);
+    ok                                     = ext != NULL && ext->present;
+  }
+
+  /* On failure the client side is closed, so the server sees EOF */
+  if (!ok) {
+    xcb_disconnect(conn);
+    conn = NULL;
+  }
+
+  void* served = NULL;
+  pthread_join(server, &served);
+  if (conn != NULL && served == NULL) {
+    xcb_disconnect(conn);
+    conn = NULL;
+  }
+
+  if (conn == NULL) {
+    LOG_ERROR("fake-xcb: handshake failed");
+    close(server_fd);
+    server_fd = -1;
+  }
+  return conn;
+}
+
+void
+fake_xcb_disconnect(xcb_connection_t* conn)
+{
+  if (conn != NULL)
+    xcb_disconnect(conn);
+  if (server_fd >= 0)
+    close(server_fd);
+  server_fd = -1;
+}
+
+uint32_t
+fake_xcb_count_requests(xcb_connection_t* conn, uint8_t major, int minor)
+{
+  static uint8_t buf[256 * 1024];
+
+  xcb_flush(conn);
+  ssize_t len = server_read(buf, sizeof(buf));
+
+  uint32_t count = 0;
+  for (ssize_t pos = 0; pos + 4 <= len;) {
+    uint16_t units;
+    memcpy(&units, buf + pos + 2, sizeof(units));
+    if (units == 0)
+      break; /* no big requests here */
+
+    if (buf[pos] == major && (minor < 0 || buf[pos + 1] == minor)) {
+      count++;
+      if (major == XCB_CONFIGURE_WINDOW)
+        memcpy(&last_configure_mask, buf + pos + 8, sizeof(last_configure_mask));
+    }
+    pos += (ssize_t) units * 4;
+  }
+  return count;
+}
+
+uint16_t
+fake_xcb_last_configure_mask(void)
+{
+  return last_configure_mask;
+}
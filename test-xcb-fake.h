@@ -0,0 +1,38 @@
+/*
+ * test-xcb-fake.h - In-process X connection for tests
+ *
+ * Connects XCB to one end of a socketpair whose other end plays the X
+ * server: it answers the connection setup and, optionally, the RandR
+ * extension query, then only listens. Requests the code under test sends can then be read
+ * back and counted; replies are fed to continuations by hand with
+ * xcb_reply_complete().
+ */
+
+#ifndef TEST_XCB_FAKE_H
+#define TEST_XCB_FAKE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+/* Major opcode the fake server assigns to RandR */
+#define FAKE_XCB_RANDR_OPCODE 140
+
+/*
+ * Connect. With randr set, RandR is reported present and its extension
+ * query is answered before this returns. Returns NULL on failure.
+ */
+xcb_connection_t* fake_xcb_connect(bool randr);
+void              fake_xcb_disconnect(xcb_connection_t* conn);
+
+/*
+ * Flush conn and read everything sent since the last call. Returns the
+ * number of requests with the given major opcode (and minor opcode, for
+ * extension requests; pass -1 to match any).
+ */
+uint32_t fake_xcb_count_requests(xcb_connection_t* conn, uint8_t major, int minor);
+
+/* Value mask of the last ConfigureWindow counted, 0 if none */
+uint16_t fake_xcb_last_configure_mask(void);
+
+#endif /* TEST_XCB_FAKE_H */
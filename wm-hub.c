@@ -6,79 +6,281 @@
 
 #include "wm-log.h"
 
-/* Registry data structures */
-#define MAX_COMPONENTS    64
-#define MAX_TARGETS       256
-#define MAX_REQUEST_TYPES 256
-#define MAX_TARGET_TYPES  16
-
-static HubComponent* components[MAX_COMPONENTS];
-static uint32_t      component_count = 0;
+/*
+ * Registry data structures
+ *
+ * Components, target types and targets live in arrays that grow on demand
+ * (doubling from REGISTRY_INITIAL_CAPACITY), so memory follows what is
+ * actually registered and there is no fixed limit.
+ *
+ * Target types are stored in fixed-size chunks: growing never moves an
+ * entry, so HubTargetType pointers handed out stay valid. Targets sit in a
+ * slot array; target->slot is their handle, and slots freed by
+ * unregistration are reused, which keeps insert and remove O(1).
+ */
+#define MAX_REQUEST_TYPES         256
+#define REGISTRY_INITIAL_CAPACITY 16
+#define TYPE_CHUNK_SHIFT          4
+#define TYPE_CHUNK_SIZE           (1U << TYPE_CHUNK_SHIFT)
 
-/* Component lookup by name */
-typedef struct {
-  const char*   name;
-  HubComponent* comp;
-} component_name_entry_t;
+static HubComponent** components         = NULL;
+static uint32_t       component_count    = 0;
+static uint32_t       component_capacity = 0;
 
-static component_name_entry_t component_by_name[MAX_COMPONENTS];
-static uint32_t               name_entry_count = 0;
+/* Component lookup by name atom (array indexed by NameAtom) */
+static HubComponent** component_by_atom          = NULL;
+static uint32_t       component_by_atom_capacity = 0;
 
 /* Component lookup by request type (array indexed by RequestType) */
 static HubComponent* component_by_request_type[MAX_REQUEST_TYPES];
 
-/* Target type registry */
-static HubTargetType target_types[MAX_TARGET_TYPES];
-static uint32_t      target_type_count = 0;
-
-/* Target type lookup by name */
-static HubTargetType* target_type_by_name[MAX_TARGET_TYPES];
-static uint32_t       target_type_name_count = 0;
+/* Target type registry - a type and everything kept per type */
+typedef struct target_type_entry {
+  HubTargetType   type;
+  HubTarget**     targets; /* NULL-terminated, NULL until the first target */
+  uint32_t        target_count;
+  uint32_t        target_capacity;
+  HubComponent**  adopters; /* accepting components, NULL-terminated */
+  uint32_t        adopter_count;
+  uint32_t        adopter_capacity;
+  RelayoutHandler relayout; /* see hub_register_relayout_handler() */
+} target_type_entry_t;
+
+static target_type_entry_t** type_chunks         = NULL;
+static uint32_t              type_chunk_count    = 0;
+static uint32_t              type_chunk_capacity = 0;
+static uint32_t              target_type_count   = 0;
+
+/* Target type lookup by name atom: type ID + 1, 0 for none */
+static uint32_t* type_by_atom          = NULL;
+static uint32_t  type_by_atom_capacity = 0;
+
+/* Returned for registered types that have no targets or adopters */
+static HubTarget*    no_targets[1]  = { NULL };
+static HubComponent* no_adopters[1] = { NULL };
+
+/* Target registry - slots indexed by target->slot, NULL when free */
+static HubTarget** target_slots       = NULL;
+static uint32_t    slot_count         = 0; /* slots ever handed out */
+static uint32_t    slot_capacity      = 0;
+static uint32_t*   free_slots         = NULL; /* stack of freed slots */
+static uint32_t    free_slot_count    = 0;
+static uint32_t    free_slot_capacity = 0;
+static uint32_t    target_count       = 0;
 
-/* Target registry */
-static HubTarget* targets[MAX_TARGETS];
-static uint32_t   target_count = 0;
-
-/* Target lookup by ID - use hash map for TargetID (uint64_t) beyond MAX_TARGETS */
-#define TARGET_ID_MAP_SIZE 512
+/*
+ * Target lookup by ID - open-addressing hash map for arbitrary TargetID
+ * (uint64_t) values. Robin Hood linear probing: an entry never sits further
+ * from its home slot than the entry it displaced, so a lookup stops as soon
+ * as it passes where the ID would have been. Deletion shifts the rest of the
+ * probe run back, so there are no tombstones. id == TARGET_ID_NONE marks an
+ * empty slot.
+ */
+#define TARGET_ID_MAP_INITIAL_CAPACITY 64
 
 typedef struct target_id_entry {
-  TargetID                id;
-  HubTarget*              target;
-  struct target_id_entry* next;
+  TargetID   id;
+  HubTarget* target;
 } target_id_entry_t;
 
-static target_id_entry_t* target_by_id_map[TARGET_ID_MAP_SIZE];
+static target_id_entry_t* target_by_id_map          = NULL;
+static uint32_t           target_by_id_map_capacity = 0; /* power of two */
 
 static uint32_t
 target_id_hash(TargetID id)
 {
-  /* Simple hash function for TargetID */
-  return (uint32_t) ((id ^ (id >> 16)) % TARGET_ID_MAP_SIZE);
+  /* XIDs share their high bits per client: mix every bit into the low ones */
+  uint64_t h = id * 0x9E3779B97F4A7C15ULL;
+  return (uint32_t) (h ^ (h >> 32));
+}
+
+/* How far the entry in slot i sits from its home slot */
+static uint32_t
+target_id_distance(uint32_t i)
+{
+  return (i - target_id_hash(target_by_id_map[i].id)) & (target_by_id_map_capacity - 1);
 }
 
-/* Targets grouped by type ID (array of arrays) */
-static HubTarget* targets_by_type[MAX_TARGET_TYPES][MAX_TARGETS];
-static uint32_t   targets_by_type_count[MAX_TARGET_TYPES];
+/* Deferred relayout - dirty targets in mark order */
+static TargetID*        dirty_targets  = NULL;
+static uint32_t         dirty_count    = 0;
+static uint32_t         dirty_capacity = 0;
+static HubRelayoutStats relayout_stats;
+
+/* Result buffer handed out by hub_get_all_target_types() */
+static HubTargetType** all_types_result          = NULL;
+static uint32_t        all_types_result_capacity = 0;
 
 /* Event Bus - maximum number of event types */
 #define MAX_EVENT_TYPES 64
 
-/* Event Bus - maximum subscribers per event type */
-#define MAX_SUBSCRIBERS 16
-
-/* Event Bus - subscription array per event type */
+/*
+ * Event Bus - subscribers of one event type, or of one (type, target).
+ * While a delivery walks a list, removed entries keep a NULL handler and
+ * are compacted once no delivery is running.
+ */
+typedef struct subscriber_list_t {
+  struct Subscriber* entries;
+  uint32_t           count;
+  uint32_t           capacity;
+  uint32_t           delivering; /* deliveries walking the list */
+  uint32_t           removed;    /* NULL entries awaiting compaction */
+} subscriber_list_t;
+
+/* Event Bus - subscriptions to every target, per event type */
 static struct {
-  struct Subscriber subscribers[MAX_SUBSCRIBERS];
-  int               count;
-} subscribers[MAX_EVENT_TYPES];
+  subscriber_list_t list;
+  bool              coalesce; /* hub_post() folds by (type, target) */
+} event_types[MAX_EVENT_TYPES];
+
+/*
+ * Event Bus - target-scoped subscriptions, one list per (type, target).
+ * Each list is allocated on its own so a delivery can keep walking it
+ * while a handler unregisters the target: the list is then detached from
+ * the index and freed when that delivery returns.
+ */
+typedef struct target_subscription_t {
+  EventType         type;
+  TargetID          target;
+  subscriber_list_t list;
+  bool              detached;
+} target_subscription_t;
+
+#define TARGET_SUBSCRIPTION_MAP_INITIAL_CAPACITY 64
+
+/* (type, target) -> list, open addressing with linear probing */
+static target_subscription_t** target_subscription_map          = NULL;
+static uint32_t                target_subscription_map_capacity = 0; /* power of two */
+static uint32_t                target_subscription_count        = 0;
+
+/*
+ * Bumped by every subscribe. A delivery only calls subscribers whose
+ * generation is not newer than the bus generation when it started.
+ */
+static uint64_t event_generation = 0;
+
+/* Queued delivery - ring buffer of posted events, capacity a power of two */
+typedef struct queued_event_t {
+  EventType type;
+  TargetID  target;
+  void*     data;
+} queued_event_t;
+
+#define EVENT_QUEUE_INITIAL_CAPACITY 64
+#define SETTLE_MAX_ROUNDS            16
+
+static queued_event_t* event_queue          = NULL;
+static uint32_t        event_queue_head     = 0;
+static uint32_t        event_queue_count    = 0;
+static uint32_t        event_queue_capacity = 0;
+static uint32_t*       event_queue_index    = NULL; /* ring slot + 1 by (type, target), 0 if free */
+static int             emit_depth           = 0; /* nested deliveries */
+static int             batch_depth          = 0; /* open request batches */
+static bool            draining             = false;
+static bool            deferred             = false; /* the loop drains once per iteration */
+static HubEventStats   event_stats;
+
+/* Request queue - requests waiting for hub_run_queued_requests(), in order */
+typedef struct queued_request_t {
+  struct HubRequest request;
+  uint32_t          merged_into; /* index of the request that runs for it */
+} queued_request_t;
+
+#define REQUEST_NOT_MERGED UINT32_MAX
+
+static queued_request_t* request_queue          = NULL;
+static uint32_t          request_queue_count    = 0;
+static uint32_t          request_queue_capacity = 0;
+static bool              request_merging[MAX_REQUEST_TYPES];
+static HubRequestStats   request_stats;
 
 /* Forward declarations */
 static void       component_add_to_request_type_index(HubComponent* comp);
-static void       target_by_id_map_insert(HubTarget* target);
+static bool       target_by_id_map_insert(HubTarget* target);
 static void       target_by_id_map_remove(TargetID id);
 static HubTarget* target_by_id_map_lookup(TargetID id);
 static uint32_t   resolve_target_type_id(uint32_t legacy_id);
+static void       target_subscriptions_drop(HubTarget* target);
+
+/*
+ * Make room for need items of the given size, doubling the capacity.
+ * Returns false (leaving the array untouched) if memory runs out.
+ */
+static bool
+registry_reserve(void** items, uint32_t* capacity, uint32_t need, size_t size)
+{
+  if (need <= *capacity)
+    return true;
+
+  uint32_t grown = *capacity > 0 ? *capacity : REGISTRY_INITIAL_CAPACITY;
+  while (grown < need)
+    grown *= 2;
+
+  void* resized = realloc(*items, (size_t) grown * size);
+  if (resized == NULL) {
+    LOG_ERROR("Failed to grow hub registry to %u entries", grown);
+    return false;
+  }
+
+  *items    = resized;
+  *capacity = grown;
+  return true;
+}
+
+static target_type_entry_t*
+type_entry(uint32_t id)
+{
+  return &type_chunks[id >> TYPE_CHUNK_SHIFT][id & (TYPE_CHUNK_SIZE - 1)];
+}
+
+/* Make an atom-indexed array cover atom, zero-filling the new part */
+static bool
+atom_index_reserve(void** items, uint32_t* capacity, NameAtom atom, size_t size)
+{
+  uint32_t old_capacity = *capacity;
+  if (!registry_reserve(items, capacity, atom + 1, size))
+    return false;
+
+  memset((char*) *items + (size_t) old_capacity * size, 0, (size_t) (*capacity - old_capacity) * size);
+  return true;
+}
+
+/*
+ * Adoption lists: the components accepting each target type, kept up to
+ * date as components and types register, so adopting a target is a walk
+ * over one array.
+ */
+static void
+adopters_add(target_type_entry_t* entry, HubComponent* comp)
+{
+  for (uint32_t i = 0; i < entry->adopter_count; i++) {
+    if (entry->adopters[i] == comp)
+      return;
+  }
+
+  if (!registry_reserve((void**) &entry->adopters, &entry->adopter_capacity,
+                        entry->adopter_count + 2, sizeof(*entry->adopters))) {
+    LOG_ERROR("Component '%s' will not adopt '%s' targets", comp->name, entry->type.name);
+    return;
+  }
+
+  entry->adopters[entry->adopter_count++] = comp;
+  entry->adopters[entry->adopter_count]   = NULL;
+}
+
+static void
+adopters_remove(target_type_entry_t* entry, HubComponent* comp)
+{
+  for (uint32_t i = 0; i < entry->adopter_count; i++) {
+    if (entry->adopters[i] == comp) {
+      /* Shift down to keep registration order; includes the NULL terminator */
+      memmove(&entry->adopters[i], &entry->adopters[i + 1],
+              (entry->adopter_count - i) * sizeof(*entry->adopters));
+      entry->adopter_count--;
+      return;
+    }
+  }
+}
 
 /*
  * Clear all registry state.
@@ -87,29 +289,93 @@ static uint32_t   resolve_target_type_id(uint32_t legacy_id);
 static void
 clear_registry_state(void)
 {
-  /* Clear component arrays */
-  memset(components, 0, sizeof(components));
-  memset(component_by_name, 0, sizeof(component_by_name));
+  /* Free component arrays */
+  free(components);
+  free(component_by_atom);
+  components                 = NULL;
+  component_by_atom          = NULL;
+  component_capacity         = 0;
+  component_by_atom_capacity = 0;
   memset(component_by_request_type, 0, sizeof(component_by_request_type));
 
-  /* Clear target type arrays */
-  memset(target_types, 0, sizeof(target_types));
-  memset(target_type_by_name, 0, sizeof(target_type_by_name));
-  target_type_count      = 0;
-  target_type_name_count = 0;
-
-  /* Clear target arrays */
-  memset(targets, 0, sizeof(targets));
-  memset(target_by_id_map, 0, sizeof(target_by_id_map));
-  memset(targets_by_type, 0, sizeof(targets_by_type));
-  memset(targets_by_type_count, 0, sizeof(targets_by_type_count));
-
-  /* Clear event bus subscriber arrays */
-  memset(subscribers, 0, sizeof(subscribers));
-
-  component_count  = 0;
-  name_entry_count = 0;
-  target_count     = 0;
+  /* Free target types and their per-type lists */
+  for (uint32_t i = 0; i < target_type_count; i++) {
+    free(type_entry(i)->targets);
+    free(type_entry(i)->adopters);
+  }
+  for (uint32_t i = 0; i < type_chunk_count; i++)
+    free(type_chunks[i]);
+  free(type_chunks);
+  type_chunks         = NULL;
+  type_chunk_count    = 0;
+  type_chunk_capacity = 0;
+  target_type_count   = 0;
+  free(type_by_atom);
+  type_by_atom          = NULL;
+  type_by_atom_capacity = 0;
+
+  /* Free target slots */
+  free(target_slots);
+  free(free_slots);
+  target_slots       = NULL;
+  free_slots         = NULL;
+  slot_count         = 0;
+  slot_capacity      = 0;
+  free_slot_count    = 0;
+  free_slot_capacity = 0;
+  free(target_by_id_map);
+  target_by_id_map          = NULL;
+  target_by_id_map_capacity = 0;
+
+  /* Clear deferred relayout state */
+  free(dirty_targets);
+  dirty_targets  = NULL;
+  dirty_count    = 0;
+  dirty_capacity = 0;
+  memset(&relayout_stats, 0, sizeof(relayout_stats));
+
+  free(all_types_result);
+  all_types_result          = NULL;
+  all_types_result_capacity = 0;
+
+  /* Clear event bus subscriber lists and queue */
+  for (uint32_t i = 0; i < MAX_EVENT_TYPES; i++)
+    free(event_types[i].list.entries);
+  memset(event_types, 0, sizeof(event_types));
+  for (uint32_t i = 0; i < target_subscription_map_capacity; i++) {
+    if (target_subscription_map[i] != NULL) {
+      free(target_subscription_map[i]->list.entries);
+      free(target_subscription_map[i]);
+    }
+  }
+  free(target_subscription_map);
+  target_subscription_map          = NULL;
+  target_subscription_map_capacity = 0;
+  target_subscription_count        = 0;
+  event_generation = 0;
+  free(event_queue);
+  free(event_queue_index);
+  event_queue          = NULL;
+  event_queue_index    = NULL;
+  event_queue_head     = 0;
+  event_queue_count    = 0;
+  event_queue_capacity = 0;
+  emit_depth           = 0;
+  batch_depth          = 0;
+  draining             = false;
+  deferred             = false;
+  memset(&event_stats, 0, sizeof(event_stats));
+
+  /* Clear the request queue */
+  free(request_queue);
+  request_queue          = NULL;
+  request_queue_count    = 0;
+  request_queue_capacity = 0;
+  memset(request_merging, 0, sizeof(request_merging));
+  memset(&request_stats, 0, sizeof(request_stats));
+
+  component_count = 0;
+  target_count    = 0;
 }
 
 void
@@ -137,28 +403,61 @@ hub_register_target_type(const char* name, HubComponent* owner)
     return NULL;
   }
 
+  NameAtom atom = name_intern(name);
+  if (atom == NAME_ATOM_NONE)
+    return NULL;
+
   /* Check if type already exists */
-  HubTargetType* existing = hub_get_target_type_by_name(name);
+  HubTargetType* existing = hub_get_target_type_by_atom(atom);
   if (existing != NULL) {
     LOG_DEBUG("Target type '%s' already registered", name);
     return existing;
   }
 
-  if (target_type_count >= MAX_TARGET_TYPES) {
-    LOG_ERROR("Maximum number of target types reached (%d)", MAX_TARGET_TYPES);
+  if (!atom_index_reserve((void**) &type_by_atom, &type_by_atom_capacity, atom, sizeof(*type_by_atom)))
     return NULL;
+
+  /* Start a new chunk when the last one is full */
+  if (target_type_count == type_chunk_count * TYPE_CHUNK_SIZE) {
+    if (!registry_reserve((void**) &type_chunks, &type_chunk_capacity,
+                          type_chunk_count + 1, sizeof(*type_chunks)))
+      return NULL;
+
+    type_chunks[type_chunk_count] = calloc(TYPE_CHUNK_SIZE, sizeof(target_type_entry_t));
+    if (type_chunks[type_chunk_count] == NULL) {
+      LOG_ERROR("Failed to allocate target types");
+      return NULL;
+    }
+    type_chunk_count++;
   }
 
   /* Create new target type */
-  HubTargetType* tt = &target_types[target_type_count++];
+  HubTargetType* tt = &type_entry(target_type_count)->type;
   tt->name          = name;
-  tt->id            = target_type_count - 1; /* 0-indexed ID */
+  tt->atom          = atom;
+  tt->id            = target_type_count++; /* 0-indexed ID */
   tt->owner         = owner;
   tt->reserved      = true;
 
-  /* Add to name index */
-  if (target_type_name_count < MAX_TARGET_TYPES) {
-    target_type_by_name[target_type_name_count++] = tt;
+  type_by_atom[atom] = tt->id + 1;
+
+  /* Components registered earlier may accept this type by name */
+  for (uint32_t i = 0; i < component_count; i++) {
+    HubComponent* comp = components[i];
+    if (comp->accepted_target_names == NULL || comp->accepted_targets == NULL)
+      continue;
+
+    for (uint32_t j = 0; comp->accepted_target_names[j] != NULL; j++) {
+      if (name_atom_find(comp->accepted_target_names[j]) == atom) {
+        /* accepted_targets has room for every name, resolved or not */
+        uint32_t k = 0;
+        while (comp->accepted_targets[k] != NULL)
+          k++;
+        comp->accepted_targets[k] = tt;
+        adopters_add(type_entry(tt->id), comp);
+        break;
+      }
+    }
   }
 
   LOG_DEBUG("Registered target type: name='%s', id=%u", name, tt->id);
@@ -172,16 +471,33 @@ hub_register_target_type(const char* name, HubComponent* owner)
 HubTargetType*
 hub_get_target_type_by_name(const char* name)
 {
-  if (name == NULL)
+  return hub_get_target_type_by_atom(name_atom_find(name));
+}
+
+/*
+ * Get a target type by name atom.
+ * Returns NULL if not found.
+ */
+HubTargetType*
+hub_get_target_type_by_atom(NameAtom atom)
+{
+  if (atom >= type_by_atom_capacity || type_by_atom[atom] == 0)
     return NULL;
 
-  for (uint32_t i = 0; i < target_type_name_count; i++) {
-    HubTargetType* tt = target_type_by_name[i];
-    if (tt != NULL && tt->name != NULL && strcmp(tt->name, name) == 0) {
-      return tt;
-    }
-  }
-  return NULL;
+  return &type_entry(type_by_atom[atom] - 1)->type;
+}
+
+/*
+ * Get a target type ID by name atom.
+ * Returns TARGET_TYPE_INVALID if not found.
+ */
+uint32_t
+hub_get_target_type_id_by_atom(NameAtom atom)
+{
+  if (atom >= type_by_atom_capacity || type_by_atom[atom] == 0)
+    return TARGET_TYPE_INVALID;
+
+  return type_by_atom[atom] - 1;
 }
 
 /*
@@ -205,7 +521,7 @@ hub_get_target_type_by_id(uint32_t id)
   if (id >= target_type_count)
     return NULL;
 
-  return &target_types[id];
+  return &type_entry(id)->type;
 }
 
 /*
@@ -216,17 +532,23 @@ hub_get_target_type_by_id(uint32_t id)
 HubTargetType**
 hub_get_all_target_types(uint32_t* count)
 {
-  static HubTargetType* result[MAX_TARGET_TYPES];
-
   if (count != NULL) {
     *count = target_type_count;
   }
 
+  if (!registry_reserve((void**) &all_types_result, &all_types_result_capacity,
+                        target_type_count + 1, sizeof(*all_types_result))) {
+    if (count != NULL)
+      *count = 0;
+    return NULL;
+  }
+
   for (uint32_t i = 0; i < target_type_count; i++) {
-    result[i] = &target_types[i];
+    all_types_result[i] = &type_entry(i)->type;
   }
+  all_types_result[target_type_count] = NULL;
 
-  return result;
+  return all_types_result;
 }
 
 /*
@@ -241,8 +563,7 @@ static uint32_t
 resolve_target_type_id(uint32_t legacy_id)
 {
   /* If we have a registered type at this index, use it */
-  if (target_type_count > 0 && legacy_id < target_type_count &&
-      target_types[legacy_id].reserved) {
+  if (legacy_id < target_type_count && type_entry(legacy_id)->type.reserved) {
     return legacy_id;
   }
 
@@ -263,8 +584,13 @@ hub_register_component(HubComponent* comp)
     return;
   }
 
-  if (component_count >= MAX_COMPONENTS) {
-    LOG_ERROR("Maximum number of components reached (%d)", MAX_COMPONENTS);
+  NameAtom atom = name_intern(comp->name);
+
+  if (!registry_reserve((void**) &components, &component_capacity,
+                        component_count + 1, sizeof(*components)) ||
+      !atom_index_reserve((void**) &component_by_atom, &component_by_atom_capacity,
+                          atom, sizeof(*component_by_atom))) {
+    LOG_ERROR("Cannot register component '%s'", comp->name);
     return;
   }
 
@@ -286,6 +612,7 @@ hub_register_component(HubComponent* comp)
         HubTargetType* tt   = hub_get_target_type_by_name(name);
         if (tt != NULL) {
           comp->accepted_targets[j++] = tt;
+          adopters_add(type_entry(tt->id), comp);
           LOG_DEBUG("Component '%s' accepts target type '%s' (id=%u)",
                     comp->name, name, tt->id);
         } else {
@@ -301,14 +628,12 @@ hub_register_component(HubComponent* comp)
 
   /* Add to main component array */
   components[component_count++] = comp;
+  comp->atom                    = atom;
   comp->registered              = true;
 
-  /* Add to name index */
-  if (name_entry_count < MAX_COMPONENTS) {
-    component_by_name[name_entry_count].name = comp->name;
-    component_by_name[name_entry_count].comp = comp;
-    name_entry_count++;
-  }
+  /* Add to name index; the first component registered under a name wins */
+  if (atom != NAME_ATOM_NONE && component_by_atom[atom] == NULL)
+    component_by_atom[atom] = comp;
 
   /* Add to request type index */
   component_add_to_request_type_index(comp);
@@ -371,17 +696,22 @@ hub_unregister_component(const char* name)
     }
   }
 
-  /* Remove from name index */
-  for (uint32_t i = 0; i < name_entry_count; i++) {
-    if (component_by_name[i].comp == comp) {
-      /* Swap with last and decrement */
-      component_by_name[i] = component_by_name[name_entry_count - 1];
-      name_entry_count--;
-      break;
+  /* Remove from name index, handing the name to another component using it */
+  if (component_by_atom[comp->atom] == comp) {
+    component_by_atom[comp->atom] = NULL;
+    for (uint32_t i = 0; i < component_count; i++) {
+      if (components[i]->atom == comp->atom) {
+        component_by_atom[comp->atom] = components[i];
+        break;
+      }
     }
   }
 
-  /* Free accepted_targets array if allocated */
+  /* Remove from adoption lists and free accepted_targets array if allocated */
+  if (comp->accepted_targets != NULL) {
+    for (uint32_t i = 0; comp->accepted_targets[i] != NULL; i++)
+      adopters_remove(type_entry(comp->accepted_targets[i]->id), comp);
+  }
   free(comp->accepted_targets);
   comp->accepted_targets = NULL;
 
@@ -392,16 +722,16 @@ hub_unregister_component(const char* name)
 HubComponent*
 hub_get_component_by_name(const char* name)
 {
-  if (name == NULL)
+  return hub_get_component_by_atom(name_atom_find(name));
+}
+
+HubComponent*
+hub_get_component_by_atom(NameAtom atom)
+{
+  if (atom == NAME_ATOM_NONE || atom >= component_by_atom_capacity)
     return NULL;
 
-  for (uint32_t i = 0; i < name_entry_count; i++) {
-    if (component_by_name[i].name != NULL &&
-        strcmp(component_by_name[i].name, name) == 0) {
-      return component_by_name[i].comp;
-    }
-  }
-  return NULL;
+  return component_by_atom[atom];
 }
 
 HubComponent*
@@ -416,52 +746,27 @@ hub_get_component_by_request_type(RequestType type)
 /*
  * Get all components that accept a specific target type ID.
  * Returns a NULL-terminated array of components.
- * The array is owned by the hub and should not be modified or freed.
+ * The array is owned by the hub and should not be modified or freed; it
+ * changes when a component accepting the type registers or unregisters.
  * Returns NULL for invalid type IDs.
  */
 HubComponent**
 hub_get_components_for_target_type(TargetTypeId type_id)
 {
-  static HubComponent* results[MAX_COMPONENTS + 1];
-  static uint32_t      result_count = 0;
-
   /* Check for invalid type_id (sentinel value) */
   if (type_id == TARGET_TYPE_INVALID) {
     return NULL;
   }
 
   /* Check if type_id is in valid range */
-  if (type_id >= target_type_count || !target_types[type_id].reserved) {
+  if (type_id >= target_type_count || !type_entry(type_id)->type.reserved) {
     return NULL;
   }
 
   /* Resolve type_id to actual registered type */
-  uint32_t resolved_id = resolve_target_type_id(type_id);
+  target_type_entry_t* entry = type_entry(resolve_target_type_id(type_id));
 
-  /* Clear the results array */
-  memset(results, 0, sizeof(results));
-  result_count = 0;
-
-  for (uint32_t i = 0; i < component_count; i++) {
-    HubComponent* comp = components[i];
-    if (comp == NULL)
-      continue;
-
-    /* Check accepted_target_names for a match */
-    if (comp->accepted_target_names != NULL) {
-      for (uint32_t j = 0; comp->accepted_target_names[j] != NULL; j++) {
-        HubTargetType* tt = hub_get_target_type_by_name(comp->accepted_target_names[j]);
-        if (tt != NULL && tt->id == resolved_id) {
-          if (result_count < MAX_COMPONENTS) {
-            results[result_count++] = comp;
-          }
-          break;
-        }
-      }
-    }
-  }
-  results[result_count] = NULL;
-  return results;
+  return entry->adopters != NULL ? entry->adopters : no_adopters;
 }
 
 /*
@@ -541,11 +846,6 @@ hub_register_target(HubTarget* target)
     return;
   }
 
-  if (target_count >= MAX_TARGETS) {
-    LOG_ERROR("Maximum number of targets reached (%d)", MAX_TARGETS);
-    return;
-  }
-
   if (target->id == TARGET_ID_NONE) {
     LOG_ERROR("Cannot register target with ID NONE");
     return;
@@ -560,22 +860,41 @@ hub_register_target(HubTarget* target)
     return;
   }
 
-  /* Add to main target array */
-  targets[target_count++] = target;
-  target->registered      = true;
-  target->type_id         = resolved_type; /* Store resolved ID */
+  if (resolved_type == TARGET_TYPE_INVALID) {
+    LOG_ERROR("Target %" PRIu64 " has unknown type %u", target->id, target->type_id);
+    return;
+  }
+
+  /* Reserve room first so a failed allocation leaves no partial state */
+  target_type_entry_t* entry = type_entry(resolved_type);
+  if (!registry_reserve((void**) &entry->targets, &entry->target_capacity,
+                        entry->target_count + 2, sizeof(*entry->targets)))
+    return;
+
+  if (free_slot_count == 0 &&
+      (!registry_reserve((void**) &target_slots, &slot_capacity,
+                         slot_count + 1, sizeof(*target_slots)) ||
+       !registry_reserve((void**) &free_slots, &free_slot_capacity,
+                         slot_count + 1, sizeof(*free_slots))))
+    return;
 
   /* Add to ID index (hash map for arbitrary TargetID values) */
-  target_by_id_map_insert(target);
+  if (!target_by_id_map_insert(target))
+    return;
+
+  /* Add to main target array, reusing a freed slot if there is one */
+  target->slot               = free_slot_count > 0 ? free_slots[--free_slot_count] : slot_count++;
+  target_slots[target->slot] = target;
+  target_count++;
+  target->registered    = true;
+  target->dirty         = false;
+  target->subscriptions = 0;
+  target->type_id       = resolved_type; /* Store resolved ID */
 
   /* Add to type index with NULL terminator */
-  if (targets_by_type_count[resolved_type] < MAX_TARGETS) {
-    targets_by_type[resolved_type][targets_by_type_count[resolved_type]++] = target;
-    /* Ensure NULL terminator */
-    if (targets_by_type_count[resolved_type] < MAX_TARGETS) {
-      targets_by_type[resolved_type][targets_by_type_count[resolved_type]] = NULL;
-    }
-  }
+  target->type_index                    = entry->target_count;
+  entry->targets[entry->target_count++] = target;
+  entry->targets[entry->target_count]   = NULL;
 
   LOG_DEBUG("Registered target: id=%" PRIu64 ", type_id=%u", target->id, target->type_id);
 
@@ -597,34 +916,27 @@ hub_unregister_target(TargetID id)
     return;
   }
 
-  uint32_t type_id = target->type_id;
+  target_type_entry_t* entry = type_entry(target->type_id);
 
-  /* Remove from type index */
-  for (uint32_t i = 0; i < targets_by_type_count[type_id]; i++) {
-    if (targets_by_type[type_id][i] == target) {
-      targets_by_type[type_id][i] =
-          targets_by_type[type_id][targets_by_type_count[type_id] - 1];
-      targets_by_type_count[type_id]--;
-      /* Clear vacated slot and ensure NULL terminator */
-      targets_by_type[type_id][targets_by_type_count[type_id]] = NULL;
-      break;
-    }
-  }
+  /* Remove from type index: the last target takes its place */
+  HubTarget* last                     = entry->targets[--entry->target_count];
+  entry->targets[target->type_index]  = last;
+  last->type_index                    = target->type_index;
+  entry->targets[entry->target_count] = NULL; /* NULL terminator */
 
   /* Unadopt all compatible components before unregistering */
   hub_unadopt_components_for_target(target);
 
+  /* Its scoped subscriptions go with it */
+  target_subscriptions_drop(target);
+
   /* Remove from ID index */
   target_by_id_map_remove(id);
 
-  /* Remove from main target array */
-  for (uint32_t i = 0; i < target_count; i++) {
-    if (targets[i] == target) {
-      targets[i] = targets[target_count - 1];
-      target_count--;
-      break;
-    }
-  }
+  /* Release the target's slot */
+  target_slots[target->slot]    = NULL;
+  free_slots[free_slot_count++] = target->slot;
+  target_count--;
 
   target->registered = false;
   LOG_DEBUG("Unregistered target: id=%" PRIu64, id);
@@ -648,21 +960,16 @@ hub_get_targets_by_type(TargetTypeId type_id)
   }
 
   /* Check if type_id is valid - must be within range and have a registered type */
-  if (type_id >= target_type_count || !target_types[type_id].reserved) {
+  if (type_id >= target_type_count || !type_entry(type_id)->type.reserved) {
     /* Invalid type_id or type not registered */
     return NULL;
   }
 
   /* Resolve type_id to actual registered type */
-  uint32_t resolved_id = resolve_target_type_id(type_id);
-
-  /* Ensure NULL terminator is set */
-  if (targets_by_type_count[resolved_id] < MAX_TARGETS) {
-    targets_by_type[resolved_id][targets_by_type_count[resolved_id]] = NULL;
-  }
+  target_type_entry_t* entry = type_entry(resolve_target_type_id(type_id));
 
   /* Return pointer to the array - caller should not modify */
-  return targets_by_type[resolved_id];
+  return entry->targets != NULL ? entry->targets : no_targets;
 }
 
 HubTarget**
@@ -693,6 +1000,94 @@ hub_target_type_count(void)
   return target_type_count;
 }
 
+/*
+ * Deferred Relayout
+ *
+ * Dirty targets are kept by ID, so a target unregistered before the end of
+ * the batch is simply skipped when the scheduled relayouts run.
+ */
+
+void
+hub_register_relayout_handler(TargetTypeId type_id, RelayoutHandler handler)
+{
+  if (type_id >= target_type_count) {
+    LOG_ERROR("Cannot register relayout handler for invalid type %u", type_id);
+    return;
+  }
+
+  type_entry(type_id)->relayout = handler;
+}
+
+void
+hub_unregister_relayout_handler(TargetTypeId type_id)
+{
+  if (type_id >= target_type_count)
+    return;
+
+  type_entry(type_id)->relayout = NULL;
+}
+
+void
+hub_schedule_relayout(TargetID id)
+{
+  relayout_stats.requested++;
+
+  HubTarget* target = hub_get_target_by_id(id);
+  if (target == NULL || target->dirty)
+    return;
+
+  if (!registry_reserve((void**) &dirty_targets, &dirty_capacity,
+                        dirty_count + 1, sizeof(*dirty_targets)))
+    return;
+
+  target->dirty                = true;
+  dirty_targets[dirty_count++] = id;
+}
+
+void
+hub_run_scheduled_relayouts(void)
+{
+  /* Targets marked dirty by a relayout handler wait for the next batch */
+  uint32_t count = dirty_count;
+
+  for (uint32_t i = 0; i < count; i++) {
+    HubTarget* target = hub_get_target_by_id(dirty_targets[i]);
+    if (target == NULL || !target->dirty)
+      continue;
+
+    target->dirty = false;
+
+    RelayoutHandler handler = type_entry(target->type_id)->relayout;
+    if (handler == NULL)
+      continue;
+
+    relayout_stats.executed++;
+    handler(target);
+  }
+
+  if (dirty_count > count)
+    memmove(dirty_targets, &dirty_targets[count], (dirty_count - count) * sizeof(TargetID));
+  dirty_count -= count;
+}
+
+uint32_t
+hub_pending_relayout_count(void)
+{
+  return dirty_count;
+}
+
+HubRelayoutStats
+hub_get_relayout_stats(void)
+{
+  return relayout_stats;
+}
+
+void
+hub_reset_relayout_stats(void)
+{
+  memset(&relayout_stats, 0, sizeof(relayout_stats));
+}
+
 /* Internal helper: add component to request type index */
 static void
 component_add_to_request_type_index(HubComponent* comp)
@@ -712,51 +1107,117 @@ component_add_to_request_type_index(HubComponent* comp)
 
 /* Hash map implementation for TargetID lookup */
 static void
+target_by_id_map_place(target_id_entry_t entry)
+{
+  uint32_t mask = target_by_id_map_capacity - 1;
+  uint32_t dist = 0;
+
+  for (uint32_t i = target_id_hash(entry.id) & mask;; i = (i + 1) & mask, dist++) {
+    if (target_by_id_map[i].id == TARGET_ID_NONE) {
+      target_by_id_map[i] = entry;
+      return;
+    }
+
+    /* Take the slot from an entry closer to home and carry that one on */
+    uint32_t resident = target_id_distance(i);
+    if (resident < dist) {
+      target_id_entry_t displaced = target_by_id_map[i];
+      target_by_id_map[i]         = entry;
+      entry                       = displaced;
+      dist                        = resident;
+    }
+  }
+}
+
+static bool
+target_by_id_map_grow(void)
+{
+  uint32_t           old_capacity = target_by_id_map_capacity;
+  target_id_entry_t* old_entries  = target_by_id_map;
+  uint32_t           new_capacity = old_capacity ? old_capacity * 2 : TARGET_ID_MAP_INITIAL_CAPACITY;
+
+  target_id_entry_t* new_entries = calloc(new_capacity, sizeof(target_id_entry_t));
+  if (new_entries == NULL) {
+    LOG_ERROR("Failed to grow target ID map to %u entries", new_capacity);
+    return false;
+  }
+
+  target_by_id_map          = new_entries;
+  target_by_id_map_capacity = new_capacity;
+
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old_entries[i].id != TARGET_ID_NONE)
+      target_by_id_map_place(old_entries[i]);
+  }
+
+  free(old_entries);
+  return true;
+}
+
+static bool
 target_by_id_map_insert(HubTarget* target)
 {
-  uint32_t           hash  = target_id_hash(target->id);
-  target_id_entry_t* entry = malloc(sizeof(target_id_entry_t));
-  if (entry == NULL) {
-    LOG_ERROR("Failed to allocate target ID map entry");
-    return;
+  /* Keep the load factor below 3/4 */
+  if ((target_count + 1) * 4 > target_by_id_map_capacity * 3 && !target_by_id_map_grow())
+    return false;
+
+  target_by_id_map_place((target_id_entry_t) { .id = target->id, .target = target });
+  return true;
+}
+
+static uint32_t
+target_by_id_map_find(TargetID id)
+{
+  if (target_by_id_map_capacity == 0)
+    return UINT32_MAX;
+
+  uint32_t mask = target_by_id_map_capacity - 1;
+  uint32_t dist = 0;
+
+  for (uint32_t i = target_id_hash(id) & mask;; i = (i + 1) & mask, dist++) {
+    if (target_by_id_map[i].id == id)
+      return i;
+    /* Empty, or the ID would have displaced this entry: not present */
+    if (target_by_id_map[i].id == TARGET_ID_NONE || target_id_distance(i) < dist)
+      return UINT32_MAX;
   }
-  entry->id              = target->id;
-  entry->target          = target;
-  entry->next            = target_by_id_map[hash];
-  target_by_id_map[hash] = entry;
 }
 
 static void
 target_by_id_map_remove(TargetID id)
 {
-  uint32_t            hash = target_id_hash(id);
-  target_id_entry_t** prev = &target_by_id_map[hash];
-  target_id_entry_t*  curr = *prev;
+  uint32_t hole = target_by_id_map_find(id);
+  if (hole == UINT32_MAX)
+    return;
 
-  while (curr != NULL) {
-    if (curr->id == id) {
-      *prev = curr->next;
-      free(curr);
-      return;
-    }
-    prev = &curr->next;
-    curr = curr->next;
+  /* Backward shift: pull the rest of the probe run one slot closer to home */
+  uint32_t mask = target_by_id_map_capacity - 1;
+  for (uint32_t i = (hole + 1) & mask;
+       target_by_id_map[i].id != TARGET_ID_NONE && target_id_distance(i) > 0;
+       i = (i + 1) & mask) {
+    target_by_id_map[hole] = target_by_id_map[i];
+    hole                   = i;
   }
+
+  target_by_id_map[hole].id     = TARGET_ID_NONE;
+  target_by_id_map[hole].target = NULL;
 }
 
 static HubTarget*
 target_by_id_map_lookup(TargetID id)
 {
-  uint32_t           hash = target_id_hash(id);
-  target_id_entry_t* curr = target_by_id_map[hash];
+  if (target_by_id_map_capacity == 0)
+    return NULL;
 
-  while (curr != NULL) {
-    if (curr->id == id) {
-      return curr->target;
-    }
-    curr = curr->next;
-  }
-  return NULL;
+  uint32_t mask = target_by_id_map_capacity - 1;
+  uint32_t i    = target_id_hash(id) & mask;
+
+  /* Most lookups hit their home slot */
+  if (target_by_id_map[i].id == id)
+    return target_by_id_map[i].target;
+
+  i = target_by_id_map_find(id);
+  return i != UINT32_MAX ? target_by_id_map[i].target : NULL;
 }
 
 /*
@@ -767,59 +1228,611 @@ target_by_id_map_lookup(TargetID id)
  * Other components subscribe to these events.
  */
 
-void
-hub_emit(EventType type, TargetID target, void* data)
+/*
+ * Subscriber lists
+ */
+
+/*
+ * Add a handler unless already present. Reuses an entry unsubscribed
+ * during the delivery in progress, else appends.
+ */
+static bool
+subscriber_list_add(subscriber_list_t* list, EventHandler handler, void* userdata)
 {
-  if (type >= MAX_EVENT_TYPES) {
-    return;
+  for (uint32_t i = 0; i < list->count; i++) {
+    if (list->entries[i].handler == handler)
+      return false;
   }
 
-  int count = subscribers[type].count;
-  if (count == 0) {
-    return;
+  uint32_t slot = list->count;
+  if (list->removed > 0) {
+    for (slot = 0; list->entries[slot].handler != NULL; slot++)
+      ;
+    list->removed--;
+  } else {
+    if (!registry_reserve((void**) &list->entries, &list->capacity, list->count + 1,
+                          sizeof(struct Subscriber)))
+      return false;
+    list->count++;
   }
 
-  /* Snapshot subscribers to safely handle unsubscribe during emit */
-  struct Subscriber snapshot[MAX_SUBSCRIBERS];
-  memcpy(snapshot, subscribers[type].subscribers, (size_t) count * sizeof(struct Subscriber));
-
-  for (int i = 0; i < count; i++) {
-    struct Event e = {
-      .type     = type,
-      .target   = target,
-      .data     = data,
-      .userdata = snapshot[i].userdata,
-    };
-    snapshot[i].handler(e);
-  }
+  list->entries[slot] = (struct Subscriber) {
+    .handler    = handler,
+    .userdata   = userdata,
+    .generation = ++event_generation,
+  };
+  return true;
 }
 
-void
-hub_subscribe(EventType type, EventHandler handler, void* userdata)
+static bool
+subscriber_list_remove(subscriber_list_t* list, EventHandler handler)
 {
-  if (type >= MAX_EVENT_TYPES) {
-    return;
-  }
+  for (uint32_t i = 0; i < list->count; i++) {
+    if (list->entries[i].handler != handler)
+      continue;
 
-  if (handler == NULL) {
-    return;
-  }
+    /* A delivery is walking the list: leave the entry for it to skip */
+    if (list->delivering > 0) {
+      list->entries[i].handler = NULL;
+      list->removed++;
+      return true;
+    }
 
-  int count = subscribers[type].count;
-  if (count >= MAX_SUBSCRIBERS) {
-    return;
+    /* Remove by shifting remaining subscribers */
+    memmove(&list->entries[i], &list->entries[i + 1],
+            (list->count - i - 1) * sizeof(struct Subscriber));
+    list->count--;
+    return true;
   }
+  return false;
+}
+
+/*
+ * Drop the entries removed while a delivery was running, keeping the
+ * order of the rest.
+ */
+static void
+subscriber_list_compact(subscriber_list_t* list)
+{
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < list->count; i++) {
+    if (list->entries[i].handler != NULL)
+      list->entries[kept++] = list->entries[i];
+  }
+  list->count   = kept;
+  list->removed = 0;
+}
+
+/*
+ * Call every subscriber of a list not newer than generation. Handlers may
+ * subscribe and unsubscribe: the list is walked by index and each entry
+ * is copied before its handler runs, as adding may move the entries.
+ */
+static void
+subscriber_list_deliver(subscriber_list_t* list, EventType type, TargetID target, void* data,
+                        uint64_t generation)
+{
+  list->delivering++;
+
+  for (uint32_t i = 0; i < list->count; i++) {
+    struct Subscriber sub = list->entries[i];
+    if (sub.handler == NULL || sub.generation > generation)
+      continue;
+
+    struct Event e = {
+      .type     = type,
+      .target   = target,
+      .data     = data,
+      .userdata = sub.userdata,
+    };
+    sub.handler(e);
+  }
+
+  list->delivering--;
+
+  if (list->delivering == 0 && list->removed > 0)
+    subscriber_list_compact(list);
+}
+
+/*
+ * Target-scoped subscription index
+ */
+
+static uint32_t
+target_subscription_hash(EventType type, TargetID target)
+{
+  return target_id_hash(target ^ ((uint64_t) type << 48));
+}
+
+static void
+target_subscription_place(target_subscription_t* ts)
+{
+  uint32_t mask = target_subscription_map_capacity - 1;
+  uint32_t i    = target_subscription_hash(ts->type, ts->target) & mask;
+  while (target_subscription_map[i] != NULL)
+    i = (i + 1) & mask;
+  target_subscription_map[i] = ts;
+}
+
+static bool
+target_subscription_map_grow(void)
+{
+  uint32_t new_capacity = target_subscription_map_capacity
+                            ? target_subscription_map_capacity * 2
+                            : TARGET_SUBSCRIPTION_MAP_INITIAL_CAPACITY;
+  target_subscription_t** old_map      = target_subscription_map;
+  uint32_t                old_capacity = target_subscription_map_capacity;
+
+  target_subscription_map = calloc(new_capacity, sizeof(target_subscription_t*));
+  if (target_subscription_map == NULL) {
+    LOG_ERROR("Failed to grow target subscription index to %u lists", new_capacity);
+    target_subscription_map = old_map;
+    return false;
+  }
+  target_subscription_map_capacity = new_capacity;
+
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old_map[i] != NULL)
+      target_subscription_place(old_map[i]);
+  }
+  free(old_map);
+  return true;
+}
+
+static bool
+target_subscription_insert(target_subscription_t* ts)
+{
+  /* Keep the load factor below 3/4 */
+  if ((target_subscription_count + 1) * 4 > target_subscription_map_capacity * 3 &&
+      !target_subscription_map_grow())
+    return false;
+
+  target_subscription_place(ts);
+  target_subscription_count++;
+  return true;
+}
+
+static target_subscription_t*
+target_subscription_find(EventType type, TargetID target)
+{
+  if (target_subscription_count == 0)
+    return NULL;
+
+  uint32_t mask = target_subscription_map_capacity - 1;
+  for (uint32_t i = target_subscription_hash(type, target) & mask;; i = (i + 1) & mask) {
+    target_subscription_t* ts = target_subscription_map[i];
+    if (ts == NULL || (ts->type == type && ts->target == target))
+      return ts;
+  }
+}
+
+/*
+ * Remove a list from the index, shifting later entries of its probe run
+ * back into the hole instead of leaving a tombstone.
+ */
+static void
+target_subscription_map_remove(target_subscription_t* ts)
+{
+  uint32_t mask = target_subscription_map_capacity - 1;
+  uint32_t hole = target_subscription_hash(ts->type, ts->target) & mask;
+  while (target_subscription_map[hole] != ts)
+    hole = (hole + 1) & mask;
+
+  target_subscription_map[hole] = NULL;
+  target_subscription_count--;
+
+  for (uint32_t i = (hole + 1) & mask; target_subscription_map[i] != NULL; i = (i + 1) & mask) {
+    target_subscription_t* next = target_subscription_map[i];
+    uint32_t               home = target_subscription_hash(next->type, next->target) & mask;
+
+    /* Move it back unless its home lies between the hole and its slot */
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      target_subscription_map[hole] = next;
+      target_subscription_map[i]    = NULL;
+      hole                          = i;
+    }
+  }
+}
+
+/*
+ * Free a list nobody walks anymore: one detached by its target's
+ * unregistration, or one left empty by unsubscribes.
+ */
+static void
+target_subscription_prune(target_subscription_t* ts)
+{
+  if (ts->list.delivering > 0)
+    return;
+
+  if (!ts->detached) {
+    if (ts->list.count > 0)
+      return;
+
+    target_subscription_map_remove(ts);
+    HubTarget* target = hub_get_target_by_id(ts->target);
+    if (target != NULL && target->subscriptions > 0)
+      target->subscriptions--;
+  }
+
+  free(ts->list.entries);
+  free(ts);
+}
+
+/*
+ * Drop every subscription scoped to a target, on its unregistration.
+ */
+static void
+target_subscriptions_drop(HubTarget* target)
+{
+  for (EventType type = 0; target->subscriptions > 0 && type < MAX_EVENT_TYPES; type++) {
+    target_subscription_t* ts = target_subscription_find(type, target->id);
+    if (ts == NULL)
+      continue;
+
+    target_subscription_map_remove(ts);
+    target->subscriptions--;
+
+    /* A delivery in progress must not call these anymore */
+    for (uint32_t i = 0; i < ts->list.count; i++)
+      ts->list.entries[i].handler = NULL;
+    ts->list.removed = ts->list.count;
+    ts->detached     = true;
+    target_subscription_prune(ts);
+  }
+}
+
+/*
+ * Deliver to the subscribers of every target, then to those of this one.
+ */
+static void
+deliver_event(EventType type, TargetID target, void* data)
+{
+  uint64_t generation = event_generation;
+  bool     delivered  = false;
+
+  emit_depth++;
+
+  if (event_types[type].list.count > 0) {
+    subscriber_list_deliver(&event_types[type].list, type, target, data, generation);
+    delivered = true;
+  }
+
+  /*
+   * Looked up only now: a global handler may have unregistered the target.
+   * Most targets have no scoped lists, and say so without a probe.
+   */
+  HubTarget* t = target_subscription_count > 0 ? hub_get_target_by_id(target) : NULL;
+  if (t != NULL && t->subscriptions > 0) {
+    target_subscription_t* scoped = target_subscription_find(type, target);
+    if (scoped != NULL) {
+      subscriber_list_deliver(&scoped->list, type, target, data, generation);
+      target_subscription_prune(scoped);
+      delivered = true;
+    }
+  }
+
+  emit_depth--;
+
+  if (delivered)
+    event_stats.emitted++;
+}
+
+/*
+ * Posted events wait while a delivery or a request batch is in progress.
+ */
+static bool
+events_held(void)
+{
+  return emit_depth > 0 || batch_depth > 0;
+}
+
+/*
+ * Whether posted events must wait for a later hub_drain_events(): held
+ * ones until the delivery or batch is over, deferred ones until the loop
+ * drains them.
+ */
+static bool
+events_waiting(void)
+{
+  return deferred || events_held();
+}
+
+void
+hub_emit(EventType type, TargetID target, void* data)
+{
+  if (type >= MAX_EVENT_TYPES) {
+    return;
+  }
+
+  deliver_event(type, target, data);
+
+  /* Events posted by the handlers go out once the outermost one returns */
+  if (!events_waiting())
+    hub_drain_events();
+}
+
+/*
+ * Queued events of coalescing types, indexed by (type, target) so a post
+ * finds the event it folds into without scanning the queue. The index has
+ * twice the ring's slots and keeps one entry per pair; every entry refers
+ * to an event still queued.
+ */
+
+static uint32_t
+event_queue_index_find(EventType type, TargetID target)
+{
+  if (event_queue_count == 0)
+    return UINT32_MAX;
+
+  uint32_t mask = event_queue_capacity * 2 - 1;
+  for (uint32_t i = target_subscription_hash(type, target) & mask; event_queue_index[i] != 0;
+       i = (i + 1) & mask) {
+    queued_event_t* qe = &event_queue[event_queue_index[i] - 1];
+    if (qe->type == type && qe->target == target)
+      return i;
+  }
+  return UINT32_MAX;
+}
+
+static void
+event_queue_index_add(uint32_t slot)
+{
+  uint32_t mask = event_queue_capacity * 2 - 1;
+  uint32_t i    = target_subscription_hash(event_queue[slot].type, event_queue[slot].target) & mask;
+  while (event_queue_index[i] != 0)
+    i = (i + 1) & mask;
+  event_queue_index[i] = slot + 1;
+}
+
+/*
+ * Remove an index entry, shifting later entries of its probe run back into
+ * the hole, as target_subscription_map_remove() does.
+ */
+static void
+event_queue_index_remove(uint32_t hole)
+{
+  uint32_t mask = event_queue_capacity * 2 - 1;
+
+  event_queue_index[hole] = 0;
+  for (uint32_t i = (hole + 1) & mask; event_queue_index[i] != 0; i = (i + 1) & mask) {
+    queued_event_t* next = &event_queue[event_queue_index[i] - 1];
+    uint32_t        home = target_subscription_hash(next->type, next->target) & mask;
+
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      event_queue_index[hole] = event_queue_index[i];
+      event_queue_index[i]    = 0;
+      hole                    = i;
+    }
+  }
+}
+
+/*
+ * Append an event to the ring buffer, growing it when full.
+ */
+static bool
+event_queue_push(EventType type, TargetID target, void* data)
+{
+  if (event_queue_count == event_queue_capacity) {
+    uint32_t        new_capacity = event_queue_capacity ? event_queue_capacity * 2 : EVENT_QUEUE_INITIAL_CAPACITY;
+    queued_event_t* grown        = malloc((size_t) new_capacity * sizeof(queued_event_t));
+    uint32_t*       index        = calloc((size_t) new_capacity * 2, sizeof(uint32_t));
+    if (grown == NULL || index == NULL) {
+      LOG_ERROR("Failed to grow event queue to %u events", new_capacity);
+      free(grown);
+      free(index);
+      return false;
+    }
+
+    /* Unwrap the ring so it starts at index 0 */
+    for (uint32_t i = 0; i < event_queue_count; i++)
+      grown[i] = event_queue[(event_queue_head + i) & (event_queue_capacity - 1)];
+
+    free(event_queue);
+    free(event_queue_index);
+    event_queue          = grown;
+    event_queue_index    = index;
+    event_queue_head     = 0;
+    event_queue_capacity = new_capacity;
+
+    /* Slots moved: index the coalescing events again */
+    for (uint32_t i = 0; i < event_queue_count; i++) {
+      if (event_types[grown[i].type].coalesce)
+        event_queue_index_add(i);
+    }
+  }
+
+  uint32_t tail     = (event_queue_head + event_queue_count) & (event_queue_capacity - 1);
+  event_queue[tail] = (queued_event_t) { .type = type, .target = target, .data = data };
+  event_queue_count++;
+
+  if (event_types[type].coalesce)
+    event_queue_index_add(tail);
+
+  if (event_queue_count > event_stats.max_queue_depth)
+    event_stats.max_queue_depth = event_queue_count;
+  return true;
+}
+
+/*
+ * Find the queued event for (type, target) of a coalescing type, or NULL.
+ */
+static queued_event_t*
+event_queue_find(EventType type, TargetID target)
+{
+  uint32_t i = event_queue_index_find(type, target);
+  return i == UINT32_MAX ? NULL : &event_queue[event_queue_index[i] - 1];
+}
+
+void
+hub_post(EventType type, TargetID target, void* data)
+{
+  if (type >= MAX_EVENT_TYPES) {
+    return;
+  }
+
+  event_stats.posted++;
+
+  if (event_types[type].coalesce) {
+    queued_event_t* queued = event_queue_find(type, target);
+    if (queued != NULL) {
+      queued->data = data;
+      event_stats.coalesced++;
+      return;
+    }
+  }
+
+  if (!event_queue_push(type, target, data)) {
+    /* Out of memory: deliver now rather than lose the event */
+    deliver_event(type, target, data);
+    return;
+  }
+
+  if (!events_waiting())
+    hub_drain_events();
+}
+
+void
+hub_set_event_deferral(bool defer)
+{
+  deferred = defer;
+
+  if (!events_waiting())
+    hub_drain_events();
+}
+
+void
+hub_set_event_coalescing(EventType type, bool coalesce)
+{
+  if (type >= MAX_EVENT_TYPES) {
+    return;
+  }
+
+  /* Events of the type already queued become ones later posts fold into */
+  if (coalesce && !event_types[type].coalesce) {
+    for (uint32_t i = 0; i < event_queue_count; i++) {
+      uint32_t slot = (event_queue_head + i) & (event_queue_capacity - 1);
+      if (event_queue[slot].type == type &&
+          event_queue_index_find(type, event_queue[slot].target) == UINT32_MAX)
+        event_queue_index_add(slot);
+    }
+  }
+
+  event_types[type].coalesce = coalesce;
+}
+
+void
+hub_drain_events(void)
+{
+  /* The drain already running picks up events posted meanwhile */
+  if (draining) {
+    return;
+  }
+
+  draining = true;
+  while (event_queue_count > 0) {
+    queued_event_t qe = event_queue[event_queue_head];
+
+    /* Unindex it before handlers can post into its slot */
+    uint32_t i = event_queue_index_find(qe.type, qe.target);
+    if (i != UINT32_MAX && event_queue_index[i] == event_queue_head + 1)
+      event_queue_index_remove(i);
+
+    event_queue_head = (event_queue_head + 1) & (event_queue_capacity - 1);
+    event_queue_count--;
+    deliver_event(qe.type, qe.target, qe.data);
+  }
+  draining = false;
+}
+
+void
+hub_settle(void)
+{
+  /* Bounded, so a relayout that keeps rescheduling itself cannot spin */
+  for (int round = 0; round < SETTLE_MAX_ROUNDS; round++) {
+    hub_drain_events();
+    hub_run_scheduled_relayouts();
+    if (dirty_count == 0 && event_queue_count == 0)
+      return;
+  }
+
+  LOG_DEBUG("Relayouts or events still pending after %d rounds", SETTLE_MAX_ROUNDS);
+}
+
+HubEventStats
+hub_get_event_stats(void)
+{
+  HubEventStats stats = event_stats;
+  stats.queue_depth   = event_queue_count;
+  return stats;
+}
+
+void
+hub_reset_event_stats(void)
+{
+  memset(&event_stats, 0, sizeof(event_stats));
+}
 
-  /* Check for duplicate handler */
-  for (int i = 0; i < count; i++) {
-    if (subscribers[type].subscribers[i].handler == handler) {
+void
+hub_subscribe(EventType type, EventHandler handler, void* userdata)
+{
+  if (type >= MAX_EVENT_TYPES) {
+    return;
+  }
+
+  if (handler == NULL) {
+    return;
+  }
+
+  (void) subscriber_list_add(&event_types[type].list, handler, userdata);
+}
+
+void
+hub_subscribe_target(EventType type, TargetID target, EventHandler handler, void* userdata)
+{
+  if (type >= MAX_EVENT_TYPES || handler == NULL) {
+    return;
+  }
+
+  HubTarget* t = hub_get_target_by_id(target);
+  if (t == NULL) {
+    LOG_WARN("Cannot subscribe to events of unregistered target %" PRIu64, target);
+    return;
+  }
+
+  target_subscription_t* ts = target_subscription_find(type, target);
+  if (ts == NULL) {
+    ts = calloc(1, sizeof(target_subscription_t));
+    if (ts == NULL) {
+      LOG_ERROR("Failed to allocate subscriptions for target %" PRIu64, target);
+      return;
+    }
+    ts->type   = type;
+    ts->target = target;
+    if (!target_subscription_insert(ts)) {
+      free(ts);
       return;
     }
+    t->subscriptions++;
+  }
+
+  (void) subscriber_list_add(&ts->list, handler, userdata);
+  target_subscription_prune(ts);
+}
+
+void
+hub_unsubscribe_target(EventType type, TargetID target, EventHandler handler)
+{
+  if (type >= MAX_EVENT_TYPES || handler == NULL) {
+    return;
   }
 
-  subscribers[type].subscribers[count].handler  = handler;
-  subscribers[type].subscribers[count].userdata = userdata;
-  subscribers[type].count++;
+  target_subscription_t* ts = target_subscription_find(type, target);
+  if (ts == NULL) {
+    return;
+  }
+
+  (void) subscriber_list_remove(&ts->list, handler);
+  target_subscription_prune(ts);
 }
 
 /*
@@ -900,6 +1913,198 @@ hub_send_request_with_cid(RequestType type, TargetID target, uint64_t correlatio
   comp->executor(&req);
 }
 
+/*
+ * Close a batch. The outermost one commits: scheduled relayouts run, then
+ * the events posted meanwhile are delivered.
+ */
+static void
+batch_end(void)
+{
+  batch_depth--;
+
+  if (batch_depth == 0) {
+    hub_run_scheduled_relayouts();
+    if (!events_waiting())
+      hub_drain_events();
+  }
+}
+
+void
+hub_send_request_batch(RequestType type, const TargetID* targets, uint32_t count, void* data)
+{
+  if (targets == NULL || count == 0) {
+    return;
+  }
+
+  HubComponent* comp = hub_get_component_by_request_type(type);
+  if (comp == NULL) {
+    LOG_DEBUG("No component handles request type %u for a batch of %u", type, count);
+    return;
+  }
+
+  if (comp->executor == NULL && comp->batch_executor == NULL) {
+    LOG_DEBUG("Component '%s' has no executor for request type %u",
+              comp->name, type);
+    return;
+  }
+
+  LOG_DEBUG("Routing request type=%u to component '%s' for %u targets",
+            type, comp->name, count);
+
+  batch_depth++;
+
+  if (comp->batch_executor != NULL) {
+    struct HubRequestBatch batch = {
+      .type    = type,
+      .targets = targets,
+      .count   = count,
+      .data    = data,
+    };
+    comp->batch_executor(&batch);
+  } else {
+    for (uint32_t i = 0; i < count; i++) {
+      struct HubRequest req = {
+        .type           = type,
+        .target         = targets[i],
+        .data           = data,
+        .correlation_id = 0,
+      };
+      comp->executor(&req);
+    }
+  }
+
+  batch_end();
+}
+
+/*
+ * Find the waiting request that a new (type, target, data) request merges
+ * into, or REQUEST_NOT_MERGED.
+ */
+static uint32_t
+request_queue_find(RequestType type, TargetID target, void* data)
+{
+  for (uint32_t i = 0; i < request_queue_count; i++) {
+    queued_request_t* qr = &request_queue[i];
+    if (qr->merged_into == REQUEST_NOT_MERGED && qr->request.type == type
+        && qr->request.target == target && qr->request.data == data)
+      return i;
+  }
+  return REQUEST_NOT_MERGED;
+}
+
+bool
+hub_queue_request(RequestType type, TargetID target, void* data, uint64_t correlation_id)
+{
+  if (!registry_reserve((void**) &request_queue, &request_queue_capacity,
+                        request_queue_count + 1, sizeof(*request_queue))) {
+    LOG_ERROR("Failed to queue request type %u (cid=%" PRIu64 ")", type, correlation_id);
+    return false;
+  }
+
+  uint32_t merged_into = REQUEST_NOT_MERGED;
+  if (type < MAX_REQUEST_TYPES && request_merging[type])
+    merged_into = request_queue_find(type, target, data);
+
+  request_queue[request_queue_count++] = (queued_request_t) {
+    .request = {
+      .type           = type,
+      .target         = target,
+      .data           = data,
+      .correlation_id = correlation_id,
+    },
+    .merged_into = merged_into,
+  };
+
+  request_stats.queued++;
+  if (merged_into != REQUEST_NOT_MERGED)
+    request_stats.merged++;
+  return true;
+}
+
+/*
+ * Route one queued request to its executor. Returns false if it failed.
+ */
+static bool
+run_queued_request(struct HubRequest* req)
+{
+  HubComponent* comp = hub_get_component_by_request_type(req->type);
+  if (comp == NULL || comp->executor == NULL) {
+    LOG_DEBUG("No executor for queued request type %u for target %lu (cid=%" PRIu64 ")",
+              req->type, (unsigned long) req->target, req->correlation_id);
+    return false;
+  }
+
+  comp->executor(req);
+  return !req->failed;
+}
+
+void
+hub_run_queued_requests(void)
+{
+  /* Never from inside a delivery or batch: the next iteration runs them */
+  if (request_queue_count == 0 || events_held()) {
+    return;
+  }
+
+  /* Take the queue: requests queued while these run wait for the next call */
+  queued_request_t* queue = request_queue;
+  uint32_t          count = request_queue_count;
+  request_queue           = NULL;
+  request_queue_count     = 0;
+  request_queue_capacity  = 0;
+
+  batch_depth++;
+
+  for (uint32_t i = 0; i < count; i++) {
+    struct HubRequest* req = &queue[i].request;
+
+    if (queue[i].merged_into == REQUEST_NOT_MERGED)
+      req->failed = !run_queued_request(req);
+    else
+      req->failed = queue[queue[i].merged_into].request.failed;
+
+    /* Held by the batch: delivered once every request has run */
+    if (req->failed) {
+      request_stats.failed++;
+      hub_post(EVT_REQUEST_FAILED, req->target, req);
+    } else {
+      request_stats.completed++;
+      hub_post(EVT_REQUEST_COMPLETED, req->target, req);
+    }
+  }
+
+  batch_end();
+
+  /* Completions point into the queue: deliver them before it goes, even
+   * when deferral would have them wait for the loop's drain */
+  hub_drain_events();
+  free(queue);
+}
+
+void
+hub_set_request_merging(RequestType type, bool merge)
+{
+  if (type >= MAX_REQUEST_TYPES) {
+    return;
+  }
+
+  request_merging[type] = merge;
+}
+
+HubRequestStats
+hub_get_request_stats(void)
+{
+  HubRequestStats stats = request_stats;
+  stats.pending         = request_queue_count;
+  return stats;
+}
+
+void
+hub_reset_request_stats(void)
+{
+  memset(&request_stats, 0, sizeof(request_stats));
+}
+
 /*
  * Get the executor function for a request type.
  * Used for testing purposes.
@@ -939,9 +2144,9 @@ hub_shutdown(void)
   }
 
   /* Unregister all targets */
-  while (target_count > 0) {
-    target_count--;
-    targets[target_count]->registered = false;
+  for (uint32_t i = 0; i < slot_count; i++) {
+    if (target_slots[i] != NULL)
+      target_slots[i]->registered = false;
   }
 
   /* Clear all registry state including indexes */
@@ -959,16 +2164,5 @@ hub_unsubscribe(EventType type, EventHandler handler)
     return;
   }
 
-
-  int count = subscribers[type].count;
-  for (int i = 0; i < count; i++) {
-    if (subscribers[type].subscribers[i].handler == handler) {
-      /* Remove by shifting remaining subscribers */
-      for (int j = i; j < count - 1; j++) {
-        subscribers[type].subscribers[j] = subscribers[type].subscribers[j + 1];
-      }
-      subscribers[type].count--;
-      return;
-    }
-  }
+  (void) subscriber_list_remove(&event_types[type].list, handler);
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "wm-intern.h"
+
 /* Forward declarations */
 typedef struct HubComponent  HubComponent;
 typedef struct HubTarget     HubTarget;
@@ -15,14 +17,20 @@ typedef void (*EventHandler)(Event);
 /* Type definitions */
 typedef uint64_t TargetID;
 typedef uint32_t RequestType;
+
+/*
+ * Event types are below 64 and unique across components, since IPC
+ * subscribers select them by bit: 20 tags, 25 fullscreen, 30 focus,
+ * 35 monitor connection, 40 layout, 60 requests.
+ */
 typedef uint32_t EventType;
 
 /*
  * Target Type
  *
  * Introduced by components, registered with the hub.
- * Provides both string-based lookup (extensible) and
- * integer-based lookup (fast).
+ * Provides string-based lookup (extensible), and lookup by name atom
+ * or integer ID (fast, no string compares).
  *
  * Components declare which target types they:
  * - INTRODUCE: Target types they own (must be registered before use)
@@ -30,6 +38,7 @@ typedef uint32_t EventType;
  */
 struct HubTargetType {
   const char*   name;     /* e.g., "client", "monitor", "focused-client" */
+  NameAtom      atom;     /* interned name, see wm-intern.h */
   uint32_t      id;       /* unique integer ID, assigned on registration */
   HubComponent* owner;    /* component that introduced this type */
   bool          reserved; /* true once registered */
@@ -88,11 +97,25 @@ struct HubRequest {
   TargetID    target;
   void*       data;
   uint64_t    correlation_id; /* for async response correlation */
+  bool        failed;         /* set by the executor when the request fails */
 };
 
 /* Forward declaration for executor type */
 typedef void (*RequestExecutor)(struct HubRequest* req);
 
+/*
+ * Batch request - one request type applied to many targets, passed to
+ * component batch executors. Same lifetime rules as HubRequest.
+ */
+struct HubRequestBatch {
+  RequestType     type;
+  const TargetID* targets;
+  uint32_t        count;
+  void*           data; /* shared by every target */
+};
+
+typedef void (*BatchExecutor)(struct HubRequestBatch* batch);
+
 /* Forward declarations for adoption hooks */
 typedef void (*AdoptionHook)(struct HubTarget* target);
 
@@ -108,6 +131,7 @@ typedef void (*AdoptionHook)(struct HubTarget* target);
  */
 struct HubComponent {
   const char* name;
+  NameAtom    atom; /* interned name, assigned at registration */
 
   /* Target types this component ACCEPTS (works with)
    * NULL-terminated array of target type names.
@@ -119,9 +143,10 @@ struct HubComponent {
   HubTargetType** accepted_targets;
 
   RequestType*    requests;   /* 0-terminated array of request types handled */
-  RequestExecutor executor;   /* called when this component receives a request */
-  AdoptionHook    on_adopt;   /* called when a target adopts this component */
-  AdoptionHook    on_unadopt; /* called when a target unadopts this component */
+  RequestExecutor executor;       /* called when this component receives a request */
+  BatchExecutor   batch_executor; /* optional: whole hub_send_request_batch() at once */
+  AdoptionHook    on_adopt;       /* called when a target adopts this component */
+  AdoptionHook    on_unadopt;     /* called when a target unadopts this component */
   bool            registered;
 };
 
@@ -130,6 +155,10 @@ struct HubTarget {
   TargetID     id;
   TargetTypeId type_id; /* ID for fast lookup, maps to HubTargetType */
   bool         registered;
+  bool         dirty;         /* relayout scheduled, see hub_schedule_relayout() */
+  uint32_t     slot;          /* registry handle, valid while registered */
+  uint32_t     type_index;    /* position in hub_get_targets_by_type() */
+  uint32_t     subscriptions; /* event types with hub_subscribe_target() lists */
 };
 
 /*
@@ -151,8 +180,9 @@ typedef void (*EventHandler)(struct Event);
  * Subscriber structure
  */
 struct Subscriber {
-  EventHandler handler;
+  EventHandler handler;    /* NULL once unsubscribed during delivery */
   void*        userdata;
+  uint64_t     generation; /* event bus generation at subscribe time */
 };
 
 /* Hub initialization */
@@ -190,16 +220,71 @@ void hub_send_request_data(RequestType type, TargetID target, void* data);
  */
 void hub_send_request_with_cid(RequestType type, TargetID target, uint64_t correlation_id);
 
+/*
+ * Send one request type to many targets as a single transaction.
+ * A component with a batch_executor gets the whole array in one call;
+ * otherwise its executor runs once per target. Side effects are committed
+ * once, when the outermost batch ends: scheduled relayouts run, then the
+ * events posted with hub_post() are delivered (coalesced per target).
+ *
+ * @param type     The request type
+ * @param targets  Target IDs, count entries
+ * @param count    Number of targets
+ * @param data     Data passed with every target
+ */
+void hub_send_request_batch(RequestType type, const TargetID* targets, uint32_t count, void* data);
+
+/*
+ * Request queue
+ *
+ * hub_queue_request() returns right away; the event loop runs queued
+ * requests once per iteration with hub_run_queued_requests(), in the order
+ * they were queued, as one transaction like hub_send_request_batch().
+ * Each request then posts EVT_REQUEST_COMPLETED or EVT_REQUEST_FAILED for
+ * its target, with data pointing at the struct HubRequest, so listeners
+ * match the correlation_id. The request is only valid during delivery, so
+ * the completions are delivered before hub_run_queued_requests() returns,
+ * even with event deferral on.
+ * A request fails when no component executes its type, or when the
+ * executor sets req->failed.
+ *
+ * With merging on for a type, queuing a request whose (type, target, data)
+ * is already waiting runs it once; every caller still gets its completion
+ * event with its own correlation_id. Only idempotent requests, such as
+ * REQ_MONITOR_TILE, should merge.
+ */
+enum {
+  EVT_REQUEST_COMPLETED = 60,
+  EVT_REQUEST_FAILED    = 61,
+};
+
+typedef struct HubRequestStats {
+  uint64_t queued;    /* hub_queue_request() calls */
+  uint64_t merged;    /* requests folded into a waiting one */
+  uint64_t completed; /* completion events posted */
+  uint64_t failed;    /* failure events posted */
+  uint32_t pending;   /* requests waiting now */
+} HubRequestStats;
+
+bool            hub_queue_request(RequestType type, TargetID target, void* data, uint64_t correlation_id);
+void            hub_run_queued_requests(void);
+void            hub_set_request_merging(RequestType type, bool merge);
+HubRequestStats hub_get_request_stats(void);
+void            hub_reset_request_stats(void);
+
 /* Component registration */
 void          hub_register_component(HubComponent* comp);
 void          hub_unregister_component(const char* name);
 HubComponent* hub_get_component_by_name(const char* name);
+HubComponent* hub_get_component_by_atom(NameAtom atom);
 HubComponent* hub_get_component_by_request_type(RequestType type);
 
 /* Target type registration and lookup */
 HubTargetType*  hub_register_target_type(const char* name, HubComponent* owner);
 HubTargetType*  hub_get_target_type_by_name(const char* name);
+HubTargetType*  hub_get_target_type_by_atom(NameAtom atom);
 uint32_t        hub_get_target_type_id_by_name(const char* name);
+uint32_t        hub_get_target_type_id_by_atom(NameAtom atom);
 HubTargetType*  hub_get_target_type_by_id(uint32_t id);
 HubTargetType** hub_get_all_target_types(uint32_t* count);
 
@@ -216,6 +301,29 @@ HubTarget*  hub_get_target_by_id(TargetID id);
 HubTarget** hub_get_targets_by_type(TargetTypeId type_id);
 HubTarget** hub_get_targets_by_type_name(const char* type_name);
 
+/*
+ * Deferred relayout
+ *
+ * Instead of laying a target (typically a monitor) out immediately, code
+ * paths mark it dirty. The event loop calls hub_run_scheduled_relayouts()
+ * at the end of each event batch, which runs the handler registered for the
+ * target's type once per dirty target, however often it was marked.
+ */
+typedef void (*RelayoutHandler)(HubTarget* target);
+
+typedef struct HubRelayoutStats {
+  uint64_t requested; /* hub_schedule_relayout() calls */
+  uint64_t executed;  /* relayout handler invocations */
+} HubRelayoutStats;
+
+void             hub_register_relayout_handler(TargetTypeId type_id, RelayoutHandler handler);
+void             hub_unregister_relayout_handler(TargetTypeId type_id);
+void             hub_schedule_relayout(TargetID target);
+void             hub_run_scheduled_relayouts(void);
+uint32_t         hub_pending_relayout_count(void);
+HubRelayoutStats hub_get_relayout_stats(void);
+void             hub_reset_relayout_stats(void);
+
 /* Event bus operations */
 
 /*
@@ -235,9 +343,57 @@ void hub_subscribe(EventType type, EventHandler handler, void* userdata);
 /*
  * Unsubscribe a handler from an event type.
  * If handler is not subscribed, this is a no-op.
+ * Safe to call from a handler: the removed handler is not called again,
+ * and a handler subscribed during a delivery does not see that event.
  */
 void hub_unsubscribe(EventType type, EventHandler handler);
 
+/*
+ * Subscribe to an event type for one target only. Emitting the event
+ * for that target reaches these handlers after the hub_subscribe() ones;
+ * events of other targets never look at them. The target must be
+ * registered, and its subscriptions are dropped when it unregisters.
+ */
+void hub_subscribe_target(EventType type, TargetID target, EventHandler handler, void* userdata);
+void hub_unsubscribe_target(EventType type, TargetID target, EventHandler handler);
+
+/*
+ * Queued delivery
+ *
+ * hub_post() queues the event instead of calling handlers from inside the
+ * handler that is running, and the queue is drained once the outermost
+ * delivery returns. Outside any delivery the event is delivered right away.
+ *
+ * With deferral on, every post waits for hub_drain_events(), which the
+ * main loop calls once per iteration: everything one iteration posted is
+ * delivered together, so coalescing folds posts from separate requests,
+ * X events and timers too.
+ * Queued data must stay valid until delivery: point it at target state,
+ * never at the caller's stack.
+ *
+ * With coalescing on for a type, posting an event whose (type, target) is
+ * still queued replaces the queued event's data instead of adding another.
+ *
+ * hub_settle() drains the queue and runs the scheduled relayouts until
+ * neither has work left, as relayouts post events and handlers schedule
+ * relayouts. The main loop calls it before it blocks.
+ */
+typedef struct HubEventStats {
+  uint64_t emitted;         /* events delivered, hub_emit() or queued */
+  uint64_t posted;          /* hub_post() calls */
+  uint64_t coalesced;       /* posts folded into a queued event */
+  uint32_t queue_depth;     /* events waiting now */
+  uint32_t max_queue_depth; /* deepest the queue has been */
+} HubEventStats;
+
+void          hub_post(EventType type, TargetID target, void* data);
+void          hub_set_event_coalescing(EventType type, bool coalesce);
+void          hub_set_event_deferral(bool defer);
+void          hub_drain_events(void);
+void          hub_settle(void);
+HubEventStats hub_get_event_stats(void);
+void          hub_reset_event_stats(void);
+
 /* Utility */
 uint32_t hub_component_count(void);
 uint32_t hub_target_count(void);
@@ -0,0 +1,157 @@
+#include "wm-intern.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wm-log.h"
+
+#define NAME_ATOMS_INITIAL_CAPACITY 64
+
+/* Names by atom; names[0] stays NULL for NAME_ATOM_NONE */
+static const char** names         = NULL;
+static uint32_t     name_count    = 0; /* atoms handed out, NONE included */
+static uint32_t     name_capacity = 0;
+
+/*
+ * Name to atom index: open addressing with linear probing, atom 0 marks an
+ * empty slot. Only interning and name_atom_find() use it.
+ */
+static NameAtom* index_slots    = NULL;
+static uint32_t  index_capacity = 0; /* power of two */
+
+static uint32_t
+hash_name(const char* s)
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261U;
+  while (*s) {
+    hash ^= (uint8_t) *s++;
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+static void
+index_place(NameAtom atom)
+{
+  uint32_t i = hash_name(names[atom]) & (index_capacity - 1);
+  while (index_slots[i] != NAME_ATOM_NONE)
+    i = (i + 1) & (index_capacity - 1);
+  index_slots[i] = atom;
+}
+
+static bool
+index_grow(void)
+{
+  uint32_t  new_capacity = index_capacity ? index_capacity * 2 : NAME_ATOMS_INITIAL_CAPACITY;
+  NameAtom* new_slots    = calloc(new_capacity, sizeof(NameAtom));
+  if (new_slots == NULL) {
+    LOG_ERROR("name atoms: cannot grow index to %u names", new_capacity);
+    return false;
+  }
+
+  free(index_slots);
+  index_slots    = new_slots;
+  index_capacity = new_capacity;
+
+  for (NameAtom atom = 1; atom < name_count; atom++)
+    index_place(atom);
+  return true;
+}
+
+static NameAtom
+add_name(const char* name)
+{
+  /* keep the index load factor below 3/4 */
+  if ((name_count + 1) * 4 > index_capacity * 3 && !index_grow())
+    return NAME_ATOM_NONE;
+
+  if (name_count >= name_capacity) {
+    uint32_t     new_capacity = name_capacity ? name_capacity * 2 : NAME_ATOMS_INITIAL_CAPACITY;
+    const char** new_names    = realloc(names, new_capacity * sizeof(*names));
+    if (new_names == NULL) {
+      LOG_ERROR("name atoms: cannot grow to %u names", new_capacity);
+      return NAME_ATOM_NONE;
+    }
+    names         = new_names;
+    name_capacity = new_capacity;
+  }
+
+  char* copy = strdup(name);
+  if (copy == NULL) {
+    LOG_ERROR("name atoms: cannot copy '%s'", name);
+    return NAME_ATOM_NONE;
+  }
+
+  NameAtom atom = name_count++;
+  names[atom]   = copy;
+  index_place(atom);
+  return atom;
+}
+
+/* Seed the well-known names, so they get their fixed atoms */
+static bool
+ensure_seeded(void)
+{
+  if (name_count > 0)
+    return true;
+
+  if (!index_grow())
+    return false;
+
+  names = calloc(NAME_ATOMS_INITIAL_CAPACITY, sizeof(*names));
+  if (names == NULL) {
+    LOG_ERROR("name atoms: cannot allocate the name table");
+    return false;
+  }
+  name_capacity = NAME_ATOMS_INITIAL_CAPACITY;
+  name_count    = 1; /* NAME_ATOM_NONE */
+
+#define NAME_ATOM_SEED(id, name) add_name(name);
+  NAME_ATOM_LIST(NAME_ATOM_SEED)
+#undef NAME_ATOM_SEED
+
+  return name_count == NAME_ATOM_WELL_KNOWN_COUNT;
+}
+
+NameAtom
+name_atom_find(const char* name)
+{
+  if (name == NULL || !ensure_seeded())
+    return NAME_ATOM_NONE;
+
+  for (uint32_t i = hash_name(name) & (index_capacity - 1);; i = (i + 1) & (index_capacity - 1)) {
+    NameAtom atom = index_slots[i];
+    if (atom == NAME_ATOM_NONE || strcmp(names[atom], name) == 0)
+      return atom;
+  }
+}
+
+NameAtom
+name_intern(const char* name)
+{
+  NameAtom atom = name_atom_find(name);
+  if (atom != NAME_ATOM_NONE || name == NULL || name_count == 0)
+    return atom;
+
+  return add_name(name);
+}
+
+const char*
+name_atom_string(NameAtom atom)
+{
+  if (!ensure_seeded() || atom == NAME_ATOM_NONE || atom >= name_count)
+    return NULL;
+
+  return names[atom];
+}
+
+uint32_t
+name_atom_count(void)
+{
+  if (!ensure_seeded())
+    return 0;
+
+  return name_count - 1;
+}
@@ -0,0 +1,71 @@
+/*
+ * Name Atoms - Interned names for registry keys
+ *
+ * Target types, components, state machines, SM guards and actions, and
+ * actions are all registered by name. Each name is interned once into a
+ * small integer atom, and the registries are indexed by atom, so looking
+ * something up never compares strings:
+ *
+ *   hub_get_target_type_id_by_atom(NAME_ATOM_CLIENT)
+ *   client_get_sm_atom(c, NAME_ATOM_FOCUS)
+ *
+ * Names used on hot paths are listed once in NAME_ATOM_LIST and have fixed
+ * atom values, so code can use them as constants. Other names get the next
+ * free atom when first interned. Atoms are never released: an atom and its
+ * name stay valid for the life of the process.
+ */
+
+#ifndef _WM_INTERN_H_
+#define _WM_INTERN_H_
+
+#include <stdint.h>
+
+/*
+ * Well-known names: X(ENUM_SUFFIX, "name")
+ */
+#define NAME_ATOM_LIST(X)      \
+  X(CLIENT, "client")          \
+  X(MONITOR, "monitor")        \
+  X(TAG, "tag")                \
+  X(FOCUS, "focus")            \
+  X(FULLSCREEN, "fullscreen")  \
+  X(TILING, "tiling")          \
+  X(PERTAG, "pertag")          \
+  X(TAG_VIEW, "tag-view")
+
+typedef uint32_t NameAtom;
+
+/*
+ * Well-known atoms. NAME_ATOM_NONE is never assigned to a name.
+ */
+enum {
+  NAME_ATOM_NONE = 0,
+#define NAME_ATOM_ENUM(id, name) NAME_ATOM_##id,
+  NAME_ATOM_LIST(NAME_ATOM_ENUM)
+#undef NAME_ATOM_ENUM
+    NAME_ATOM_WELL_KNOWN_COUNT
+};
+
+/*
+ * Atom of a name, interning it (the string is copied) if it is new.
+ * Returns NAME_ATOM_NONE for NULL or if memory runs out.
+ */
+NameAtom name_intern(const char* name);
+
+/*
+ * Atom of a name already interned, or NAME_ATOM_NONE. Never adds a name.
+ */
+NameAtom name_atom_find(const char* name);
+
+/*
+ * Name of an atom, or NULL for NAME_ATOM_NONE and unknown atoms.
+ */
+const char* name_atom_string(NameAtom atom);
+
+/*
+ * Number of atoms handed out, NAME_ATOM_NONE not included. Every atom is
+ * below name_atom_count() + 1, so registries can size arrays by it.
+ */
+uint32_t name_atom_count(void);
+
+#endif /* _WM_INTERN_H_ */
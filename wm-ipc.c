@@ -0,0 +1,930 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "src/actions/action-registry.h"
+#include "src/components/state-snapshot.h"
+#include "wm-hub.h"
+#include "wm-ipc.h"
+#include "wm-log.h"
+#include "wm-loop.h"
+
+/* Bytes requested from the socket per read() */
+#define IPC_READ_CHUNK 16384
+
+/* Longest action name accepted */
+#define IPC_MAX_NAME 255
+
+_Static_assert(sizeof(IpcHeader) == 12, "IpcHeader is part of the wire format");
+_Static_assert(sizeof(IpcClient) == 40, "IpcClient is part of the wire format");
+_Static_assert(sizeof(IpcMonitor) == 32, "IpcMonitor is part of the wire format");
+_Static_assert(sizeof(IpcInvoke) == 24, "IpcInvoke is part of the wire format");
+_Static_assert(sizeof(IpcEventBatch) == 16, "IpcEventBatch is part of the wire format");
+_Static_assert(sizeof(IpcEvent) == 16, "IpcEvent is part of the wire format");
+
+/* Open-addressed index over the pending pairs, kept at most half full */
+#define IPC_EVENT_INDEX_SIZE (IPC_MAX_PENDING_EVENTS * 2)
+
+/*
+ * One client connection. Input holds bytes of frames not complete yet;
+ * output holds responses the socket did not take yet, from out_sent on.
+ */
+typedef struct IpcConnection {
+  int      fd;
+  uint32_t events; /* epoll mask currently registered */
+  uint8_t* in;
+  uint32_t in_len;
+  uint32_t in_cap;
+  uint8_t* out;
+  uint32_t out_len;
+  uint32_t out_sent;
+  uint32_t out_cap;
+  uint64_t subscriptions; /* event type mask, see IPC_OP_SUBSCRIBE */
+  uint32_t event_seq;     /* seq of the next pushed batch */
+  uint32_t missed;        /* batches skipped in a row while behind */
+  bool     resync;        /* events were lost, push the state next */
+} IpcConnection;
+
+static int            listen_fd = -1;
+static char           socket_path[sizeof(((struct sockaddr_un*) 0)->sun_path)];
+static IpcConnection* connections[IPC_MAX_CONNECTIONS];
+static IpcStats       stats;
+
+/*
+ * Events collected during the current loop iteration, one entry per
+ * (type, target) in order of first occurrence, shared by all subscribers.
+ */
+static IpcEvent pending_events[IPC_MAX_PENDING_EVENTS];
+static uint16_t pending_index[IPC_EVENT_INDEX_SIZE]; /* entry + 1, 0 if free */
+static uint32_t pending_count    = 0;
+static uint64_t pending_types    = 0; /* types with a pending entry */
+static uint64_t overflow_types   = 0; /* types of events that found no room */
+static uint64_t subscribed_types = 0; /* types the hub delivers to us */
+
+static void on_event(Event event);
+
+/* Follow the union of all connections' subscriptions on the hub */
+static void
+subscriptions_update(void)
+{
+  uint64_t wanted = 0;
+  for (uint32_t i = 0; i < IPC_MAX_CONNECTIONS; i++) {
+    if (connections[i] != NULL)
+      wanted |= connections[i]->subscriptions;
+  }
+
+  uint64_t changed = wanted ^ subscribed_types;
+  for (EventType type = 0; changed != 0 && type < IPC_MAX_EVENT_TYPES; type++) {
+    uint64_t bit = UINT64_C(1) << type;
+    if (!(changed & bit))
+      continue;
+    if (wanted & bit)
+      hub_subscribe(type, on_event, NULL);
+    else
+      hub_unsubscribe(type, on_event);
+  }
+  subscribed_types = wanted;
+}
+
+static bool
+buffer_reserve(uint8_t** buf, uint32_t* cap, uint32_t need)
+{
+  if (need <= *cap)
+    return true;
+
+  uint32_t new_cap = *cap ? *cap : IPC_READ_CHUNK;
+  while (new_cap < need)
+    new_cap *= 2;
+
+  uint8_t* grown = realloc(*buf, new_cap);
+  if (grown == NULL) {
+    LOG_ERROR("ipc: cannot grow a connection buffer to %u bytes", new_cap);
+    return false;
+  }
+  *buf = grown;
+  *cap = new_cap;
+  return true;
+}
+
+static void
+connection_close(IpcConnection* conn)
+{
+  for (uint32_t i = 0; i < IPC_MAX_CONNECTIONS; i++) {
+    if (connections[i] == conn)
+      connections[i] = NULL;
+  }
+
+  loop_remove_fd(conn->fd);
+  close(conn->fd);
+  free(conn->in);
+  free(conn->out);
+  stats.connections--;
+
+  if (conn->subscriptions != 0)
+    subscriptions_update();
+  free(conn);
+}
+
+/*
+ * Responses
+ *
+ * A response is built in place at the end of the output buffer: the
+ * header is reserved first and its length filled in once the payload is
+ * complete.
+ */
+static bool
+reply_append(IpcConnection* conn, const void* data, uint32_t len)
+{
+  if (!buffer_reserve(&conn->out, &conn->out_cap, conn->out_len + len))
+    return false;
+
+  memcpy(conn->out + conn->out_len, data, len);
+  conn->out_len += len;
+  return true;
+}
+
+static bool
+reply_begin(IpcConnection* conn, const IpcHeader* req, uint32_t* start)
+{
+  IpcHeader header = { .length = 0, .op = req->op, .status = IPC_STATUS_OK, .seq = req->seq };
+  *start           = conn->out_len;
+  return reply_append(conn, &header, sizeof(header));
+}
+
+static void
+reply_end(IpcConnection* conn, uint32_t start, uint16_t status)
+{
+  IpcHeader* header = (IpcHeader*) (conn->out + start);
+  header->length    = conn->out_len - start - sizeof(IpcHeader);
+  header->status    = status;
+}
+
+static bool
+reply_status(IpcConnection* conn, const IpcHeader* req, uint16_t status)
+{
+  uint32_t start;
+  if (!reply_begin(conn, req, &start))
+    return false;
+  reply_end(conn, start, status);
+  return true;
+}
+
+/*
+ * Queries
+ */
+static IpcClient
+ipc_client(const WmSnapshotClient* c)
+{
+  return (IpcClient) {
+    .id      = c->id,
+    .monitor = c->monitor,
+    .window  = c->window,
+    .tags    = c->tags,
+    .x       = c->x,
+    .y       = c->y,
+    .width   = c->width,
+    .height  = c->height,
+    .flags   = (c->managed ? IPC_CLIENT_MANAGED : 0) | (c->mapped ? IPC_CLIENT_MAPPED : 0)
+             | (c->urgent ? IPC_CLIENT_URGENT : 0) | (c->focused ? IPC_CLIENT_FOCUSED : 0)
+             | (c->fullscreen ? IPC_CLIENT_FULLSCREEN : 0),
+  };
+}
+
+static IpcState
+ipc_state(const WmSnapshot* s)
+{
+  if (s == NULL)
+    return (IpcState) { 0 };
+
+  return (IpcState) {
+    .sequence         = s->sequence,
+    .focused_client   = s->focused_client,
+    .selected_monitor = s->selected_monitor,
+    .client_count     = s->client_count,
+    .monitor_count    = s->monitor_count,
+    .tag_count        = s->tag_count,
+  };
+}
+
+static bool
+append_string(IpcConnection* conn, const char* s)
+{
+  if (s == NULL)
+    s = "";
+  return reply_append(conn, s, strlen(s) + 1);
+}
+
+static uint16_t
+query(IpcConnection* conn, const IpcHeader* req, const uint8_t* payload, bool* ok)
+{
+  const WmSnapshot* s      = snapshot_acquire();
+  uint16_t          status = IPC_STATUS_OK;
+
+  *ok = true;
+  if (s == NULL) {
+    snapshot_release(s);
+    return IPC_STATUS_NO_STATE;
+  }
+
+  switch (req->op) {
+  case IPC_OP_STATE: {
+    IpcState state = ipc_state(s);
+    *ok            = reply_append(conn, &state, sizeof(state));
+    break;
+  }
+
+  case IPC_OP_CLIENTS:
+    for (uint32_t i = 0; i < s->client_count && *ok; i++) {
+      IpcClient client = ipc_client(&s->clients[i]);
+      *ok              = reply_append(conn, &client, sizeof(client));
+    }
+    break;
+
+  case IPC_OP_MONITORS:
+    for (uint32_t i = 0; i < s->monitor_count && *ok; i++) {
+      const WmSnapshotMonitor* m = &s->monitors[i];
+
+      IpcMonitor monitor = {
+        .id       = m->id,
+        .x        = m->x,
+        .y        = m->y,
+        .width    = m->width,
+        .height   = m->height,
+        .tagset   = m->tagset,
+        .layout   = m->layout,
+        .selected = m->selected,
+      };
+      *ok = reply_append(conn, &monitor, sizeof(monitor));
+    }
+    break;
+
+  case IPC_OP_CLIENT: {
+    if (req->length != sizeof(uint64_t)) {
+      status = IPC_STATUS_BAD_REQUEST;
+      break;
+    }
+
+    uint64_t id;
+    memcpy(&id, payload, sizeof(id));
+
+    status = IPC_STATUS_NOT_FOUND;
+    for (uint32_t i = 0; i < s->client_count; i++) {
+      if (s->clients[i].id != id)
+        continue;
+      IpcClient client = ipc_client(&s->clients[i]);
+      *ok              = reply_append(conn, &client, sizeof(client))
+          && append_string(conn, s->clients[i].title)
+          && append_string(conn, s->clients[i].class_name);
+      status = IPC_STATUS_OK;
+      break;
+    }
+    break;
+  }
+  }
+
+  snapshot_release(s);
+  return status;
+}
+
+/*
+ * Actions
+ */
+static uint16_t
+invoke(const IpcHeader* req, const IpcInvoke* args, Action* action)
+{
+  if (action == NULL)
+    return IPC_STATUS_NOT_FOUND;
+
+  ActionInvocation inv = {
+    .target         = args->target,
+    .correlation_id = req->seq,
+    .target_type    = action->target_type,
+  };
+
+  if (args->flags & IPC_INVOKE_HAS_ARG) {
+    /* Intentional int-to-pointer cast, as for keybinding arguments */
+    inv.data = (void*) (intptr_t) args->arg; // NOLINT
+  }
+
+  return action_invoke_atom(action->atom, &inv) ? IPC_STATUS_OK : IPC_STATUS_FAILED;
+}
+
+/* Copy a name payload into a NUL-terminated buffer */
+static bool
+payload_name(const uint8_t* payload, uint32_t len, char* name)
+{
+  if (len == 0 || len > IPC_MAX_NAME)
+    return false;
+
+  memcpy(name, payload, len);
+  name[len] = '\0';
+  return true;
+}
+
+static uint16_t
+action_request(IpcConnection* conn, const IpcHeader* req, const uint8_t* payload, bool* ok)
+{
+  char      name[IPC_MAX_NAME + 1];
+  IpcInvoke args;
+
+  *ok = true;
+  switch (req->op) {
+  case IPC_OP_ACTION_LOOKUP: {
+    if (!payload_name(payload, req->length, name))
+      return IPC_STATUS_BAD_REQUEST;
+
+    Action* action = action_lookup(name);
+    if (action == NULL)
+      return IPC_STATUS_NOT_FOUND;
+
+    uint32_t id = action->atom;
+    *ok         = reply_append(conn, &id, sizeof(id));
+    return IPC_STATUS_OK;
+  }
+
+  case IPC_OP_ACTION_INVOKE:
+    if (req->length != sizeof(args))
+      return IPC_STATUS_BAD_REQUEST;
+    memcpy(&args, payload, sizeof(args));
+    return invoke(req, &args, action_lookup_atom(args.action));
+
+  case IPC_OP_ACTION_INVOKE_NAME:
+    if (req->length <= sizeof(args)
+        || !payload_name(payload + sizeof(args), req->length - sizeof(args), name))
+      return IPC_STATUS_BAD_REQUEST;
+    memcpy(&args, payload, sizeof(args));
+    return invoke(req, &args, action_lookup(name));
+  }
+
+  return IPC_STATUS_UNKNOWN_OP;
+}
+
+/*
+ * Event stream
+ */
+static uint16_t
+subscribe(IpcConnection* conn, const IpcHeader* req, const uint8_t* payload)
+{
+  if (req->length != sizeof(uint64_t))
+    return IPC_STATUS_BAD_REQUEST;
+
+  memcpy(&conn->subscriptions, payload, sizeof(conn->subscriptions));
+  conn->missed = 0;
+  conn->resync = false;
+  subscriptions_update();
+  return IPC_STATUS_OK;
+}
+
+/*
+ * Handle one complete request frame. Returns false if the connection
+ * must be dropped (out of memory).
+ */
+static bool
+handle_request(IpcConnection* conn, const IpcHeader* req, const uint8_t* payload)
+{
+  uint32_t start;
+  uint16_t status;
+  bool     ok = true;
+
+  stats.requests++;
+
+  if (!reply_begin(conn, req, &start))
+    return false;
+
+  switch (req->op) {
+  case IPC_OP_PING:
+    ok     = reply_append(conn, payload, req->length);
+    status = IPC_STATUS_OK;
+    break;
+
+  case IPC_OP_STATE:
+  case IPC_OP_CLIENTS:
+  case IPC_OP_MONITORS:
+  case IPC_OP_CLIENT:
+    status = query(conn, req, payload, &ok);
+    break;
+
+  case IPC_OP_ACTION_LOOKUP:
+  case IPC_OP_ACTION_INVOKE:
+  case IPC_OP_ACTION_INVOKE_NAME:
+    status = action_request(conn, req, payload, &ok);
+    break;
+
+  case IPC_OP_SUBSCRIBE:
+    status = subscribe(conn, req, payload);
+    break;
+
+  default:
+    status = IPC_STATUS_UNKNOWN_OP;
+    break;
+  }
+
+  if (!ok)
+    return false;
+
+  /* Errors carry no payload */
+  if (status != IPC_STATUS_OK) {
+    conn->out_len = start;
+    return reply_status(conn, req, status);
+  }
+
+  reply_end(conn, start, status);
+  return true;
+}
+
+/*
+ * Handle every complete frame in the input buffer and keep the rest.
+ * Returns false on a protocol error or when out of memory.
+ */
+static bool
+connection_process(IpcConnection* conn)
+{
+  uint32_t pos = 0;
+
+  while (conn->in_len - pos >= sizeof(IpcHeader)) {
+    IpcHeader req;
+    memcpy(&req, conn->in + pos, sizeof(req));
+
+    if (req.length > IPC_MAX_PAYLOAD) {
+      LOG_WARN("ipc: dropping client sending a %u byte frame", req.length);
+      return false;
+    }
+    if (conn->in_len - pos - sizeof(IpcHeader) < req.length)
+      break;
+
+    if (!handle_request(conn, &req, conn->in + pos + sizeof(IpcHeader)))
+      return false;
+    pos += sizeof(IpcHeader) + req.length;
+  }
+
+  if (pos > 0) {
+    memmove(conn->in, conn->in + pos, conn->in_len - pos);
+    conn->in_len -= pos;
+  }
+  return true;
+}
+
+/*
+ * Write as much pending output as the socket takes.
+ * Returns false if the connection failed.
+ */
+static bool
+connection_flush(IpcConnection* conn)
+{
+  bool ok = true;
+
+  while (conn->out_sent < conn->out_len) {
+    ssize_t n = send(conn->fd, conn->out + conn->out_sent, conn->out_len - conn->out_sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      ok = errno == EAGAIN || errno == EWOULDBLOCK;
+      break;
+    }
+    conn->out_sent += n;
+    stats.bytes_out += n;
+  }
+
+  /*
+   * Move the unsent tail to the front: new output is appended at out_len,
+   * so a reader that is always a little behind would otherwise grow the
+   * buffer forever.
+   */
+  if (conn->out_sent > 0) {
+    memmove(conn->out, conn->out + conn->out_sent, conn->out_len - conn->out_sent);
+    conn->out_len -= conn->out_sent;
+    conn->out_sent = 0;
+  }
+  return ok;
+}
+
+static uint32_t
+connection_pending(const IpcConnection* conn)
+{
+  return conn->out_len - conn->out_sent;
+}
+
+/*
+ * Read what the socket has, handling frames as they complete. Stops early
+ * while the client leaves too much output unread.
+ * Returns false when the client hung up or the connection failed.
+ */
+static bool
+connection_read(IpcConnection* conn)
+{
+  while (connection_pending(conn) < IPC_MAX_PENDING_OUTPUT) {
+    if (!buffer_reserve(&conn->in, &conn->in_cap, conn->in_len + IPC_READ_CHUNK))
+      return false;
+
+    ssize_t n = read(conn->fd, conn->in + conn->in_len, IPC_READ_CHUNK);
+    if (n == 0)
+      return false;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    conn->in_len += n;
+    stats.bytes_in += n;
+    if (!connection_process(conn))
+      return false;
+  }
+  return true;
+}
+
+/* Watch for output space only while output is pending, pause a slow reader */
+static void
+connection_update_events(IpcConnection* conn)
+{
+  uint32_t pending = connection_pending(conn);
+  uint32_t events  = (pending < IPC_MAX_PENDING_OUTPUT ? EPOLLIN : 0) | (pending > 0 ? EPOLLOUT : 0);
+
+  if (events != conn->events && loop_modify_fd(conn->fd, events) == 0)
+    conn->events = events;
+}
+
+static void
+connection_ready(int fd, uint32_t events, void* userdata)
+{
+  IpcConnection* conn = userdata;
+  (void) fd;
+
+  bool ok = true;
+  if (events & EPOLLIN)
+    ok = connection_read(conn);
+  else if (events & (EPOLLERR | EPOLLHUP))
+    ok = false;
+
+  /* Answer right away; EPOLLOUT only covers what the socket refused */
+  if (ok)
+    ok = connection_flush(conn);
+
+  if (!ok) {
+    /* Hang up: best effort for responses to the requests already read */
+    connection_flush(conn);
+    connection_close(conn);
+    return;
+  }
+
+  connection_update_events(conn);
+}
+
+/*
+ * Event stream delivery
+ */
+static uint32_t
+event_hash(EventType type, TargetID target)
+{
+  uint64_t h = (target ^ ((uint64_t) type << 56)) * UINT64_C(0x9E3779B97F4A7C15);
+  return (uint32_t) (h >> 32) & (IPC_EVENT_INDEX_SIZE - 1);
+}
+
+/* Hub handler for every subscribed type: record or coalesce the pair */
+static void
+on_event(Event event)
+{
+  if (event.type >= IPC_MAX_EVENT_TYPES)
+    return;
+
+  stats.events++;
+
+  uint32_t slot = event_hash(event.type, event.target);
+  while (pending_index[slot] != 0) {
+    IpcEvent* pending = &pending_events[pending_index[slot] - 1];
+    if (pending->type == event.type && pending->target == event.target) {
+      pending->count++;
+      stats.events_coalesced++;
+      return;
+    }
+    slot = (slot + 1) & (IPC_EVENT_INDEX_SIZE - 1);
+  }
+
+  uint64_t bit = UINT64_C(1) << event.type;
+  if (pending_count == IPC_MAX_PENDING_EVENTS) {
+    overflow_types |= bit;
+    return;
+  }
+
+  pending_events[pending_count] = (IpcEvent) { .target = event.target, .type = event.type, .count = 1 };
+  pending_index[slot]           = ++pending_count;
+  pending_types |= bit;
+}
+
+/* Append one IPC_OP_EVENTS frame with the pending entries conn subscribed to */
+static bool
+push_events(IpcConnection* conn, uint64_t snapshot)
+{
+  IpcHeader     frame = { .op = IPC_OP_EVENTS, .seq = conn->event_seq++ };
+  IpcEventBatch batch = { .snapshot = snapshot };
+  uint32_t      start;
+
+  if (!reply_begin(conn, &frame, &start))
+    return false;
+
+  uint32_t batch_at = conn->out_len;
+  if (!reply_append(conn, &batch, sizeof(batch)))
+    return false;
+
+  for (uint32_t i = 0; i < pending_count; i++) {
+    if (!(conn->subscriptions & (UINT64_C(1) << pending_events[i].type)))
+      continue;
+    if (!reply_append(conn, &pending_events[i], sizeof(IpcEvent)))
+      return false;
+    batch.count++;
+  }
+
+  /* The buffer may have moved while appending */
+  memcpy(conn->out + batch_at, &batch, sizeof(batch));
+  reply_end(conn, start, IPC_STATUS_OK);
+  stats.event_batches++;
+  return true;
+}
+
+/* Append the state in place of the events a lagging subscriber missed */
+static bool
+push_resync(IpcConnection* conn, const WmSnapshot* s)
+{
+  IpcHeader     frame = { .op = IPC_OP_EVENTS, .seq = conn->event_seq++ };
+  IpcEventBatch batch = { .snapshot = s != NULL ? s->sequence : 0, .flags = IPC_EVENTS_RESYNC };
+  IpcState      state = ipc_state(s);
+  uint32_t      start;
+
+  if (!reply_begin(conn, &frame, &start)
+      || !reply_append(conn, &batch, sizeof(batch))
+      || !reply_append(conn, &state, sizeof(state)))
+    return false;
+
+  reply_end(conn, start, IPC_STATUS_OK);
+  stats.event_batches++;
+  stats.resyncs++;
+  return true;
+}
+
+/*
+ * Push this iteration's events to one subscriber. Returns false if the
+ * connection must be dropped.
+ */
+static bool
+connection_push(IpcConnection* conn, const WmSnapshot* s)
+{
+  uint64_t types = conn->subscriptions & pending_types;
+  if (conn->subscriptions & overflow_types)
+    conn->resync = true;
+
+  if (types == 0 && !conn->resync)
+    return true;
+
+  /* Behind: never queue more, the state replaces what it misses */
+  if (connection_pending(conn) > IPC_EVENT_BACKLOG) {
+    if (types != 0 || (conn->subscriptions & overflow_types)) {
+      conn->resync = true;
+      if (++conn->missed > IPC_EVENT_MAX_MISSED) {
+        LOG_WARN("ipc: dropping a subscriber %u event batches behind", conn->missed);
+        stats.dropped_lagging++;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ok = conn->resync ? push_resync(conn, s) : push_events(conn, s != NULL ? s->sequence : 0);
+
+  conn->resync = false;
+  conn->missed = 0;
+  return ok && connection_flush(conn);
+}
+
+/*
+ * Prepare hook: runs after the X hook has handled the iteration's events
+ * and published the snapshot, so each batch matches a snapshot.
+ */
+static void
+ipc_prepare(void* userdata)
+{
+  (void) userdata;
+
+  if (subscribed_types == 0)
+    return;
+
+  const WmSnapshot* s = snapshot_acquire();
+
+  for (uint32_t i = 0; i < IPC_MAX_CONNECTIONS; i++) {
+    IpcConnection* conn = connections[i];
+    if (conn == NULL || conn->subscriptions == 0)
+      continue;
+
+    if (!connection_push(conn, s)) {
+      connection_close(conn);
+      continue;
+    }
+    connection_update_events(conn);
+  }
+
+  snapshot_release(s);
+
+  if (pending_count > 0)
+    memset(pending_index, 0, sizeof(pending_index));
+  pending_count  = 0;
+  pending_types  = 0;
+  overflow_types = 0;
+}
+
+static void
+accept_ready(int fd, uint32_t events, void* userdata)
+{
+  (void) events;
+  (void) userdata;
+
+  for (;;) {
+    int client = accept(fd, NULL, NULL);
+    if (client < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        LOG_ERROR("ipc: accept failed: %s", strerror(errno));
+      return;
+    }
+
+    /* accept4 needs _GNU_SOURCE, the build only asks for _DEFAULT_SOURCE */
+    if (fcntl(client, F_SETFL, O_NONBLOCK) < 0 || fcntl(client, F_SETFD, FD_CLOEXEC) < 0) {
+      LOG_ERROR("ipc: cannot make connection non-blocking: %s", strerror(errno));
+      stats.refused++;
+      close(client);
+      continue;
+    }
+
+    uint32_t slot = 0;
+    while (slot < IPC_MAX_CONNECTIONS && connections[slot] != NULL)
+      slot++;
+
+    IpcConnection* conn = slot < IPC_MAX_CONNECTIONS ? calloc(1, sizeof(*conn)) : NULL;
+    if (conn == NULL) {
+      LOG_WARN("ipc: refusing connection, %d clients connected", IPC_MAX_CONNECTIONS);
+      stats.refused++;
+      close(client);
+      continue;
+    }
+
+    conn->fd     = client;
+    conn->events = EPOLLIN;
+    if (loop_add_fd(client, conn->events, connection_ready, conn) < 0) {
+      stats.refused++;
+      close(client);
+      free(conn);
+      continue;
+    }
+
+    connections[slot] = conn;
+    stats.accepted++;
+    stats.connections++;
+  }
+}
+
+static bool
+default_socket_path(char* path, size_t size)
+{
+  const char* env = getenv(IPC_SOCKET_ENV);
+  if (env != NULL && env[0] != '\0')
+    return (size_t) snprintf(path, size, "%s", env) < size;
+
+  const char* runtime = getenv("XDG_RUNTIME_DIR");
+  if (runtime != NULL && runtime[0] != '\0')
+    return (size_t) snprintf(path, size, "%s/wm-xcb.sock", runtime) < size;
+
+  return (size_t) snprintf(path, size, "/tmp/wm-xcb-%u.sock", (unsigned) getuid()) < size;
+}
+
+/*
+ * Clear the way for bind: only a socket nobody answers on is left over
+ * from an earlier run. Anything else at the path is not ours to remove.
+ */
+static bool
+remove_stale_socket(const struct sockaddr_un* addr)
+{
+  struct stat st;
+  if (lstat(socket_path, &st) < 0)
+    return errno == ENOENT;
+
+  if (!S_ISSOCK(st.st_mode)) {
+    LOG_ERROR("ipc: %s exists and is not a socket", socket_path);
+    return false;
+  }
+
+  /* Non-blocking, a listener with a full backlog still counts as live */
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (probe < 0)
+    return false;
+  bool live = connect(probe, (const struct sockaddr*) addr, sizeof(*addr)) == 0 || errno == EAGAIN;
+  close(probe);
+  if (live) {
+    LOG_ERROR("ipc: another instance is listening on %s", socket_path);
+    return false;
+  }
+
+  return unlink(socket_path) == 0 || errno == ENOENT;
+}
+
+int
+ipc_init(const char* path)
+{
+  if (listen_fd >= 0) {
+    LOG_WARN("ipc: already listening on %s", socket_path);
+    return 0;
+  }
+
+  bool fits = path != NULL ? (size_t) snprintf(socket_path, sizeof(socket_path), "%s", path) < sizeof(socket_path)
+                           : default_socket_path(socket_path, sizeof(socket_path));
+  if (!fits) {
+    LOG_ERROR("ipc: socket path too long");
+    return -1;
+  }
+
+  listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd < 0) {
+    LOG_ERROR("ipc: cannot create socket: %s", strerror(errno));
+    return -1;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, socket_path, sizeof(socket_path));
+
+  if (!remove_stale_socket(&addr)) {
+    close(listen_fd);
+    listen_fd = -1;
+    return -1;
+  }
+
+  /* Created owner-only, there is no window where others can connect */
+  mode_t old_umask = umask(S_IXUSR | S_IRWXG | S_IRWXO);
+  bool   bound     = bind(listen_fd, (struct sockaddr*) &addr, sizeof(addr)) == 0;
+  umask(old_umask);
+
+  if (!bound || listen(listen_fd, IPC_MAX_CONNECTIONS) < 0
+      || loop_add_fd(listen_fd, EPOLLIN, accept_ready, NULL) < 0) {
+    LOG_ERROR("ipc: cannot listen on %s: %s", socket_path, strerror(errno));
+    close(listen_fd);
+    if (bound)
+      unlink(socket_path);
+    listen_fd = -1;
+    return -1;
+  }
+
+  /* Registered after the X hook, so event batches go out after it ran */
+  if (loop_add_prepare_hook(ipc_prepare, NULL) < 0)
+    LOG_WARN("ipc: no prepare hook left, event streams are disabled");
+
+  memset(&stats, 0, sizeof(stats));
+  LOG_DEBUG("ipc: listening on %s", socket_path);
+  return 0;
+}
+
+void
+ipc_shutdown(void)
+{
+  for (uint32_t i = 0; i < IPC_MAX_CONNECTIONS; i++) {
+    if (connections[i] != NULL)
+      connection_close(connections[i]);
+  }
+
+  loop_remove_prepare_hook(ipc_prepare);
+  if (pending_count > 0)
+    memset(pending_index, 0, sizeof(pending_index));
+  pending_count  = 0;
+  pending_types  = 0;
+  overflow_types = 0;
+
+  if (listen_fd >= 0) {
+    loop_remove_fd(listen_fd);
+    close(listen_fd);
+    unlink(socket_path);
+    listen_fd = -1;
+  }
+}
+
+const char*
+ipc_socket_path(void)
+{
+  return listen_fd >= 0 ? socket_path : NULL;
+}
+
+IpcStats
+ipc_get_stats(void)
+{
+  IpcStats s = stats;
+  for (uint32_t i = 0; i < IPC_MAX_CONNECTIONS; i++) {
+    if (connections[i] == NULL)
+      continue;
+    s.output_pending += connection_pending(connections[i]);
+    s.output_capacity += connections[i]->out_cap;
+  }
+  return s;
+}
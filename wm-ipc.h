@@ -0,0 +1,206 @@
+/*
+ * IPC - Unix socket control channel
+ *
+ * Scripts and test harnesses drive the window manager through a Unix
+ * stream socket serviced by the main loop. Every connection is
+ * non-blocking with its own input and output buffer, so a slow or
+ * misbehaving client never stalls event handling.
+ *
+ * Protocol: a stream of frames, each an IpcHeader followed by `length`
+ * payload bytes, in host byte order (the socket never leaves the
+ * machine). A client may write any number of requests at once; they are
+ * handled in order and every request gets exactly one response frame
+ * with the same op and seq, so responses can be matched without waiting
+ * for each one:
+ *
+ *   request:  IpcHeader { length, op, 0, seq } payload
+ *   response: IpcHeader { length, op, status, seq } payload
+ *
+ * Queries answer from the state snapshot published at the end of the
+ * previous loop iteration (see src/components/state-snapshot.h); effects
+ * of commands in the same write show up from the next iteration on.
+ *
+ * Event stream: after IPC_OP_SUBSCRIBE, the server also pushes
+ * IPC_OP_EVENTS frames, at most one per loop iteration, listing the hub
+ * events of the subscribed types seen in that iteration. Each (type,
+ * target) pair appears once with the number of times it happened. A
+ * subscriber that does not keep up gets no events until it has read its
+ * backlog, then one IPC_EVENTS_RESYNC frame carrying the current state
+ * instead of what it missed; one that stays behind is dropped.
+ */
+
+#ifndef _WM_IPC_H_
+#define _WM_IPC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Environment variable overriding the default socket path */
+#define IPC_SOCKET_ENV "WM_IPC_SOCKET"
+
+/* Connections served at once; more are refused */
+#define IPC_MAX_CONNECTIONS 16
+
+/* Largest payload accepted in a request; bigger frames drop the client */
+#define IPC_MAX_PAYLOAD 65536
+
+/* Output a client may leave unread before its input is paused */
+#define IPC_MAX_PENDING_OUTPUT (1024 * 1024)
+
+/* Subscribable event types: bit n of a subscription mask is type n */
+#define IPC_MAX_EVENT_TYPES 64
+
+/* Distinct (type, target) pairs collected per loop iteration */
+#define IPC_MAX_PENDING_EVENTS 256
+
+/* Unread output past which a subscriber is sent no event batches */
+#define IPC_EVENT_BACKLOG (64 * 1024)
+
+/* Event batches a subscriber may miss in a row before it is dropped */
+#define IPC_EVENT_MAX_MISSED 256
+
+typedef struct IpcHeader {
+  uint32_t length; /* payload bytes following the header */
+  uint16_t op;     /* IPC_OP_*, echoed in the response */
+  uint16_t status; /* IPC_STATUS_* in responses, 0 in requests */
+  uint32_t seq;    /* chosen by the client, echoed in the response */
+} IpcHeader;
+
+enum {
+  IPC_OP_PING               = 1,  /* payload echoed back */
+  IPC_OP_STATE              = 2,  /* -> IpcState */
+  IPC_OP_CLIENTS            = 3,  /* -> IpcClient[] */
+  IPC_OP_MONITORS           = 4,  /* -> IpcMonitor[] */
+  IPC_OP_CLIENT             = 5,  /* uint64_t id -> IpcClient, title\0, class\0 */
+  IPC_OP_ACTION_LOOKUP      = 6,  /* name -> uint32_t action id */
+  IPC_OP_ACTION_INVOKE      = 7,  /* IpcInvoke */
+  IPC_OP_ACTION_INVOKE_NAME = 8,  /* IpcInvoke, then the name */
+  IPC_OP_SUBSCRIBE          = 9,  /* uint64_t event type mask, 0 to stop */
+  IPC_OP_EVENTS             = 10, /* pushed: IpcEventBatch, then entries */
+};
+
+enum {
+  IPC_STATUS_OK          = 0,
+  IPC_STATUS_BAD_REQUEST = 1, /* payload has the wrong size */
+  IPC_STATUS_UNKNOWN_OP  = 2,
+  IPC_STATUS_NOT_FOUND   = 3, /* no such target or action */
+  IPC_STATUS_FAILED      = 4, /* the action ran and reported failure */
+  IPC_STATUS_NO_STATE    = 5, /* no state snapshot published yet */
+};
+
+typedef struct IpcState {
+  uint64_t sequence; /* snapshot sequence number */
+  uint64_t focused_client;
+  uint64_t selected_monitor;
+  uint32_t client_count;
+  uint32_t monitor_count;
+  uint32_t tag_count;
+  uint32_t reserved;
+} IpcState;
+
+/* IpcClient.flags */
+enum {
+  IPC_CLIENT_MANAGED    = 1 << 0,
+  IPC_CLIENT_MAPPED     = 1 << 1,
+  IPC_CLIENT_URGENT     = 1 << 2,
+  IPC_CLIENT_FOCUSED    = 1 << 3,
+  IPC_CLIENT_FULLSCREEN = 1 << 4,
+};
+
+typedef struct IpcClient {
+  uint64_t id;
+  uint64_t monitor; /* 0 if not on a monitor */
+  uint32_t window;
+  uint32_t tags;
+  int16_t  x;
+  int16_t  y;
+  uint16_t width;
+  uint16_t height;
+  uint32_t flags; /* IPC_CLIENT_* */
+  uint32_t reserved;
+} IpcClient;
+
+typedef struct IpcMonitor {
+  uint64_t id;
+  int16_t  x;
+  int16_t  y;
+  uint16_t width;
+  uint16_t height;
+  uint32_t tagset;
+  uint32_t layout;   /* LayoutState */
+  uint32_t selected; /* 1 for the selected monitor */
+  uint32_t reserved;
+} IpcMonitor;
+
+/* IpcInvoke.flags */
+enum {
+  IPC_INVOKE_HAS_ARG = 1 << 0, /* pass arg as the action's data */
+};
+
+/*
+ * Action invocation. The action id comes from IPC_OP_ACTION_LOOKUP and
+ * stays valid for the life of the window manager, so a client resolves
+ * each name once. A target of 0 lets the action resolve its own (e.g. the
+ * focused client). The request's seq is the invocation's correlation_id.
+ */
+typedef struct IpcInvoke {
+  uint32_t action; /* ignored by IPC_OP_ACTION_INVOKE_NAME */
+  uint32_t flags;  /* IPC_INVOKE_* */
+  uint64_t target;
+  int64_t  arg;
+} IpcInvoke;
+
+/* IpcEventBatch.flags */
+enum {
+  IPC_EVENTS_RESYNC = 1 << 0, /* events were lost: no entries, an IpcState follows */
+};
+
+/*
+ * Payload of a pushed IPC_OP_EVENTS frame, followed by `count` IpcEvent
+ * entries in the order their pairs first occurred. The frame's seq counts
+ * the batches pushed to this client, from 0.
+ */
+typedef struct IpcEventBatch {
+  uint64_t snapshot; /* sequence of the snapshot that includes these events */
+  uint32_t count;
+  uint32_t flags; /* IPC_EVENTS_* */
+} IpcEventBatch;
+
+typedef struct IpcEvent {
+  uint64_t target;
+  uint32_t type;
+  uint32_t count; /* occurrences coalesced into this entry */
+} IpcEvent;
+
+typedef struct IpcStats {
+  uint64_t accepted; /* connections accepted */
+  uint64_t refused;  /* connections refused, table full */
+  uint64_t requests; /* frames handled */
+  uint64_t bytes_in;
+  uint64_t bytes_out;
+  uint64_t events;           /* hub events collected for subscribers */
+  uint64_t events_coalesced; /* events folded into a pending pair */
+  uint64_t event_batches;    /* IPC_OP_EVENTS frames pushed */
+  uint64_t resyncs;          /* IPC_EVENTS_RESYNC frames pushed */
+  uint64_t dropped_lagging;  /* subscribers dropped for falling behind */
+  uint64_t output_pending;   /* bytes the sockets did not take yet, now */
+  uint64_t output_capacity;  /* bytes allocated for output buffers, now */
+  uint32_t connections;      /* open now */
+} IpcStats;
+
+/*
+ * Listen on `path`, or on the default path when NULL: $WM_IPC_SOCKET,
+ * else $XDG_RUNTIME_DIR/wm-xcb.sock, else /tmp/wm-xcb-<uid>.sock.
+ * A socket left there by an earlier run is replaced; anything else at
+ * the path, or a socket another process answers on, makes this fail.
+ * The loop must be initialized. Returns 0 on success, -1 on failure.
+ */
+int  ipc_init(const char* path);
+void ipc_shutdown(void);
+
+/* Path being listened on, or NULL */
+const char* ipc_socket_path(void);
+
+IpcStats ipc_get_stats(void);
+
+#endif /* _WM_IPC_H_ */
@@ -0,0 +1,374 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "wm-log.h"
+#include "wm-loop.h"
+#include "wm-running.h"
+
+/* Maximum events fetched by a single epoll_wait() */
+#define LOOP_MAX_EVENTS 32
+
+/*
+ * Source slot
+ * The epoll user data packs (generation << 32 | slot index) so that an
+ * event for a source removed earlier in the same batch is recognised as
+ * stale and skipped, even if the slot has been reused meanwhile.
+ */
+typedef struct LoopSource {
+  int              fd;
+  uint32_t         generation;
+  bool             active;
+  bool             is_timer;
+  LoopFdHandler    fd_handler;
+  LoopTimerHandler timer_handler;
+  void*            userdata;
+} LoopSource;
+
+typedef struct LoopPrepare {
+  LoopPrepareHook hook;
+  void*           userdata;
+} LoopPrepare;
+
+static int         epoll_fd = -1;
+static LoopSource  sources[LOOP_MAX_SOURCES];
+static uint32_t    source_count = 0;
+static LoopPrepare prepare_hooks[LOOP_MAX_PREPARE_HOOKS];
+static uint32_t    prepare_count = 0;
+static LoopStats   stats;
+
+static LoopSource*
+find_source(int fd)
+{
+  for (uint32_t i = 0; i < LOOP_MAX_SOURCES; i++) {
+    if (sources[i].active && sources[i].fd == fd)
+      return &sources[i];
+  }
+  return NULL;
+}
+
+static LoopSource*
+alloc_source(void)
+{
+  for (uint32_t i = 0; i < LOOP_MAX_SOURCES; i++) {
+    if (!sources[i].active)
+      return &sources[i];
+  }
+  return NULL;
+}
+
+static int
+add_source(int fd, uint32_t events, LoopSource* src)
+{
+  struct epoll_event ev;
+  uint32_t           idx = (uint32_t) (src - sources);
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events   = events;
+  ev.data.u64 = ((uint64_t) src->generation << 32) | idx;
+
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    LOG_ERROR("loop: cannot watch fd %d: %s", fd, strerror(errno));
+    return -1;
+  }
+
+  src->fd     = fd;
+  src->active = true;
+  source_count++;
+  return 0;
+}
+
+static void
+release_source(LoopSource* src)
+{
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, src->fd, NULL);
+  src->active        = false;
+  src->fd            = -1;
+  src->fd_handler    = NULL;
+  src->timer_handler = NULL;
+  src->userdata      = NULL;
+  src->generation++;
+  source_count--;
+}
+
+static void
+ms_to_timespec(uint32_t ms, struct timespec* ts)
+{
+  ts->tv_sec  = ms / 1000;
+  ts->tv_nsec = (long) (ms % 1000) * 1000000L;
+}
+
+int
+loop_init(void)
+{
+  if (epoll_fd >= 0)
+    return 0;
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    LOG_FATAL("loop: epoll_create1 failed: %s", strerror(errno));
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < LOOP_MAX_SOURCES; i++) {
+    sources[i].fd     = -1;
+    sources[i].active = false;
+  }
+  source_count  = 0;
+  prepare_count = 0;
+  memset(&stats, 0, sizeof(stats));
+  return 0;
+}
+
+void
+loop_shutdown(void)
+{
+  if (epoll_fd < 0)
+    return;
+
+  for (uint32_t i = 0; i < LOOP_MAX_SOURCES; i++) {
+    if (!sources[i].active)
+      continue;
+    int  fd       = sources[i].fd;
+    bool is_timer = sources[i].is_timer;
+    release_source(&sources[i]);
+    if (is_timer)
+      close(fd);
+  }
+
+  close(epoll_fd);
+  epoll_fd      = -1;
+  source_count  = 0;
+  prepare_count = 0;
+}
+
+int
+loop_add_fd(int fd, uint32_t events, LoopFdHandler handler, void* userdata)
+{
+  if (epoll_fd < 0 || fd < 0 || handler == NULL)
+    return -1;
+
+  if (find_source(fd) != NULL) {
+    LOG_ERROR("loop: fd %d already registered", fd);
+    return -1;
+  }
+
+  LoopSource* src = alloc_source();
+  if (src == NULL) {
+    LOG_ERROR("loop: source table full (max %d)", LOOP_MAX_SOURCES);
+    return -1;
+  }
+
+  src->is_timer      = false;
+  src->fd_handler    = handler;
+  src->timer_handler = NULL;
+  src->userdata      = userdata;
+  return add_source(fd, events, src);
+}
+
+int
+loop_modify_fd(int fd, uint32_t events)
+{
+  LoopSource* src = find_source(fd);
+  if (src == NULL)
+    return -1;
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events   = events;
+  ev.data.u64 = ((uint64_t) src->generation << 32) | (uint32_t) (src - sources);
+
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+    LOG_ERROR("loop: cannot modify fd %d: %s", fd, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+int
+loop_remove_fd(int fd)
+{
+  LoopSource* src = find_source(fd);
+  if (src == NULL || src->is_timer)
+    return -1;
+
+  release_source(src);
+  return 0;
+}
+
+LoopTimer
+loop_add_timer(uint32_t delay_ms, uint32_t interval_ms, LoopTimerHandler handler, void* userdata)
+{
+  if (epoll_fd < 0 || handler == NULL)
+    return -1;
+
+  LoopSource* src = alloc_source();
+  if (src == NULL) {
+    LOG_ERROR("loop: source table full (max %d)", LOOP_MAX_SOURCES);
+    return -1;
+  }
+
+  int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (tfd < 0) {
+    LOG_ERROR("loop: timerfd_create failed: %s", strerror(errno));
+    return -1;
+  }
+
+  src->is_timer      = true;
+  src->fd_handler    = NULL;
+  src->timer_handler = handler;
+  src->userdata      = userdata;
+  if (add_source(tfd, EPOLLIN, src) < 0) {
+    close(tfd);
+    return -1;
+  }
+
+  if (loop_rearm_timer(tfd, delay_ms, interval_ms) < 0) {
+    loop_cancel_timer(tfd);
+    return -1;
+  }
+
+  return tfd;
+}
+
+int
+loop_rearm_timer(LoopTimer timer, uint32_t delay_ms, uint32_t interval_ms)
+{
+  LoopSource* src = find_source(timer);
+  if (src == NULL || !src->is_timer)
+    return -1;
+
+  struct itimerspec spec;
+  /* a zero it_value would disarm the timer */
+  ms_to_timespec(delay_ms ? delay_ms : 1, &spec.it_value);
+  ms_to_timespec(interval_ms, &spec.it_interval);
+
+  if (timerfd_settime(timer, 0, &spec, NULL) < 0) {
+    LOG_ERROR("loop: timerfd_settime failed: %s", strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+int
+loop_cancel_timer(LoopTimer timer)
+{
+  LoopSource* src = find_source(timer);
+  if (src == NULL || !src->is_timer)
+    return -1;
+
+  release_source(src);
+  close(timer);
+  return 0;
+}
+
+int
+loop_add_prepare_hook(LoopPrepareHook hook, void* userdata)
+{
+  if (hook == NULL || prepare_count >= LOOP_MAX_PREPARE_HOOKS)
+    return -1;
+
+  prepare_hooks[prepare_count].hook     = hook;
+  prepare_hooks[prepare_count].userdata = userdata;
+  prepare_count++;
+  return 0;
+}
+
+void
+loop_remove_prepare_hook(LoopPrepareHook hook)
+{
+  for (uint32_t i = 0; i < prepare_count; i++) {
+    if (prepare_hooks[i].hook != hook)
+      continue;
+    memmove(&prepare_hooks[i], &prepare_hooks[i + 1],
+            (prepare_count - i - 1) * sizeof(LoopPrepare));
+    prepare_count--;
+    return;
+  }
+}
+
+static void
+dispatch_timer(LoopSource* src)
+{
+  uint64_t expirations = 0;
+
+  if (read(src->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    return; /* spurious wakeup, EAGAIN */
+
+  stats.timer_runs++;
+  src->timer_handler(expirations, src->userdata);
+}
+
+int
+loop_iterate(int timeout_ms)
+{
+  struct epoll_event events[LOOP_MAX_EVENTS];
+
+  if (epoll_fd < 0)
+    return -1;
+
+  for (uint32_t i = 0; i < prepare_count; i++)
+    prepare_hooks[i].hook(prepare_hooks[i].userdata);
+
+  /* a prepare hook may have requested shutdown (e.g. X connection lost) */
+  if (!running)
+    return 0;
+
+  int n = epoll_wait(epoll_fd, events, LOOP_MAX_EVENTS, timeout_ms);
+  stats.wakeups++;
+
+  if (n < 0) {
+    if (errno == EINTR)
+      return 0;
+    LOG_ERROR("loop: epoll_wait failed: %s", strerror(errno));
+    return -1;
+  }
+
+  for (int i = 0; i < n; i++) {
+    uint32_t idx = (uint32_t) (events[i].data.u64 & 0xffffffffU);
+    uint32_t gen = (uint32_t) (events[i].data.u64 >> 32);
+    if (idx >= LOOP_MAX_SOURCES)
+      continue;
+
+    /* removed (or removed and reused) by an earlier callback in this batch */
+    LoopSource* src = &sources[idx];
+    if (!src->active || src->generation != gen)
+      continue;
+
+    stats.dispatched++;
+    if (src->is_timer)
+      dispatch_timer(src);
+    else
+      src->fd_handler(src->fd, events[i].events, src->userdata);
+  }
+
+  return n;
+}
+
+void
+loop_run(void)
+{
+  while (running) {
+    if (loop_iterate(-1) < 0)
+      break;
+  }
+}
+
+LoopStats
+loop_get_stats(void)
+{
+  return stats;
+}
+
+void
+loop_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t
+loop_source_count(void)
+{
+  return source_count;
+}
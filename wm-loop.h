@@ -0,0 +1,142 @@
+/*
+ * Event Loop - Blocking epoll main loop for the window manager
+ *
+ * The window manager sleeps in epoll_wait() until one of its file
+ * descriptors becomes readable: the X connection, the signalfd, a timerfd
+ * or any descriptor a component registered. An idle session therefore
+ * produces no wakeups at all.
+ *
+ * Sources:
+ * - fd sources: loop_add_fd() with an epoll event mask and a callback
+ * - timers: loop_add_timer() backed by timerfd, one-shot or periodic
+ * - prepare hooks: called before every blocking wait, used to drain
+ *   events XCB already buffered and to flush pending output requests
+ */
+
+#ifndef _WM_LOOP_H_
+#define _WM_LOOP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+/* Maximum number of fd sources (including timers) */
+#define LOOP_MAX_SOURCES       64
+
+/* Maximum number of prepare hooks */
+#define LOOP_MAX_PREPARE_HOOKS 8
+
+/* Called when a registered fd is ready; events is the epoll event mask */
+typedef void (*LoopFdHandler)(int fd, uint32_t events, void* userdata);
+
+/* Called when a timer expires; expirations counts missed periods too */
+typedef void (*LoopTimerHandler)(uint64_t expirations, void* userdata);
+
+/* Called before the loop blocks waiting for events */
+typedef void (*LoopPrepareHook)(void* userdata);
+
+/* Timer handle returned by loop_add_timer(), -1 on failure */
+typedef int LoopTimer;
+
+/*
+ * Loop statistics
+ * Used by benchmarks to verify the loop does not wake up when idle.
+ */
+typedef struct LoopStats {
+  uint64_t wakeups;    /* epoll_wait() returns, including timeouts */
+  uint64_t dispatched; /* fd callbacks invoked (timers included) */
+  uint64_t timer_runs; /* timer callbacks invoked */
+} LoopStats;
+
+/*
+ * Create the epoll instance.
+ * Returns 0 on success, -1 on failure.
+ */
+int loop_init(void);
+
+/*
+ * Close all timers and the epoll instance.
+ * Registered fds other than timers are owned by their callers and stay open.
+ */
+void loop_shutdown(void);
+
+/*
+ * Register a file descriptor with the loop.
+ *
+ * @param fd       File descriptor to watch
+ * @param events   epoll event mask (EPOLLIN, EPOLLOUT, ...)
+ * @param handler  Callback invoked when the fd is ready
+ * @param userdata Passed back to the callback
+ * @return 0 on success, -1 on failure
+ */
+int loop_add_fd(int fd, uint32_t events, LoopFdHandler handler, void* userdata);
+
+/*
+ * Change the epoll event mask of a registered fd.
+ * Returns 0 on success, -1 if the fd is not registered or epoll fails.
+ */
+int loop_modify_fd(int fd, uint32_t events);
+
+/*
+ * Remove a file descriptor from the loop.
+ * Safe to call from inside any loop callback, including the fd's own.
+ * Returns 0 on success, -1 if the fd is not registered.
+ */
+int loop_remove_fd(int fd);
+
+/*
+ * Create a timer.
+ *
+ * @param delay_ms    First expiration, relative to now (0 is treated as 1ms)
+ * @param interval_ms Period for repeating timers, 0 for one-shot
+ * @param handler     Callback invoked on expiration
+ * @param userdata    Passed back to the callback
+ * @return timer handle, or -1 on failure
+ *
+ * One-shot timers stay registered (disarmed) until loop_cancel_timer().
+ */
+LoopTimer loop_add_timer(uint32_t delay_ms, uint32_t interval_ms, LoopTimerHandler handler, void* userdata);
+
+/*
+ * Re-arm an existing timer with a new delay and interval.
+ * Returns 0 on success, -1 on failure.
+ */
+int loop_rearm_timer(LoopTimer timer, uint32_t delay_ms, uint32_t interval_ms);
+
+/*
+ * Cancel and destroy a timer.
+ * Returns 0 on success, -1 if the timer is unknown.
+ */
+int loop_cancel_timer(LoopTimer timer);
+
+/*
+ * Register a hook called before every blocking wait.
+ * Returns 0 on success, -1 if the hook table is full.
+ */
+int loop_add_prepare_hook(LoopPrepareHook hook, void* userdata);
+
+/*
+ * Remove a prepare hook. No-op if not registered.
+ */
+void loop_remove_prepare_hook(LoopPrepareHook hook);
+
+/*
+ * Run prepare hooks, wait up to timeout_ms (-1 blocks forever) and
+ * dispatch every ready source.
+ * Returns the number of ready sources, or -1 on error.
+ */
+int loop_iterate(int timeout_ms);
+
+/*
+ * Block and dispatch until the global running flag is cleared.
+ */
+void loop_run(void);
+
+/*
+ * Statistics
+ */
+LoopStats loop_get_stats(void);
+void      loop_reset_stats(void);
+uint32_t  loop_source_count(void);
+
+#endif
@@ -1,19 +1,30 @@
+#include <errno.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <string.h>
+#include <sys/signalfd.h>
 #include <sys/wait.h>
+#include <unistd.h>
 #include <xcb/xcb.h>
 
 #include "wm-log.h"
+#include "wm-loop.h"
 #include "wm-running.h"
 #include "wm-signals.h"
 #include "wm-xcb.h"
 
+/*
+ * Signals are blocked and delivered through a signalfd watched by the main
+ * loop, so they are handled synchronously between event batches instead of
+ * interrupting arbitrary code. The original mask is kept for children.
+ */
+static int      signal_fd = -1;
+static sigset_t original_mask;
+static bool     mask_saved = false;
+
 void
 sigchld(int unused)
 {
-  /* NOLINTNEXTLINE(performance-no-int-to-ptr) */
-  if (signal(SIGCHLD, sigchld) == SIG_ERR)
-    LOG_ERROR("cannot install SIGCHLD event handler:");
   while (0 < waitpid(-1, NULL, WNOHANG))
     ;
 }
@@ -25,16 +36,30 @@ sigint(int unused)
 
   printf("\n");
   LOG_DEBUG("received interrupt signal.");
+}
 
-  /* when XCB is blocking-waitfor events, changing running to 0 doesn't exit. */
-  // xcb_generic_event_t event;
-  // event.response_type = XCB_CLIENT_MESSAGE;
-  // xcb_send_event(dpy, false, root, XCB_EVENT_MASK_NO_EVENT, (char*)&event);
-  // xcb_flush(dpy);
+static void
+handle_signal_fd(int fd, uint32_t events, void* userdata)
+{
+  struct signalfd_siginfo info;
+
+  while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+    switch (info.ssi_signo) {
+    case SIGINT:
+    case SIGTERM:
+      sigint((int) info.ssi_signo);
+      break;
+    case SIGCHLD:
+      sigchld((int) info.ssi_signo);
+      break;
+    default:
+      break;
+    }
+  }
 }
 
-void
-setup_signals()
+static void
+setup_signal_handlers(void)
 {
   /* NOLINTNEXTLINE(performance-no-int-to-ptr) */
   if (signal(SIGINT, sigint) == SIG_ERR)
@@ -44,3 +69,53 @@ setup_signals()
   if (signal(SIGTERM, sigint) == SIG_ERR)
     LOG_FATAL("cannot install SIGTERM event handler");
 }
+
+void
+setup_signals()
+{
+  sigset_t mask;
+
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  sigaddset(&mask, SIGCHLD);
+
+  if (sigprocmask(SIG_BLOCK, &mask, &original_mask) < 0) {
+    LOG_ERROR("cannot block signals, falling back to handlers: %s", strerror(errno));
+    setup_signal_handlers();
+    return;
+  }
+  mask_saved = true;
+
+  signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (signal_fd < 0 || loop_add_fd(signal_fd, EPOLLIN, handle_signal_fd, NULL) < 0) {
+    LOG_ERROR("cannot watch signals via signalfd, falling back to handlers");
+    if (signal_fd >= 0)
+      close(signal_fd);
+    signal_fd = -1;
+    sigprocmask(SIG_SETMASK, &original_mask, NULL);
+    mask_saved = false;
+    setup_signal_handlers();
+  }
+}
+
+void
+destruct_signals()
+{
+  if (signal_fd >= 0) {
+    loop_remove_fd(signal_fd);
+    close(signal_fd);
+    signal_fd = -1;
+  }
+  if (mask_saved) {
+    sigprocmask(SIG_SETMASK, &original_mask, NULL);
+    mask_saved = false;
+  }
+}
+
+void
+restore_child_signals()
+{
+  if (mask_saved)
+    sigprocmask(SIG_SETMASK, &original_mask, NULL);
+}
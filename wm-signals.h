@@ -4,5 +4,9 @@
 void sigchld(int unused);
 void sigint(int unused);
 void setup_signals();
+void destruct_signals();
+
+/* restore the pre-setup_signals() mask; call in forked children before exec */
+void restore_child_signals();
 
 #endif
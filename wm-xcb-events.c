@@ -2,6 +2,7 @@
 #include <xcb/xinput.h>
 
 #include "src/target/client.h"
+#include "src/xcb/xcb-atoms.h"
 #include "wm-log.h"
 #include "wm-xcb-ewmh.h"
 #include "wm-xcb.h"
@@ -18,7 +19,11 @@ handle_property_notify(xcb_property_notify_event_t* event)
               event->atom,
               event->time,
               event->state);
-  print_atom_name(event->atom);
+  /* cache only: a property change never costs a round trip */
+  const char* name = xcb_atom_name(event->atom);
+  LOG_DEBUG("property %s changed on window %u",
+            name ? name : "(unknown)", event->window);
+  (void) name;
   return;
 }
 
@@ -4,6 +4,7 @@
 #include <xcb/xcb_atom.h>
 #include <xcb/xcb_ewmh.h>
 
+#include "src/xcb/xcb-atoms.h"
 #include "wm-log.h"
 #include "wm-xcb-ewmh.h"
 #include "wm-xcb.h"
@@ -31,65 +32,48 @@ destruct_ewmh()
 void
 print_atom_name(xcb_atom_t atom)
 {
-  xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(dpy, atom);
-  xcb_get_atom_name_reply_t* reply  = xcb_get_atom_name_reply(dpy, cookie, NULL);
-  if (reply == NULL) {
-    LOG_ERROR("Failed to get atom name\n");
+  const char* name = xcb_atom_name(atom);
+  if (name != NULL) {
+    LOG_DEBUG("atom name: %s", name);
     return;
   }
 
-  LOG_DEBUG("atom name: %s", xcb_get_atom_name_name(reply));
-
-  free(reply);
+  /* unknown: ask once, later calls find it in the cache */
+  LOG_DEBUG("atom name: #%u (resolving)", atom);
+  xcb_atom_resolve(dpy, atom);
 }
 
 /*
- * Check if _NET_WM_STATE contains _NET_WM_STATE_FULLSCREEN for a window.
+ * Check if a _NET_WM_STATE property reply contains _NET_WM_STATE_FULLSCREEN.
  *
- * Uses xcb_get_property directly to get the raw atom list.
+ * The reply comes from xcb_get_property() on the raw atom list.
  */
 bool
-ewmh_check_wm_state_fullscreen(xcb_ewmh_connection_t* ewmh, xcb_window_t window)
+ewmh_wm_state_has_fullscreen(const xcb_get_property_reply_t* reply)
 {
-  if (ewmh == NULL)
-    return false;
-
-  /* Get the _NET_WM_STATE property directly */
-  xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(
-      dpy, 0, window, ewmh->_NET_WM_STATE, XCB_GET_PROPERTY_TYPE_ANY, 0, 1024);
-
-  xcb_get_property_reply_t* reply = xcb_get_property_reply(dpy, cookie, NULL);
-  if (reply == NULL)
+  xcb_atom_t fullscreen = xcb_atom_get(ATOM_NET_WM_STATE_FULLSCREEN);
+  if (fullscreen == XCB_ATOM_NONE || reply == NULL)
     return false;
 
   /* Check format (should be 32 bits for atoms) */
-  if (reply->format != 32) {
-    free(reply);
+  if (reply->format != 32)
     return false;
-  }
 
-  /* Get length in atoms (format * length / 32 = number of atoms) */
-  uint32_t length = xcb_get_property_value_length(reply);
-  if (length == 0) {
-    free(reply);
+  /* Value length is in bytes */
+  uint32_t length = (uint32_t) xcb_get_property_value_length(reply);
+  if (length == 0)
     return false;
-  }
 
-  xcb_atom_t* atoms = (xcb_atom_t*) xcb_get_property_value(reply);
-  if (atoms == NULL) {
-    free(reply);
+  const xcb_atom_t* atoms = (const xcb_atom_t*) xcb_get_property_value(reply);
+  if (atoms == NULL)
     return false;
-  }
 
   /* Check if _NET_WM_STATE_FULLSCREEN is in the list */
   uint32_t count = length / sizeof(xcb_atom_t);
   for (uint32_t i = 0; i < count; i++) {
-    if (atoms[i] == ewmh->_NET_WM_STATE_FULLSCREEN) {
-      free(reply);
+    if (atoms[i] == fullscreen)
       return true;
-    }
   }
 
-  free(reply);
   return false;
 }
@@ -10,11 +10,16 @@ extern xcb_ewmh_connection_t* ewmh;
 
 void setup_ewmh();
 void destruct_ewmh();
+
+/*
+ * Log the name of an atom. Names missing from the atom cache are
+ * requested once, asynchronously (does not block).
+ */
 void print_atom_name(xcb_atom_t atom);
 
 /*
- * Check if _NET_WM_STATE contains _NET_WM_STATE_FULLSCREEN for a window.
+ * Check if a _NET_WM_STATE property reply contains _NET_WM_STATE_FULLSCREEN.
  */
-bool ewmh_check_wm_state_fullscreen(xcb_ewmh_connection_t* ewmh, xcb_window_t window);
+bool ewmh_wm_state_has_fullscreen(const xcb_get_property_reply_t* reply);
 
 #endif
@@ -3,9 +3,17 @@
 #include <xcb/xcb.h>
 #include <xcb/xinput.h>
 
+#include "src/components/client-adopt.h"
+#include "src/components/state-snapshot.h"
 #include "src/target/client.h"
+#include "src/xcb/xcb-atoms.h"
+#include "src/xcb/xcb-batch.h"
 #include "src/xcb/xcb-handler.h"
+#include "src/xcb/xcb-mirror.h"
+#include "src/xcb/xcb-reply.h"
+#include "wm-hub.h"
 #include "wm-log.h"
+#include "wm-loop.h"
 #include "wm-running.h"
 #include "wm-states.h"
 #include "wm-xcb-events.h"
@@ -14,7 +22,11 @@
 xcb_connection_t* dpy;
 xcb_window_t      root;
 
-void wm_manage_all_clients();
+/* Events drained during the current loop wakeup */
+static XCBBatch batch;
+
+static void xcb_fd_ready(int fd, uint32_t events, void* userdata);
+static void xcb_prepare(void* userdata);
 
 void
 error_details(xcb_generic_error_t* error)
@@ -70,6 +82,9 @@ setup_xinput_initialize()
   xcb_input_xi_query_version_reply_t* xi_reply  = xcb_input_xi_query_version_reply(dpy, xi_cookie, NULL);
   LOG_DEBUG("XInput version: %d.%d", xi_reply->major_version, xi_reply->minor_version);
   free(xi_reply);
+
+  /* XI2 events arrive as GenericEvents tagged with the extension opcode */
+  xcb_batch_set_xinput_opcode(xcb_handler_extension_opcode(XCB_EXT_XINPUT));
 }
 
 void
@@ -115,6 +130,12 @@ setup_xcb()
   if (!running)
     return;
 
+  /* Every atom we use, in one round trip */
+  xcb_atoms_intern(dpy);
+
+  /* Event bases of RandR and XInput, for extension-aware dispatch */
+  xcb_handler_resolve_extensions(dpy);
+
   setup_xinput_initialize();
   setup_xinput_events();
 
@@ -125,106 +146,161 @@ setup_xcb()
 
   xcb_map_window(dpy, root);
 
-  /* Note: root window is not a client */
-
-  wm_manage_all_clients();
+  /* Note: root window is not a client; existing windows are adopted by wm_manage_all_clients() */
 
   if (xcb_flush(dpy) <= 0)
     LOG_FATAL("failed to flush.");
 
+  /* Sleep in the main loop until the X server has something for us */
+  if (loop_add_fd(xcb_get_file_descriptor(dpy), EPOLLIN, xcb_fd_ready, NULL) < 0)
+    LOG_FATAL("cannot watch the X connection");
+  loop_add_prepare_hook(xcb_prepare, NULL);
+
+  /* Posted events wait for xcb_prepare(), once per iteration */
+  hub_set_event_deferral(true);
+
   LOG_DEBUG("root window id: %d", root);
 }
 
 void
 destruct_xcb()
 {
+  hub_set_event_deferral(false);
+  loop_remove_prepare_hook(xcb_prepare);
+  loop_remove_fd(xcb_get_file_descriptor(dpy));
+  xcb_batch_free(&batch);
+  xcb_reply_clear(dpy);
+  xcb_atoms_clear();
+
   /* Shutdown XCB handler registry */
   xcb_handler_shutdown();
 
   /* Tear down any remaining managed clients before disconnecting XCB */
   client_list_shutdown();
+  xcb_mirror_clear();
 
   xcb_disconnect(dpy);
 }
 
+/*
+ * Adopt the windows that were mapped before the WM started.
+ * Must run after the components are initialized so the new clients are
+ * registered with the hub and picked up by tiling, tags and focus.
+ */
 void
 wm_manage_all_clients()
 {
-  static uint32_t values[3];
-
-  // events we want to "hijack" from child windows
-  values[0] = 0 | XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW;
+  uint32_t adopted = client_adopt_existing(dpy, root);
+  LOG_DEBUG("adopted %u pre-existing windows", adopted);
+  (void) adopted;
 
-  // 1. query all the window descendants of the root window
-  xcb_query_tree_cookie_t tree_cookie = xcb_query_tree_unchecked(dpy, root);
-  xcb_query_tree_reply_t* reply       = xcb_query_tree_reply(dpy, tree_cookie, NULL);
+  xcb_flush(dpy);
+}
 
-  if (!reply)
+static void
+dispatch_xcb_event(xcb_generic_event_t* event)
+{
+  /* Handle errors (response_type = 0) */
+  if (event->response_type == 0) {
+    error_details((xcb_generic_error_t*) event);
+    free(event);
     return;
+  }
 
-  // ALL the windows, includeing children of children.
-  xcb_window_t* children        = xcb_query_tree_children(reply);
-  uint16_t      children_length = xcb_query_tree_children_length(reply);
-  free(reply);
+  /* Dispatch to registered handlers */
+  xcb_handler_dispatch(event);
 
-  // 2. create a data structure to store the cookies for each xcb_query_tree call of child windows
-  xcb_query_tree_cookie_t* cookies = malloc(children_length * sizeof(xcb_query_tree_cookie_t));
-  if (!cookies) {
-    LOG_FATAL("could not allocate memory to store children cookies.");
-    return;
-  }
+  /* Handle state events (e.g., running flag changes) */
+  handle_state_event(event);
 
-  // 3. query each child window for its own descendants & store the cookie
-  for (uint16_t i = 0; i < children_length; i++) {
-    xcb_window_t child = children[i];
-    cookies[i]         = xcb_query_tree_unchecked(dpy, child);
-  }
+  free(event);
+}
 
-  // 4. check the reply for each such cookie to find the parent of this window
-  for (uint16_t i = 0; i < children_length; i++) {
-    xcb_window_t child = children[i];
+/* Queue an event for the current batch, or dispatch it now if that fails */
+static void
+collect_event(xcb_generic_event_t* event)
+{
+  if (!xcb_batch_push(&batch, event))
+    dispatch_xcb_event(event);
+}
 
-    // 5. get the reply for this child window
-    xcb_query_tree_reply_t* reply = xcb_query_tree_reply(dpy, cookies[i], NULL);
-    if (!reply)
-      continue;
+/*
+ * Coalesce and dispatch everything collected during this wakeup, input
+ * first, complete the continuations whose replies arrived with it, then
+ * send all requests the handlers produced with a single flush.
+ */
+static void
+process_batch(void)
+{
+  uint32_t events = xcb_batch_coalesce(&batch);
+  xcb_batch_prioritize(&batch);
 
-    // 6. check if the child window is a direct descendant of the root window
-    if (reply->parent == root) {
-      xcb_reparent_window(dpy, child, root, 0, 0);
-      xcb_change_window_attributes(dpy, child, XCB_CW_EVENT_MASK, values);
-      xcb_map_window(dpy, child);
-    }
+  for (uint32_t i = 0; i < events; i++)
+    dispatch_xcb_event(batch.events[i]);
+  batch.count = 0;
 
-    // 7. free the reply for this child window
-    free(reply);
-  }
+  uint32_t replies = xcb_reply_process(dpy);
+  if (events == 0 && replies == 0)
+    return;
 
-  // 8. free the data structure that stores the cookies
-  free(cookies);
+  /* Lay out every monitor the batch dirtied, once each */
+  hub_run_scheduled_relayouts();
 
-  xcb_flush(dpy);
+  xcb_batch_count_flush();
+  if (xcb_flush(dpy) <= 0)
+    LOG_FATAL("failed to flush.");
 }
 
 void
 handle_xcb_events()
 {
-  xcb_generic_event_t* event = xcb_poll_for_event(dpy);
-  if (event == NULL)
-    return;
+  xcb_generic_event_t* event;
 
-  /* Handle errors (response_type = 0) */
-  if (event->response_type == 0) {
-    error_details((xcb_generic_error_t*) event);
-    free(event);
-    return;
+  /* one wakeup may carry many events: drain everything readable */
+  while ((event = xcb_poll_for_event(dpy)) != NULL) {
+    collect_event(event);
+    while ((event = xcb_poll_for_queued_event(dpy)) != NULL)
+      collect_event(event);
   }
 
-  /* Dispatch to registered handlers */
-  xcb_handler_dispatch(event);
+  process_batch();
 
-  /* Handle state events (e.g., running flag changes) */
-  handle_state_event(event);
+  if (xcb_connection_has_error(dpy))
+    LOG_FATAL("wm: lost connection to the X server");
+}
 
-  free(event);
+static void
+xcb_fd_ready(int fd, uint32_t events, void* userdata)
+{
+  handle_xcb_events();
+}
+
+/*
+ * Runs before the main loop blocks. Handlers that waited for a reply may
+ * have caused XCB to read and queue events and replies without the fd
+ * becoming readable again, so handle those first, then flush pending
+ * requests.
+ */
+static void
+xcb_prepare(void* userdata)
+{
+  xcb_generic_event_t* event;
+
+  while ((event = xcb_poll_for_queued_event(dpy)) != NULL)
+    collect_event(event);
+  process_batch();
+
+  /* Requests queued this iteration, by handlers, timers or other fd sources */
+  hub_run_queued_requests();
+
+  /* Events posted this iteration, coalesced, including the completions,
+   * and relayouts scheduled by timers or other fd sources. Both can cause
+   * more of the other, so nothing is left waiting while the loop blocks */
+  hub_settle();
+
+  /* Let other threads see the state this iteration left behind */
+  snapshot_publish();
+
+  if (xcb_flush(dpy) <= 0)
+    LOG_FATAL("failed to flush.");
 }
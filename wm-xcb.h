@@ -9,6 +9,7 @@ extern xcb_window_t      root;
 void setup_xcb();
 void handle_xcb_events();
 void destruct_xcb();
+void wm_manage_all_clients();
 void error_details(xcb_generic_error_t* error);
 
 #endif
@@ -3,10 +3,12 @@
 #include <unistd.h>
 
 #include "wm-log.h"
+#include "wm-loop.h"
 #include "wm-running.h"
 #include "wm-signals.h"
 
 #include "wm-hub.h"
+#include "wm-ipc.h"
 #include "wm-states.h"
 #include "wm-xcb-ewmh.h"
 #include "wm-xcb.h"
@@ -16,6 +18,7 @@
 #include "src/components/keybinding.h"
 #include "src/components/monitor-manager.h"
 #include "src/components/pertag.h"
+#include "src/components/state-snapshot.h"
 #include "src/components/tiling.h"
 
 #include "src/actions/launcher.h"
@@ -27,6 +30,7 @@ int
 main(int argc, char** argv)
 {
   /* Initialize core systems */
+  loop_init();
   setup_signals();
   setup_xcb();
   setup_ewmh();
@@ -44,18 +48,25 @@ main(int argc, char** argv)
   monitor_manager_init();
   tiling_component_init();
 
+  /* Adopt windows that existed before we started, now that components listen */
+  wm_manage_all_clients();
+
   /* Initialize launcher action (must be after action_registry_init which happens in keybinding_init) */
   launcher_init();
 
   /* Initialize terminal action */
   terminal_init();
 
-  /* Main event loop */
-  while (running) {
-    handle_xcb_events();
-  }
+  /* Control socket for scripts, served by the loop */
+  if (ipc_init(NULL) < 0)
+    LOG_WARN("IPC socket unavailable, continuing without it");
+
+  /* Main event loop - blocks until X, a signal or a timer needs attention */
+  loop_run();
 
   /* Shutdown in reverse order */
+  ipc_shutdown();
+  snapshot_shutdown();
   monitor_manager_shutdown();
   tiling_component_shutdown();
   client_list_component_shutdown();
@@ -70,5 +81,7 @@ main(int argc, char** argv)
   destruct_state_machine();
   destruct_ewmh();
   destruct_xcb();
+  destruct_signals();
+  loop_shutdown();
   return 0;
 }